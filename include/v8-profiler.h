@@ -416,12 +416,46 @@ class V8EXPORT HeapProfiler {
       HeapSnapshot::Type type = HeapSnapshot::kFull,
       ActivityControl* control = NULL);
 
+  /**
+   * Writes a full heap snapshot to the stream as the heap is traversed,
+   * without keeping the snapshot in memory.  The output uses the JSON
+   * format of HeapSnapshot::Serialize, except that nodes carry no
+   * retained size and dominator, edges refer to nodes by their ids and
+   * embedder objects are not reported.  Returns false if streaming was
+   * aborted by the stream or the control.
+   */
+  static bool StreamSnapshot(Handle<String> title,
+                             OutputStream* stream,
+                             ActivityControl* control = NULL);
+
   /**
    * Deletes all snapshots taken. All previously returned pointers to
    * snapshots and their contents become invalid after this call.
    */
   static void DeleteAllSnapshots();
 
+  /**
+   * Starts sampling heap allocations.  About every sample_interval bytes
+   * of allocation (randomized) the JavaScript stack and the type of the
+   * allocated object are recorded.  Sampling has a low overhead and can
+   * stay enabled in production.
+   */
+  static void StartHeapObjectSampling(int sample_interval = 512 * 1024);
+
+  /**
+   * Returns the root of the call tree of the samples taken so far, or
+   * NULL if sampling is not active.  Paths lead from the outermost
+   * function to the allocating one and end at nodes naming the types of
+   * the sampled objects, like "(string)" or "(Foo)" for objects built by
+   * constructor Foo.  Sample counts multiplied by the sample interval
+   * estimate the allocated bytes.  Time values of the nodes are not
+   * meaningful.  The tree is valid until sampling is stopped.
+   */
+  static const CpuProfileNode* GetHeapObjectSamples();
+
+  /** Stops sampling heap allocations and deletes the samples. */
+  static void StopHeapObjectSampling();
+
   /** Binds a callback to embedder's class ID. */
   static void DefineWrapperClass(
       uint16_t class_id,
@@ -2551,11 +2551,26 @@ class V8EXPORT ResourceConstraints {
   uint32_t* stack_limit() const { return stack_limit_; }
   // Sets an address beyond which the VM's stack may not grow.
   void set_stack_limit(uint32_t* value) { stack_limit_ = value; }
+  int max_pause_time() const { return max_pause_time_; }
+  // Sets a goal, in milliseconds, for the longest garbage collection pause.
+  // The heap then keeps the young generation small enough and does the
+  // marking of the old generation in increments that fit the goal, at the
+  // cost of throughput.  0 means no goal.  Can be changed at any time.
+  void set_max_pause_time(int value) { max_pause_time_ = value; }
+  int max_gc_time_percentage() const { return max_gc_time_percentage_; }
+  // Sets a goal for the share of time, in percent, spent in garbage
+  // collection.  When it is missed the heap trades memory for fewer
+  // collections.  0 means no goal.  Can be changed at any time.
+  void set_max_gc_time_percentage(int value) {
+    max_gc_time_percentage_ = value;
+  }
  private:
   int max_young_space_size_;
   int max_old_space_size_;
   int max_executable_size_;
   uint32_t* stack_limit_;
+  int max_pause_time_;
+  int max_gc_time_percentage_;
 };
 
 
@@ -3180,6 +3195,20 @@ class V8EXPORT V8 {
    */
   static void GetHeapStatistics(HeapStatistics* heap_statistics);
 
+  /**
+   * Performs full garbage collections that charge the live heap objects
+   * to the contexts of the current isolate, for example to find out how
+   * much memory each of several tenants uses.  An object is charged to
+   * the first context, newest first, from which it is reachable.  Objects
+   * that all contexts share, and objects only reachable from handles,
+   * are not charged to any context.
+   * Stores up to max_contexts contexts and the number of bytes charged to
+   * each, and returns the number of contexts stored.
+   */
+  static int MeasureContextMemory(Local<Context>* contexts,
+                                  intptr_t* sizes,
+                                  int max_contexts);
+
   /**
    * Optional notification that the embedder is idle.
    * V8 uses the notification to reduce memory footprint.
@@ -3190,6 +3219,35 @@ class V8EXPORT V8 {
    */
   static bool IdleNotification();
 
+  /**
+   * Optional notification that the embedder is idle for about the given
+   * number of milliseconds, for example until the next frame is due.
+   * V8 uses the time for the garbage collection work that it expects to
+   * finish before the deadline: an incremental marking step, lazy sweeping,
+   * a scavenge or the end of an incremental marking cycle.
+   * Returns true if V8 has no more garbage collection work to do when idle.
+   * This includes the case where only the end of an incremental marking
+   * cycle is left and it is not expected to fit into the given time.
+   * The embedder should then stop calling IdleNotification until real work
+   * has been done.
+   */
+  static bool IdleNotification(int idle_time_in_ms);
+
+  /**
+   * Returns the number of weak callbacks that garbage collections have
+   * queued.  Callbacks are only queued when V8 runs with
+   * --queue-weak-callbacks, otherwise they are invoked at the end of the
+   * garbage collection that found their objects unreachable.
+   */
+  static int NumberOfPendingWeakCallbacks();
+
+  /**
+   * Invokes at most the given number of queued weak callbacks, for example
+   * from the embedder's message loop.  Idle notifications dispatch queued
+   * callbacks too.  Returns true if no queued callbacks remain.
+   */
+  static bool DispatchPendingWeakCallbacks(int max_callbacks);
+
   /**
    * Optional notification that the system is running low on memory.
    * V8 uses these notifications to attempt to free memory.
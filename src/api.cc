@@ -559,7 +559,9 @@ ResourceConstraints::ResourceConstraints()
   : max_young_space_size_(0),
     max_old_space_size_(0),
     max_executable_size_(0),
-    stack_limit_(NULL) { }
+    stack_limit_(NULL),
+    max_pause_time_(0),
+    max_gc_time_percentage_(0) { }
 
 
 bool SetResourceConstraints(ResourceConstraints* constraints) {
@@ -580,6 +582,9 @@ bool SetResourceConstraints(ResourceConstraints* constraints) {
     uintptr_t limit = reinterpret_cast<uintptr_t>(constraints->stack_limit());
     isolate->stack_guard()->SetStackLimit(limit);
   }
+  // A goal of 0 clears a goal that was set before.
+  isolate->heap()->SetGCGoals(constraints->max_pause_time(),
+                              constraints->max_gc_time_percentage());
   return true;
 }
 
@@ -3970,6 +3975,23 @@ void v8::V8::GetHeapStatistics(HeapStatistics* heap_statistics) {
 }
 
 
+int v8::V8::MeasureContextMemory(Local<Context>* contexts,
+                                 intptr_t* sizes,
+                                 int max_contexts) {
+  i::Isolate* isolate = i::Isolate::Current();
+  if (IsDeadCheck(isolate, "v8::V8::MeasureContextMemory()")) return 0;
+  i::List<i::Handle<i::Context> > all_contexts;
+  i::List<intptr_t> all_sizes;
+  isolate->heap()->MeasureContextMemory(&all_contexts, &all_sizes);
+  int count = i::Min(max_contexts, all_contexts.length());
+  for (int i = 0; i < count; i++) {
+    contexts[i] = Utils::ToLocal(all_contexts[i]);
+    sizes[i] = all_sizes[i];
+  }
+  return count;
+}
+
+
 bool v8::V8::IdleNotification() {
   // Returning true tells the caller that it need not
   // continue to call IdleNotification.
@@ -3978,6 +4000,30 @@ bool v8::V8::IdleNotification() {
 }
 
 
+bool v8::V8::IdleNotification(int idle_time_in_ms) {
+  // Returning true tells the caller that it need not
+  // continue to call IdleNotification.
+  if (!i::Isolate::Current()->IsInitialized()) return true;
+  return i::V8::IdleNotification(idle_time_in_ms);
+}
+
+
+int v8::V8::NumberOfPendingWeakCallbacks() {
+  i::Isolate* isolate = i::Isolate::Current();
+  if (!isolate->IsInitialized()) return 0;
+  return isolate->global_handles()->NumberOfPendingWeakCallbacks();
+}
+
+
+bool v8::V8::DispatchPendingWeakCallbacks(int max_callbacks) {
+  i::Isolate* isolate = i::Isolate::Current();
+  if (!isolate->IsInitialized()) return true;
+  i::GlobalHandles* global_handles = isolate->global_handles();
+  global_handles->DispatchPendingWeakCallbacks(max_callbacks);
+  return global_handles->NumberOfPendingWeakCallbacks() == 0;
+}
+
+
 void v8::V8::LowMemoryNotification() {
   i::Isolate* isolate = i::Isolate::Current();
   if (!isolate->IsInitialized()) return;
@@ -5705,8 +5751,11 @@ const HeapGraphNode* HeapGraphEdge::GetToNode() const {
 
 
 static i::HeapEntry* ToInternal(const HeapGraphNode* entry) {
-  return const_cast<i::HeapEntry*>(
+  i::HeapEntry* result = const_cast<i::HeapEntry*>(
       reinterpret_cast<const i::HeapEntry*>(entry));
+  // Dominators and retained sizes may still be computed in background.
+  result->snapshot()->WaitForAggregation();
+  return result;
 }
 
 
@@ -5794,8 +5843,10 @@ v8::Handle<v8::Value> HeapGraphNode::GetHeapValue() const {
 
 
 static i::HeapSnapshot* ToInternal(const HeapSnapshot* snapshot) {
-  return const_cast<i::HeapSnapshot*>(
+  i::HeapSnapshot* result = const_cast<i::HeapSnapshot*>(
       reinterpret_cast<const i::HeapSnapshot*>(snapshot));
+  result->WaitForAggregation();
+  return result;
 }
 
 
@@ -5923,6 +5974,19 @@ const HeapSnapshot* HeapProfiler::TakeSnapshot(Handle<String> title,
 }
 
 
+bool HeapProfiler::StreamSnapshot(Handle<String> title,
+                                  OutputStream* stream,
+                                  ActivityControl* control) {
+  i::Isolate* isolate = i::Isolate::Current();
+  IsDeadCheck(isolate, "v8::HeapProfiler::StreamSnapshot");
+  ApiCheck(stream->GetOutputEncoding() == OutputStream::kAscii,
+           "v8::HeapProfiler::StreamSnapshot",
+           "Unsupported output encoding");
+  return i::HeapProfiler::StreamSnapshot(
+      *Utils::OpenHandle(*title), stream, control);
+}
+
+
 void HeapProfiler::DeleteAllSnapshots() {
   i::Isolate* isolate = i::Isolate::Current();
   IsDeadCheck(isolate, "v8::HeapProfiler::DeleteAllSnapshots");
@@ -5930,6 +5994,32 @@ void HeapProfiler::DeleteAllSnapshots() {
 }
 
 
+void HeapProfiler::StartHeapObjectSampling(int sample_interval) {
+  i::Isolate* isolate = i::Isolate::Current();
+  IsDeadCheck(isolate, "v8::HeapProfiler::StartHeapObjectSampling");
+  ApiCheck(sample_interval > 0,
+           "v8::HeapProfiler::StartHeapObjectSampling",
+           "Sample interval must be positive");
+  i::HeapProfiler::StartHeapObjectSampling(sample_interval);
+}
+
+
+const CpuProfileNode* HeapProfiler::GetHeapObjectSamples() {
+  i::Isolate* isolate = i::Isolate::Current();
+  IsDeadCheck(isolate, "v8::HeapProfiler::GetHeapObjectSamples");
+  i::ProfileTree* tree = i::HeapProfiler::GetHeapObjectSamples();
+  if (tree == NULL) return NULL;
+  return reinterpret_cast<const CpuProfileNode*>(tree->root());
+}
+
+
+void HeapProfiler::StopHeapObjectSampling() {
+  i::Isolate* isolate = i::Isolate::Current();
+  IsDeadCheck(isolate, "v8::HeapProfiler::StopHeapObjectSampling");
+  i::HeapProfiler::StopHeapObjectSampling();
+}
+
+
 void HeapProfiler::DefineWrapperClass(uint16_t class_id,
                                       WrapperInfoCallback callback) {
   i::Isolate::Current()->heap_profiler()->DefineWrapperClass(class_id,
@@ -6038,10 +6128,18 @@ char* HandleScopeImplementer::RestoreThread(char* storage) {
 
 
 void HandleScopeImplementer::IterateThis(ObjectVisitor* v) {
-  // Iterate over all handles in the blocks except for the last.
+  // Iterate over all handles in the blocks except for the last. While a
+  // DeferredHandleScope is open, the block it interrupted is only in use up
+  // to the last handle created before the scope.
   for (int i = blocks()->length() - 2; i >= 0; --i) {
     Object** block = blocks()->at(i);
-    v->VisitPointers(block, &block[kHandleBlockSize]);
+    if (last_handle_before_deferred_block_ != NULL &&
+        last_handle_before_deferred_block_ >= block &&
+        last_handle_before_deferred_block_ <= &block[kHandleBlockSize]) {
+      v->VisitPointers(block, last_handle_before_deferred_block_);
+    } else {
+      v->VisitPointers(block, &block[kHandleBlockSize]);
+    }
   }
 
   // Iterate over live handles in the last block (if any).
@@ -6064,6 +6162,59 @@ void HandleScopeImplementer::Iterate(ObjectVisitor* v) {
 }
 
 
+void HandleScopeImplementer::BeginDeferredScope(Object** prev_next) {
+  ASSERT(last_handle_before_deferred_block_ == NULL);
+  last_handle_before_deferred_block_ = prev_next;
+}
+
+
+DeferredHandles* HandleScopeImplementer::Detach(Object** prev_limit) {
+  DeferredHandles* deferred =
+      new DeferredHandles(isolate_->handle_scope_data()->next, isolate_);
+
+  // Move the blocks allocated since the deferred scope was entered, newest
+  // first, to the deferred handles.
+  while (!blocks_.is_empty()) {
+    Object** block_start = blocks_.last();
+    Object** block_limit = &block_start[kHandleBlockSize];
+    if (block_start <= prev_limit && prev_limit <= block_limit) break;
+    deferred->blocks_.Add(block_start);
+    blocks_.RemoveLast();
+  }
+  ASSERT(!deferred->blocks_.is_empty());
+  ASSERT((blocks_.is_empty() && prev_limit == NULL) ||
+         (!blocks_.is_empty() && prev_limit != NULL));
+
+  last_handle_before_deferred_block_ = NULL;
+  return deferred;
+}
+
+
+DeferredHandles::~DeferredHandles() {
+  isolate_->UnlinkDeferredHandles(this);
+  for (int i = 0; i < blocks_.length(); i++) {
+#ifdef DEBUG
+    v8::ImplementationUtilities::ZapHandleRange(
+        blocks_[i], &blocks_[i][kHandleBlockSize]);
+#endif
+    DeleteArray(blocks_[i]);
+  }
+}
+
+
+void DeferredHandles::Iterate(ObjectVisitor* v) {
+  ASSERT(!blocks_.is_empty());
+  // The first block is the one that was current when the handles were
+  // detached; it is only in use up to the limit recorded then.
+  ASSERT(first_block_limit_ >= blocks_.first() &&
+         first_block_limit_ <= &blocks_.first()[kHandleBlockSize]);
+  v->VisitPointers(blocks_.first(), first_block_limit_);
+  for (int i = 1; i < blocks_.length(); i++) {
+    v->VisitPointers(blocks_[i], &blocks_[i][kHandleBlockSize]);
+  }
+}
+
+
 char* HandleScopeImplementer::Iterate(ObjectVisitor* v, char* storage) {
   HandleScopeImplementer* scope_implementer =
       reinterpret_cast<HandleScopeImplementer*>(storage);
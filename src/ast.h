@@ -1271,7 +1271,8 @@ class CallNew: public Expression {
       : Expression(isolate),
         expression_(expression),
         arguments_(arguments),
-        pos_(pos) { }
+        pos_(pos),
+        return_id_(GetNextId(isolate)) { }
 
   DECLARE_NODE_TYPE(CallNew)
 
@@ -1281,10 +1282,15 @@ class CallNew: public Expression {
   ZoneList<Expression*>* arguments() const { return arguments_; }
   virtual int position() const { return pos_; }
 
+  // Bailout support.
+  int ReturnId() const { return return_id_; }
+
  private:
   Expression* expression_;
   ZoneList<Expression*>* arguments_;
   int pos_;
+
+  int return_id_;
 };
 
 
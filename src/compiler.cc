@@ -39,6 +39,7 @@
 #include "isolate-inl.h"
 #include "lithium.h"
 #include "liveedit.h"
+#include "optimizing-compiler-thread.h"
 #include "parser.h"
 #include "rewriter.h"
 #include "runtime-profiler.h"
@@ -176,34 +177,52 @@ static bool MakeCrankshaftCode(CompilationInfo* info) {
     return FullCodeGenerator::MakeCode(info);
   }
 
+  OptimizingCompiler compiler(info);
+  OptimizingCompiler::Status status = compiler.CreateGraph();
+  if (status != OptimizingCompiler::SUCCEEDED) {
+    return status != OptimizingCompiler::FAILED;
+  }
+  {
+    // The graph optimizations and register allocation must not touch the
+    // heap, so that they can also run on the optimizing compiler thread.
+    AssertNoAllocation no_allocation;
+    status = compiler.OptimizeGraph();
+  }
+  if (status != OptimizingCompiler::SUCCEEDED) {
+    status = compiler.AbortOptimization();
+  } else {
+    status = compiler.GenerateCode();
+  }
+  return status != OptimizingCompiler::FAILED;
+}
+
+
+OptimizingCompiler::Status OptimizingCompiler::CreateGraph() {
+  ASSERT(info()->IsOptimizing());
+
   // We should never arrive here if there is not code object on the
   // shared function object.
-  Handle<Code> code(info->shared_info()->code());
+  Handle<Code> code(info()->shared_info()->code());
   ASSERT(code->kind() == Code::FUNCTION);
 
   // We should never arrive here if optimization has been disabled on the
   // shared function info.
-  ASSERT(!info->shared_info()->optimization_disabled());
+  ASSERT(!info()->shared_info()->optimization_disabled());
 
   // Fall back to using the full code generator if it's not possible
   // to use the Hydrogen-based optimizing compiler. We already have
   // generated code for this from the shared function object.
   if (AlwaysFullCompiler() || !FLAG_use_hydrogen) {
-    info->SetCode(code);
-    return true;
+    info()->SetCode(code);
+    return BAILED_OUT;
   }
 
   // Limit the number of times we re-compile a functions with
   // the optimizing compiler.
   const int kMaxOptCount =
       FLAG_deopt_every_n_times == 0 ? Compiler::kDefaultMaxOptCount : 1000;
-  if (info->shared_info()->opt_count() > kMaxOptCount) {
-    info->AbortOptimization();
-    Handle<JSFunction> closure = info->closure();
-    info->shared_info()->DisableOptimization(*closure);
-    // True indicates the compilation pipeline is still going, not
-    // necessarily that we optimized the code.
-    return true;
+  if (info()->shared_info()->opt_count() > kMaxOptCount) {
+    return AbortOptimization();
   }
 
   // Due to an encoding limit on LUnallocated operands in the Lithium
@@ -215,45 +234,40 @@ static bool MakeCrankshaftCode(CompilationInfo* info) {
   // the negative indices and locals the non-negative ones.
   const int parameter_limit = -LUnallocated::kMinFixedIndex;
   const int locals_limit = LUnallocated::kMaxFixedIndex;
-  Scope* scope = info->scope();
+  Scope* scope = info()->scope();
   if ((scope->num_parameters() + 1) > parameter_limit ||
-      (info->osr_ast_id() != AstNode::kNoNumber &&
+      (info()->osr_ast_id() != AstNode::kNoNumber &&
        scope->num_parameters() + 1 + scope->num_stack_slots() > locals_limit)) {
-    info->AbortOptimization();
-    Handle<JSFunction> closure = info->closure();
-    info->shared_info()->DisableOptimization(*closure);
-    // True indicates the compilation pipeline is still going, not
-    // necessarily that we optimized the code.
-    return true;
+    return AbortOptimization();
   }
 
   // Take --hydrogen-filter into account.
   Vector<const char> filter = CStrVector(FLAG_hydrogen_filter);
-  Handle<String> name = info->function()->debug_name();
+  Handle<String> name = info()->function()->debug_name();
   bool match = filter.is_empty() || name->IsEqualTo(filter);
   if (!match) {
-    info->SetCode(code);
-    return true;
+    info()->SetCode(code);
+    return BAILED_OUT;
   }
 
   // Recompile the unoptimized version of the code if the current version
   // doesn't have deoptimization support. Alternatively, we may decide to
   // run the full code generator to get a baseline for the compile-time
   // performance of the hydrogen-based compiler.
-  int64_t start = OS::Ticks();
-  bool should_recompile = !info->shared_info()->has_deoptimization_support();
+  start_ = OS::Ticks();
+  bool should_recompile = !info()->shared_info()->has_deoptimization_support();
   if (should_recompile || FLAG_hydrogen_stats) {
     HPhase phase(HPhase::kFullCodeGen);
-    CompilationInfo unoptimized(info->shared_info());
+    CompilationInfo unoptimized(info()->shared_info());
     // Note that we use the same AST that we will use for generating the
     // optimized code.
-    unoptimized.SetFunction(info->function());
-    unoptimized.SetScope(info->scope());
+    unoptimized.SetFunction(info()->function());
+    unoptimized.SetScope(info()->scope());
     if (should_recompile) unoptimized.EnableDeoptimizationSupport();
     bool succeeded = FullCodeGenerator::MakeCode(&unoptimized);
     if (should_recompile) {
-      if (!succeeded) return false;
-      Handle<SharedFunctionInfo> shared = info->shared_info();
+      if (!succeeded) return FAILED;
+      Handle<SharedFunctionInfo> shared = info()->shared_info();
       shared->EnableDeoptimizationSupport(*unoptimized.code());
       // The existing unoptimized code was replaced with the new one.
       Compiler::RecordFunctionCompilation(
@@ -267,44 +281,62 @@ static bool MakeCrankshaftCode(CompilationInfo* info) {
   // is safe as long as the unoptimized code has deoptimization
   // support.
   ASSERT(FLAG_always_opt || code->optimizable());
-  ASSERT(info->shared_info()->has_deoptimization_support());
+  ASSERT(info()->shared_info()->has_deoptimization_support());
 
   if (FLAG_trace_hydrogen) {
     PrintF("-----------------------------------------------------------\n");
     PrintF("Compiling method %s using hydrogen\n", *name->ToCString());
-    HTracer::Instance()->TraceCompilation(info->function());
+    HTracer::Instance()->TraceCompilation(info()->function());
   }
 
-  Handle<Context> global_context(info->closure()->context()->global_context());
-  TypeFeedbackOracle oracle(code, global_context, info->isolate());
-  HGraphBuilder builder(info, &oracle);
+  Handle<Context> global_context(
+      info()->closure()->context()->global_context());
+  TypeFeedbackOracle oracle(code, global_context, info()->isolate());
+  HGraphBuilder builder(info(), &oracle);
   HPhase phase(HPhase::kTotal);
-  HGraph* graph = builder.CreateGraph();
-  if (info->isolate()->has_pending_exception()) {
-    info->SetCode(Handle<Code>::null());
-    return false;
+  graph_ = builder.CreateGraph();
+  inline_bailout_ = builder.inline_bailout();
+  if (info()->isolate()->has_pending_exception()) {
+    info()->SetCode(Handle<Code>::null());
+    return FAILED;
   }
 
-  if (graph != NULL && FLAG_build_lithium) {
-    Handle<Code> optimized_code = graph->Compile(info);
-    if (!optimized_code.is_null()) {
-      info->SetCode(optimized_code);
-      FinishOptimization(info->closure(), start);
-      return true;
-    }
-  }
+  if (graph_ == NULL || !FLAG_build_lithium) return AbortOptimization();
+  return SUCCEEDED;
+}
+
+
+OptimizingCompiler::Status OptimizingCompiler::OptimizeGraph() {
+  ASSERT(graph_ != NULL);
+  HPhase phase(HPhase::kTotal);
+  graph_->Optimize(info());
+  chunk_ = graph_->BuildChunk(info());
+  return chunk_ != NULL ? SUCCEEDED : BAILED_OUT;
+}
+
 
+OptimizingCompiler::Status OptimizingCompiler::GenerateCode() {
+  ASSERT(chunk_ != NULL);
+  HPhase phase(HPhase::kTotal);
+  Handle<Code> optimized_code = graph_->GenerateCode(chunk_, info());
+  if (optimized_code.is_null()) return AbortOptimization();
+  info()->SetCode(optimized_code);
+  FinishOptimization(info()->closure(), start_);
+  return SUCCEEDED;
+}
+
+
+OptimizingCompiler::Status OptimizingCompiler::AbortOptimization() {
   // Keep using the shared code.
-  info->AbortOptimization();
-  if (!builder.inline_bailout()) {
+  info()->AbortOptimization();
+  if (!inline_bailout_) {
     // Mark the shared code as unoptimizable unless it was an inlined
     // function that bailed out.
-    Handle<JSFunction> closure = info->closure();
-    info->shared_info()->DisableOptimization(*closure);
+    Handle<JSFunction> closure = info()->closure();
+    info()->shared_info()->DisableOptimization(*closure);
   }
-  // True indicates the compilation pipeline is still going, not necessarily
-  // that we optimized the code.
-  return true;
+  // The compilation pipeline is still going, we just did not optimize.
+  return BAILED_OUT;
 }
 
 
@@ -675,6 +707,95 @@ bool Compiler::CompileLazy(CompilationInfo* info) {
 }
 
 
+bool Compiler::RecompileConcurrent(Handle<JSFunction> closure) {
+  Isolate* isolate = closure->GetIsolate();
+  OptimizingCompilerThread* thread = isolate->optimizing_compiler_thread();
+  ASSERT(thread != NULL);
+  if (!thread->IsQueueAvailable()) return false;
+
+  Handle<SharedFunctionInfo> shared(closure->shared());
+  if (!shared->code()->optimizable() ||
+      shared->optimization_disabled() ||
+      isolate->DebuggerHasBreakPoints()) {
+    return false;
+  }
+
+  // Everything the job refers to outlives this call: the AST and the graph
+  // live in the job's own zone and the handles are detached from the
+  // current handle scope.
+  DeferredHandleScope deferred(isolate);
+  RecompileJob* job = new RecompileJob(Handle<JSFunction>(*closure));
+  OptimizingCompiler::Status status = OptimizingCompiler::FAILED;
+  {
+    ThreadZoneScope zone_scope(job->zone());
+    VMState state(isolate, COMPILER);
+    PostponeInterruptsScope postpone(isolate);
+
+    CompilationInfo* info = job->info();
+    if (ParserApi::Parse(info)) {
+      if (info->function()->strict_mode()) {
+        shared->set_strict_mode(true);
+        info->MarkAsStrictMode();
+      }
+      if (!info->AllowOptimize()) info->DisableOptimization();
+      if (info->IsOptimizing() &&
+          Rewriter::Rewrite(info) &&
+          Scope::Analyze(info)) {
+        status = job->compiler()->CreateGraph();
+      }
+    }
+  }
+  // The unoptimized code may have been replaced to get deoptimization
+  // support; remember the version the graph was built against.
+  job->set_unoptimized_code(Handle<Code>(shared->code()));
+  job->set_deferred_handles(deferred.Detach());
+
+  if (status != OptimizingCompiler::SUCCEEDED) {
+    delete job;
+    isolate->clear_pending_exception();
+    return false;
+  }
+  thread->QueueForOptimization(job);
+  return true;
+}
+
+
+void Compiler::InstallOptimizedCode(RecompileJob* job) {
+  Isolate* isolate = job->info()->isolate();
+  HandleScope scope(isolate);
+  Handle<JSFunction> closure = job->info()->closure();
+  Handle<SharedFunctionInfo> shared = job->info()->shared_info();
+
+  // The world may have changed while the job was in flight: the function
+  // may have been optimized by other means, its code may have been flushed
+  // or recompiled, or the debugger may need the unoptimized code.
+  if (closure->IsOptimized() ||
+      shared->code() != *job->unoptimized_code() ||
+      isolate->DebuggerHasBreakPoints()) {
+    return;
+  }
+
+  OptimizingCompiler::Status status;
+  {
+    ThreadZoneScope zone_scope(job->zone());
+    VMState state(isolate, COMPILER);
+    PostponeInterruptsScope postpone(isolate);
+    if (job->status() == OptimizingCompiler::SUCCEEDED) {
+      status = job->compiler()->GenerateCode();
+    } else {
+      status = job->compiler()->AbortOptimization();
+    }
+  }
+
+  if (status == OptimizingCompiler::SUCCEEDED) {
+    CompilationInfo* info = job->info();
+    ASSERT(!info->code().is_null());
+    RecordFunctionCompilation(Logger::LAZY_COMPILE_TAG, info, shared);
+    closure->ReplaceCode(*info->code());
+  }
+}
+
+
 Handle<SharedFunctionInfo> Compiler::BuildFunctionInfo(FunctionLiteral* literal,
                                                        Handle<Script> script) {
   // Precondition: code has been parsed and scopes have been analyzed.
@@ -35,6 +35,9 @@
 namespace v8 {
 namespace internal {
 
+class HGraph;
+class LChunk;
+class RecompileJob;
 class ScriptDataImpl;
 
 // CompilationInfo encapsulates some information known at compile time.  It
@@ -230,6 +233,47 @@ class CompilationInfo BASE_EMBEDDED {
 };
 
 
+// Drives the optimizing compiler for a single function. The work is split
+// into three phases so that the middle one, which neither allocates nor
+// creates handles, can run on a background thread:
+//
+//   CreateGraph()    builds the hydrogen graph and runs the passes that
+//                    need handles; main thread only.
+//   OptimizeGraph()  optimizes the graph, builds the lithium chunk and
+//                    allocates registers; any thread.
+//   GenerateCode()   emits the code object; main thread only.
+//
+// A phase that bails out leaves the unoptimized code in the compilation
+// info; a bailout in OptimizeGraph() has to be finished on the main thread
+// by calling AbortOptimization().
+class OptimizingCompiler BASE_EMBEDDED {
+ public:
+  explicit OptimizingCompiler(CompilationInfo* info)
+      : info_(info),
+        graph_(NULL),
+        chunk_(NULL),
+        inline_bailout_(false),
+        start_(0) { }
+
+  enum Status { FAILED, BAILED_OUT, SUCCEEDED };
+
+  MUST_USE_RESULT Status CreateGraph();
+  MUST_USE_RESULT Status OptimizeGraph();
+  MUST_USE_RESULT Status GenerateCode();
+
+  Status AbortOptimization();
+
+  CompilationInfo* info() const { return info_; }
+
+ private:
+  CompilationInfo* info_;
+  HGraph* graph_;
+  LChunk* chunk_;
+  bool inline_bailout_;
+  int64_t start_;
+};
+
+
 // The V8 compiler
 //
 // General strategy: Source code is translated into an anonymous function w/o
@@ -273,6 +317,15 @@ class Compiler : public AllStatic {
   // success and false if the compilation resulted in a stack overflow.
   static bool CompileLazy(CompilationInfo* info);
 
+  // Builds the optimizing compiler's graph for the function and hands it to
+  // the optimizing compiler thread. Returns false if it was not queued, in
+  // which case the function simply keeps running its unoptimized code.
+  static bool RecompileConcurrent(Handle<JSFunction> closure);
+
+  // Finishes a job of the optimizing compiler thread on the main thread and
+  // installs the optimized code on the function if it is still wanted.
+  static void InstallOptimizedCode(RecompileJob* job);
+
   // Compile a shared function info object (the function is possibly lazily
   // compiled).
   static Handle<SharedFunctionInfo> BuildFunctionInfo(FunctionLiteral* node,
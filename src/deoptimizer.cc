@@ -107,7 +107,7 @@ Deoptimizer* Deoptimizer::Grab(Isolate* isolate) {
 #ifdef ENABLE_DEBUGGER_SUPPORT
 DeoptimizedFrameInfo* Deoptimizer::DebuggerInspectableFrame(
     JavaScriptFrame* frame,
-    int frame_index,
+    int jsframe_index,
     Isolate* isolate) {
   ASSERT(isolate == Isolate::Current());
   ASSERT(frame->is_optimized());
@@ -157,7 +157,11 @@ DeoptimizedFrameInfo* Deoptimizer::DebuggerInspectableFrame(
 
   // Create the GC safe output frame information and register it for GC
   // handling.
-  ASSERT_LT(frame_index, deoptimizer->output_count());
+  ASSERT_LT(jsframe_index, deoptimizer->jsframe_count());
+
+  // Convert JS frame index into frame index.
+  int frame_index = deoptimizer->ConvertJSFrameIndexToFrameIndex(jsframe_index);
+
   DeoptimizedFrameInfo* info =
       new DeoptimizedFrameInfo(deoptimizer, frame_index);
   isolate->deoptimizer_data()->deoptimized_frame_info_ = info;
@@ -171,7 +175,7 @@ DeoptimizedFrameInfo* Deoptimizer::DebuggerInspectableFrame(
   deoptimizer->DeleteFrameDescriptions();
 
   // Allocate a heap number for the doubles belonging to this frame.
-  deoptimizer->MaterializeHeapNumbersForDebuggerInspectableFrame(
+  deoptimizer->MaterializeHeapObjectsForDebuggerInspectableFrame(
       top, size, info);
 
   // Finished using the deoptimizer instance.
@@ -181,6 +185,18 @@ DeoptimizedFrameInfo* Deoptimizer::DebuggerInspectableFrame(
 }
 
 
+int Deoptimizer::ConvertJSFrameIndexToFrameIndex(int jsframe_index) {
+  for (int frame_index = 0; frame_index < output_count_; ++frame_index) {
+    if (output_[frame_index]->GetFrameType() == StackFrame::JAVA_SCRIPT) {
+      if (jsframe_index == 0) return frame_index;
+      jsframe_index--;
+    }
+  }
+  UNREACHABLE();
+  return -1;
+}
+
+
 void Deoptimizer::DeleteDebuggerInspectableFrame(DeoptimizedFrameInfo* info,
                                                  Isolate* isolate) {
   ASSERT(isolate == Isolate::Current());
@@ -322,10 +338,14 @@ Deoptimizer::Deoptimizer(Isolate* isolate,
       fp_to_sp_delta_(fp_to_sp_delta),
       input_(NULL),
       output_count_(0),
+      jsframe_count_(0),
       output_(NULL),
       frame_alignment_marker_(isolate->heap()->frame_alignment_marker()),
       has_alignment_padding_(0),
-      deferred_heap_numbers_(0) {
+      deferred_heap_numbers_(0),
+      deferred_objects_(0),
+      deferred_object_values_(0),
+      deferred_object_numbers_(0) {
   if (FLAG_trace_deopt && type != OSR) {
     if (type == DEBUGGER) {
       PrintF("**** DEOPT FOR DEBUGGER: ");
@@ -524,6 +544,7 @@ void Deoptimizer::DoComputeOutputFrames() {
   // Read the number of output frames and allocate an array for their
   // descriptions.
   int count = iterator.Next();
+  iterator.Next();  // Drop JS frames count.
   ASSERT(output_ == NULL);
   output_ = new FrameDescription*[count];
   for (int i = 0; i < count; ++i) {
@@ -533,7 +554,21 @@ void Deoptimizer::DoComputeOutputFrames() {
 
   // Translate each output frame.
   for (int i = 0; i < count; ++i) {
-    DoComputeFrame(&iterator, i);
+    // Read the ast node id, function, and frame height for this output frame.
+    Translation::Opcode opcode =
+        static_cast<Translation::Opcode>(iterator.Next());
+    switch (opcode) {
+      case Translation::FRAME:
+        DoComputeFrame(&iterator, i);
+        jsframe_count_++;
+        break;
+      case Translation::CONSTRUCT_STUB_FRAME:
+        DoComputeConstructStubFrame(&iterator, i);
+        break;
+      default:
+        UNREACHABLE();
+        break;
+    }
   }
 
   // Print some helpful diagnostic information.
@@ -555,58 +590,131 @@ void Deoptimizer::DoComputeOutputFrames() {
 }
 
 
-void Deoptimizer::MaterializeHeapNumbers() {
+void Deoptimizer::MaterializeDeferredObjects(List<Handle<Object> >* objects) {
+  // Wrap all field values in handles before allocating anything.
+  List<Handle<Object> > values(deferred_object_values_.length());
+  for (int i = 0; i < deferred_object_values_.length(); i++) {
+    Object* value = reinterpret_cast<Object*>(deferred_object_values_[i]);
+    values.Add(Handle<Object>(value, isolate_));
+  }
+  for (int i = 0; i < deferred_object_numbers_.length(); i++) {
+    HeapNumberMaterializationDescriptor<int> d = deferred_object_numbers_[i];
+    values[d.destination()] = isolate_->factory()->NewNumber(d.value());
+  }
+
+  int value_index = 0;
+  for (int i = 0; i < deferred_objects_.length(); i++) {
+    ObjectMaterializationDescriptor d = deferred_objects_[i];
+    // An object captured in several frames or slots is allocated once.
+    Handle<Object> object;
+    for (int j = 0; j < i; j++) {
+      if (deferred_objects_[j].id() == d.id()) {
+        object = objects->at(j);
+        break;
+      }
+    }
+    if (object.is_null()) {
+      // Literal maps do not account for their in-object properties in the
+      // pre-allocated property fields, so the object cannot be allocated
+      // from its map.  Copy the boilerplate, which has empty properties and
+      // elements, and overwrite its fields instead.
+      Handle<JSObject> boilerplate =
+          Handle<JSObject>::cast(values[value_index]);
+      Handle<JSObject> result = isolate_->factory()->CopyJSObject(boilerplate);
+      ASSERT(result->map()->inobject_properties() == d.length() - 1);
+      for (int j = 1; j < d.length(); j++) {
+        result->InObjectPropertyAtPut(j - 1, *values[value_index + j]);
+      }
+      object = result;
+      if (FLAG_trace_deopt) {
+        PrintF("Materializing a new captured object %p for id %d in slot %p\n",
+               reinterpret_cast<void*>(*object),
+               d.id(),
+               d.slot_address());
+      }
+    }
+    objects->Add(object);
+    // Every occurrence of an object, including the duplicates, has its
+    // field values in the translation.
+    value_index += d.length();
+  }
+  ASSERT(value_index == values.length());
+}
+
+
+void Deoptimizer::MaterializeHeapObjects() {
   ASSERT_NE(DEBUGGER, bailout_type_);
+  List<Handle<Object> > objects(deferred_objects_.length());
+  MaterializeDeferredObjects(&objects);
+  for (int i = 0; i < deferred_objects_.length(); i++) {
+    Memory::Object_at(deferred_objects_[i].slot_address()) = *objects[i];
+  }
+
   for (int i = 0; i < deferred_heap_numbers_.length(); i++) {
-    HeapNumberMaterializationDescriptor d = deferred_heap_numbers_[i];
+    HeapNumberMaterializationDescriptor<Address> d = deferred_heap_numbers_[i];
     Handle<Object> num = isolate_->factory()->NewNumber(d.value());
     if (FLAG_trace_deopt) {
       PrintF("Materializing a new heap number %p [%e] in slot %p\n",
              reinterpret_cast<void*>(*num),
              d.value(),
-             d.slot_address());
+             d.destination());
     }
 
-    Memory::Object_at(d.slot_address()) = *num;
+    Memory::Object_at(d.destination()) = *num;
   }
 }
 
 
 #ifdef ENABLE_DEBUGGER_SUPPORT
-void Deoptimizer::MaterializeHeapNumbersForDebuggerInspectableFrame(
+void Deoptimizer::SetDebuggerFrameSlot(DeoptimizedFrameInfo* info,
+                                       Address top,
+                                       uint32_t size,
+                                       Address slot,
+                                       Object* value) {
+  // Calculate the index with the bottom of the expression stack at index 0,
+  // and the fixed part (including incoming arguments) at negative indexes.
+  int index = static_cast<int>(
+      info->expression_count() - (slot - top) / kPointerSize - 1);
+  if (index >= 0) {
+    info->SetExpression(index, value);
+  } else {
+    // Calculate parameter index subtracting one for the receiver.
+    int parameter_index =
+        index +
+        static_cast<int>(size) / kPointerSize -
+        info->expression_count() - 1;
+    info->SetParameter(parameter_index, value);
+  }
+}
+
+
+void Deoptimizer::MaterializeHeapObjectsForDebuggerInspectableFrame(
     Address top, uint32_t size, DeoptimizedFrameInfo* info) {
   ASSERT_EQ(DEBUGGER, bailout_type_);
+  List<Handle<Object> > objects(deferred_objects_.length());
+  MaterializeDeferredObjects(&objects);
+  for (int i = 0; i < deferred_objects_.length(); i++) {
+    Address slot = deferred_objects_[i].slot_address();
+    if (top <= slot && slot < top + size) {
+      SetDebuggerFrameSlot(info, top, size, slot, *objects[i]);
+    }
+  }
+
   for (int i = 0; i < deferred_heap_numbers_.length(); i++) {
-    HeapNumberMaterializationDescriptor d = deferred_heap_numbers_[i];
+    HeapNumberMaterializationDescriptor<Address> d = deferred_heap_numbers_[i];
 
     // Check of the heap number to materialize actually belong to the frame
     // being extracted.
-    Address slot = d.slot_address();
+    Address slot = d.destination();
     if (top <= slot && slot < top + size) {
       Handle<Object> num = isolate_->factory()->NewNumber(d.value());
-      // Calculate the index with the botton of the expression stack
-      // at index 0, and the fixed part (including incoming arguments)
-      // at negative indexes.
-      int index = static_cast<int>(
-          info->expression_count_ - (slot - top) / kPointerSize - 1);
       if (FLAG_trace_deopt) {
-        PrintF("Materializing a new heap number %p [%e] in slot %p"
-               "for stack index %d\n",
+        PrintF("Materializing a new heap number %p [%e] in slot %p\n",
                reinterpret_cast<void*>(*num),
                d.value(),
-               d.slot_address(),
-               index);
-      }
-      if (index >=0) {
-        info->SetExpression(index, *num);
-      } else {
-        // Calculate parameter index subtracting one for the receiver.
-        int parameter_index =
-            index +
-            static_cast<int>(size) / kPointerSize -
-            info->expression_count_ - 1;
-        info->SetParameter(parameter_index, *num);
+               d.destination());
       }
+      SetDebuggerFrameSlot(info, top, size, slot, *num);
     }
   }
 }
@@ -632,6 +740,7 @@ void Deoptimizer::DoTranslateCommand(TranslationIterator* iterator,
   switch (opcode) {
     case Translation::BEGIN:
     case Translation::FRAME:
+    case Translation::CONSTRUCT_STUB_FRAME:
     case Translation::DUPLICATE:
       UNREACHABLE();
       return;
@@ -794,6 +903,97 @@ void Deoptimizer::DoTranslateCommand(TranslationIterator* iterator,
       output_[frame_index]->SetFrameSlot(output_offset, value);
       return;
     }
+
+    case Translation::CAPTURED_OBJECT: {
+      int object_id = iterator->Next();
+      int length = iterator->Next();
+      if (FLAG_trace_deopt) {
+        PrintF("    0x%08" V8PRIxPTR ": [top + %d] <- captured object #%d\n",
+               output_[frame_index]->GetTop() + output_offset,
+               output_offset,
+               object_id);
+      }
+      // The object is allocated from the translated field values once the
+      // frames are built.  Store a GC-safe temporary placeholder in the
+      // frame until then.
+      ObjectMaterializationDescriptor object_desc(
+          reinterpret_cast<Address>(
+              output_[frame_index]->GetTop() + output_offset),
+          object_id,
+          length);
+      deferred_objects_.Add(object_desc);
+      for (int i = 0; i < length; i++) DoTranslateObjectField(iterator);
+      output_[frame_index]->SetFrameSlot(output_offset, kPlaceholder);
+      return;
+    }
+  }
+}
+
+
+void Deoptimizer::DoTranslateObjectField(TranslationIterator* iterator) {
+  Translation::Opcode opcode =
+      static_cast<Translation::Opcode>(iterator->Next());
+  while (opcode == Translation::DUPLICATE) {
+    opcode = static_cast<Translation::Opcode>(iterator->Next());
+    iterator->Skip(Translation::NumberOfOperandsFor(opcode));
+    opcode = static_cast<Translation::Opcode>(iterator->Next());
+  }
+
+  switch (opcode) {
+    case Translation::BEGIN:
+    case Translation::FRAME:
+    case Translation::CONSTRUCT_STUB_FRAME:
+    case Translation::DUPLICATE:
+    case Translation::ARGUMENTS_OBJECT:
+    case Translation::CAPTURED_OBJECT:
+      UNREACHABLE();
+      return;
+
+    case Translation::REGISTER:
+      AddObjectValue(input_->GetRegister(iterator->Next()));
+      return;
+
+    case Translation::INT32_REGISTER:
+    case Translation::INT32_STACK_SLOT: {
+      intptr_t value;
+      if (opcode == Translation::INT32_REGISTER) {
+        value = input_->GetRegister(iterator->Next());
+      } else {
+        unsigned input_offset =
+            input_->GetOffsetFromSlotIndex(this, iterator->Next());
+        value = input_->GetFrameSlot(input_offset);
+      }
+      if (Smi::IsValid(value)) {
+        AddObjectValue(
+            reinterpret_cast<intptr_t>(Smi::FromInt(static_cast<int>(value))));
+      } else {
+        AddObjectDoubleValue(static_cast<double>(static_cast<int32_t>(value)));
+      }
+      return;
+    }
+
+    case Translation::DOUBLE_REGISTER:
+      AddObjectDoubleValue(input_->GetDoubleRegister(iterator->Next()));
+      return;
+
+    case Translation::STACK_SLOT: {
+      unsigned input_offset =
+          input_->GetOffsetFromSlotIndex(this, iterator->Next());
+      AddObjectValue(input_->GetFrameSlot(input_offset));
+      return;
+    }
+
+    case Translation::DOUBLE_STACK_SLOT: {
+      unsigned input_offset =
+          input_->GetOffsetFromSlotIndex(this, iterator->Next());
+      AddObjectDoubleValue(input_->GetDoubleFrameSlot(input_offset));
+      return;
+    }
+
+    case Translation::LITERAL:
+      AddObjectValue(
+          reinterpret_cast<intptr_t>(ComputeLiteral(iterator->Next())));
+      return;
   }
 }
 
@@ -818,6 +1018,7 @@ bool Deoptimizer::DoOsrTranslateCommand(TranslationIterator* iterator,
   switch (opcode) {
     case Translation::BEGIN:
     case Translation::FRAME:
+    case Translation::CONSTRUCT_STUB_FRAME:
     case Translation::DUPLICATE:
       UNREACHABLE();  // Malformed input.
        return false;
@@ -965,6 +1166,13 @@ bool Deoptimizer::DoOsrTranslateCommand(TranslationIterator* iterator,
       UNREACHABLE();
       return false;
     }
+
+    case Translation::CAPTURED_OBJECT: {
+      // Captured objects are never live at an OSR entry, whose values all
+      // come from the unoptimized frame.
+      UNREACHABLE();
+      return false;
+    }
   }
 
   if (!duplicate) *input_offset -= kPointerSize;
@@ -1068,12 +1276,26 @@ Object* Deoptimizer::ComputeLiteral(int index) const {
 
 void Deoptimizer::AddDoubleValue(intptr_t slot_address,
                                  double value) {
-  HeapNumberMaterializationDescriptor value_desc(
+  HeapNumberMaterializationDescriptor<Address> value_desc(
       reinterpret_cast<Address>(slot_address), value);
   deferred_heap_numbers_.Add(value_desc);
 }
 
 
+void Deoptimizer::AddObjectValue(intptr_t value) {
+  deferred_object_values_.Add(value);
+}
+
+
+void Deoptimizer::AddObjectDoubleValue(double value) {
+  // A GC-safe placeholder that is replaced by the heap number.
+  deferred_object_values_.Add(reinterpret_cast<intptr_t>(Smi::FromInt(0)));
+  HeapNumberMaterializationDescriptor<int> value_desc(
+      deferred_object_values_.length() - 1, value);
+  deferred_object_numbers_.Add(value_desc);
+}
+
+
 MemoryChunk* Deoptimizer::CreateCode(BailoutType type) {
   // We cannot run this if the serializer is enabled because this will
   // cause us to emit relocation information for the external
@@ -1145,7 +1367,8 @@ FrameDescription::FrameDescription(uint32_t frame_size,
       function_(function),
       top_(kZapUint32),
       pc_(kZapUint32),
-      fp_(kZapUint32) {
+      fp_(kZapUint32),
+      type_(StackFrame::JAVA_SCRIPT) {
   // Zap all the registers.
   for (int r = 0; r < Register::kNumRegisters; r++) {
     SetRegister(r, kZapUint32);
@@ -1254,6 +1477,13 @@ void Translation::BeginFrame(int node_id, int literal_id, unsigned height) {
 }
 
 
+void Translation::BeginConstructStubFrame(int literal_id, unsigned height) {
+  buffer_->Add(CONSTRUCT_STUB_FRAME);
+  buffer_->Add(literal_id);
+  buffer_->Add(height);
+}
+
+
 void Translation::StoreRegister(Register reg) {
   buffer_->Add(REGISTER);
   buffer_->Add(reg.code());
@@ -1301,6 +1531,13 @@ void Translation::StoreArgumentsObject() {
 }
 
 
+void Translation::BeginCapturedObject(int object_id, int length) {
+  buffer_->Add(CAPTURED_OBJECT);
+  buffer_->Add(object_id);
+  buffer_->Add(length);
+}
+
+
 void Translation::MarkDuplicate() {
   buffer_->Add(DUPLICATE);
 }
@@ -1311,7 +1548,6 @@ int Translation::NumberOfOperandsFor(Opcode opcode) {
     case ARGUMENTS_OBJECT:
     case DUPLICATE:
       return 0;
-    case BEGIN:
     case REGISTER:
     case INT32_REGISTER:
     case DOUBLE_REGISTER:
@@ -1320,6 +1556,10 @@ int Translation::NumberOfOperandsFor(Opcode opcode) {
     case DOUBLE_STACK_SLOT:
     case LITERAL:
       return 1;
+    case BEGIN:
+    case CONSTRUCT_STUB_FRAME:
+    case CAPTURED_OBJECT:
+      return 2;
     case FRAME:
       return 3;
   }
@@ -1336,6 +1576,8 @@ const char* Translation::StringFor(Opcode opcode) {
       return "BEGIN";
     case FRAME:
       return "FRAME";
+    case CONSTRUCT_STUB_FRAME:
+      return "CONSTRUCT_STUB_FRAME";
     case REGISTER:
       return "REGISTER";
     case INT32_REGISTER:
@@ -1352,6 +1594,8 @@ const char* Translation::StringFor(Opcode opcode) {
       return "LITERAL";
     case ARGUMENTS_OBJECT:
       return "ARGUMENTS_OBJECT";
+    case CAPTURED_OBJECT:
+      return "CAPTURED_OBJECT";
     case DUPLICATE:
       return "DUPLICATE";
   }
@@ -1390,6 +1634,7 @@ SlotRef SlotRef::ComputeSlotForNextArgument(TranslationIterator* iterator,
   switch (opcode) {
     case Translation::BEGIN:
     case Translation::FRAME:
+    case Translation::CONSTRUCT_STUB_FRAME:
       // Peeled off before getting here.
       break;
 
@@ -1397,6 +1642,10 @@ SlotRef SlotRef::ComputeSlotForNextArgument(TranslationIterator* iterator,
       // This can be only emitted for local slots not for argument slots.
       break;
 
+    case Translation::CAPTURED_OBJECT:
+      // Objects passed to inlined functions are never captured.
+      break;
+
     case Translation::REGISTER:
     case Translation::INT32_REGISTER:
     case Translation::DOUBLE_REGISTER:
@@ -1436,7 +1685,7 @@ SlotRef SlotRef::ComputeSlotForNextArgument(TranslationIterator* iterator,
 
 
 void SlotRef::ComputeSlotMappingForArguments(JavaScriptFrame* frame,
-                                             int inlined_frame_index,
+                                             int inlined_jsframe_index,
                                              Vector<SlotRef>* args_slots) {
   AssertNoAllocation no_gc;
   int deopt_index = AstNode::kNoNumber;
@@ -1446,16 +1695,17 @@ void SlotRef::ComputeSlotMappingForArguments(JavaScriptFrame* frame,
                          data->TranslationIndex(deopt_index)->value());
   Translation::Opcode opcode = static_cast<Translation::Opcode>(it.Next());
   ASSERT(opcode == Translation::BEGIN);
-  int frame_count = it.Next();
-  USE(frame_count);
-  ASSERT(frame_count > inlined_frame_index);
-  int frames_to_skip = inlined_frame_index;
+  it.Next();  // Drop frame count.
+  int jsframe_count = it.Next();
+  USE(jsframe_count);
+  ASSERT(jsframe_count > inlined_jsframe_index);
+  int jsframes_to_skip = inlined_jsframe_index;
   while (true) {
     opcode = static_cast<Translation::Opcode>(it.Next());
     // Skip over operands to advance to the next opcode.
     it.Skip(Translation::NumberOfOperandsFor(opcode));
     if (opcode == Translation::FRAME) {
-      if (frames_to_skip == 0) {
+      if (jsframes_to_skip == 0) {
         // We reached the frame corresponding to the inlined function
         // in question.  Process the translation commands for the
         // arguments.
@@ -1469,7 +1719,7 @@ void SlotRef::ComputeSlotMappingForArguments(JavaScriptFrame* frame,
         }
         return;
       }
-      frames_to_skip--;
+      jsframes_to_skip--;
     }
   }
 
@@ -43,20 +43,40 @@ class TranslationIterator;
 class DeoptimizingCodeListNode;
 class DeoptimizedFrameInfo;
 
+// The destination of a heap number is either the address of a frame slot or
+// the index of a field value of a captured object.
+template<typename T>
 class HeapNumberMaterializationDescriptor BASE_EMBEDDED {
  public:
-  HeapNumberMaterializationDescriptor(Address slot_address, double val)
-      : slot_address_(slot_address), val_(val) { }
+  HeapNumberMaterializationDescriptor(T destination, double val)
+      : destination_(destination), val_(val) { }
 
-  Address slot_address() const { return slot_address_; }
+  T destination() const { return destination_; }
   double value() const { return val_; }
 
  private:
-  Address slot_address_;
+  T destination_;
   double val_;
 };
 
 
+class ObjectMaterializationDescriptor BASE_EMBEDDED {
+ public:
+  ObjectMaterializationDescriptor(Address slot_address, int id, int length)
+      : slot_address_(slot_address), id_(id), length_(length) { }
+
+  Address slot_address() const { return slot_address_; }
+  int id() const { return id_; }
+  // Number of field values, starting with the boilerplate.
+  int length() const { return length_; }
+
+ private:
+  Address slot_address_;
+  int id_;
+  int length_;
+};
+
+
 class OptimizedFunctionVisitor BASE_EMBEDDED {
  public:
   virtual ~OptimizedFunctionVisitor() {}
@@ -119,6 +139,9 @@ class Deoptimizer : public Malloced {
 
   int output_count() const { return output_count_; }
 
+  // Number of created JS frames. Not all created frames are necessarily JS.
+  int jsframe_count() const { return jsframe_count_; }
+
   static Deoptimizer* New(JSFunction* function,
                           BailoutType type,
                           unsigned bailout_id,
@@ -131,7 +154,7 @@ class Deoptimizer : public Malloced {
   // The returned object with information on the optimized frame needs to be
   // freed before another one can be generated.
   static DeoptimizedFrameInfo* DebuggerInspectableFrame(JavaScriptFrame* frame,
-                                                        int frame_index,
+                                                        int jsframe_index,
                                                         Isolate* isolate);
   static void DeleteDebuggerInspectableFrame(DeoptimizedFrameInfo* info,
                                              Isolate* isolate);
@@ -192,9 +215,9 @@ class Deoptimizer : public Malloced {
 
   ~Deoptimizer();
 
-  void MaterializeHeapNumbers();
+  void MaterializeHeapObjects();
 #ifdef ENABLE_DEBUGGER_SUPPORT
-  void MaterializeHeapNumbersForDebuggerInspectableFrame(
+  void MaterializeHeapObjectsForDebuggerInspectableFrame(
       Address top, uint32_t size, DeoptimizedFrameInfo* info);
 #endif
 
@@ -268,12 +291,21 @@ class Deoptimizer : public Malloced {
               Code* optimized_code);
   void DeleteFrameDescriptions();
 
+  // Map an index among the output JS frames to an index among all output
+  // frames, skipping the construct stub frames in between.
+  int ConvertJSFrameIndexToFrameIndex(int jsframe_index);
+
   void DoComputeOutputFrames();
   void DoComputeOsrOutputFrame();
   void DoComputeFrame(TranslationIterator* iterator, int frame_index);
+  void DoComputeConstructStubFrame(TranslationIterator* iterator,
+                                   int frame_index);
   void DoTranslateCommand(TranslationIterator* iterator,
                           int frame_index,
                           unsigned output_offset);
+  // Translate the command for one field of a captured object and record its
+  // value in deferred_object_values_.
+  void DoTranslateObjectField(TranslationIterator* iterator);
   // Translate a command for OSR.  Updates the input offset to be used for
   // the next command.  Returns false if translation of the command failed
   // (e.g., a number conversion failed) and may or may not have updated the
@@ -290,6 +322,22 @@ class Deoptimizer : public Malloced {
   Object* ComputeLiteral(int index) const;
 
   void AddDoubleValue(intptr_t slot_address, double value);
+  void AddObjectValue(intptr_t value);
+  void AddObjectDoubleValue(double value);
+
+  // Allocate the objects captured by the translation.  Must be called before
+  // anything else is allocated, since the recorded field values are not
+  // visited by the GC.
+  void MaterializeDeferredObjects(List<Handle<Object> >* objects);
+
+#ifdef ENABLE_DEBUGGER_SUPPORT
+  // Store a materialized value in the slot of the frame being inspected.
+  static void SetDebuggerFrameSlot(DeoptimizedFrameInfo* info,
+                                   Address top,
+                                   uint32_t size,
+                                   Address slot,
+                                   Object* value);
+#endif
 
   static MemoryChunk* CreateCode(BailoutType type);
   static void GenerateDeoptimizationEntries(
@@ -318,6 +366,8 @@ class Deoptimizer : public Malloced {
   FrameDescription* input_;
   // Number of output frames.
   int output_count_;
+  // Number of output js frames.
+  int jsframe_count_;
   // Array of output frame descriptions.
   FrameDescription** output_;
 
@@ -325,7 +375,14 @@ class Deoptimizer : public Malloced {
   Object* frame_alignment_marker_;
   intptr_t has_alignment_padding_;
 
-  List<HeapNumberMaterializationDescriptor> deferred_heap_numbers_;
+  List<HeapNumberMaterializationDescriptor<Address> > deferred_heap_numbers_;
+
+  // Objects that were scalar replaced in the optimized code, and the values
+  // of their fields in order.  Untagged field values are stored as a
+  // placeholder and recorded with their index in deferred_object_numbers_.
+  List<ObjectMaterializationDescriptor> deferred_objects_;
+  List<intptr_t> deferred_object_values_;
+  List<HeapNumberMaterializationDescriptor<int> > deferred_object_numbers_;
 
   static const int table_entry_size_;
 
@@ -409,6 +466,9 @@ class FrameDescription {
 
   void SetContinuation(intptr_t pc) { continuation_ = pc; }
 
+  StackFrame::Type GetFrameType() const { return type_; }
+  void SetFrameType(StackFrame::Type type) { type_ = type; }
+
 #ifdef DEBUG
   Code::Kind GetKind() const { return kind_; }
   void SetKind(Code::Kind kind) { kind_ = kind; }
@@ -468,6 +528,7 @@ class FrameDescription {
   intptr_t pc_;
   intptr_t fp_;
   Smi* state_;
+  StackFrame::Type type_;
 #ifdef DEBUG
   Code::Kind kind_;
 #endif
@@ -528,6 +589,7 @@ class Translation BASE_EMBEDDED {
   enum Opcode {
     BEGIN,
     FRAME,
+    CONSTRUCT_STUB_FRAME,
     REGISTER,
     INT32_REGISTER,
     DOUBLE_REGISTER,
@@ -536,23 +598,29 @@ class Translation BASE_EMBEDDED {
     DOUBLE_STACK_SLOT,
     LITERAL,
     ARGUMENTS_OBJECT,
+    // An object that was not allocated by the optimized code.  The operands
+    // are an object id and the number of field commands that follow, the
+    // first of which is the map.
+    CAPTURED_OBJECT,
 
     // A prefix indicating that the next command is a duplicate of the one
     // that follows it.
     DUPLICATE
   };
 
-  Translation(TranslationBuffer* buffer, int frame_count)
+  Translation(TranslationBuffer* buffer, int frame_count, int jsframe_count)
       : buffer_(buffer),
         index_(buffer->CurrentIndex()) {
     buffer_->Add(BEGIN);
     buffer_->Add(frame_count);
+    buffer_->Add(jsframe_count);
   }
 
   int index() const { return index_; }
 
   // Commands.
   void BeginFrame(int node_id, int literal_id, unsigned height);
+  void BeginConstructStubFrame(int literal_id, unsigned height);
   void StoreRegister(Register reg);
   void StoreInt32Register(Register reg);
   void StoreDoubleRegister(DoubleRegister reg);
@@ -561,6 +629,7 @@ class Translation BASE_EMBEDDED {
   void StoreDoubleStackSlot(int index);
   void StoreLiteral(int literal_id);
   void StoreArgumentsObject();
+  void BeginCapturedObject(int object_id, int length);
   void MarkDuplicate();
 
   static int NumberOfOperandsFor(Opcode opcode);
@@ -643,7 +712,7 @@ class SlotRef BASE_EMBEDDED {
   }
 
   static void ComputeSlotMappingForArguments(JavaScriptFrame* frame,
-                                             int inlined_frame_index,
+                                             int inlined_jsframe_index,
                                              Vector<SlotRef>* args_slots);
 
  private:
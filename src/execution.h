@@ -42,7 +42,8 @@ enum InterruptFlag {
   PREEMPT = 1 << 3,
   TERMINATE = 1 << 4,
   RUNTIME_PROFILER_TICK = 1 << 5,
-  GC_REQUEST = 1 << 6
+  GC_REQUEST = 1 << 6,
+  INSTALL_CODE = 1 << 7
 };
 
 class Execution : public AllStatic {
@@ -199,6 +200,8 @@ class StackGuard {
 #endif
   bool IsGCRequest();
   void RequestGC();
+  bool IsInstallCodeRequest();
+  void RequestInstallCode();
   void Continue(InterruptFlag after_what);
 
   // This provides an asynchronous read of the stack limits for the current
@@ -894,6 +894,13 @@ Handle<JSObject> Factory::NewJSObjectFromMap(Handle<Map> map) {
 }
 
 
+Handle<JSObject> Factory::CopyJSObject(Handle<JSObject> object) {
+  CALL_HEAP_FUNCTION(isolate(),
+                     isolate()->heap()->CopyJSObject(*object),
+                     JSObject);
+}
+
+
 Handle<JSArray> Factory::NewJSArray(int capacity,
                                     PretenureFlag pretenure) {
   Handle<JSObject> obj = NewJSObject(isolate()->array_function(), pretenure);
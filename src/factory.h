@@ -247,6 +247,9 @@ class Factory {
   // runtime.
   Handle<JSObject> NewJSObjectFromMap(Handle<Map> map);
 
+  // Copies the object, including its properties and elements.
+  Handle<JSObject> CopyJSObject(Handle<JSObject> object);
+
   // JS arrays are pretenured when allocated by the parser.
   Handle<JSArray> NewJSArray(int capacity,
                              PretenureFlag pretenure = NOT_TENURED);
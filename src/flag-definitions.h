@@ -127,10 +127,23 @@ DEFINE_bool(use_range, true, "use hydrogen range analysis")
 DEFINE_bool(eliminate_dead_phis, true, "eliminate dead phis")
 DEFINE_bool(use_gvn, true, "use hydrogen global value numbering")
 DEFINE_bool(use_canonicalizing, true, "use hydrogen instruction canonicalizing")
+DEFINE_bool(use_load_store_elimination, true,
+            "use field sensitive load forwarding and dead store elimination")
+DEFINE_bool(use_escape_analysis, true,
+            "replace object literals that do not escape by their fields")
 DEFINE_bool(use_inlining, true, "use function inlining")
 DEFINE_bool(limit_inlining, true, "limit code size growth from inlining")
+DEFINE_bool(inline_construct, true, "inline constructor calls")
 DEFINE_bool(eliminate_empty_blocks, true, "eliminate empty blocks")
 DEFINE_bool(loop_invariant_code_motion, true, "loop invariant code motion")
+DEFINE_bool(eliminate_write_barriers, true,
+            "omit write barriers for stores into freshly allocated objects")
+DEFINE_bool(array_bounds_checks_elimination, true,
+            "remove and merge redundant array bounds checks")
+DEFINE_bool(concurrent_recompilation, false,
+            "optimize hot functions on a separate thread")
+DEFINE_int(concurrent_recompilation_queue_length, 8,
+           "maximum number of functions queued for optimization")
 DEFINE_bool(hydrogen_stats, false, "print statistics for hydrogen")
 DEFINE_bool(trace_hydrogen, false, "trace generated hydrogen to file")
 DEFINE_bool(trace_inlining, false, "trace inlining decisions")
@@ -248,6 +261,11 @@ DEFINE_bool(always_inline_smi_code, false,
 DEFINE_int(max_new_space_size, 0, "max size of the new generation (in kBytes)")
 DEFINE_int(max_old_space_size, 0, "max size of the old generation (in Mbytes)")
 DEFINE_int(max_executable_size, 0, "max size of executable memory (in Mbytes)")
+DEFINE_int(max_gc_pause, 0,
+           "goal for the longest garbage collection pause (in ms, 0 for none)")
+DEFINE_int(max_gc_time_percentage, 0,
+           "goal for the share of time spent in garbage collection "
+           "(in percent, 0 for none)")
 DEFINE_bool(gc_global, false, "always perform global GCs")
 DEFINE_int(gc_interval, -1, "garbage collect after <n> allocations")
 DEFINE_bool(trace_gc, false,
@@ -260,7 +278,34 @@ DEFINE_bool(print_cumulative_gc_stat, false,
 DEFINE_bool(trace_gc_verbose, false,
             "print more details following each garbage collection")
 DEFINE_bool(trace_fragmentation, false,
-            "report fragmentation for old pointer and data pages")
+            "report fragmentation for old pointer and data pages and "
+            "free lists")
+DEFINE_bool(allocation_site_pretenuring, true,
+            "pretenure objects allocated at sites whose objects survive "
+            "scavenges")
+DEFINE_bool(trace_pretenuring, false,
+            "trace pretenuring decisions of allocation sites")
+DEFINE_bool(cache_large_pages, true,
+            "keep recently freed large object pages mapped for reuse")
+DEFINE_bool(transparent_huge_pages, false,
+            "advise the OS to back new space and heap chunks of 2MB or more "
+            "with transparent huge pages")
+DEFINE_bool(prefault_semi_spaces, false,
+            "fault in the pages of new space when they are committed")
+DEFINE_bool(memory_reducer, true,
+            "give unused heap memory back to the OS after a quiet period")
+DEFINE_int(memory_reducer_quiet_period, 1000,
+           "milliseconds between collections after which the memory "
+           "reducer runs")
+DEFINE_bool(queue_weak_callbacks, false,
+            "queue weak global handle callbacks instead of invoking them at "
+            "the end of the GC and dispatch them when idle")
+DEFINE_int(weak_callbacks_per_slice, 100,
+           "number of queued weak callbacks dispatched between deadline "
+           "checks")
+DEFINE_bool(heap_snapshot_background_aggregation, false,
+            "compute dominators and retained sizes of heap snapshots on a "
+            "background thread")
 DEFINE_bool(collect_maps, true,
             "garbage collect maps from which no objects can be reached")
 DEFINE_bool(flush_code, true,
@@ -269,6 +314,11 @@ DEFINE_bool(incremental_marking, true, "use incremental marking")
 DEFINE_bool(incremental_marking_steps, true, "do incremental marking steps")
 DEFINE_bool(trace_incremental_marking, false,
             "trace progress of the incremental marking")
+DEFINE_bool(parallel_scavenge, false,
+            "use helper threads to copy live objects during scavenges")
+DEFINE_int(scavenge_threads, 4,
+           "number of threads (including the main thread) used for "
+           "parallel scavenges")
 
 // v8.cc
 DEFINE_bool(use_idle_notification, true,
@@ -290,11 +340,24 @@ DEFINE_bool(native_code_counters, false,
 DEFINE_bool(always_compact, false, "Perform compaction on every full GC")
 DEFINE_bool(lazy_sweeping, true,
             "Use lazy sweeping for old pointer and data spaces")
+DEFINE_bool(concurrent_sweeping, false,
+            "Sweep old pointer and data space pages on a background thread")
 DEFINE_bool(cleanup_caches_in_maps_at_gc, true,
             "Flush code caches in maps during mark compact cycle.")
 DEFINE_bool(never_compact, false,
             "Never perform compaction on full GC - testing only")
 DEFINE_bool(compact_code_space, false, "Compact code space")
+DEFINE_bool(parallel_marking, false,
+            "use helper threads to mark live objects during full GC")
+DEFINE_int(marking_threads, 4,
+           "number of threads (including the main thread) used for "
+           "parallel marking")
+DEFINE_bool(parallel_compaction, false,
+            "use helper threads to evacuate pages and update pointers "
+            "during compaction")
+DEFINE_int(compaction_threads, 4,
+           "number of threads (including the main thread) used for "
+           "parallel compaction")
 DEFINE_bool(cleanup_code_caches_at_gc, true,
             "Flush inline caches prior to mark compact collection and "
             "flush code caches in maps during mark compact cycle.")
@@ -289,6 +289,19 @@ class GlobalHandles::NodeBlock {
     }
   }
 
+  // Links the free nodes of this block in front of the given free list,
+  // lowest index first, so that allocation fills the block in order.
+  void PutFreeNodesOnFreeList(Node** first_free) {
+    for (int i = kSize - 1; i >= 0; --i) {
+      Node* node = &nodes_[i];
+      if (node->state() != Node::FREE) continue;
+      node->set_next_free(*first_free);
+      *first_free = node;
+    }
+  }
+
+  bool IsEmpty() const { return used_nodes_ == 0; }
+
   Node* node_at(int index) {
     ASSERT(0 <= index && index < kSize);
     return &nodes_[index];
@@ -319,6 +332,7 @@ class GlobalHandles::NodeBlock {
 
   // Next block in the list of all blocks.
   NodeBlock* next() const { return next_; }
+  void set_next(NodeBlock* next) { next_ = next; }
 
   // Next/previous block in the list of blocks with used nodes.
   NodeBlock* next_used() const { return next_used_; }
@@ -326,7 +340,7 @@ class GlobalHandles::NodeBlock {
 
  private:
   Node nodes_[kSize];
-  NodeBlock* const next_;
+  NodeBlock* next_;
   int used_nodes_;
   NodeBlock* next_used_;
   NodeBlock* prev_used_;
@@ -387,7 +401,7 @@ GlobalHandles::GlobalHandles(Isolate* isolate)
       first_block_(NULL),
       first_used_block_(NULL),
       first_free_(NULL),
-      post_gc_processing_count_(0) {}
+      dispatch_depth_(0) {}
 
 
 GlobalHandles::~GlobalHandles() {
@@ -481,6 +495,7 @@ void GlobalHandles::IdentifyWeakHandles(WeakSlotCallback f) {
   for (NodeIterator it(this); !it.done(); it.Advance()) {
     if (it.node()->IsWeak() && f(it.node()->location())) {
       it.node()->MarkPending();
+      pending_nodes_.Add(it.node());
     }
   }
 }
@@ -505,6 +520,7 @@ void GlobalHandles::IdentifyNewSpaceWeakIndependentHandles(
     if (node->is_independent() && node->IsWeak() &&
         f(isolate_->heap(), node->location())) {
       node->MarkPending();
+      pending_nodes_.Add(node);
     }
   }
 }
@@ -527,41 +543,10 @@ bool GlobalHandles::PostGarbageCollectionProcessing(
   // GC is completely done, because the callbacks may invoke arbitrary
   // API functions.
   ASSERT(isolate_->heap()->gc_state() == Heap::NOT_IN_GC);
-  const int initial_post_gc_processing_count = ++post_gc_processing_count_;
   bool next_gc_likely_to_collect_more = false;
-  if (collector == SCAVENGER) {
-    for (int i = 0; i < new_space_nodes_.length(); ++i) {
-      Node* node = new_space_nodes_[i];
-      ASSERT(node->is_in_new_space_list());
-      // Skip dependent handles. Their weak callbacks might expect to be
-      // called between two global garbage collection callbacks which
-      // are not called for minor collections.
-      if (!node->is_independent()) continue;
-      if (node->PostGarbageCollectionProcessing(isolate_, this)) {
-        if (initial_post_gc_processing_count != post_gc_processing_count_) {
-          // Weak callback triggered another GC and another round of
-          // PostGarbageCollection processing.  The current node might
-          // have been deleted in that round, so we need to bail out (or
-          // restart the processing).
-          return next_gc_likely_to_collect_more;
-        }
-      }
-      if (!node->IsRetainer()) {
-        next_gc_likely_to_collect_more = true;
-      }
-    }
-  } else {
-    for (NodeIterator it(this); !it.done(); it.Advance()) {
-      if (it.node()->PostGarbageCollectionProcessing(isolate_, this)) {
-        if (initial_post_gc_processing_count != post_gc_processing_count_) {
-          // See the comment above.
-          return next_gc_likely_to_collect_more;
-        }
-      }
-      if (!it.node()->IsRetainer()) {
-        next_gc_likely_to_collect_more = true;
-      }
-    }
+  if (!FLAG_queue_weak_callbacks) {
+    next_gc_likely_to_collect_more =
+        DispatchWeakCallbacks(collector, kMaxInt) > 0;
   }
   // Update the list of new space nodes.
   int last = 0;
@@ -575,10 +560,96 @@ bool GlobalHandles::PostGarbageCollectionProcessing(
     }
   }
   new_space_nodes_.Rewind(last);
+  if (collector == MARK_COMPACTOR) ReleaseEmptyBlocks();
   return next_gc_likely_to_collect_more;
 }
 
 
+int GlobalHandles::DispatchPendingWeakCallbacks(int max_callbacks) {
+  ASSERT(isolate_->heap()->gc_state() == Heap::NOT_IN_GC);
+  return DispatchWeakCallbacks(MARK_COMPACTOR, max_callbacks);
+}
+
+
+int GlobalHandles::DispatchWeakCallbacks(GarbageCollector collector,
+                                         int max_callbacks) {
+  if (pending_nodes_.is_empty()) return 0;
+  // Only nodes marked pending by a GC can have callbacks to dispatch, so
+  // they are processed as one batch instead of walking all nodes.  The
+  // batch is taken off the pending list because a callback may trigger
+  // another GC which marks more nodes pending.  Blocks are not released
+  // while a batch is dispatched, so its nodes stay valid even if a
+  // callback destroys them.
+  List<Node*> batch(pending_nodes_.length());
+  batch.AddAll(pending_nodes_);
+  pending_nodes_.Rewind(0);
+  dispatch_depth_++;
+  int released = 0;
+  int dispatched = 0;
+  for (int i = 0; i < batch.length(); ++i) {
+    Node* node = batch[i];
+    if (node->state() != Node::PENDING) continue;
+    // Dependent handles stay pending during scavenges.  Their weak
+    // callbacks might expect to be called between two global garbage
+    // collection callbacks which are not called for minor collections.
+    if (dispatched == max_callbacks ||
+        (collector == SCAVENGER && !node->is_independent())) {
+      pending_nodes_.Add(node);
+      continue;
+    }
+    dispatched++;
+    node->PostGarbageCollectionProcessing(isolate_, this);
+    if (!node->IsRetainer()) released++;
+  }
+  dispatch_depth_--;
+  return released;
+}
+
+
+void GlobalHandles::ReleaseEmptyBlocks() {
+  // A GC triggered by a weak callback must not free the block of the node
+  // whose callback is running, nor the blocks of the rest of its batch,
+  // which the dispatch loop still reads after the callbacks return.
+  // Queued nodes are still referenced from the pending list.
+  if (dispatch_depth_ > 0 || !pending_nodes_.is_empty()) return;
+  int empty_blocks = 0;
+  for (NodeBlock* block = first_block_; block != NULL; block = block->next()) {
+    if (block->IsEmpty()) empty_blocks++;
+  }
+  if (empty_blocks <= kMaxEmptyBlocks) return;
+
+  // Free nodes of the released blocks are scattered over the free list,
+  // so rebuild it from the blocks that stay.  Empty blocks are not on the
+  // used block list and none of their nodes can be referenced from the
+  // new space or pending node lists at this point.
+  first_free_ = NULL;
+  NodeBlock* survivors = NULL;
+  NodeBlock* block = first_block_;
+  while (block != NULL) {
+    NodeBlock* next = block->next();
+    if (block->IsEmpty() && empty_blocks > kMaxEmptyBlocks) {
+      delete block;
+      empty_blocks--;
+    } else {
+      block->set_next(survivors);
+      survivors = block;
+      block->PutFreeNodesOnFreeList(&first_free_);
+    }
+    block = next;
+  }
+  first_block_ = survivors;
+}
+
+
+int GlobalHandles::NumberOfNodeBlocks() {
+  int count = 0;
+  for (NodeBlock* block = first_block_; block != NULL; block = block->next()) {
+    count++;
+  }
+  return count;
+}
+
+
 void GlobalHandles::IterateStrongRoots(ObjectVisitor* v) {
   for (NodeIterator it(this); !it.done(); it.Advance()) {
     if (it.node()->IsStrongRetainer()) {
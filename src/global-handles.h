@@ -36,10 +36,9 @@ namespace v8 {
 namespace internal {
 
 // Structure for tracking global handles.
-// A single list keeps all the allocated global handles.
-// Destroyed handles stay in the list but is added to the free list.
-// At GC the destroyed global handles are removed from the free list
-// and deallocated.
+// Global handles are allocated in blocks of nodes.  Destroyed handles stay
+// in their block and are added to the free list.  After a full GC blocks
+// that contain no live handles are deallocated.
 
 // An object group is treated like a single JS object: if one of object in
 // the group is alive, all objects in the same group are considered alive.
@@ -137,6 +136,9 @@ class GlobalHandles {
 
   void RecordStats(HeapStats* stats);
 
+  // Returns the number of allocated node blocks, used or not.
+  int NumberOfNodeBlocks();
+
   // Returns the current number of weak handles to global objects.
   // These handles are also included in NumberOfWeakHandles().
   int NumberOfGlobalObjectWeakHandles() {
@@ -155,10 +157,18 @@ class GlobalHandles {
   // Tells whether global handle is weak.
   static bool IsWeak(Object** location);
 
-  // Process pending weak handles.
+  // Process pending weak handles.  With --queue-weak-callbacks the
+  // callbacks stay queued until DispatchPendingWeakCallbacks is called.
   // Returns true if next major GC is likely to collect more garbage.
   bool PostGarbageCollectionProcessing(GarbageCollector collector);
 
+  // Returns the number of weak callbacks waiting to be dispatched.
+  int NumberOfPendingWeakCallbacks() { return pending_nodes_.length(); }
+
+  // Invokes at most max_callbacks queued weak callbacks.  Returns the
+  // number of handles that were released by their callbacks.
+  int DispatchPendingWeakCallbacks(int max_callbacks);
+
   // Iterates over all strong handles.
   void IterateStrongRoots(ObjectVisitor* v);
 
@@ -238,6 +248,18 @@ class GlobalHandles {
   class NodeBlock;
   class NodeIterator;
 
+  // Number of completely unused node blocks kept after a full GC so that
+  // handle churn does not keep allocating and freeing blocks.
+  static const int kMaxEmptyBlocks = 1;
+
+  // Frees node blocks without used nodes beyond kMaxEmptyBlocks. Does
+  // nothing while weak callbacks are pending or being dispatched.
+  void ReleaseEmptyBlocks();
+
+  // Invokes the callbacks of up to max_callbacks pending nodes and
+  // returns the number of nodes released by them.
+  int DispatchWeakCallbacks(GarbageCollector collector, int max_callbacks);
+
   Isolate* isolate_;
 
   // Field always containing the number of weak and near-death handles.
@@ -261,7 +283,12 @@ class GlobalHandles {
   // is accessed, some of the objects may have been promoted already.
   List<Node*> new_space_nodes_;
 
-  int post_gc_processing_count_;
+  // Contains the nodes marked pending by a GC whose weak callbacks have
+  // not been dispatched yet.
+  List<Node*> pending_nodes_;
+
+  // Number of weak callback batches being dispatched.
+  int dispatch_depth_;
 
   List<ObjectGroup*> object_groups_;
   List<ImplicitRefGroup*> implicit_ref_groups_;
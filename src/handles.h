@@ -161,6 +161,35 @@ class HandleScope {
 };
 
 
+class DeferredHandles;
+class HandleScopeImplementer;
+
+
+// A DeferredHandleScope puts the handles it creates into blocks of their
+// own. Detach() takes them off the handle scope stack and returns them as a
+// DeferredHandles object, which keeps them alive after the scope is left
+// until it is deleted. Used to hand a compilation over to another thread.
+class DeferredHandleScope {
+ public:
+  explicit DeferredHandleScope(Isolate* isolate);
+  // The DeferredHandles object returned stores the Handles created
+  // since the creation of this DeferredHandleScope. The Handles are
+  // alive as long as the DeferredHandles object is alive.
+  DeferredHandles* Detach();
+  ~DeferredHandleScope();
+
+ private:
+  Object** prev_limit_;
+  Object** prev_next_;
+  HandleScopeImplementer* impl_;
+
+#ifdef DEBUG
+  bool handles_detached_;
+  int prev_level_;
+#endif
+};
+
+
 // ----------------------------------------------------------------------------
 // Handle operations.
 // They might invoke garbage collection. The result is an handle to
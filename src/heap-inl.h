@@ -148,13 +148,14 @@ MaybeObject* Heap::AllocateTwoByteSymbol(Vector<const uc16> str,
   return answer;
 }
 
-MaybeObject* Heap::CopyFixedArray(FixedArray* src) {
-  return CopyFixedArrayWithMap(src, src->map());
+MaybeObject* Heap::CopyFixedArray(FixedArray* src, PretenureFlag pretenure) {
+  return CopyFixedArrayWithMap(src, src->map(), pretenure);
 }
 
 
-MaybeObject* Heap::CopyFixedDoubleArray(FixedDoubleArray* src) {
-  return CopyFixedDoubleArrayWithMap(src, src->map());
+MaybeObject* Heap::CopyFixedDoubleArray(FixedDoubleArray* src,
+                                        PretenureFlag pretenure) {
+  return CopyFixedDoubleArrayWithMap(src, src->map(), pretenure);
 }
 
 
@@ -199,7 +200,14 @@ MaybeObject* Heap::AllocateRaw(int size_in_bytes,
     ASSERT(MAP_SPACE == space);
     result = map_space_->AllocateRaw(size_in_bytes);
   }
-  if (result->IsFailure()) old_gen_exhausted_ = true;
+  if (result->IsFailure()) {
+    old_gen_exhausted_ = true;
+  } else if (allocation_sampler_ != NULL) {
+    // New space allocations are seen through the lowered new space limit.
+    AllocationSamplingStep(
+        size_in_bytes,
+        HeapObject::cast(result->ToObjectUnchecked())->address());
+  }
   return result;
 }
 
@@ -36,11 +36,16 @@ namespace internal {
 
 HeapProfiler::HeapProfiler()
     : snapshots_(new HeapSnapshotsCollection()),
-      next_snapshot_uid_(1) {
+      next_snapshot_uid_(1),
+      allocation_sampler_(NULL) {
 }
 
 
 HeapProfiler::~HeapProfiler() {
+  if (allocation_sampler_ != NULL) {
+    HEAP->StopAllocationSampling();
+    delete allocation_sampler_;
+  }
   delete snapshots_;
 }
 
@@ -86,6 +91,16 @@ HeapSnapshot* HeapProfiler::TakeSnapshot(String* name,
 }
 
 
+bool HeapProfiler::StreamSnapshot(String* name,
+                                  v8::OutputStream* stream,
+                                  v8::ActivityControl* control) {
+  ASSERT(Isolate::Current()->heap_profiler() != NULL);
+  return Isolate::Current()->heap_profiler()->StreamSnapshotImpl(name,
+                                                                 stream,
+                                                                 control);
+}
+
+
 void HeapProfiler::DefineWrapperClass(
     uint16_t class_id, v8::HeapProfiler::WrapperInfoCallback callback) {
   ASSERT(class_id != v8::HeapProfiler::kPersistentHandleNoClassId);
@@ -137,6 +152,26 @@ HeapSnapshot* HeapProfiler::TakeSnapshotImpl(String* name,
 }
 
 
+bool HeapProfiler::StreamSnapshotImpl(String* name,
+                                      v8::OutputStream* stream,
+                                      v8::ActivityControl* control) {
+  // The snapshot only provides the title, the uid and the ids map; it
+  // gets no entries and is not added to the collection.
+  HeapSnapshot* snapshot = snapshots_->NewSnapshot(
+      HeapSnapshot::kFull,
+      snapshots_->names()->GetName(name),
+      next_snapshot_uid_++);
+  bool completed;
+  {
+    HeapSnapshotStreamer streamer(snapshot, control);
+    completed = streamer.Stream(stream);
+  }
+  delete snapshot;
+  snapshots_->SnapshotGenerationFinished(NULL);
+  return completed;
+}
+
+
 int HeapProfiler::GetSnapshotsCount() {
   HeapProfiler* profiler = Isolate::Current()->heap_profiler();
   ASSERT(profiler != NULL);
@@ -165,6 +200,33 @@ void HeapProfiler::DeleteAllSnapshots() {
 }
 
 
+void HeapProfiler::StartHeapObjectSampling(int sample_interval) {
+  HeapProfiler* profiler = Isolate::Current()->heap_profiler();
+  ASSERT(profiler != NULL);
+  if (profiler->allocation_sampler_ != NULL) return;
+  profiler->allocation_sampler_ = new AllocationSampler(HEAP, sample_interval);
+  HEAP->StartAllocationSampling(profiler->allocation_sampler_);
+}
+
+
+void HeapProfiler::StopHeapObjectSampling() {
+  HeapProfiler* profiler = Isolate::Current()->heap_profiler();
+  ASSERT(profiler != NULL);
+  if (profiler->allocation_sampler_ == NULL) return;
+  HEAP->StopAllocationSampling();
+  delete profiler->allocation_sampler_;
+  profiler->allocation_sampler_ = NULL;
+}
+
+
+ProfileTree* HeapProfiler::GetHeapObjectSamples() {
+  HeapProfiler* profiler = Isolate::Current()->heap_profiler();
+  ASSERT(profiler != NULL);
+  if (profiler->allocation_sampler_ == NULL) return NULL;
+  return profiler->allocation_sampler_->tree();
+}
+
+
 void HeapProfiler::ObjectMoveEvent(Address from, Address to) {
   snapshots_->ObjectMoveEvent(from, to);
 }
@@ -33,8 +33,10 @@
 namespace v8 {
 namespace internal {
 
+class AllocationSampler;
 class HeapSnapshot;
 class HeapSnapshotsCollection;
+class ProfileTree;
 
 #define HEAP_PROFILE(heap, call)                                             \
   do {                                                                       \
@@ -57,11 +59,23 @@ class HeapProfiler {
   static HeapSnapshot* TakeSnapshot(String* name,
                                     int type,
                                     v8::ActivityControl* control);
+  // Writes a snapshot to the stream without keeping it, see
+  // HeapSnapshotStreamer.  Returns false if streaming was aborted.
+  static bool StreamSnapshot(String* name,
+                             v8::OutputStream* stream,
+                             v8::ActivityControl* control);
   static int GetSnapshotsCount();
   static HeapSnapshot* GetSnapshot(int index);
   static HeapSnapshot* FindSnapshot(unsigned uid);
   static void DeleteAllSnapshots();
 
+  // Sampling of heap allocations, see AllocationSampler.  The tree of
+  // samples is deleted when sampling is stopped.
+  static void StartHeapObjectSampling(int sample_interval);
+  static void StopHeapObjectSampling();
+  // Returns NULL if sampling is not active.
+  static ProfileTree* GetHeapObjectSamples();
+
   void ObjectMoveEvent(Address from, Address to);
 
   void DefineWrapperClass(
@@ -82,10 +96,14 @@ class HeapProfiler {
   HeapSnapshot* TakeSnapshotImpl(String* name,
                                  int type,
                                  v8::ActivityControl* control);
+  bool StreamSnapshotImpl(String* name,
+                          v8::OutputStream* stream,
+                          v8::ActivityControl* control);
   void ResetSnapshots();
 
   HeapSnapshotsCollection* snapshots_;
   unsigned next_snapshot_uid_;
+  AllocationSampler* allocation_sampler_;
   List<v8::HeapProfiler::WrapperInfoCallback> wrapper_callbacks_;
 };
 
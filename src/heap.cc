@@ -42,6 +42,8 @@
 #include "natives.h"
 #include "objects-visiting.h"
 #include "objects-visiting-inl.h"
+#include "optimizing-compiler-thread.h"
+#include "profile-generator.h"
 #include "runtime-profiler.h"
 #include "scopeinfo.h"
 #include "snapshot.h"
@@ -137,13 +139,23 @@ Heap::Heap()
       min_in_mutator_(kMaxInt),
       alive_after_last_gc_(0),
       last_gc_end_timestamp_(0.0),
+      memory_reducer_last_gc_ms_(0.0),
+      max_pause_goal_ms_(0),
+      max_gc_time_percentage_goal_(0),
+      scavenge_speed_(0),
+      marking_speed_(0),
+      idle_finalization_time_ms_(0.0),
+      gc_time_ratio_(0.0),
       store_buffer_(this),
       marking_(this),
       incremental_marking_(this),
       number_idle_notifications_(0),
       last_idle_notification_gc_count_(0),
       last_idle_notification_gc_count_init_(false),
+      parallel_scavenger_(NULL),
       configured_(false),
+      allocation_site_feedback_(this),
+      allocation_sampler_(NULL),
       chunks_queued_for_free_(NULL) {
   // Allow build-time customization of the max semispace size. Building
   // V8 with snapshots and a non-default max semispace size is much
@@ -359,8 +371,16 @@ void Heap::ReportStatisticsAfterGC() {
 
 
 void Heap::GarbageCollectionPrologue() {
+  // New space is iterated up to its top.
+  new_space_.RetireAllocationBuffer();
+  // Both collectors iterate old space pages, so they have to be taken back
+  // from the concurrent sweeper first.
+  mark_compact_collector()->WaitUntilSweepingCompleted();
   isolate_->transcendental_cache()->Clear();
   ClearJSFunctionResultCaches();
+  if (allocation_sampler_ != NULL) {
+    allocation_sampler_->GarbageCollectionPrologue();
+  }
   gc_count_++;
   unflattened_strings_length_ = 0;
 #ifdef DEBUG
@@ -448,15 +468,120 @@ void Heap::CollectAllAvailableGarbage() {
   // Therefore stop recollecting after several attempts.
   mark_compact_collector()->SetFlags(kMakeHeapIterableMask);
   const int kMaxNumberOfAttempts = 7;
+  GlobalHandles* global_handles = isolate_->global_handles();
   for (int attempt = 0; attempt < kMaxNumberOfAttempts; attempt++) {
-    if (!CollectGarbage(OLD_POINTER_SPACE, MARK_COMPACTOR)) {
+    // Queued weak callbacks are due now, their handles keep garbage alive.
+    if (!CollectGarbage(OLD_POINTER_SPACE, MARK_COMPACTOR) &&
+        global_handles->DispatchPendingWeakCallbacks(kMaxInt) == 0) {
       break;
     }
   }
   mark_compact_collector()->SetFlags(kNoGCFlags);
+  isolate_->memory_allocator()->ReleaseCachedLargePages();
+  ReduceMemoryFootprint();
+}
+
+
+void Heap::MeasureContextMemory(List<Handle<Context> >* contexts,
+                                List<intptr_t>* sizes) {
+  // Attribution marks every global context as a root, so first drop the
+  // contexts that died since the last full collection.  The precise
+  // sweeping flag also makes sure incremental marking is not finished.
+  CollectAllGarbage(kNoGCFlags);
+  mark_compact_collector()->RequestContextAttribution();
+  CollectAllGarbage(kMakeHeapIterableMask);
+
+  // Contexts created by weak callbacks since the collection are at the
+  // head of the list and were not measured.
+  const List<intptr_t>& attributed =
+      mark_compact_collector()->attributed_context_sizes();
+  int length = 0;
+  for (Object* context = global_contexts_list_;
+       !context->IsUndefined();
+       context = Context::cast(context)->get(Context::NEXT_CONTEXT_LINK)) {
+    length++;
+  }
+  int unmeasured = length - attributed.length();
+  int index = 0;
+  for (Object* context = global_contexts_list_;
+       !context->IsUndefined();
+       context = Context::cast(context)->get(Context::NEXT_CONTEXT_LINK)) {
+    contexts->Add(Handle<Context>(Context::cast(context)));
+    sizes->Add(index < unmeasured ? 0 : attributed[index - unmeasured]);
+    index++;
+  }
+}
+
+
+void Heap::StartAllocationSampling(AllocationSampler* sampler) {
+  ASSERT(allocation_sampler_ == NULL);
+  allocation_sampler_ = sampler;
+  // Generated code allocates in new space without calling into the
+  // runtime, so lower the new space limit to get to see its allocations.
+  new_space_.StartAllocationSampling(sampler->bytes_until_next_sample());
+}
+
+
+void Heap::StopAllocationSampling() {
+  ASSERT(allocation_sampler_ != NULL);
+  new_space_.StopAllocationSampling();
+  allocation_sampler_ = NULL;
+}
+
+
+void Heap::AllocationSamplingStep(intptr_t bytes_allocated,
+                                  Address soon_object) {
+  if (allocation_sampler_ == NULL) return;
+  allocation_sampler_->Step(bytes_allocated, soon_object);
+  new_space_.set_allocation_sampling_step(
+      Max(allocation_sampler_->bytes_until_next_sample(),
+          static_cast<intptr_t>(kPointerSize)));
+}
+
+
+intptr_t Heap::ReduceMemoryFootprint() {
+  new_space_.Shrink();
+  UncommitFromSpace();
+
+  // The free lists are only touched by the main thread; the concurrent
+  // sweeper hands its blocks over in RefillFreeList.
+  intptr_t discarded = 0;
+  PagedSpaces spaces;
+  for (PagedSpace* space = spaces.next();
+       space != NULL;
+       space = spaces.next()) {
+    discarded += space->DiscardFreeMemory();
+  }
+  if (FLAG_trace_gc_verbose) {
+    PrintF("Memory reducer: new space %" V8_PTR_PREFIX "d, "
+           "discarded %" V8_PTR_PREFIX "d\n",
+           new_space_.Capacity(),
+           discarded);
+  }
+  return discarded;
 }
 
 
+// Keeps the optimizing compiler thread from working on a graph while
+// objects move, since the graph refers to heap objects through handles.
+// The thread stops at the end of the phase it is in, so a collection does
+// not wait for the whole job.
+class OptimizingCompilerThreadHeapAccess BASE_EMBEDDED {
+ public:
+  explicit OptimizingCompilerThreadHeapAccess(Isolate* isolate)
+      : thread_(isolate->optimizing_compiler_thread()) {
+    if (thread_ != NULL) thread_->LockHeapAccess();
+  }
+
+  ~OptimizingCompilerThreadHeapAccess() {
+    if (thread_ != NULL) thread_->UnlockHeapAccess();
+  }
+
+ private:
+  OptimizingCompilerThread* thread_;
+};
+
+
 bool Heap::CollectGarbage(AllocationSpace space, GarbageCollector collector) {
   // The VM is in the GC state until exiting this function.
   VMState state(isolate_, GC);
@@ -502,16 +627,32 @@ bool Heap::CollectGarbage(AllocationSpace space, GarbageCollector collector) {
         ? isolate_->counters()->gc_scavenger()
         : isolate_->counters()->gc_compactor();
     rate->Start();
-    next_gc_likely_to_collect_more =
-        PerformGarbageCollection(collector, &tracer);
+    {
+      OptimizingCompilerThreadHeapAccess heap_access(isolate_);
+      next_gc_likely_to_collect_more =
+          PerformGarbageCollection(collector, &tracer);
+    }
     rate->Stop();
 
     GarbageCollectionEpilogue();
   }
 
+  if (FLAG_memory_reducer) {
+    // A collection after a long quiet period finds the mutator done with
+    // the burst that made the heap grow.  The memory committed for it is
+    // given back to the OS without waiting for the heap to shrink.
+    double now = OS::TimeCurrentMillis();
+    if (memory_reducer_last_gc_ms_ > 0 &&
+        now - memory_reducer_last_gc_ms_ >= FLAG_memory_reducer_quiet_period) {
+      ReduceMemoryFootprint();
+    }
+    memory_reducer_last_gc_ms_ = now;
+  }
+
   ASSERT(collector == SCAVENGER || incremental_marking()->IsStopped());
   if (incremental_marking()->IsStopped()) {
-    if (incremental_marking()->WorthActivating() && NextGCIsLikelyToBeFull()) {
+    if (incremental_marking()->WorthActivating() &&
+        (NextGCIsLikelyToBeFull() || IncrementalMarkingNeededForPauseGoal())) {
       incremental_marking()->Start();
     }
   }
@@ -521,7 +662,9 @@ bool Heap::CollectGarbage(AllocationSpace space, GarbageCollector collector) {
 
 
 void Heap::PerformScavenge() {
+  mark_compact_collector()->WaitUntilSweepingCompleted();
   GCTracer tracer(this);
+  OptimizingCompilerThreadHeapAccess heap_access(isolate_);
   if (incremental_marking()->IsStopped()) {
     PerformGarbageCollection(SCAVENGER, &tracer);
   } else {
@@ -731,8 +874,9 @@ bool Heap::PerformGarbageCollection(GarbageCollector collector,
 
     size_of_old_gen_at_last_old_space_gc_ = PromotedSpaceSize();
 
-    if (high_survival_rate_during_scavenges &&
-        IsStableOrIncreasingSurvivalTrend()) {
+    if ((high_survival_rate_during_scavenges &&
+         IsStableOrIncreasingSurvivalTrend()) ||
+        ThroughputGoalMissed()) {
       // Stable high survival rates of young objects both during partial and
       // full collection indicate that mutator is either building or modifying
       // a structure with a long lifetime.
@@ -907,8 +1051,12 @@ static void VerifyNonPointerSpacePointers() {
 
 
 void Heap::CheckNewSpaceExpansionCriteria() {
+  // Missing the throughput goal is a reason to scavenge less often, but
+  // twice the survivors must still be copied within the pause goal.
   if (new_space_.Capacity() < new_space_.MaximumCapacity() &&
-      survived_since_last_expansion_ > new_space_.Capacity()) {
+      (survived_since_last_expansion_ > new_space_.Capacity() ||
+       ThroughputGoalMissed()) &&
+      !ScavengeExceedsPauseGoal(2 * young_survivors_after_last_gc_)) {
     // Grow the size of new space if there is room to grow and enough
     // data has survived scavenge since the last expansion.
     new_space_.Grow();
@@ -1036,33 +1184,30 @@ void Heap::Scavenge() {
 #endif
 
   ScavengeVisitor scavenge_visitor(this);
-  // Copy roots.
-  IterateRoots(&scavenge_visitor, VISIT_ALL_IN_SCAVENGE);
-
-  // Copy objects reachable from the old generation.
-  {
-    StoreBufferRebuildScope scope(this,
-                                  store_buffer(),
-                                  &ScavengeStoreBufferCallback);
-    store_buffer()->IteratePointersToNewSpace(&ScavengeObject);
-  }
+  if (CanScavengeInParallel()) {
+    ScavengeInParallel();
+    // Everything copied so far has been scanned by the parallel scavenger.
+    new_space_front = new_space_.top();
+  } else {
+    // Copy roots.
+    IterateRoots(&scavenge_visitor, VISIT_ALL_IN_SCAVENGE);
 
-  // Copy objects reachable from cells by scavenging cell values directly.
-  HeapObjectIterator cell_iterator(cell_space_);
-  for (HeapObject* cell = cell_iterator.Next();
-       cell != NULL; cell = cell_iterator.Next()) {
-    if (cell->IsJSGlobalPropertyCell()) {
-      Address value_address =
-          reinterpret_cast<Address>(cell) +
-          (JSGlobalPropertyCell::kValueOffset - kHeapObjectTag);
-      scavenge_visitor.VisitPointer(reinterpret_cast<Object**>(value_address));
+    // Copy objects reachable from the old generation.
+    {
+      StoreBufferRebuildScope scope(this,
+                                    store_buffer(),
+                                    &ScavengeStoreBufferCallback);
+      store_buffer()->IteratePointersToNewSpace(&ScavengeObject);
     }
-  }
 
-  // Scavenge object reachable from the global contexts list directly.
-  scavenge_visitor.VisitPointer(BitCast<Object**>(&global_contexts_list_));
+    // Copy objects reachable from cells by scavenging cell values directly.
+    IterateCellValues(&scavenge_visitor);
 
-  new_space_front = DoScavenge(&scavenge_visitor, new_space_front);
+    // Scavenge object reachable from the global contexts list directly.
+    scavenge_visitor.VisitPointer(BitCast<Object**>(&global_contexts_list_));
+
+    new_space_front = DoScavenge(&scavenge_visitor, new_space_front);
+  }
   isolate_->global_handles()->IdentifyNewSpaceWeakIndependentHandles(
       &IsUnscavengedHeapObject);
   isolate_->global_handles()->IterateNewSpaceWeakIndependentRoots(
@@ -1073,6 +1218,8 @@ void Heap::Scavenge() {
   UpdateNewSpaceReferencesInExternalStringTable(
       &UpdateNewSpaceReferenceInExternalStringTableEntry);
 
+  allocation_site_feedback_.UpdateAfterScavenge();
+
   LiveObjectList::UpdateReferencesForScavengeGC();
   isolate()->runtime_profiler()->UpdateSamplesAfterScavenge();
   incremental_marking()->UpdateMarkingDequeAfterScavenge();
@@ -1082,12 +1229,18 @@ void Heap::Scavenge() {
   // Set age mark.
   new_space_.set_age_mark(new_space_.top());
 
+  intptr_t survived = (PromotedSpaceSize() - survived_watermark) +
+      new_space_.Size();
+  if (ScavengeExceedsPauseGoal(survived)) {
+    // A smaller new space is scavenged more often with fewer survivors.
+    new_space_.Shrink();
+  }
+
   new_space_.LowerInlineAllocationLimit(
       new_space_.inline_allocation_limit_step());
 
   // Update how much has survived scavenge.
-  IncrementYoungSurvivorsCounter(static_cast<int>(
-      (PromotedSpaceSize() - survived_watermark) + new_space_.Size()));
+  IncrementYoungSurvivorsCounter(static_cast<int>(survived));
 
   LOG(isolate_, ResourceEvent("scavenge", "end"));
 
@@ -1200,6 +1353,8 @@ static Object* ProcessFunctionWeakReferences(Heap* heap,
 
 
 void Heap::ProcessWeakReferences(WeakObjectRetainer* retainer) {
+  allocation_site_feedback_.ProcessWeakReferences(retainer);
+
   Object* undefined = undefined_value();
   Object* head = undefined;
   Context* tail = NULL;
@@ -1266,6 +1421,507 @@ class NewSpaceScavenger : public StaticNewSpaceVisitor<NewSpaceScavenger> {
 };
 
 
+void Heap::IterateCellValues(ObjectVisitor* v) {
+  HeapObjectIterator cell_iterator(cell_space_);
+  for (HeapObject* cell = cell_iterator.Next();
+       cell != NULL; cell = cell_iterator.Next()) {
+    if (cell->IsJSGlobalPropertyCell()) {
+      Address value_address =
+          reinterpret_cast<Address>(cell) +
+          (JSGlobalPropertyCell::kValueOffset - kHeapObjectTag);
+      v->VisitPointer(reinterpret_cast<Object**>(value_address));
+    }
+  }
+}
+
+
+bool Heap::CanScavengeInParallel() {
+  if (!FLAG_parallel_scavenge || FLAG_scavenge_threads < 2) return false;
+  // The parallel scavenger neither transfers mark bits nor records slots
+  // for the incremental marker, and it does not report moved objects.
+  if (!incremental_marking()->IsStopped()) return false;
+  bool should_record = FLAG_log_gc;
+#ifdef DEBUG
+  should_record = should_record || FLAG_heap_stats;
+#endif
+  return !should_record &&
+         !isolate()->logger()->is_logging() &&
+         !CpuProfiler::is_profiling(isolate()) &&
+         (isolate()->heap_profiler() == NULL ||
+          !isolate()->heap_profiler()->is_profiling());
+}
+
+
+// Collects the slots that point into new space for the parallel scavenger.
+class ParallelScavengeRootVisitor: public ObjectVisitor {
+ public:
+  ParallelScavengeRootVisitor(Heap* heap, ParallelScavenger* scavenger)
+      : heap_(heap), scavenger_(scavenger) { }
+
+  void VisitPointer(Object** p) { AddRoot(p); }
+
+  void VisitPointers(Object** start, Object** end) {
+    for (Object** p = start; p < end; p++) AddRoot(p);
+  }
+
+ private:
+  void AddRoot(Object** p) {
+    if (!heap_->InNewSpace(*p)) return;
+    scavenger_->AddRoot(reinterpret_cast<HeapObject**>(p));
+  }
+
+  Heap* heap_;
+  ParallelScavenger* scavenger_;
+};
+
+
+void Heap::ScavengeInParallel() {
+  if (parallel_scavenger_ == NULL) {
+    parallel_scavenger_ = new ParallelScavenger(this);
+  }
+
+  ParallelScavengeRootVisitor root_visitor(this, parallel_scavenger_);
+  IterateRoots(&root_visitor, VISIT_ALL_IN_SCAVENGE);
+
+  // The slots stay in the store buffer, entries that end up pointing to old
+  // space are dropped by the next scavenge.
+  {
+    StoreBufferRebuildScope scope(this,
+                                  store_buffer(),
+                                  &ScavengeStoreBufferCallback);
+    store_buffer()->IteratePointersToNewSpace(
+        &ParallelScavenger::AddStoreBufferRoot);
+  }
+
+  IterateCellValues(&root_visitor);
+  root_visitor.VisitPointer(BitCast<Object**>(&global_contexts_list_));
+
+  parallel_scavenger_->Scavenge();
+}
+
+
+// The state of one parallel scavenging task.  Objects are copied into local
+// allocation buffers, copies that may contain pointers to from space are
+// pushed on a private stack and scanned by the same task.
+class ParallelScavengingTask {
+ public:
+  ParallelScavengingTask(Heap* heap, ParallelScavenger* scavenger)
+      : heap_(heap),
+        scavenger_(scavenger),
+        promoted_bytes_(0) {
+    ClearBuffer(&to_space_buffer_);
+    ClearBuffer(&old_pointer_space_buffer_);
+    ClearBuffer(&old_data_space_buffer_);
+  }
+
+  // Copies the object the slot points to unless it has already been copied
+  // and updates the slot.
+  void ScavengeSlot(HeapObject** slot, HeapObject* object);
+
+  // Scans the copied objects until the stack is empty.
+  void ProcessCopiedObjects();
+
+  // Gives the unused parts of the allocation buffers back, enters the
+  // recorded slots into the store buffer and accounts for the promoted
+  // bytes.  Called on the main thread after all tasks are done.
+  void Finish();
+
+  // Local allocation buffers are refilled in chunks of this size.  Larger
+  // objects are allocated directly, which bounds the waste at the end of a
+  // buffer to a quarter of it.
+  static const int kBufferSize = 8 * KB;
+  static const int kMaxBufferedObjectSize = kBufferSize / 4;
+
+ private:
+  static void ClearBuffer(AllocationInfo* buffer) {
+    buffer->top = buffer->limit = NULL;
+  }
+
+  static inline bool ContainsOnlyData(Map* map);
+
+  HeapObject* AllocateInBuffer(AllocationInfo* buffer, int size_in_bytes);
+  HeapObject* AllocateInToSpace(int size_in_bytes);
+  HeapObject* Promote(HeapObject* object, int size_in_bytes, bool data);
+  void FreeCopy(HeapObject* copy, int size_in_bytes);
+  void ScanCopiedObject(HeapObject* object);
+
+  Heap* heap_;
+  ParallelScavenger* scavenger_;
+
+  AllocationInfo to_space_buffer_;
+  AllocationInfo old_pointer_space_buffer_;
+  AllocationInfo old_data_space_buffer_;
+
+  List<HeapObject*> copied_objects_;
+
+  // Slots of promoted objects that still point to new space.
+  List<Address> store_buffer_slots_;
+
+  intptr_t promoted_bytes_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelScavengingTask);
+};
+
+
+bool ParallelScavengingTask::ContainsOnlyData(Map* map) {
+  int id = map->visitor_id();
+  return id == StaticVisitorBase::kVisitSeqAsciiString ||
+         id == StaticVisitorBase::kVisitSeqTwoByteString ||
+         id == StaticVisitorBase::kVisitByteArray ||
+         id == StaticVisitorBase::kVisitFixedDoubleArray ||
+         (id >= StaticVisitorBase::kVisitDataObject &&
+          id <= StaticVisitorBase::kVisitDataObjectGeneric);
+}
+
+
+HeapObject* ParallelScavengingTask::AllocateInBuffer(AllocationInfo* buffer,
+                                                     int size_in_bytes) {
+  if (buffer->limit - buffer->top < size_in_bytes) return NULL;
+  HeapObject* result = HeapObject::FromAddress(buffer->top);
+  buffer->top += size_in_bytes;
+  return result;
+}
+
+
+HeapObject* ParallelScavengingTask::AllocateInToSpace(int size_in_bytes) {
+  HeapObject* result = AllocateInBuffer(&to_space_buffer_, size_in_bytes);
+  if (result != NULL) return result;
+  if (size_in_bytes > kMaxBufferedObjectSize) {
+    return scavenger_->AllocateInNewSpace(size_in_bytes);
+  }
+
+  // To space has to stay iterable, so the rest of the old buffer becomes a
+  // filler.
+  if (to_space_buffer_.top != NULL) {
+    heap_->CreateFillerObjectAt(
+        to_space_buffer_.top,
+        static_cast<int>(to_space_buffer_.limit - to_space_buffer_.top));
+  }
+  ClearBuffer(&to_space_buffer_);
+  HeapObject* buffer = scavenger_->AllocateInNewSpace(kBufferSize);
+  if (buffer == NULL) return scavenger_->AllocateInNewSpace(size_in_bytes);
+  to_space_buffer_.top = buffer->address();
+  to_space_buffer_.limit = buffer->address() + kBufferSize;
+  return AllocateInBuffer(&to_space_buffer_, size_in_bytes);
+}
+
+
+HeapObject* ParallelScavengingTask::Promote(HeapObject* object,
+                                            int size_in_bytes,
+                                            bool data) {
+  if (size_in_bytes > Page::kMaxHeapObjectSize) {
+    return scavenger_->AllocateInLargeObjectSpace(size_in_bytes);
+  }
+
+  OldSpace* space =
+      data ? heap_->old_data_space() : heap_->old_pointer_space();
+  AllocationInfo* buffer =
+      data ? &old_data_space_buffer_ : &old_pointer_space_buffer_;
+  HeapObject* result = AllocateInBuffer(buffer, size_in_bytes);
+  if (result != NULL) return result;
+  if (size_in_bytes > kMaxBufferedObjectSize) {
+    return scavenger_->AllocateInOldSpace(space, size_in_bytes);
+  }
+
+  // The rest of the old buffer is given back when the task finishes.  Until
+  // then it is only wasted, so keep using the buffer if it has room for
+  // smaller objects.
+  HeapObject* new_buffer = scavenger_->AllocateInOldSpace(space, kBufferSize);
+  if (new_buffer == NULL) return NULL;
+  if (buffer->top != NULL) {
+    ScopedLock lock(scavenger_->allocation_mutex_);
+    space->Free(buffer->top, static_cast<int>(buffer->limit - buffer->top));
+  }
+  buffer->top = new_buffer->address();
+  buffer->limit = new_buffer->address() + kBufferSize;
+  return AllocateInBuffer(buffer, size_in_bytes);
+}
+
+
+void ParallelScavengingTask::FreeCopy(HeapObject* copy, int size_in_bytes) {
+  // The copy is the last allocation of this task if it went to one of the
+  // buffers.
+  Address end = copy->address() + size_in_bytes;
+  if (end == to_space_buffer_.top) {
+    to_space_buffer_.top = copy->address();
+  } else if (end == old_pointer_space_buffer_.top) {
+    old_pointer_space_buffer_.top = copy->address();
+  } else if (end == old_data_space_buffer_.top) {
+    old_data_space_buffer_.top = copy->address();
+  } else {
+    heap_->CreateFillerObjectAt(copy->address(), size_in_bytes);
+  }
+}
+
+
+void ParallelScavengingTask::ScavengeSlot(HeapObject** slot,
+                                          HeapObject* object) {
+  ASSERT(heap_->InFromSpace(object));
+  MapWord first_word = object->map_word();
+  if (first_word.IsForwardingAddress()) {
+    *slot = first_word.ToForwardingAddress();
+    return;
+  }
+
+  Map* map = first_word.ToMap();
+  int size = object->SizeFromMap(map);
+  bool data = ContainsOnlyData(map);
+
+  HeapObject* target = NULL;
+  bool promoted = false;
+  if (heap_->ShouldBePromoted(object->address(), size)) {
+    target = Promote(object, size, data);
+    promoted = (target != NULL);
+  }
+  if (target == NULL) target = AllocateInToSpace(size);
+  if (target == NULL) {
+    target = Promote(object, size, data);
+    promoted = (target != NULL);
+  }
+  if (target == NULL) {
+    V8::FatalProcessOutOfMemory("ParallelScavengingTask::ScavengeSlot");
+  }
+
+  heap_->CopyBlock(target->address(), object->address(), size);
+
+  // Install the forwarding address.  If another task has copied the object
+  // in the meantime use its copy instead.
+  AtomicWord forwarded = static_cast<AtomicWord>(
+      MapWord::FromForwardingAddress(target).ToRawValue());
+  AtomicWord current = Release_CompareAndSwap(
+      reinterpret_cast<volatile AtomicWord*>(object->address()),
+      static_cast<AtomicWord>(first_word.ToRawValue()),
+      forwarded);
+  if (current != static_cast<AtomicWord>(first_word.ToRawValue())) {
+    FreeCopy(target, size);
+    *slot = MapWord::FromRawValue(current).ToForwardingAddress();
+    return;
+  }
+
+  *slot = target;
+  if (promoted) promoted_bytes_ += size;
+  if (!data) copied_objects_.Add(target);
+}
+
+
+void ParallelScavengingTask::ScanCopiedObject(HeapObject* object) {
+  // Like IterateAndMarkPointersToFromSpace this looks at every word of the
+  // object, copies are only scanned if they may contain pointers.
+  bool promoted = !heap_->InNewSpace(object);
+  Address end = object->address() + object->Size();
+  for (Address slot_address = object->address() + kPointerSize;
+       slot_address < end;
+       slot_address += kPointerSize) {
+    Object** slot = reinterpret_cast<Object**>(slot_address);
+    Object* value = *slot;
+    if (!value->IsHeapObject() || !heap_->InFromSpace(value)) continue;
+    ScavengeSlot(reinterpret_cast<HeapObject**>(slot),
+                 HeapObject::cast(value));
+    if (promoted && heap_->InNewSpace(*slot)) {
+      store_buffer_slots_.Add(slot_address);
+    }
+  }
+}
+
+
+void ParallelScavengingTask::ProcessCopiedObjects() {
+  while (!copied_objects_.is_empty()) {
+    ScanCopiedObject(copied_objects_.RemoveLast());
+  }
+}
+
+
+void ParallelScavengingTask::Finish() {
+  ASSERT(copied_objects_.is_empty());
+  if (to_space_buffer_.top != NULL) {
+    heap_->CreateFillerObjectAt(
+        to_space_buffer_.top,
+        static_cast<int>(to_space_buffer_.limit - to_space_buffer_.top));
+  }
+  if (old_pointer_space_buffer_.top != NULL) {
+    heap_->old_pointer_space()->Free(
+        old_pointer_space_buffer_.top,
+        static_cast<int>(old_pointer_space_buffer_.limit -
+                         old_pointer_space_buffer_.top));
+  }
+  if (old_data_space_buffer_.top != NULL) {
+    heap_->old_data_space()->Free(
+        old_data_space_buffer_.top,
+        static_cast<int>(old_data_space_buffer_.limit -
+                         old_data_space_buffer_.top));
+  }
+  ClearBuffer(&to_space_buffer_);
+  ClearBuffer(&old_pointer_space_buffer_);
+  ClearBuffer(&old_data_space_buffer_);
+
+  for (int i = 0; i < store_buffer_slots_.length(); i++) {
+    heap_->store_buffer()->EnterDirectlyIntoStoreBuffer(store_buffer_slots_[i]);
+  }
+  store_buffer_slots_.Clear();
+
+  heap_->tracer()->increment_promoted_objects_size(promoted_bytes_);
+  promoted_bytes_ = 0;
+}
+
+
+class ParallelScavengingThread : public Thread {
+ public:
+  ParallelScavengingThread(ParallelScavenger* scavenger,
+                           int task_id,
+                           Isolate* isolate,
+                           Semaphore* done_semaphore)
+      : Thread("v8:ParallelScavenger"),
+        scavenger_(scavenger),
+        task_id_(task_id),
+        isolate_(isolate),
+        start_semaphore_(OS::CreateSemaphore(0)),
+        done_semaphore_(done_semaphore),
+        stop_(0) { }
+
+  ~ParallelScavengingThread() {
+    delete start_semaphore_;
+  }
+
+  void Run() {
+    // Copying objects creates fillers and reads maps through the current
+    // isolate.
+    Thread::SetThreadLocal(Isolate::isolate_key(), isolate_);
+    while (true) {
+      start_semaphore_->Wait();
+      if (Acquire_Load(&stop_) != 0) return;
+      scavenger_->Work(task_id_);
+      done_semaphore_->Signal();
+    }
+  }
+
+  void StartTask() {
+    start_semaphore_->Signal();
+  }
+
+  void Stop() {
+    Release_Store(&stop_, 1);
+    start_semaphore_->Signal();
+    Join();
+  }
+
+ private:
+  ParallelScavenger* scavenger_;
+  int task_id_;
+  Isolate* isolate_;
+  Semaphore* start_semaphore_;
+  Semaphore* done_semaphore_;
+  Atomic32 stop_;
+};
+
+
+ParallelScavenger::ParallelScavenger(Heap* heap)
+    : heap_(heap),
+      tasks_(FLAG_scavenge_threads),
+      next_root_(0),
+      allocation_mutex_(OS::CreateMutex()),
+      done_semaphore_(OS::CreateSemaphore(0)) {
+  task_state_ = NewArray<ParallelScavengingTask*>(tasks_);
+  threads_ = NewArray<ParallelScavengingThread*>(tasks_);
+  for (int i = 0; i < tasks_; i++) {
+    task_state_[i] = new ParallelScavengingTask(heap, this);
+    threads_[i] = NULL;
+  }
+  // Task 0 runs on the main thread.
+  for (int i = 1; i < tasks_; i++) {
+    threads_[i] = new ParallelScavengingThread(this,
+                                               i,
+                                               heap->isolate(),
+                                               done_semaphore_);
+    threads_[i]->Start();
+  }
+}
+
+
+ParallelScavenger::~ParallelScavenger() {
+  for (int i = 1; i < tasks_; i++) {
+    threads_[i]->Stop();
+    delete threads_[i];
+  }
+  for (int i = 0; i < tasks_; i++) {
+    delete task_state_[i];
+  }
+  DeleteArray(threads_);
+  DeleteArray(task_state_);
+  delete allocation_mutex_;
+  delete done_semaphore_;
+}
+
+
+void ParallelScavenger::AddStoreBufferRoot(HeapObject** slot,
+                                           HeapObject* object) {
+  object->GetHeap()->parallel_scavenger_->AddRoot(slot);
+}
+
+
+void ParallelScavenger::Scavenge() {
+  next_root_ = 0;
+  for (int i = 1; i < tasks_; i++) threads_[i]->StartTask();
+  Work(0);
+  for (int i = 1; i < tasks_; i++) done_semaphore_->Wait();
+
+  StoreBufferRebuildScope scope(heap_,
+                                heap_->store_buffer(),
+                                &Heap::ScavengeStoreBufferCallback);
+  for (int i = 0; i < tasks_; i++) task_state_[i]->Finish();
+  roots_.Clear();
+}
+
+
+void ParallelScavenger::Work(int task_id) {
+  ParallelScavengingTask* task = task_state_[task_id];
+  int length = roots_.length();
+  while (true) {
+    int start =
+        Barrier_AtomicIncrement(&next_root_, kRootsPerClaim) - kRootsPerClaim;
+    if (start >= length) break;
+    int end = Min(start + kRootsPerClaim, length);
+    for (int i = start; i < end; i++) {
+      HeapObject** slot = roots_[i];
+      // The same slot can be found more than once, so it may have been
+      // updated by another task already.
+      Object* object = *slot;
+      if (!heap_->InFromSpace(object)) continue;
+      task->ScavengeSlot(slot, HeapObject::cast(object));
+    }
+    task->ProcessCopiedObjects();
+  }
+}
+
+
+HeapObject* ParallelScavenger::AllocateInNewSpace(int size_in_bytes) {
+  ScopedLock lock(allocation_mutex_);
+  MaybeObject* maybe_result = heap_->new_space()->AllocateRaw(size_in_bytes);
+  Object* result;
+  if (!maybe_result->ToObject(&result)) return NULL;
+  return HeapObject::cast(result);
+}
+
+
+HeapObject* ParallelScavenger::AllocateInOldSpace(OldSpace* space,
+                                                  int size_in_bytes) {
+  ScopedLock lock(allocation_mutex_);
+  MaybeObject* maybe_result = space->AllocateRaw(size_in_bytes);
+  Object* result;
+  if (!maybe_result->ToObject(&result)) return NULL;
+  return HeapObject::cast(result);
+}
+
+
+HeapObject* ParallelScavenger::AllocateInLargeObjectSpace(int size_in_bytes) {
+  ScopedLock lock(allocation_mutex_);
+  MaybeObject* maybe_result =
+      heap_->lo_space()->AllocateRaw(size_in_bytes, NOT_EXECUTABLE);
+  Object* result;
+  if (!maybe_result->ToObject(&result)) return NULL;
+  return HeapObject::cast(result);
+}
+
+
 Address Heap::DoScavenge(ObjectVisitor* scavenge_visitor,
                          Address new_space_front) {
   do {
@@ -2373,6 +3029,9 @@ bool Heap::CreateInitialObjects() {
   // Handling of script id generation is in FACTORY->NewScript.
   set_last_script_id(undefined_value());
 
+  // The offset is recorded when the construct stub is generated.
+  set_construct_stub_deopt_pc_offset(Smi::FromInt(0));
+
   // Initialize keyed lookup cache.
   isolate_->keyed_lookup_cache()->Clear();
 
@@ -3554,14 +4213,23 @@ MaybeObject* Heap::AllocateJSObject(JSFunction* constructor,
     constructor->set_initial_map(Map::cast(initial_map));
     Map::cast(initial_map)->set_constructor(constructor);
   }
+  bool track_allocation_site =
+      FLAG_allocation_site_pretenuring && pretenure == NOT_TENURED;
+  if (track_allocation_site) {
+    pretenure = allocation_site_feedback_.GetPretenureFlag(constructor);
+  }
   // Allocate the object based on the constructors initial map.
   MaybeObject* result =
       AllocateJSObjectFromMap(constructor->initial_map(), pretenure);
+  Object* non_failure;
 #ifdef DEBUG
   // Make sure result is NOT a global object if valid.
-  Object* non_failure;
   ASSERT(!result->ToObject(&non_failure) || !non_failure->IsGlobalObject());
 #endif
+  if (track_allocation_site && result->ToObject(&non_failure)) {
+    allocation_site_feedback_.RecordAllocation(constructor,
+                                               HeapObject::cast(non_failure));
+  }
   return result;
 }
 
@@ -3685,7 +4353,7 @@ MaybeObject* Heap::AllocateGlobalObject(JSFunction* constructor) {
 }
 
 
-MaybeObject* Heap::CopyJSObject(JSObject* source) {
+MaybeObject* Heap::CopyJSObject(JSObject* source, PretenureFlag pretenure) {
   // Never used to copy functions.  If functions need to be copied we
   // have to be careful to clear the literals array.
   ASSERT(!source->IsJSFunction());
@@ -3697,9 +4365,11 @@ MaybeObject* Heap::CopyJSObject(JSObject* source) {
 
   // If we're forced to always allocate, we use the general allocation
   // functions which may leave us with an object in old space.
-  if (always_allocate()) {
+  if (always_allocate() || pretenure == TENURED) {
+    AllocationSpace space =
+        (pretenure == TENURED) ? OLD_POINTER_SPACE : NEW_SPACE;
     { MaybeObject* maybe_clone =
-          AllocateRaw(object_size, NEW_SPACE, OLD_POINTER_SPACE);
+          AllocateRaw(object_size, space, OLD_POINTER_SPACE);
       if (!maybe_clone->ToObject(&clone)) return maybe_clone;
     }
     Address clone_address = HeapObject::cast(clone)->address();
@@ -3732,9 +4402,10 @@ MaybeObject* Heap::CopyJSObject(JSObject* source) {
       if (elements->map() == fixed_cow_array_map()) {
         maybe_elem = FixedArray::cast(elements);
       } else if (source->HasFastDoubleElements()) {
-        maybe_elem = CopyFixedDoubleArray(FixedDoubleArray::cast(elements));
+        maybe_elem = CopyFixedDoubleArray(FixedDoubleArray::cast(elements),
+                                          pretenure);
       } else {
-        maybe_elem = CopyFixedArray(FixedArray::cast(elements));
+        maybe_elem = CopyFixedArray(FixedArray::cast(elements), pretenure);
       }
       if (!maybe_elem->ToObject(&elem)) return maybe_elem;
     }
@@ -3743,7 +4414,7 @@ MaybeObject* Heap::CopyJSObject(JSObject* source) {
   // Update properties if necessary.
   if (properties->length() > 0) {
     Object* prop;
-    { MaybeObject* maybe_prop = CopyFixedArray(properties);
+    { MaybeObject* maybe_prop = CopyFixedArray(properties, pretenure);
       if (!maybe_prop->ToObject(&prop)) return maybe_prop;
     }
     JSObject::cast(clone)->set_properties(FixedArray::cast(prop));
@@ -4104,10 +4775,14 @@ MaybeObject* Heap::AllocateRawFixedArray(int length) {
 }
 
 
-MaybeObject* Heap::CopyFixedArrayWithMap(FixedArray* src, Map* map) {
+MaybeObject* Heap::CopyFixedArrayWithMap(FixedArray* src,
+                                         Map* map,
+                                         PretenureFlag pretenure) {
   int len = src->length();
   Object* obj;
-  { MaybeObject* maybe_obj = AllocateRawFixedArray(len);
+  { MaybeObject* maybe_obj = (pretenure == TENURED)
+        ? AllocateRawFixedArray(len, TENURED)
+        : AllocateRawFixedArray(len);
     if (!maybe_obj->ToObject(&obj)) return maybe_obj;
   }
   if (InNewSpace(obj)) {
@@ -4131,10 +4806,11 @@ MaybeObject* Heap::CopyFixedArrayWithMap(FixedArray* src, Map* map) {
 
 
 MaybeObject* Heap::CopyFixedDoubleArrayWithMap(FixedDoubleArray* src,
-                                               Map* map) {
+                                               Map* map,
+                                               PretenureFlag pretenure) {
   int len = src->length();
   Object* obj;
-  { MaybeObject* maybe_obj = AllocateRawFixedDoubleArray(len, NOT_TENURED);
+  { MaybeObject* maybe_obj = AllocateRawFixedDoubleArray(len, pretenure);
     if (!maybe_obj->ToObject(&obj)) return maybe_obj;
   }
   HeapObject* dst = HeapObject::cast(obj);
@@ -4431,6 +5107,91 @@ STRUCT_LIST(MAKE_CASE)
 }
 
 
+char* Heap::ArchiveThread(char* to) {
+  NewSpace::ThreadAllocationBuffer buffer;
+  new_space_.ArchiveAllocationBuffer(&buffer);
+  memcpy(to, reinterpret_cast<char*>(&buffer), sizeof(buffer));
+  return to + sizeof(buffer);
+}
+
+
+char* Heap::RestoreThread(char* from) {
+  NewSpace::ThreadAllocationBuffer buffer;
+  memcpy(reinterpret_cast<char*>(&buffer), from, sizeof(buffer));
+  new_space_.RestoreAllocationBuffer(&buffer);
+  return from + sizeof(buffer);
+}
+
+
+void Heap::SetGCGoals(int max_pause_ms, int max_gc_time_percentage) {
+  max_pause_goal_ms_ = Max(max_pause_ms, 0);
+  max_gc_time_percentage_goal_ = Max(Min(max_gc_time_percentage, 100), 0);
+}
+
+
+static intptr_t CombineSpeeds(intptr_t previous, intptr_t current) {
+  // Speeds are never 0 once measured.
+  current = Max(current, static_cast<intptr_t>(1));
+  if (previous == 0) return current;
+  return (previous + current) / 2;
+}
+
+
+void Heap::RecordGCTimes(GarbageCollector collector,
+                         double pause_ms,
+                         double mutator_ms,
+                         double marking_ms,
+                         bool marked_incrementally) {
+  if (mutator_ms > 0) {
+    // Average over roughly the last ten collections.
+    double ratio = pause_ms / (pause_ms + mutator_ms);
+    gc_time_ratio_ = gc_time_ratio_ * 0.9 + ratio * 0.1;
+  }
+
+  if (collector == SCAVENGER) {
+    // The time of a scavenge is dominated by copying the survivors.
+    if (young_survivors_after_last_gc_ > 0) {
+      intptr_t speed = static_cast<intptr_t>(
+          young_survivors_after_last_gc_ / Max(pause_ms, 1.0));
+      scavenge_speed_ = CombineSpeeds(scavenge_speed_, speed);
+    }
+  } else if (!marked_incrementally && marking_ms >= 1) {
+    // After incremental marking the marking pause only finishes the work.
+    intptr_t speed = static_cast<intptr_t>(PromotedSpaceSize() / marking_ms);
+    marking_speed_ = CombineSpeeds(marking_speed_, speed);
+  }
+}
+
+
+void Heap::RecordIncrementalMarkingStep(intptr_t marked_bytes, double ms) {
+  if (marked_bytes <= 0 || ms <= 0) return;
+  intptr_t speed = static_cast<intptr_t>(marked_bytes / ms);
+  marking_speed_ = CombineSpeeds(marking_speed_, speed);
+}
+
+
+intptr_t Heap::MaxIncrementalMarkingStepSize() {
+  if (max_pause_goal_ms_ == 0 || marking_speed_ == 0) return 0;
+  return marking_speed_ * max_pause_goal_ms_;
+}
+
+
+bool Heap::IncrementalMarkingNeededForPauseGoal() {
+  intptr_t max_step_size = MaxIncrementalMarkingStepSize();
+  if (max_step_size == 0) return false;
+  // Marking takes this many steps if every step uses up the pause goal.
+  intptr_t steps = PromotedSpaceSize() / max_step_size + 1;
+  // A step is done whenever this much has been allocated.  Leave room for
+  // twice the allocation because steps do not always use up the goal.
+  intptr_t allocation_during_marking =
+      2 * steps * IncrementalMarking::kAllocatedThreshold;
+  intptr_t adjusted_promotion_limit =
+      old_gen_promotion_limit_ - new_space_.Capacity();
+  return PromotedTotalSize() + allocation_during_marking >=
+      adjusted_promotion_limit;
+}
+
+
 bool Heap::IsHeapIterable() {
   return (!old_pointer_space()->was_swept_conservatively() &&
           !old_data_space()->was_swept_conservatively());
@@ -4458,6 +5219,13 @@ bool Heap::IdleNotification() {
     last_idle_notification_gc_count_init_ = true;
   }
 
+  GlobalHandles* global_handles = isolate_->global_handles();
+  if (global_handles->NumberOfPendingWeakCallbacks() > 0) {
+    global_handles->DispatchPendingWeakCallbacks(
+        FLAG_weak_callbacks_per_slice);
+    return false;
+  }
+
   bool uncommit = true;
   bool finished = false;
 
@@ -4532,6 +5300,117 @@ bool Heap::IdleNotification() {
 }
 
 
+intptr_t Heap::EstimatedScavengeTimeInMs() {
+  intptr_t speed =
+      scavenge_speed_ > 0 ? scavenge_speed_ : kInitialIdleScavengeSpeed;
+  intptr_t survivors =
+      static_cast<intptr_t>(new_space_.Size() * survival_rate_ / 100);
+  return survivors / speed;
+}
+
+
+intptr_t Heap::EstimatedFinalizationTimeInMs() {
+  // Finishing the cycle evacuates new space like a scavenge does.  Until a
+  // cycle has been finished when idle, the rest of the pause is assumed to
+  // be short after incremental marking.
+  return Max(EstimatedScavengeTimeInMs(),
+             static_cast<intptr_t>(idle_finalization_time_ms_));
+}
+
+
+bool Heap::WorthStartingIncrementalMarkingWhenIdle() {
+  if (!incremental_marking()->WorthActivating()) return false;
+  if (contexts_disposed_ > 0) return true;
+  // Start when the old generation has used up half of the room it had after
+  // the last full GC, so marking is likely to finish while still idle.
+  intptr_t room =
+      old_gen_promotion_limit_ - size_of_old_gen_at_last_old_space_gc_;
+  intptr_t promoted =
+      PromotedTotalSize() - size_of_old_gen_at_last_old_space_gc_;
+  return promoted >= room / 2;
+}
+
+
+bool Heap::IdleNotification(int idle_time_in_ms) {
+  if (idle_time_in_ms <= 0) return false;
+
+  // Queued weak callbacks come first, they may release the objects the
+  // rest of the idle work would otherwise have to deal with.
+  GlobalHandles* global_handles = isolate_->global_handles();
+  if (global_handles->NumberOfPendingWeakCallbacks() > 0) {
+    double deadline = OS::TimeCurrentMillis() + idle_time_in_ms;
+    do {
+      global_handles->DispatchPendingWeakCallbacks(
+          FLAG_weak_callbacks_per_slice);
+    } while (global_handles->NumberOfPendingWeakCallbacks() > 0 &&
+             OS::TimeCurrentMillis() < deadline);
+    return false;
+  }
+
+  IncrementalMarking* marking = incremental_marking();
+
+  if (marking->state() == IncrementalMarking::COMPLETE) {
+    // Marking is done and the cycle cannot be finished in pieces.  If it
+    // does not fit into this idle period, there is nothing left to do when
+    // idle: the cycle is finished by the next allocation or by a longer
+    // idle notification.
+    if (EstimatedFinalizationTimeInMs() >= idle_time_in_ms) return true;
+    double start = OS::TimeCurrentMillis();
+    CollectAllGarbage(kNoGCFlags);
+    idle_finalization_time_ms_ = OS::TimeCurrentMillis() - start;
+    // Lazy sweeping is left for the next notification.
+    return false;
+  }
+
+  if (marking->IsMarkingIncomplete() ||
+      marking->state() == IncrementalMarking::SWEEPING) {
+    intptr_t speed =
+        marking_speed_ > 0 ? marking_speed_ : kInitialIdleMarkingSpeed;
+    intptr_t bytes_to_process = speed * idle_time_in_ms;
+    double start = OS::TimeCurrentMillis();
+    bool was_marking = marking->IsMarkingIncomplete();
+    marking->Advance(bytes_to_process);
+    // Steps record their speed themselves if there are GC goals.  A step
+    // that ran out of work did not use up the time it was given.
+    if (!HasGCGoals() && was_marking && marking->IsMarkingIncomplete()) {
+      RecordIncrementalMarkingStep(bytes_to_process,
+                                   OS::TimeCurrentMillis() - start);
+    }
+    return false;
+  }
+
+  if (!old_pointer_space()->IsSweepingComplete() ||
+      !old_data_space()->IsSweepingComplete()) {
+    intptr_t bytes_to_sweep = kIdleSweepingSpeed * idle_time_in_ms;
+    old_pointer_space()->AdvanceSweeper(bytes_to_sweep);
+    old_data_space()->AdvanceSweeper(bytes_to_sweep);
+    return false;
+  }
+
+  if (new_space_.Size() >= new_space_.Capacity() / 2 &&
+      EstimatedScavengeTimeInMs() < idle_time_in_ms) {
+    double start = OS::TimeCurrentMillis();
+    CollectGarbage(NEW_SPACE);
+    // The GC tracer records the speed itself if there are GC goals.
+    if (!HasGCGoals() && young_survivors_after_last_gc_ > 0) {
+      double ms = Max(OS::TimeCurrentMillis() - start, 1.0);
+      scavenge_speed_ = CombineSpeeds(
+          scavenge_speed_,
+          static_cast<intptr_t>(young_survivors_after_last_gc_ / ms));
+    }
+    return false;
+  }
+
+  if (marking->IsStopped() && WorthStartingIncrementalMarkingWhenIdle()) {
+    marking->Start();
+    return false;
+  }
+
+  ReduceMemoryFootprint();
+  return true;
+}
+
+
 #ifdef DEBUG
 
 void Heap::Print() {
@@ -4650,6 +5529,7 @@ void Heap::Verify() {
   VerifyPointersVisitor visitor;
   IterateRoots(&visitor, VISIT_ONLY_STRONG);
 
+  new_space_.RetireAllocationBuffer();
   new_space_.Verify();
 
   old_pointer_space_->Verify(&visitor);
@@ -4993,8 +5873,13 @@ void Heap::IterateWeakRoots(ObjectVisitor* v, VisitMode mode) {
 }
 
 
-void Heap::IterateStrongRoots(ObjectVisitor* v, VisitMode mode) {
+void Heap::IterateRootList(ObjectVisitor* v) {
   v->VisitPointers(&roots_[0], &roots_[kStrongRootListLength]);
+}
+
+
+void Heap::IterateStrongRoots(ObjectVisitor* v, VisitMode mode) {
+  IterateRootList(v);
   v->Synchronize("strong_root_list");
 
   v->VisitPointer(BitCast<Object**>(&hidden_symbol_));
@@ -5019,6 +5904,7 @@ void Heap::IterateStrongRoots(ObjectVisitor* v, VisitMode mode) {
 
   // Iterate over local handles in handle scopes.
   isolate_->handle_scope_implementer()->Iterate(v);
+  isolate_->IterateDeferredHandles(v);
   v->Synchronize("handlescope");
 
   // Iterate over the builtin code objects and code stubs in the
@@ -5103,6 +5989,9 @@ bool Heap::ConfigureHeap(int max_semispace_size,
   }
 
   if (max_old_gen_size > 0) max_old_generation_size_ = max_old_gen_size;
+  if (FLAG_max_gc_pause > 0 || FLAG_max_gc_time_percentage > 0) {
+    SetGCGoals(FLAG_max_gc_pause, FLAG_max_gc_time_percentage);
+  }
   if (max_executable_size > 0) {
     max_executable_size_ = RoundUp(max_executable_size, Page::kPageSize);
   }
@@ -5498,10 +6387,14 @@ void Heap::TearDown() {
     PrintF("\n\n");
   }
 
+  mark_compact_collector()->WaitUntilSweepingCompleted();
+
   isolate_->global_handles()->TearDown();
 
   external_string_table_.TearDown();
 
+  allocation_site_feedback_.TearDown();
+
   new_space_.TearDown();
 
   if (old_pointer_space_ != NULL) {
@@ -5542,6 +6435,12 @@ void Heap::TearDown() {
 
   store_buffer()->TearDown();
   incremental_marking()->TearDown();
+  mark_compact_collector()->TearDown();
+
+  if (parallel_scavenger_ != NULL) {
+    delete parallel_scavenger_;
+    parallel_scavenger_ = NULL;
+  }
 
   isolate_->memory_allocator()->TearDown();
 
@@ -5553,6 +6452,8 @@ void Heap::TearDown() {
 
 
 void Heap::Shrink() {
+  // Pages owned by the concurrent sweeper cannot be released.
+  mark_compact_collector()->WaitUntilSweepingCompleted();
   // Try to shrink all paged spaces.
   PagedSpaces spaces;
   for (PagedSpace* space = spaces.next(); space != NULL; space = spaces.next())
@@ -5838,6 +6739,7 @@ HeapIterator::~HeapIterator() {
 
 
 void HeapIterator::Init() {
+  Isolate::Current()->heap()->new_space()->RetireAllocationBuffer();
   // Start the iteration.
   space_iterator_ = filtering_ == kNoFiltering ? new SpaceIterator :
       new SpaceIterator(Isolate::Current()->heap()->
@@ -6127,7 +7029,11 @@ GCTracer::GCTracer(Heap* heap)
       spent_in_mutator_(0),
       promoted_objects_size_(0),
       heap_(heap) {
-  if (!FLAG_trace_gc && !FLAG_print_cumulative_gc_stat) return;
+  if (!FLAG_trace_gc &&
+      !FLAG_print_cumulative_gc_stat &&
+      !heap_->HasGCGoals()) {
+    return;
+  }
   start_time_ = OS::TimeCurrentMillis();
   start_size_ = heap_->SizeOfObjects();
 
@@ -6155,8 +7061,11 @@ GCTracer::GCTracer(Heap* heap)
 
 
 GCTracer::~GCTracer() {
-  // Printf ONE line iff flag is set.
-  if (!FLAG_trace_gc && !FLAG_print_cumulative_gc_stat) return;
+  if (!FLAG_trace_gc &&
+      !FLAG_print_cumulative_gc_stat &&
+      !heap_->HasGCGoals()) {
+    return;
+  }
 
   bool first_gc = (heap_->last_gc_end_timestamp_ == 0);
 
@@ -6165,6 +7074,19 @@ GCTracer::~GCTracer() {
 
   int time = static_cast<int>(heap_->last_gc_end_timestamp_ - start_time_);
 
+  if (heap_->HasGCGoals()) {
+    // Incremental marking steps are reset when marking finishes, so steps
+    // were done during this cycle if there are any.
+    heap_->RecordGCTimes(collector_,
+                         heap_->last_gc_end_timestamp_ - start_time_,
+                         first_gc ? 0 : spent_in_mutator_,
+                         scopes_[Scope::MC_MARK],
+                         steps_count_ > 0);
+  }
+
+  // Printf ONE line iff flag is set.
+  if (!FLAG_trace_gc && !FLAG_print_cumulative_gc_stat) return;
+
   // Update cumulative GC statistics if required.
   if (FLAG_print_cumulative_gc_stat) {
     heap_->max_gc_pause_ = Max(heap_->max_gc_pause_, time);
@@ -6332,6 +7254,171 @@ void TranscendentalCache::Clear() {
 }
 
 
+AllocationSiteFeedback::AllocationSiteFeedback(Heap* heap)
+    : heap_(heap),
+      site_map_(SiteMatch) { }
+
+
+PretenureFlag AllocationSiteFeedback::GetPretenureFlag(HeapObject* site) {
+  int index = FindSite(site, false);
+  return (index < 0) ? NOT_TENURED : sites_[index].pretenure;
+}
+
+
+int AllocationSiteFeedback::FindSite(HeapObject* site, bool insert) {
+  HashMap::Entry* entry = site_map_.Lookup(site, SiteHash(site), false);
+  if (entry != NULL) {
+    return static_cast<int>(reinterpret_cast<intptr_t>(entry->value)) - 1;
+  }
+  if (!insert || sites_.length() >= kMaxSites) return -1;
+  Site new_site = { site, NOT_TENURED, 0, 0, 0, 0 };
+  sites_.Add(new_site);
+  entry = site_map_.Lookup(site, SiteHash(site), true);
+  int index = sites_.length() - 1;
+  entry->value = reinterpret_cast<void*>(static_cast<intptr_t>(index + 1));
+  return index;
+}
+
+
+void AllocationSiteFeedback::RecordAllocation(HeapObject* site,
+                                              HeapObject* object) {
+  int index = FindSite(site, true);
+  if (index < 0) return;
+  Site* entry = &sites_[index];
+  entry->allocations++;
+  if (entry->allocations % kSamplingInterval != 0) return;
+  if (samples_.length() >= kMaxSamples) return;
+  Sample sample = { object, index, entry->pretenure };
+  samples_.Add(sample);
+}
+
+
+void AllocationSiteFeedback::UpdateAfterScavenge() {
+  if (sites_.is_empty()) return;
+
+  int last = 0;
+  for (int i = 0; i < samples_.length(); i++) {
+    Sample sample = samples_[i];
+    if (heap_->InFromSpace(sample.object)) {
+      RecordSurvival(sample, sample.object->map_word().IsForwardingAddress());
+    } else {
+      samples_[last++] = sample;
+    }
+  }
+  samples_.Rewind(last);
+
+  bool sites_moved = false;
+  for (int i = 0; i < sites_.length(); i++) {
+    HeapObject* site = sites_[i].object;
+    if (!heap_->InFromSpace(site)) continue;
+    MapWord map_word = site->map_word();
+    sites_[i].object = map_word.IsForwardingAddress()
+        ? map_word.ToForwardingAddress()
+        : NULL;
+    sites_moved = true;
+  }
+  if (sites_moved) RemoveDeadSites();
+}
+
+
+void AllocationSiteFeedback::ProcessWeakReferences(
+    WeakObjectRetainer* retainer) {
+  if (sites_.is_empty()) return;
+
+  for (int i = 0; i < samples_.length(); i++) {
+    Sample sample = samples_[i];
+    RecordSurvival(sample, retainer->RetainAs(sample.object) != NULL);
+  }
+  samples_.Rewind(0);
+
+  for (int i = 0; i < sites_.length(); i++) {
+    Object* retained = retainer->RetainAs(sites_[i].object);
+    sites_[i].object =
+        (retained == NULL) ? NULL : HeapObject::cast(retained);
+  }
+  RemoveDeadSites();
+}
+
+
+void AllocationSiteFeedback::RecordSurvival(const Sample& sample,
+                                            bool survived) {
+  Site* site = &sites_[sample.site_index];
+  // Samples taken before the last decision do not count for the next one.
+  if (site->object == NULL || site->pretenure != sample.pretenure) return;
+  if (survived) {
+    site->survived++;
+  } else {
+    site->died++;
+  }
+  if (site->survived + site->died >= kMinimumSamples) Decide(site);
+}
+
+
+void AllocationSiteFeedback::Decide(Site* site) {
+  int survival_percent = site->survived * 100 / (site->survived + site->died);
+  site->survived = 0;
+  site->died = 0;
+
+  PretenureFlag decision = site->pretenure;
+  if (site->pretenure == NOT_TENURED) {
+    if (survival_percent >= kTenureSurvivalPercent) decision = TENURED;
+  } else {
+    if (survival_percent < kUntenureSurvivalPercent) decision = NOT_TENURED;
+  }
+  if (decision == site->pretenure ||
+      site->decision_changes >= kMaxDecisionChanges) {
+    return;
+  }
+
+  site->pretenure = decision;
+  site->decision_changes++;
+  if (FLAG_trace_pretenuring) {
+    PrintF("[Pretenuring] Site %p allocates %s, %d%% of samples survived\n",
+           reinterpret_cast<void*>(site->object),
+           (decision == TENURED) ? "tenured" : "in new space",
+           survival_percent);
+  }
+}
+
+
+void AllocationSiteFeedback::RemoveDeadSites() {
+  List<int> new_indices(sites_.length());
+  int live = 0;
+  for (int i = 0; i < sites_.length(); i++) {
+    if (sites_[i].object == NULL) {
+      new_indices.Add(-1);
+    } else {
+      new_indices.Add(live);
+      sites_[live++] = sites_[i];
+    }
+  }
+  sites_.Rewind(live);
+
+  int last = 0;
+  for (int i = 0; i < samples_.length(); i++) {
+    Sample sample = samples_[i];
+    sample.site_index = new_indices[sample.site_index];
+    if (sample.site_index >= 0) samples_[last++] = sample;
+  }
+  samples_.Rewind(last);
+
+  // Sites are keyed by address, so the map is rebuilt.
+  site_map_.Clear();
+  for (int i = 0; i < sites_.length(); i++) {
+    HeapObject* site = sites_[i].object;
+    HashMap::Entry* entry = site_map_.Lookup(site, SiteHash(site), true);
+    entry->value = reinterpret_cast<void*>(static_cast<intptr_t>(i + 1));
+  }
+}
+
+
+void AllocationSiteFeedback::TearDown() {
+  site_map_.Clear();
+  sites_.Free();
+  samples_.Free();
+}
+
+
 void ExternalStringTable::CleanUp() {
   int last = 0;
   for (int i = 0; i < new_space_strings_.length(); ++i) {
@@ -32,6 +32,7 @@
 
 #include "allocation.h"
 #include "globals.h"
+#include "hashmap.h"
 #include "incremental-marking.h"
 #include "list.h"
 #include "mark-compact.h"
@@ -142,6 +143,7 @@ inline Heap* _inline_get_heap_();
   V(Script, empty_script, EmptyScript)                                         \
   V(Smi, real_stack_limit, RealStackLimit)                                     \
   V(StringDictionary, intrinsic_function_names, IntrinsicFunctionNames)        \
+  V(Smi, construct_stub_deopt_pc_offset, ConstructStubDeoptPCOffset)           \
 
 #define ROOT_LIST(V)                                  \
   STRONG_ROOT_LIST(V)                                 \
@@ -236,6 +238,7 @@ inline Heap* _inline_get_heap_();
   V(minus_infinity_symbol, "-Infinity")
 
 // Forward declarations.
+class AllocationSampler;
 class GCTracer;
 class HeapStats;
 class Isolate;
@@ -325,6 +328,162 @@ typedef void (*ScavengingCallback)(Map* map,
                                    HeapObject* object);
 
 
+// Parallel scavenging.
+//
+// With --parallel-scavenge the copying phase of a scavenge is shared between
+// the main thread and --scavenge-threads - 1 helper threads.  The slots
+// found by iterating the roots and the store buffer are collected first and
+// then claimed by the tasks in chunks.  Every task copies objects into its
+// own local allocation buffers in to-space and in the old spaces, so only
+// refilling a buffer takes a lock, and installs the forwarding address with
+// a compare-and-swap on the map word; a task that loses the race gives its
+// copy back and uses the winner's.  A task scans the objects it copied
+// itself.  Slots of promoted objects that still point to new space are
+// entered into the store buffer by the main thread once all tasks are done.
+class ParallelScavengingTask;
+class ParallelScavengingThread;
+
+class ParallelScavenger {
+ public:
+  explicit ParallelScavenger(Heap* heap);
+  ~ParallelScavenger();
+
+  int tasks() { return tasks_; }
+
+  // Adds a slot pointing into from space to the work of the next Scavenge.
+  void AddRoot(HeapObject** slot) { roots_.Add(slot); }
+
+  // Store buffer callback that adds the slot to the roots.
+  static void AddStoreBufferRoot(HeapObject** slot, HeapObject* object);
+
+  // Copies everything transitively reachable from the roots added so far.
+  void Scavenge();
+
+  // Entry point of the helper threads and of the main thread while a
+  // Scavenge is in progress.
+  void Work(int task_id);
+
+  // Number of root slots a task claims at a time.
+  static const int kRootsPerClaim = 64;
+
+ private:
+  // Allocation of local allocation buffers and of objects that are too
+  // large for them.  Serialized by allocation_mutex_.
+  HeapObject* AllocateInNewSpace(int size_in_bytes);
+  HeapObject* AllocateInOldSpace(OldSpace* space, int size_in_bytes);
+  HeapObject* AllocateInLargeObjectSpace(int size_in_bytes);
+
+  Heap* heap_;
+  int tasks_;
+  ParallelScavengingTask** task_state_;
+  ParallelScavengingThread** threads_;
+
+  List<HeapObject**> roots_;
+  Atomic32 next_root_;
+
+  Mutex* allocation_mutex_;
+  Semaphore* done_semaphore_;
+
+  friend class ParallelScavengingTask;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelScavenger);
+};
+
+
+// Allocation site feedback for pretenuring.
+//
+// The allocation sites are the boilerplates of object and array literals
+// and the constructors of objects allocated with Heap::AllocateJSObject.
+// Every kSamplingInterval-th object allocated at a site is remembered as a
+// sample.  Samples in new space are resolved by the next scavenge or full
+// GC, samples in old space by the next full GC, and each counts as having
+// survived or died.  A site whose new space samples mostly survive is
+// switched to tenured allocation.  If most of its tenured samples then die
+// before the next full GC, the site goes back to allocating in new space.
+// A site changes its decision at most kMaxDecisionChanges times.
+//
+// Sites and samples are weak: a site that dies is forgotten, and its
+// samples with it.
+class AllocationSiteFeedback {
+ public:
+  explicit AllocationSiteFeedback(Heap* heap);
+
+  // Returns how objects allocated at the site should be allocated.
+  PretenureFlag GetPretenureFlag(HeapObject* site);
+
+  // Called after an object has been allocated at the site.
+  void RecordAllocation(HeapObject* site, HeapObject* object);
+
+  // Resolves the samples in new space and updates the sites in new space
+  // after a scavenge.
+  void UpdateAfterScavenge();
+
+  // Called by Heap::ProcessWeakReferences during a full GC.  Resolves all
+  // samples and forgets the sites the retainer does not retain.
+  void ProcessWeakReferences(WeakObjectRetainer* retainer);
+
+  void TearDown();
+
+  int number_of_sites() { return sites_.length(); }
+
+  static const int kSamplingInterval = 8;
+  static const int kMaxSites = 1024;
+  static const int kMaxSamples = 4 * KB;
+
+  // A decision is taken once this many samples have been resolved.
+  static const int kMinimumSamples = 32;
+
+  // Sites are tenured when at least this share of their samples survives
+  // in new space, and go back to new space when less than
+  // kUntenureSurvivalPercent of their tenured samples survive.
+  static const int kTenureSurvivalPercent = 85;
+  static const int kUntenureSurvivalPercent = 50;
+
+  static const int kMaxDecisionChanges = 2;
+
+ private:
+  struct Site {
+    HeapObject* object;
+    PretenureFlag pretenure;
+    int allocations;
+    int survived;
+    int died;
+    int decision_changes;
+  };
+
+  struct Sample {
+    HeapObject* object;
+    int site_index;
+    // The site's decision when the sample was taken.
+    PretenureFlag pretenure;
+  };
+
+  static bool SiteMatch(void* key1, void* key2) { return key1 == key2; }
+
+  static uint32_t SiteHash(HeapObject* site) {
+    return ComputePointerHash(site);
+  }
+
+  // Returns the index of the site in sites_, or -1 if it is not tracked.
+  int FindSite(HeapObject* site, bool insert);
+  void RecordSurvival(const Sample& sample, bool survived);
+  void Decide(Site* site);
+
+  // Drops the sites that died and the samples of those sites and rebuilds
+  // the site map.
+  void RemoveDeadSites();
+
+  Heap* heap_;
+  List<Site> sites_;
+  List<Sample> samples_;
+
+  // Maps the site objects to their index in sites_ plus one.
+  HashMap site_map_;
+
+  DISALLOW_COPY_AND_ASSIGN(AllocationSiteFeedback);
+};
+
+
 // External strings table is a place where all external strings are
 // registered.  We need to keep track of such strings to properly
 // finalize them.
@@ -458,6 +617,12 @@ class Heap {
   // Uncommit unused semi space.
   bool UncommitFromSpace() { return new_space_.UncommitFromSpace(); }
 
+  // Gives memory the heap does not currently need back to the OS: shrinks
+  // new space, uncommits from-space and discards the pages inside large
+  // free blocks of the paged spaces.  Returns the number of bytes
+  // discarded from the paged spaces.
+  intptr_t ReduceMemoryFootprint();
+
   // Allocates and initializes a new JavaScript object based on a
   // constructor.
   // Returns Failure::RetryAfterGC(requested_bytes, space) if the allocation
@@ -475,7 +640,9 @@ class Heap {
   // Returns a deep copy of the JavaScript object.
   // Properties and elements are copied too.
   // Returns failure if allocation failed.
-  MUST_USE_RESULT MaybeObject* CopyJSObject(JSObject* source);
+  MUST_USE_RESULT MaybeObject* CopyJSObject(
+      JSObject* source,
+      PretenureFlag pretenure = NOT_TENURED);
 
   // Allocates the function prototype.
   // Returns Failure::RetryAfterGC(requested_bytes, space) if the allocation
@@ -674,21 +841,29 @@ class Heap {
 
   // Make a copy of src and return it. Returns
   // Failure::RetryAfterGC(requested_bytes, space) if the allocation failed.
-  MUST_USE_RESULT inline MaybeObject* CopyFixedArray(FixedArray* src);
+  MUST_USE_RESULT inline MaybeObject* CopyFixedArray(
+      FixedArray* src,
+      PretenureFlag pretenure = NOT_TENURED);
 
   // Make a copy of src, set the map, and return the copy. Returns
   // Failure::RetryAfterGC(requested_bytes, space) if the allocation failed.
-  MUST_USE_RESULT MaybeObject* CopyFixedArrayWithMap(FixedArray* src, Map* map);
+  MUST_USE_RESULT MaybeObject* CopyFixedArrayWithMap(
+      FixedArray* src,
+      Map* map,
+      PretenureFlag pretenure = NOT_TENURED);
 
   // Make a copy of src and return it. Returns
   // Failure::RetryAfterGC(requested_bytes, space) if the allocation failed.
   MUST_USE_RESULT inline MaybeObject* CopyFixedDoubleArray(
-      FixedDoubleArray* src);
+      FixedDoubleArray* src,
+      PretenureFlag pretenure = NOT_TENURED);
 
   // Make a copy of src, set the map, and return the copy. Returns
   // Failure::RetryAfterGC(requested_bytes, space) if the allocation failed.
   MUST_USE_RESULT MaybeObject* CopyFixedDoubleArrayWithMap(
-      FixedDoubleArray* src, Map* map);
+      FixedDoubleArray* src,
+      Map* map,
+      PretenureFlag pretenure = NOT_TENURED);
 
   // Allocates a fixed array initialized with the hole values.
   // Returns Failure::RetryAfterGC(requested_bytes, space) if the allocation
@@ -942,6 +1117,14 @@ class Heap {
   // Last hope GC, should try to squeeze as much as possible.
   void CollectAllAvailableGarbage();
 
+  // Performs full garbage collections that charge every live object to
+  // the first global context, newest first, from which it is reachable.
+  // Objects reachable from the root list or the builtins, or only from
+  // other roots such as handles, are not charged.  Adds the global
+  // contexts and the bytes charged to each to the given lists.
+  void MeasureContextMemory(List<Handle<Context> >* contexts,
+                            List<intptr_t>* sizes);
+
   // Check whether the heap is currently iterable.
   bool IsHeapIterable();
 
@@ -952,6 +1135,15 @@ class Heap {
   // Notify the heap that a context has been disposed.
   int NotifyContextDisposed() { return ++contexts_disposed_; }
 
+  // Support for archiving the new space allocation buffer of a thread, see
+  // NewSpace::ArchiveAllocationBuffer.
+  static int ArchiveSpacePerThread() {
+    return sizeof(NewSpace::ThreadAllocationBuffer);
+  }
+  char* ArchiveThread(char* to);
+  char* RestoreThread(char* from);
+  void FreeThreadResources() { new_space_.RetireAllocationBuffer(); }
+
   // Utility to invoke the scavenger. This is needed in test code to
   // ensure correct callback for weak global handles.
   void PerformScavenge();
@@ -1038,6 +1230,8 @@ class Heap {
   void IterateRoots(ObjectVisitor* v, VisitMode mode);
   // Iterates over all strong roots in the heap.
   void IterateStrongRoots(ObjectVisitor* v, VisitMode mode);
+  // Iterates over the strong part of the root list only.
+  void IterateRootList(ObjectVisitor* v);
   // Iterates over all the other roots in the heap.
   void IterateWeakRoots(ObjectVisitor* v, VisitMode mode);
 
@@ -1096,6 +1290,13 @@ class Heap {
   // Update the next script id.
   inline void SetLastScriptId(Object* last_script_id);
 
+  // Record the offset of the return address of the call in the generic
+  // construct stub, at which deoptimized construct stub frames resume.
+  void SetConstructStubDeoptPCOffset(int pc_offset) {
+    ASSERT(construct_stub_deopt_pc_offset() == Smi::FromInt(0));
+    set_construct_stub_deopt_pc_offset(Smi::FromInt(pc_offset));
+  }
+
   // Generated code can embed this address to get access to the roots.
   Object** roots_address() { return roots_; }
 
@@ -1266,6 +1467,11 @@ class Heap {
   // Can be called when the embedding application is idle.
   bool IdleNotification();
 
+  // Can be called when the embedding application is idle for about the
+  // given time.  Does the GC work expected to fit and returns true if there
+  // is no more work to do when idle.
+  bool IdleNotification(int idle_time_in_ms);
+
   // Declare all the root indices.
   enum RootListIndex {
 #define ROOT_INDEX_DECLARATION(type, name, camel_name) k##camel_name##RootIndex,
@@ -1371,6 +1577,47 @@ class Heap {
   // Returns minimal interval between two subsequent collections.
   int get_min_in_mutator() { return min_in_mutator_; }
 
+  // Sets goals for the longest pause and for the share of time spent in
+  // garbage collection, see v8::ResourceConstraints.  0 means no goal.
+  void SetGCGoals(int max_pause_ms, int max_gc_time_percentage);
+
+  bool HasGCGoals() {
+    return max_pause_goal_ms_ > 0 || max_gc_time_percentage_goal_ > 0;
+  }
+
+  // Called by the GCTracer at the end of every collection if goals are set.
+  void RecordGCTimes(GarbageCollector collector,
+                     double pause_ms,
+                     double mutator_ms,
+                     double marking_ms,
+                     bool marked_incrementally);
+
+  // Called after every incremental marking step if goals are set.
+  void RecordIncrementalMarkingStep(intptr_t marked_bytes, double ms);
+
+  // Returns how many bytes an incremental marking step may process to stay
+  // within the pause goal, or 0 if there is no such limit.
+  intptr_t MaxIncrementalMarkingStepSize();
+
+  // Returns true if incremental marking has to start now so it can finish in
+  // steps that fit the pause goal before the next full GC is due.
+  bool IncrementalMarkingNeededForPauseGoal();
+
+  // Returns true if a scavenge that has to copy the given number of bytes
+  // would take longer than the pause goal.
+  bool ScavengeExceedsPauseGoal(intptr_t survived_bytes) {
+    return max_pause_goal_ms_ > 0 &&
+           scavenge_speed_ > 0 &&
+           survived_bytes / scavenge_speed_ > max_pause_goal_ms_;
+  }
+
+  // Returns true if more time is spent in garbage collection than the
+  // throughput goal allows.
+  bool ThroughputGoalMissed() {
+    return max_gc_time_percentage_goal_ > 0 &&
+           gc_time_ratio_ * 100 > max_gc_time_percentage_goal_;
+  }
+
   MarkCompactCollector* mark_compact_collector() {
     return &mark_compact_collector_;
   }
@@ -1391,6 +1638,19 @@ class Heap {
     return &external_string_table_;
   }
 
+  AllocationSiteFeedback* allocation_site_feedback() {
+    return &allocation_site_feedback_;
+  }
+
+  // Reports allocations to the given sampler until sampling is stopped.
+  // The sampler is owned by the caller.
+  void StartAllocationSampling(AllocationSampler* sampler);
+  void StopAllocationSampling();
+  bool IsSamplingAllocations() { return allocation_sampler_ != NULL; }
+
+  // Called by the spaces while sampling, see AllocationSampler::Step.
+  void AllocationSamplingStep(intptr_t bytes_allocated, Address soon_object);
+
   // Returns the current sweep generation.
   int sweep_generation() {
     return sweep_generation_;
@@ -1652,6 +1912,18 @@ class Heap {
       Object** pointer);
 
   Address DoScavenge(ObjectVisitor* scavenge_visitor, Address new_space_front);
+
+  // Visits the value slots of all global property cells.
+  void IterateCellValues(ObjectVisitor* v);
+
+  // Returns true if the copying phase of the current scavenge can be done by
+  // the parallel scavenger.
+  bool CanScavengeInParallel();
+
+  // Copies everything reachable from the roots, the store buffer, the cells
+  // and the global contexts list using the parallel scavenger.
+  void ScavengeInParallel();
+
   static void ScavengeStoreBufferCallback(Heap* heap,
                                           MemoryChunk* page,
                                           StoreBufferEvent event);
@@ -1758,6 +2030,33 @@ class Heap {
 
   double last_gc_end_timestamp_;
 
+  // End of the last collection, for the memory reducer.
+  double memory_reducer_last_gc_ms_;
+
+  // Goals set by the embedder, 0 if there is none.
+  int max_pause_goal_ms_;
+  int max_gc_time_percentage_goal_;
+
+  // Measured speeds in bytes per millisecond, 0 until measured.
+  intptr_t scavenge_speed_;
+  intptr_t marking_speed_;
+
+  // Duration of the last incremental marking cycle finished when idle.
+  double idle_finalization_time_ms_;
+
+  // Moving average of the share of time spent in garbage collection.
+  double gc_time_ratio_;
+
+  // Speeds in bytes per millisecond that idle notifications assume until
+  // the real ones have been measured.
+  static const intptr_t kInitialIdleMarkingSpeed = 100 * KB;
+  static const intptr_t kInitialIdleScavengeSpeed = 100 * KB;
+  static const intptr_t kIdleSweepingSpeed = 512 * KB;
+
+  intptr_t EstimatedScavengeTimeInMs();
+  intptr_t EstimatedFinalizationTimeInMs();
+  bool WorthStartingIncrementalMarkingWhenIdle();
+
   MarkCompactCollector mark_compact_collector_;
 
   StoreBuffer store_buffer_;
@@ -1773,12 +2072,19 @@ class Heap {
   // Shared state read by the scavenge collector and set by ScavengeObject.
   PromotionQueue promotion_queue_;
 
+  // Created on the first parallel scavenge.
+  ParallelScavenger* parallel_scavenger_;
+
   // Flag is set when the heap has been configured.  The heap can be repeatedly
   // configured through the API until it is setup.
   bool configured_;
 
   ExternalStringTable external_string_table_;
 
+  AllocationSiteFeedback allocation_site_feedback_;
+
+  AllocationSampler* allocation_sampler_;
+
   VisitorDispatchTable<ScavengingCallback> scavenging_visitors_table_;
 
   MemoryChunk* chunks_queued_for_free_;
@@ -1791,6 +2097,7 @@ class Heap {
   friend class Page;
   friend class Isolate;
   friend class MarkCompactCollector;
+  friend class ParallelScavenger;
   friend class StaticMarkingVisitor;
   friend class MapCompact;
 
@@ -29,6 +29,7 @@
 
 #include "factory.h"
 #include "hydrogen.h"
+#include "optimizing-compiler-thread.h"
 
 #if V8_TARGET_ARCH_IA32
 #include "ia32/lithium-ia32.h"
@@ -1154,6 +1155,15 @@ void HSimulate::PrintDataTo(StringStream* stream) {
 }
 
 
+void HCapturedObject::PrintDataTo(StringStream* stream) {
+  stream->Add("#%d", object_id());
+  for (int i = 0; i < values_.length(); ++i) {
+    stream->Add(" ");
+    values_[i]->PrintNameTo(stream);
+  }
+}
+
+
 void HDeoptimize::PrintDataTo(StringStream* stream) {
   if (OperandCount() == 0) return;
   OperandAt(0)->PrintNameTo(stream);
@@ -1556,6 +1566,7 @@ void HStoreNamedField::PrintDataTo(StringStream* stream) {
   if (!transition().is_null()) {
     stream->Add(" (transition map %p)", *transition());
   }
+  if (object_is_fresh()) stream->Add(" (no write barrier)");
 }
 
 
@@ -1565,6 +1576,7 @@ void HStoreKeyedFastElement::PrintDataTo(StringStream* stream) {
   key()->PrintNameTo(stream);
   stream->Add("] = ");
   value()->PrintNameTo(stream);
+  if (object_is_fresh()) stream->Add(" (no write barrier)");
 }
 
 
@@ -1801,6 +1813,24 @@ HType HSar::CalculateInferredType() {
 }
 
 
+HType HAllocateObject::CalculateInferredType() {
+  return HType::JSObject();
+}
+
+
+bool HAllocateObject::IsAllocationInlineable(Handle<JSFunction> constructor) {
+  if (!constructor->has_initial_map()) return false;
+  if (constructor->shared()->IsApiFunction()) return false;
+  Map* initial_map = constructor->initial_map();
+  if (initial_map->instance_type() != JS_OBJECT_TYPE) return false;
+  // All properties of a new object have to fit in the object itself, there
+  // is no property backing store to allocate.
+  return initial_map->pre_allocated_property_fields() +
+      initial_map->unused_property_fields() -
+      initial_map->inobject_properties() == 0;
+}
+
+
 HValue* HUnaryMathOperation::EnsureAndPropagateNotMinusZero(
     BitVector* visited) {
   visited->Add(id());
@@ -1898,6 +1928,14 @@ void HIn::PrintDataTo(StringStream* stream) {
 // Node-specific verification code is only included in debug mode.
 #ifdef DEBUG
 
+bool HValue::IsHandleDereferenceAllowed() {
+  Isolate* isolate = Isolate::Current();
+  OptimizingCompilerThread* thread = isolate->optimizing_compiler_thread();
+  if (thread != NULL && thread->IsOptimizerThread()) return true;
+  return !isolate->heap()->IsAllocationAllowed();
+}
+
+
 void HPhi::Verify() {
   ASSERT(OperandCount() == block()->predecessors()->length());
   for (int i = 0; i < OperandCount(); ++i) {
@@ -62,6 +62,7 @@ class LChunkBuilder;
   V(AbnormalExit)                              \
   V(AccessArgumentsAt)                         \
   V(Add)                                       \
+  V(AllocateObject)                            \
   V(ApplyArguments)                            \
   V(ArgumentsElements)                         \
   V(ArgumentsLength)                           \
@@ -83,6 +84,7 @@ class LChunkBuilder;
   V(CallNew)                                   \
   V(CallRuntime)                               \
   V(CallStub)                                  \
+  V(CapturedObject)                            \
   V(Change)                                    \
   V(CheckFunction)                             \
   V(CheckInstanceType)                         \
@@ -657,6 +659,11 @@ class HValue: public ZoneObject {
 
 #ifdef DEBUG
   virtual void Verify() = 0;
+
+  // Handles in the graph may be dereferenced on the main thread while
+  // allocation is disallowed, and on the compiler thread, which never
+  // allocates and is kept out of the way of collections.
+  static bool IsHandleDereferenceAllowed();
 #endif
 
  protected:
@@ -1246,6 +1253,47 @@ class HSimulate: public HInstruction {
 };
 
 
+// The in-object field values of an object literal that is not allocated
+// because it does not escape. Deoptimization environments refer to the
+// object through its latest snapshot, and the deoptimizer allocates the
+// object from it.
+class HCapturedObject: public HInstruction {
+ public:
+  HCapturedObject(int object_id, Handle<JSObject> boilerplate, int length)
+      : object_id_(object_id),
+        boilerplate_(boilerplate),
+        values_(length) {
+    for (int i = 0; i < length; ++i) values_.Add(NULL);
+  }
+
+  virtual void PrintDataTo(StringStream* stream);
+
+  // All snapshots of the same object share its id.
+  int object_id() const { return object_id_; }
+  // The deoptimizer allocates the object as a copy of the boilerplate.
+  Handle<JSObject> boilerplate() const { return boilerplate_; }
+
+  virtual int OperandCount() { return values_.length(); }
+  virtual HValue* OperandAt(int index) { return values_[index]; }
+
+  virtual Representation RequiredInputRepresentation(int index) {
+    return Representation::None();
+  }
+
+  DECLARE_CONCRETE_INSTRUCTION(CapturedObject)
+
+ protected:
+  virtual void InternalSetOperandAt(int index, HValue* value) {
+    values_[index] = value;
+  }
+
+ private:
+  int object_id_;
+  Handle<JSObject> boilerplate_;
+  ZoneList<HValue*> values_;
+};
+
+
 class HStackCheck: public HTemplateInstruction<1> {
  public:
   enum Type {
@@ -1285,10 +1333,14 @@ class HEnterInlined: public HTemplateInstruction<0> {
  public:
   HEnterInlined(Handle<JSFunction> closure,
                 FunctionLiteral* function,
-                CallKind call_kind)
+                CallKind call_kind,
+                bool is_construct,
+                ZoneList<HValue*>* arguments_values)
       : closure_(closure),
         function_(function),
-        call_kind_(call_kind) {
+        call_kind_(call_kind),
+        is_construct_(is_construct),
+        arguments_values_(arguments_values) {
   }
 
   virtual void PrintDataTo(StringStream* stream);
@@ -1296,6 +1348,10 @@ class HEnterInlined: public HTemplateInstruction<0> {
   Handle<JSFunction> closure() const { return closure_; }
   FunctionLiteral* function() const { return function_; }
   CallKind call_kind() const { return call_kind_; }
+  bool is_construct() const { return is_construct_; }
+  // The receiver and the arguments of the inlined call. They are not
+  // operands, the inlined environment refers to them instead.
+  ZoneList<HValue*>* arguments_values() const { return arguments_values_; }
 
   virtual Representation RequiredInputRepresentation(int index) {
     return Representation::None();
@@ -1307,6 +1363,8 @@ class HEnterInlined: public HTemplateInstruction<0> {
   Handle<JSFunction> closure_;
   FunctionLiteral* function_;
   CallKind call_kind_;
+  bool is_construct_;
+  ZoneList<HValue*>* arguments_values_;
 };
 
 
@@ -2071,7 +2129,7 @@ class HCheckPrototypeMaps: public HTemplateInstruction<0> {
   }
 
   virtual intptr_t Hashcode() {
-    ASSERT(!HEAP->IsAllocationAllowed());
+    ASSERT(IsHandleDereferenceAllowed());
     intptr_t hash = reinterpret_cast<intptr_t>(*prototype());
     hash = 17 * hash + reinterpret_cast<intptr_t>(*holder());
     return hash;
@@ -2300,7 +2358,7 @@ class HConstant: public HTemplateInstruction<0> {
   bool ToBoolean() const;
 
   virtual intptr_t Hashcode() {
-    ASSERT(!HEAP->allow_allocation(false));
+    ASSERT(IsHandleDereferenceAllowed());
     return reinterpret_cast<intptr_t>(*handle());
   }
 
@@ -3205,7 +3263,7 @@ class HLoadGlobalCell: public HTemplateInstruction<0> {
   virtual void PrintDataTo(StringStream* stream);
 
   virtual intptr_t Hashcode() {
-    ASSERT(!HEAP->allow_allocation(false));
+    ASSERT(IsHandleDereferenceAllowed());
     return reinterpret_cast<intptr_t>(*cell_);
   }
 
@@ -3656,7 +3714,8 @@ class HStoreNamedField: public HTemplateInstruction<2> {
                    int offset)
       : name_(name),
         is_in_object_(in_object),
-        offset_(offset) {
+        offset_(offset),
+        object_is_fresh_(false) {
     SetOperandAt(0, obj);
     SetOperandAt(1, val);
     if (is_in_object_) {
@@ -3682,14 +3741,23 @@ class HStoreNamedField: public HTemplateInstruction<2> {
   Handle<Map> transition() const { return transition_; }
   void set_transition(Handle<Map> map) { transition_ = map; }
 
+  // Set when the receiver is known to be a new-space object that was
+  // allocated with no possible GC in between; see HWriteBarrierEliminator.
+  bool object_is_fresh() const { return object_is_fresh_; }
+  void set_object_is_fresh() {
+    ASSERT(is_in_object_);
+    object_is_fresh_ = true;
+  }
+
   bool NeedsWriteBarrier() {
-    return StoringValueNeedsWriteBarrier(value());
+    return !object_is_fresh_ && StoringValueNeedsWriteBarrier(value());
   }
 
  private:
   Handle<String> name_;
   bool is_in_object_;
   int offset_;
+  bool object_is_fresh_;
   Handle<Map> transition_;
 };
 
@@ -3733,7 +3801,7 @@ class HStoreKeyedFastElement: public HTemplateInstruction<3> {
  public:
   HStoreKeyedFastElement(HValue* obj, HValue* key, HValue* val,
                          ElementsKind elements_kind = FAST_ELEMENTS)
-      : elements_kind_(elements_kind) {
+      : elements_kind_(elements_kind), object_is_fresh_(false) {
     SetOperandAt(0, obj);
     SetOperandAt(1, key);
     SetOperandAt(2, val);
@@ -3754,8 +3822,13 @@ class HStoreKeyedFastElement: public HTemplateInstruction<3> {
     return elements_kind_ == FAST_SMI_ONLY_ELEMENTS;
   }
 
+  // Set when the backing store is known to be a new-space object that was
+  // allocated with no possible GC in between; see HWriteBarrierEliminator.
+  bool object_is_fresh() const { return object_is_fresh_; }
+  void set_object_is_fresh() { object_is_fresh_ = true; }
+
   bool NeedsWriteBarrier() {
-    if (value_is_smi()) {
+    if (value_is_smi() || object_is_fresh_) {
       return false;
     } else {
       return StoringValueNeedsWriteBarrier(value());
@@ -3772,6 +3845,7 @@ class HStoreKeyedFastElement: public HTemplateInstruction<3> {
 
  private:
   ElementsKind elements_kind_;
+  bool object_is_fresh_;
 };
 
 
@@ -3995,6 +4069,34 @@ class HStringLength: public HUnaryOperation {
 };
 
 
+class HAllocateObject: public HTemplateInstruction<0> {
+ public:
+  explicit HAllocateObject(Handle<JSFunction> constructor)
+      : constructor_(constructor) {
+    set_representation(Representation::Tagged());
+  }
+
+  // The object is allocated in new space with the instance size of the
+  // constructor's initial map, which must not change while the code is in
+  // use.  The map itself is loaded from the constructor when the object is
+  // allocated.
+  static bool IsAllocationInlineable(Handle<JSFunction> constructor);
+
+  Handle<JSFunction> constructor() const { return constructor_; }
+
+  virtual Representation RequiredInputRepresentation(int index) {
+    return Representation::None();
+  }
+
+  virtual HType CalculateInferredType();
+
+  DECLARE_CONCRETE_INSTRUCTION(AllocateObject)
+
+ private:
+  Handle<JSFunction> constructor_;
+};
+
+
 template <int V>
 class HMaterializedLiteral: public HTemplateInstruction<V> {
  public:
@@ -4021,7 +4123,8 @@ class HArrayLiteral: public HMaterializedLiteral<1> {
                 int depth)
       : HMaterializedLiteral<1>(literal_index, depth),
         length_(length),
-        constant_elements_(constant_elements) {
+        constant_elements_(constant_elements),
+        requires_new_space_(false) {
     SetOperandAt(0, context);
   }
 
@@ -4031,6 +4134,12 @@ class HArrayLiteral: public HMaterializedLiteral<1> {
 
   bool IsCopyOnWrite() const;
 
+  // Stores into the literal were compiled without write barriers, so the
+  // generated code has to deoptimize unless the array and its elements were
+  // allocated in new space.
+  bool requires_new_space() const { return requires_new_space_; }
+  void set_requires_new_space() { requires_new_space_ = true; }
+
   virtual Representation RequiredInputRepresentation(int index) {
     return Representation::Tagged();
   }
@@ -4040,6 +4149,7 @@ class HArrayLiteral: public HMaterializedLiteral<1> {
  private:
   int length_;
   Handle<FixedArray> constant_elements_;
+  bool requires_new_space_;
 };
 
 
@@ -4054,7 +4164,8 @@ class HObjectLiteral: public HMaterializedLiteral<1> {
       : HMaterializedLiteral<1>(literal_index, depth),
         constant_properties_(constant_properties),
         fast_elements_(fast_elements),
-        has_function_(has_function) {
+        has_function_(has_function),
+        boilerplate_values_(NULL) {
     SetOperandAt(0, context);
   }
 
@@ -4065,6 +4176,22 @@ class HObjectLiteral: public HMaterializedLiteral<1> {
   bool fast_elements() const { return fast_elements_; }
   bool has_function() const { return has_function_; }
 
+  // The boilerplate, its map and its in-object property values, if the
+  // literal is known to be a copy of a boilerplate that has no elements and
+  // only in-object properties.
+  bool has_boilerplate_layout() const { return boilerplate_values_ != NULL; }
+  Handle<JSObject> boilerplate() const { return boilerplate_; }
+  Handle<Map> boilerplate_map() const { return boilerplate_map_; }
+  ZoneList<Handle<Object> >* boilerplate_values() const {
+    return boilerplate_values_;
+  }
+  void set_boilerplate_layout(Handle<JSObject> boilerplate,
+                              ZoneList<Handle<Object> >* values) {
+    boilerplate_ = boilerplate;
+    boilerplate_map_ = Handle<Map>(boilerplate->map());
+    boilerplate_values_ = values;
+  }
+
   virtual Representation RequiredInputRepresentation(int index) {
     return Representation::Tagged();
   }
@@ -4075,6 +4202,9 @@ class HObjectLiteral: public HMaterializedLiteral<1> {
   Handle<FixedArray> constant_properties_;
   bool fast_elements_;
   bool has_function_;
+  Handle<JSObject> boilerplate_;
+  Handle<Map> boilerplate_map_;
+  ZoneList<Handle<Object> >* boilerplate_values_;
 };
 
 
@@ -32,6 +32,7 @@
 #include "full-codegen.h"
 #include "hashmap.h"
 #include "lithium-allocator.h"
+#include "optimizing-compiler-thread.h"
 #include "parser.h"
 #include "scopeinfo.h"
 #include "scopes.h"
@@ -167,7 +168,7 @@ void HBasicBlock::Finish(HControlInstruction* end) {
 void HBasicBlock::Goto(HBasicBlock* block) {
   if (block->IsInlineReturnTarget()) {
     AddInstruction(new(zone()) HLeaveInlined);
-    last_environment_ = last_environment()->outer();
+    last_environment_ = last_environment()->DiscardInlined();
   }
   AddSimulate(AstNode::kNoNumber);
   HGoto* instr = new(zone()) HGoto(block);
@@ -179,7 +180,7 @@ void HBasicBlock::AddLeaveInlined(HValue* return_value, HBasicBlock* target) {
   ASSERT(target->IsInlineReturnTarget());
   ASSERT(return_value != NULL);
   AddInstruction(new(zone()) HLeaveInlined);
-  last_environment_ = last_environment()->outer();
+  last_environment_ = last_environment()->DiscardInlined();
   last_environment()->Push(return_value);
   AddSimulate(AstNode::kNoNumber);
   HGoto* instr = new(zone()) HGoto(target);
@@ -541,7 +542,7 @@ HConstant* HGraph::GetConstantHole() {
 HGraphBuilder::HGraphBuilder(CompilationInfo* info,
                              TypeFeedbackOracle* oracle)
     : function_state_(NULL),
-      initial_function_state_(this, info, oracle),
+      initial_function_state_(this, info, oracle, false),
       ast_context_(NULL),
       break_scope_(NULL),
       graph_(NULL),
@@ -621,24 +622,29 @@ HGraph::HGraph(CompilationInfo* info)
 }
 
 
-Handle<Code> HGraph::Compile(CompilationInfo* info) {
+LChunk* HGraph::BuildChunk(CompilationInfo* info) {
   int values = GetMaximumValueID();
   if (values > LAllocator::max_initial_value_ids()) {
     if (FLAG_trace_bailout) PrintF("Function is too big\n");
-    return Handle<Code>::null();
+    return NULL;
   }
 
   LAllocator allocator(values, this);
   LChunkBuilder builder(info, this, &allocator);
   LChunk* chunk = builder.Build();
-  if (chunk == NULL) return Handle<Code>::null();
+  if (chunk == NULL) return NULL;
 
-  if (!FLAG_alloc_lithium) return Handle<Code>::null();
+  if (!FLAG_alloc_lithium) return NULL;
 
+  YieldHeapAccess();
   allocator.Allocate(chunk);
 
-  if (!FLAG_use_lithium) return Handle<Code>::null();
+  if (!FLAG_use_lithium) return NULL;
+  return chunk;
+}
+
 
+Handle<Code> HGraph::GenerateCode(LChunk* chunk, CompilationInfo* info) {
   MacroAssembler assembler(info->isolate(), NULL, 0);
   LCodeGen generator(chunk, &assembler, info);
 
@@ -1297,6 +1303,1092 @@ void HStackCheckEliminator::Process() {
 }
 
 
+// Removes write barriers from stores into objects that are known to live in
+// new space and that were allocated in the same function with no instruction
+// in between that could trigger a GC. Such a store never needs a store buffer
+// entry, and since the object is still white the incremental marker cannot
+// have scanned it either.
+class HWriteBarrierEliminator BASE_EMBEDDED {
+ public:
+  explicit HWriteBarrierEliminator(HGraph* graph)
+      : graph_(graph), fresh_at_exit_(graph->blocks()->length()) { }
+
+  void Process();
+
+ private:
+  typedef ZoneList<HValue*> FreshSet;
+
+  static bool CannotTriggerGC(HInstruction* instr);
+  FreshSet* FreshAtEntry(HBasicBlock* block);
+  void MarkFresh(HValue* object, FreshSet* fresh);
+
+  HGraph* graph_;
+  ZoneList<FreshSet*> fresh_at_exit_;
+};
+
+
+bool HWriteBarrierEliminator::CannotTriggerGC(HInstruction* instr) {
+  switch (instr->opcode()) {
+    case HValue::kBlockEntry:
+    case HValue::kSimulate:
+    case HValue::kCapturedObject:
+    case HValue::kConstant:
+    case HValue::kContext:
+    case HValue::kOuterContext:
+    case HValue::kGlobalObject:
+    case HValue::kGlobalReceiver:
+    case HValue::kParameter:
+    case HValue::kThisFunction:
+    case HValue::kUseConst:
+    case HValue::kPushArgument:
+    case HValue::kEnterInlined:
+    case HValue::kLeaveInlined:
+    case HValue::kLoadElements:
+    case HValue::kElementsKind:
+    case HValue::kFixedArrayBaseLength:
+    case HValue::kJSArrayLength:
+    case HValue::kLoadNamedField:
+    case HValue::kLoadKeyedFastElement:
+    case HValue::kLoadContextSlot:
+    case HValue::kLoadGlobalCell:
+    case HValue::kStoreNamedField:
+    case HValue::kStoreKeyedFastElement:
+    case HValue::kStoreContextSlot:
+    case HValue::kBoundsCheck:
+    case HValue::kCheckFunction:
+    case HValue::kCheckInstanceType:
+    case HValue::kCheckMap:
+    case HValue::kCheckNonSmi:
+    case HValue::kCheckPrototypeMaps:
+    case HValue::kCheckSmi:
+    case HValue::kGoto:
+    case HValue::kBranch:
+    case HValue::kCompareMap:
+    case HValue::kCompareConstantEqAndBranch:
+    case HValue::kCompareObjectEqAndBranch:
+    case HValue::kIsSmiAndBranch:
+    case HValue::kIsNilAndBranch:
+    case HValue::kIsObjectAndBranch:
+    case HValue::kHasInstanceTypeAndBranch:
+      return true;
+    default:
+      // Calls, stack checks, tagged arithmetic and representation changes
+      // (which may box a double) can all allocate.
+      return false;
+  }
+}
+
+
+HWriteBarrierEliminator::FreshSet* HWriteBarrierEliminator::FreshAtEntry(
+    HBasicBlock* block) {
+  FreshSet* fresh = new FreshSet(2);
+  const ZoneList<HBasicBlock*>* predecessors = block->predecessors();
+  if (predecessors->is_empty()) return fresh;
+  // Blocks are in reverse post order, so only back edges come from blocks
+  // that have not been processed yet; a loop header starts out empty.
+  for (int i = 0; i < predecessors->length(); ++i) {
+    if (predecessors->at(i)->block_id() >= block->block_id()) return fresh;
+  }
+  // An object is fresh on entry if it is fresh at the end of every
+  // predecessor.
+  FreshSet* first = fresh_at_exit_[predecessors->at(0)->block_id()];
+  for (int i = 0; i < first->length(); ++i) {
+    HValue* object = first->at(i);
+    bool everywhere = true;
+    for (int j = 1; j < predecessors->length() && everywhere; ++j) {
+      everywhere =
+          fresh_at_exit_[predecessors->at(j)->block_id()]->Contains(object);
+    }
+    if (everywhere) fresh->Add(object);
+  }
+  return fresh;
+}
+
+
+void HWriteBarrierEliminator::MarkFresh(HValue* object, FreshSet* fresh) {
+  // Inline allocated objects always live in new space.
+  if (object->IsAllocateObject()) {
+    fresh->Add(object);
+    return;
+  }
+  if (!object->IsArrayLiteral()) return;
+  HArrayLiteral* literal = HArrayLiteral::cast(object);
+  // Only literals cloned by FastCloneShallowArrayStub are allocated in new
+  // space.  Copy-on-write literals share their elements with the
+  // boilerplate, and the runtime functions used for nested and long
+  // literals pretenure the copies of tenured allocation sites, which would
+  // make the new-space check in the generated code fail every time.
+  if (literal->IsCopyOnWrite() ||
+      literal->depth() > 1 ||
+      literal->length() > FastCloneShallowArrayStub::kMaximumClonedLength) {
+    return;
+  }
+  fresh->Add(literal);
+}
+
+
+void HWriteBarrierEliminator::Process() {
+  HPhase phase("Write barrier elimination", graph_);
+  const ZoneList<HBasicBlock*>* blocks = graph_->blocks();
+  for (int i = 0; i < blocks->length(); ++i) {
+    HBasicBlock* block = blocks->at(i);
+    ASSERT(block->block_id() == i);
+    FreshSet* fresh = FreshAtEntry(block);
+    for (HInstruction* instr = block->first();
+         instr != NULL;
+         instr = instr->next()) {
+      if (instr->IsStoreKeyedFastElement()) {
+        HStoreKeyedFastElement* store = HStoreKeyedFastElement::cast(instr);
+        HValue* elements = store->object();
+        if (elements->IsLoadElements() &&
+            fresh->Contains(HLoadElements::cast(elements)->value())) {
+          HArrayLiteral::cast(HLoadElements::cast(elements)->value())->
+              set_requires_new_space();
+          store->set_object_is_fresh();
+        }
+      } else if (instr->IsStoreNamedField()) {
+        HStoreNamedField* store = HStoreNamedField::cast(instr);
+        if (store->is_in_object() && fresh->Contains(store->object())) {
+          if (store->object()->IsArrayLiteral()) {
+            HArrayLiteral::cast(store->object())->set_requires_new_space();
+          }
+          store->set_object_is_fresh();
+        }
+      }
+      if (!CannotTriggerGC(instr)) {
+        fresh->Rewind(0);
+        // The object produced by an allocating instruction is itself fresh.
+        MarkFresh(instr, fresh);
+      }
+    }
+    fresh_at_exit_.Add(fresh);
+  }
+}
+
+
+// Escape analysis and scalar replacement of object literals. A literal with
+// a known boilerplate layout does not escape if it is only used by loads and
+// stores of its in-object fields, by smi and map checks and by simulates.
+// Such a literal is not allocated, and loads of its fields are replaced by
+// the values last stored to them. Simulates refer to HCapturedObject
+// snapshots of the field values instead, from which the deoptimizer
+// allocates the object. To do without phis for field values, a literal is
+// only replaced if its fields have the same values on all edges into a join
+// or loop header.
+class HEscapeAnalysis BASE_EMBEDDED {
+ public:
+  explicit HEscapeAnalysis(HGraph* graph)
+      : graph_(graph), zone_(graph->zone()) { }
+
+  void Process();
+
+ private:
+  typedef ZoneList<HValue*> FieldState;
+
+  bool HasOnlyScalarUses(HObjectLiteral* literal);
+  bool ReplaceFields(HObjectLiteral* literal, bool replace);
+  FieldState* CopyState(FieldState* state);
+  HCapturedObject* NewSnapshot(HObjectLiteral* literal, FieldState* state);
+
+  static int FieldIndex(HObjectLiteral* literal, bool is_in_object, int offset);
+  static bool SameState(FieldState* a, FieldState* b);
+
+  HGraph* graph_;
+  Zone* zone_;
+};
+
+
+void HEscapeAnalysis::Process() {
+  HPhase phase("Escape analysis", graph_);
+  // The receivers and arguments of inlined calls are read from the optimized
+  // frame by stack walks, which cannot handle captured objects.
+  BitVector inlined_arguments(graph_->GetMaximumValueID());
+  ZoneList<HObjectLiteral*> candidates(4);
+  for (int i = 0; i < graph_->blocks()->length(); ++i) {
+    HInstruction* instr = graph_->blocks()->at(i)->first();
+    for (; instr != NULL; instr = instr->next()) {
+      if (instr->IsEnterInlined()) {
+        ZoneList<HValue*>* arguments =
+            HEnterInlined::cast(instr)->arguments_values();
+        for (int j = 0; j < arguments->length(); ++j) {
+          inlined_arguments.Add(arguments->at(j)->id());
+        }
+      } else if (instr->IsObjectLiteral() &&
+                 HObjectLiteral::cast(instr)->has_boilerplate_layout()) {
+        candidates.Add(HObjectLiteral::cast(instr));
+      }
+    }
+  }
+
+  for (int i = 0; i < candidates.length(); ++i) {
+    HObjectLiteral* literal = candidates[i];
+    if (inlined_arguments.Contains(literal->id())) continue;
+    if (!HasOnlyScalarUses(literal)) continue;
+    // Check the field values at joins first, then rewrite the graph.
+    if (!ReplaceFields(literal, false)) continue;
+    bool replaced = ReplaceFields(literal, true);
+    ASSERT(replaced);
+    USE(replaced);
+    literal->DeleteAndReplaceWith(NULL);
+  }
+}
+
+
+int HEscapeAnalysis::FieldIndex(HObjectLiteral* literal,
+                                bool is_in_object,
+                                int offset) {
+  int field_offset = offset - JSObject::kHeaderSize;
+  if (!is_in_object || field_offset < 0) return -1;
+  if (field_offset % kPointerSize != 0) return -1;
+  int index = field_offset / kPointerSize;
+  if (index >= literal->boilerplate_values()->length()) return -1;
+  return index;
+}
+
+
+bool HEscapeAnalysis::HasOnlyScalarUses(HObjectLiteral* literal) {
+  for (HUseIterator it(literal->uses()); !it.Done(); it.Advance()) {
+    HValue* use = it.value();
+    switch (use->opcode()) {
+      case HValue::kSimulate:
+        break;
+      case HValue::kCheckNonSmi:
+        if (!use->HasNoUses()) return false;
+        break;
+      case HValue::kCheckMap: {
+        HCheckMap* check = HCheckMap::cast(use);
+        if (check->value() != literal ||
+            !check->HasNoUses() ||
+            !check->map().is_identical_to(literal->boilerplate_map())) {
+          return false;
+        }
+        break;
+      }
+      case HValue::kLoadNamedField: {
+        HLoadNamedField* load = HLoadNamedField::cast(use);
+        if (FieldIndex(literal, load->is_in_object(), load->offset()) < 0) {
+          return false;
+        }
+        break;
+      }
+      case HValue::kStoreNamedField: {
+        HStoreNamedField* store = HStoreNamedField::cast(use);
+        if (store->object() != literal ||
+            store->value() == literal ||
+            !store->transition().is_null() ||
+            FieldIndex(literal, store->is_in_object(), store->offset()) < 0) {
+          return false;
+        }
+        break;
+      }
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+
+HEscapeAnalysis::FieldState* HEscapeAnalysis::CopyState(FieldState* state) {
+  FieldState* copy = new(zone_) FieldState(state->length());
+  copy->AddAll(*state);
+  return copy;
+}
+
+
+bool HEscapeAnalysis::SameState(FieldState* a, FieldState* b) {
+  ASSERT(a->length() == b->length());
+  for (int i = 0; i < a->length(); ++i) {
+    if (a->at(i) != b->at(i)) return false;
+  }
+  return true;
+}
+
+
+HCapturedObject* HEscapeAnalysis::NewSnapshot(HObjectLiteral* literal,
+                                              FieldState* state) {
+  HCapturedObject* snapshot =
+      new(zone_) HCapturedObject(literal->id(),
+                                 literal->boilerplate(),
+                                 state->length());
+  for (int i = 0; i < state->length(); ++i) {
+    snapshot->SetOperandAt(i, state->at(i));
+  }
+  return snapshot;
+}
+
+
+// Walks the blocks dominated by the literal in reverse post order and tracks
+// the values of its fields. Without |replace| it only checks that the field
+// values agree at joins, with NULL standing for the initial values.
+bool HEscapeAnalysis::ReplaceFields(HObjectLiteral* literal, bool replace) {
+  HBasicBlock* start = literal->block();
+  const ZoneList<HBasicBlock*>* blocks = graph_->blocks();
+  int length = literal->boilerplate_values()->length();
+
+  FieldState* initial = new(zone_) FieldState(length);
+  for (int i = 0; i < length; ++i) {
+    HConstant* constant = NULL;
+    if (replace) {
+      constant = new(zone_) HConstant(literal->boilerplate_values()->at(i),
+                                      Representation::Tagged());
+      constant->InsertBefore(literal);
+    }
+    initial->Add(constant);
+  }
+
+  // The field values on entry to loop headers and on exit from every block,
+  // with the snapshot describing the exit state, indexed by block id.
+  ZoneList<FieldState*> entry_states(blocks->length());
+  ZoneList<FieldState*> exit_states(blocks->length());
+  ZoneList<HCapturedObject*> exit_snapshots(blocks->length());
+  for (int i = 0; i < blocks->length(); ++i) {
+    entry_states.Add(NULL);
+    exit_states.Add(NULL);
+    exit_snapshots.Add(NULL);
+  }
+
+  for (int i = start->block_id(); i < blocks->length(); ++i) {
+    HBasicBlock* block = blocks->at(i);
+    if (block != start && !start->Dominates(block)) continue;
+
+    FieldState* state = NULL;
+    HCapturedObject* snapshot = NULL;
+    HInstruction* instr = NULL;
+    if (block == start) {
+      state = CopyState(initial);
+      instr = literal->next();
+    } else {
+      // All predecessors are dominated by the literal as well, and all but
+      // the back edges of loops have been visited.
+      const ZoneList<HBasicBlock*>* predecessors = block->predecessors();
+      int first = predecessors->at(0)->block_id();
+      state = CopyState(exit_states[first]);
+      if (predecessors->length() == 1) {
+        snapshot = exit_snapshots[first];
+      } else if (block->IsLoopHeader()) {
+        entry_states[i] = state;
+        state = CopyState(state);
+      } else {
+        for (int j = 1; j < predecessors->length(); ++j) {
+          int id = predecessors->at(j)->block_id();
+          if (!SameState(state, exit_states[id])) return false;
+        }
+      }
+      instr = block->first();
+    }
+
+    while (instr != NULL) {
+      HInstruction* next = instr->next();
+      if (instr->IsLoadNamedField()) {
+        HLoadNamedField* load = HLoadNamedField::cast(instr);
+        if (load->object() == literal) {
+          int index = FieldIndex(literal, true, load->offset());
+          if (replace) load->DeleteAndReplaceWith(state->at(index));
+        }
+      } else if (instr->IsStoreNamedField()) {
+        HStoreNamedField* store = HStoreNamedField::cast(instr);
+        if (store->object() == literal) {
+          int index = FieldIndex(literal, true, store->offset());
+          state->at(index) = store->value();
+          snapshot = NULL;
+          if (replace) {
+            // Rebind the object in the deoptimization environment to the
+            // new field values right away.
+            snapshot = NewSnapshot(literal, state);
+            snapshot->InsertBefore(store);
+            store->DeleteAndReplaceWith(NULL);
+          }
+        }
+      } else if (instr->IsCheckNonSmi()) {
+        if (HCheckNonSmi::cast(instr)->value() == literal && replace) {
+          instr->DeleteAndReplaceWith(NULL);
+        }
+      } else if (instr->IsCheckMap()) {
+        if (HCheckMap::cast(instr)->value() == literal && replace) {
+          instr->DeleteAndReplaceWith(NULL);
+        }
+      } else if (instr->IsSimulate() && replace) {
+        for (int j = 0; j < instr->OperandCount(); ++j) {
+          if (instr->OperandAt(j) != literal) continue;
+          if (snapshot == NULL) {
+            snapshot = NewSnapshot(literal, state);
+            snapshot->InsertBefore(instr);
+          }
+          instr->SetOperandAt(j, snapshot);
+        }
+      }
+      instr = next;
+    }
+    exit_states[i] = state;
+    exit_snapshots[i] = snapshot;
+  }
+
+  // The back edges of loops must not change the field values either.
+  for (int i = start->block_id() + 1; i < blocks->length(); ++i) {
+    if (entry_states[i] == NULL) continue;
+    const ZoneList<HBasicBlock*>* predecessors = blocks->at(i)->predecessors();
+    for (int j = 1; j < predecessors->length(); ++j) {
+      int id = predecessors->at(j)->block_id();
+      if (!SameState(entry_states[i], exit_states[id])) return false;
+    }
+  }
+  return true;
+}
+
+
+// Field sensitive load elimination and dead store elimination for named
+// fields. GVN treats all in-object fields, and all backing store fields,
+// as a single location, so any field store kills every field load. This
+// pass tells fields apart by object, storage and offset. Within extended
+// basic blocks it forwards stored and loaded values to later loads of the
+// same field and removes stores that are overwritten before anything can
+// observe them. It also hoists loads out of loops that store to other
+// fields only.
+class HLoadStoreEliminator BASE_EMBEDDED {
+ public:
+  HLoadStoreEliminator(HGraph* graph, CompilationInfo* info)
+      : graph_(graph), info_(info) { }
+
+  void Process();
+
+ private:
+  // The value last loaded from or stored to a field, and the store that
+  // wrote it if nothing has observed the field since.
+  struct FieldEntry {
+    HValue* object;
+    bool is_in_object;
+    int offset;
+    HValue* value;
+    HStoreNamedField* store;
+  };
+
+  typedef ZoneList<FieldEntry> FieldTable;
+
+  void ProcessBlock(HBasicBlock* block, FieldTable* table);
+  void ProcessLoad(HLoadNamedField* load, FieldTable* table);
+  void ProcessStore(HStoreNamedField* store, FieldTable* table);
+  void HoistLoopInvariantLoads(HBasicBlock* loop_header);
+
+  static bool CannotObserveFields(HInstruction* instr);
+  static bool HasCheckInLoop(HValue* object,
+                             int first_block_id,
+                             int last_block_id);
+  static int Find(FieldTable* table,
+                  HValue* object,
+                  bool is_in_object,
+                  int offset);
+  static void Kill(FieldTable* table, bool is_in_object, int offset);
+  static void KillAll(FieldTable* table, bool is_in_object);
+
+  HGraph* graph_;
+  CompilationInfo* info_;
+};
+
+
+bool HLoadStoreEliminator::CannotObserveFields(HInstruction* instr) {
+  // Neither reads named fields nor can deoptimize, which would hand the
+  // current field values to the unoptimized code. Loads are handled by
+  // the caller.
+  switch (instr->opcode()) {
+    case HValue::kSimulate:
+    case HValue::kCapturedObject:
+    case HValue::kConstant:
+    case HValue::kAllocateObject:
+    case HValue::kLoadElements:
+    case HValue::kFixedArrayBaseLength:
+    case HValue::kJSArrayLength:
+    case HValue::kStoreNamedField:
+      return true;
+    default:
+      return false;
+  }
+}
+
+
+bool HLoadStoreEliminator::HasCheckInLoop(HValue* object,
+                                          int first_block_id,
+                                          int last_block_id) {
+  for (HUseIterator it(object->uses()); !it.Done(); it.Advance()) {
+    HValue* use = it.value();
+    if (!use->IsCheckNonSmi() &&
+        !use->IsCheckMap() &&
+        !use->IsCheckInstanceType() &&
+        !use->IsCheckFunction()) {
+      continue;
+    }
+    int block_id = use->block()->block_id();
+    if (block_id >= first_block_id && block_id <= last_block_id) return true;
+  }
+  return false;
+}
+
+
+int HLoadStoreEliminator::Find(FieldTable* table,
+                               HValue* object,
+                               bool is_in_object,
+                               int offset) {
+  for (int i = 0; i < table->length(); ++i) {
+    FieldEntry& entry = table->at(i);
+    if (entry.object == object &&
+        entry.is_in_object == is_in_object &&
+        entry.offset == offset) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+
+void HLoadStoreEliminator::Kill(FieldTable* table,
+                                bool is_in_object,
+                                int offset) {
+  // Different objects may be the same object at runtime, so a store to a
+  // field invalidates that field of every object.
+  for (int i = table->length() - 1; i >= 0; --i) {
+    FieldEntry& entry = table->at(i);
+    if (entry.is_in_object == is_in_object && entry.offset == offset) {
+      table->Remove(i);
+    }
+  }
+}
+
+
+void HLoadStoreEliminator::KillAll(FieldTable* table, bool is_in_object) {
+  for (int i = table->length() - 1; i >= 0; --i) {
+    if (table->at(i).is_in_object == is_in_object) table->Remove(i);
+  }
+}
+
+
+void HLoadStoreEliminator::ProcessLoad(HLoadNamedField* load,
+                                       FieldTable* table) {
+  int index = Find(table, load->object(), load->is_in_object(),
+                   load->offset());
+  if (index >= 0) {
+    load->DeleteAndReplaceWith(table->at(index).value);
+    return;
+  }
+  // The load may read a field stored through another object.
+  for (int i = 0; i < table->length(); ++i) {
+    FieldEntry& entry = table->at(i);
+    if (entry.is_in_object == load->is_in_object() &&
+        entry.offset == load->offset()) {
+      entry.store = NULL;
+    }
+  }
+  FieldEntry entry = { load->object(), load->is_in_object(), load->offset(),
+                       load, NULL };
+  table->Add(entry);
+}
+
+
+void HLoadStoreEliminator::ProcessStore(HStoreNamedField* store,
+                                        FieldTable* table) {
+  int index = Find(table, store->object(), store->is_in_object(),
+                   store->offset());
+  if (index >= 0) {
+    HStoreNamedField* previous = table->at(index).store;
+    // A transitioning store also changes the map, so it has to stay.
+    if (previous != NULL &&
+        previous->transition().is_null() &&
+        store->transition().is_null()) {
+      previous->DeleteAndReplaceWith(NULL);
+    }
+  }
+  Kill(table, store->is_in_object(), store->offset());
+  FieldEntry entry = { store->object(), store->is_in_object(),
+                       store->offset(), store->value(), store };
+  table->Add(entry);
+}
+
+
+void HLoadStoreEliminator::ProcessBlock(HBasicBlock* block,
+                                        FieldTable* table) {
+  HInstruction* instr = block->first();
+  while (instr != NULL) {
+    HInstruction* next = instr->next();
+    if (instr->IsLoadNamedField()) {
+      ProcessLoad(HLoadNamedField::cast(instr), table);
+    } else if (instr->IsStoreNamedField()) {
+      ProcessStore(HStoreNamedField::cast(instr), table);
+    } else {
+      if (!CannotObserveFields(instr)) {
+        for (int i = 0; i < table->length(); ++i) table->at(i).store = NULL;
+      }
+      int changes = instr->ChangesFlags();
+      if ((changes & (1 << HValue::kChangesInobjectFields)) != 0 ||
+          (changes & (1 << HValue::kChangesArrayLengths)) != 0) {
+        KillAll(table, true);
+      }
+      if ((changes & (1 << HValue::kChangesBackingStoreFields)) != 0) {
+        KillAll(table, false);
+      }
+    }
+    instr = next;
+  }
+
+  // Values flow into blocks whose only predecessor is this block. Dead
+  // store elimination stays within a block.
+  const ZoneList<HBasicBlock*>* dominated = block->dominated_blocks();
+  for (int i = 0; i < dominated->length(); ++i) {
+    HBasicBlock* child = dominated->at(i);
+    FieldTable* child_table = new(graph_->zone()) FieldTable(4);
+    if (child->predecessors()->length() == 1) {
+      child_table->AddAll(*table);
+      for (int j = 0; j < child_table->length(); ++j) {
+        child_table->at(j).store = NULL;
+      }
+    }
+    ProcessBlock(child, child_table);
+  }
+}
+
+
+void HLoadStoreEliminator::HoistLoopInvariantLoads(HBasicBlock* loop_header) {
+  HBasicBlock* pre_header = loop_header->predecessors()->at(0);
+  int last_block_id =
+      loop_header->loop_information()->GetLastBackEdge()->block_id();
+  const ZoneList<HBasicBlock*>* blocks = graph_->blocks();
+
+  // Collect what the loop changes, with the fields it stores to kept
+  // apart from the other side effects.
+  int changes = 0;
+  ZoneList<HStoreNamedField*> stores(4);
+  for (int i = loop_header->block_id(); i <= last_block_id; ++i) {
+    for (HInstruction* instr = blocks->at(i)->first();
+         instr != NULL;
+         instr = instr->next()) {
+      if (instr->IsStoreNamedField()) {
+        stores.Add(HStoreNamedField::cast(instr));
+        changes |= instr->ChangesFlags() &
+            ~(1 << HValue::kChangesInobjectFields) &
+            ~(1 << HValue::kChangesBackingStoreFields);
+      } else {
+        changes |= instr->ChangesFlags();
+      }
+    }
+  }
+  // The map checks guarding the loads must have been hoisted as well.
+  if ((changes & (1 << HValue::kChangesMaps)) != 0) return;
+
+  for (int i = loop_header->block_id(); i <= last_block_id; ++i) {
+    HBasicBlock* block = blocks->at(i);
+    if (block->IsDeoptimizing()) continue;
+    HInstruction* instr = block->first();
+    while (instr != NULL) {
+      HInstruction* next = instr->next();
+      if (instr->IsLoadNamedField()) {
+        HLoadNamedField* load = HLoadNamedField::cast(instr);
+        bool invariant = !load->object()->IsDefinedAfter(pre_header);
+        int field_changes = load->is_in_object()
+            ? (1 << HValue::kChangesInobjectFields) |
+              (1 << HValue::kChangesArrayLengths)
+            : (1 << HValue::kChangesBackingStoreFields);
+        if ((changes & field_changes) != 0) invariant = false;
+        for (int j = 0; j < stores.length() && invariant; ++j) {
+          invariant = stores[j]->is_in_object() != load->is_in_object() ||
+                      stores[j]->offset() != load->offset();
+        }
+        // The smi and map checks guarding the load must not stay behind
+        // in the loop, or the hoisted load would run before them.
+        if (invariant) {
+          invariant = !HasCheckInLoop(load->object(),
+                                      loop_header->block_id(),
+                                      last_block_id);
+        }
+        if (invariant) {
+          load->Unlink();
+          load->InsertBefore(pre_header->end());
+        }
+      }
+      instr = next;
+    }
+  }
+}
+
+
+void HLoadStoreEliminator::Process() {
+  HPhase phase("Load/store elimination", graph_);
+  ProcessBlock(graph_->entry_block(), new(graph_->zone()) FieldTable(4));
+
+  // Like GVN, do not move code in functions that keep deoptimizing.
+  if (!FLAG_loop_invariant_code_motion ||
+      info_->shared_info()->opt_count() + 1 >=
+          Compiler::kDefaultMaxOptCount) {
+    return;
+  }
+  const ZoneList<HBasicBlock*>* blocks = graph_->blocks();
+  for (int i = 0; i < blocks->length(); ++i) {
+    if (blocks->at(i)->IsLoopHeader()) {
+      HoistLoopInvariantLoads(blocks->at(i));
+    }
+  }
+}
+
+
+// Removes bounds checks that are implied by a dominating check or by a
+// dominating integer comparison of the index against the length, as in
+// for (i = 0; i < a.length; i++) loops. Checks in the same block whose
+// indices differ from a common base by constants are merged: the check
+// with the new extreme offset is hoisted to the first check, which then
+// covers all offsets in between. Checks with loop invariant operands are
+// already hoisted out of loops by GVN.
+class HBoundsCheckEliminator BASE_EMBEDDED {
+ public:
+  explicit HBoundsCheckEliminator(HGraph* graph)
+      : graph_(graph),
+        facts_(16),
+        changes_array_lengths_(graph->blocks()->length()) { }
+
+  void Process();
+
+ private:
+  // Records that base + offset is a valid index below length for every
+  // offset in [lower, upper]. Facts established by bounds checks know the
+  // checks that test the two extremes.
+  struct Fact : public ZoneObject {
+    HValue* base;
+    HValue* length;
+    int32_t lower;
+    int32_t upper;
+    HBoundsCheck* lower_check;
+    HBoundsCheck* upper_check;
+    HBasicBlock* block;
+  };
+
+  void ProcessBlock(HBasicBlock* block);
+  void AddConditionFact(HBasicBlock* block);
+  void ProcessCheck(HBoundsCheck* check);
+  void AddFact(HValue* base,
+               HValue* length,
+               int32_t offset,
+               HBoundsCheck* check,
+               HBasicBlock* block);
+  bool HoistCheck(HBoundsCheck* check, HBoundsCheck* position);
+  bool SameLength(HValue* a, HValue* b);
+  bool MayChangeArrayLengths(HInstruction* from, HInstruction* to);
+
+  static HValue* ActualLength(HValue* length);
+  static void DecomposeIndex(HValue* index, HValue** base, int32_t* offset);
+  static bool IsNonNegative(HValue* value);
+  static bool DominatesInstruction(HValue* value, HInstruction* instr);
+
+  HGraph* graph_;
+  ZoneList<Fact*> facts_;
+  BitVector changes_array_lengths_;
+};
+
+
+HValue* HBoundsCheckEliminator::ActualLength(HValue* length) {
+  // Lengths are tagged smis; look through the untagging.
+  while (length->IsChange() && length->representation().IsInteger32()) {
+    length = HChange::cast(length)->value();
+  }
+  return length;
+}
+
+
+void HBoundsCheckEliminator::DecomposeIndex(HValue* index,
+                                            HValue** base,
+                                            int32_t* offset) {
+  *base = index;
+  *offset = 0;
+  if (!index->representation().IsInteger32()) return;
+  if (index->IsAdd()) {
+    HAdd* add = HAdd::cast(index);
+    if (add->right()->IsConstant() &&
+        HConstant::cast(add->right())->HasInteger32Value()) {
+      *base = add->left();
+      *offset = HConstant::cast(add->right())->Integer32Value();
+    } else if (add->left()->IsConstant() &&
+               HConstant::cast(add->left())->HasInteger32Value()) {
+      *base = add->right();
+      *offset = HConstant::cast(add->left())->Integer32Value();
+    }
+  } else if (index->IsSub()) {
+    HSub* sub = HSub::cast(index);
+    if (sub->right()->IsConstant() &&
+        HConstant::cast(sub->right())->HasInteger32Value() &&
+        HConstant::cast(sub->right())->Integer32Value() != kMinInt) {
+      *base = sub->left();
+      *offset = -HConstant::cast(sub->right())->Integer32Value();
+    }
+  }
+}
+
+
+bool HBoundsCheckEliminator::IsNonNegative(HValue* value) {
+  Range* range = value->range();
+  if (range != NULL && range->lower() >= 0) return true;
+  // Range analysis gives loop phis the full range. Recognize induction
+  // variables that start out non-negative and are only ever incremented;
+  // an int32 add deoptimizes on overflow instead of wrapping around.
+  if (!value->IsPhi() || !value->representation().IsInteger32()) return false;
+  HPhi* phi = HPhi::cast(value);
+  for (int i = 0; i < phi->OperandCount(); ++i) {
+    HValue* input = phi->OperandAt(i);
+    if (input == phi) continue;
+    range = input->range();
+    if (range != NULL && range->lower() >= 0) continue;
+    if (!input->IsAdd() || !input->representation().IsInteger32()) {
+      return false;
+    }
+    HAdd* add = HAdd::cast(input);
+    HValue* increment = NULL;
+    if (add->left() == phi) increment = add->right();
+    if (add->right() == phi) increment = add->left();
+    if (increment == NULL ||
+        increment->range() == NULL ||
+        increment->range()->lower() < 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+bool HBoundsCheckEliminator::DominatesInstruction(HValue* value,
+                                                  HInstruction* instr) {
+  if (value->block() != instr->block()) {
+    return value->block()->Dominates(instr->block());
+  }
+  if (value->IsPhi()) return true;
+  for (HInstruction* current = instr->previous();
+       current != NULL;
+       current = current->previous()) {
+    if (current == value) return true;
+  }
+  return false;
+}
+
+
+bool HBoundsCheckEliminator::MayChangeArrayLengths(HInstruction* from,
+                                                   HInstruction* to) {
+  HBasicBlock* from_block = from->block();
+  HBasicBlock* to_block = to->block();
+  // Any path from 'from' to 'to' stays within the blocks in between in
+  // reverse post order, plus the bodies of the loops around 'to' that do
+  // not contain 'from'.
+  int last_block_id = to_block->block_id();
+  HBasicBlock* header =
+      to_block->IsLoopHeader() ? to_block : to_block->parent_loop_header();
+  while (header != NULL && header->block_id() > from_block->block_id()) {
+    HBasicBlock* back_edge = header->loop_information()->GetLastBackEdge();
+    last_block_id = Max(last_block_id, back_edge->block_id());
+    header = header->parent_loop_header();
+  }
+
+  if (from_block == to_block && last_block_id == to_block->block_id()) {
+    for (HInstruction* instr = from->next();
+         instr != to;
+         instr = instr->next()) {
+      if (instr->CheckFlag(HValue::kChangesArrayLengths)) return true;
+    }
+    return false;
+  }
+  for (HInstruction* instr = from->next();
+       instr != NULL;
+       instr = instr->next()) {
+    if (instr->CheckFlag(HValue::kChangesArrayLengths)) return true;
+  }
+  for (int i = from_block->block_id() + 1; i <= last_block_id; ++i) {
+    if (changes_array_lengths_.Contains(i)) return true;
+  }
+  return false;
+}
+
+
+bool HBoundsCheckEliminator::SameLength(HValue* a, HValue* b) {
+  if (a == b) return true;
+  // Array lengths are loaded anew for each access, guarded by different
+  // type checks, so GVN does not merge a loop condition's 'a.length' with
+  // the length used by the bounds check. They still agree if nothing in
+  // between can change the length of an array. The 'length' of an
+  // external array is an ordinary property set by the embedder, so it is
+  // not known to agree with the length used by the bounds check.
+  if (!a->IsJSArrayLength() || !b->IsJSArrayLength()) return false;
+  if (HJSArrayLength::cast(a)->value() != HJSArrayLength::cast(b)->value()) {
+    return false;
+  }
+  HInstruction* first = HInstruction::cast(a);
+  HInstruction* second = HInstruction::cast(b);
+  if (!DominatesInstruction(first, second)) {
+    if (!DominatesInstruction(second, first)) return false;
+    HInstruction* temp = first;
+    first = second;
+    second = temp;
+  }
+  return !MayChangeArrayLengths(first, second);
+}
+
+
+void HBoundsCheckEliminator::AddFact(HValue* base,
+                                     HValue* length,
+                                     int32_t offset,
+                                     HBoundsCheck* check,
+                                     HBasicBlock* block) {
+  Fact* fact = new(graph_->zone()) Fact;
+  fact->base = base;
+  fact->length = length;
+  fact->lower = offset;
+  fact->upper = offset;
+  fact->lower_check = check;
+  fact->upper_check = check;
+  fact->block = block;
+  facts_.Add(fact);
+}
+
+
+void HBoundsCheckEliminator::AddConditionFact(HBasicBlock* block) {
+  if (block->predecessors()->length() != 1) return;
+  HControlInstruction* end = block->predecessors()->at(0)->end();
+  if (!end->IsCompareIDAndBranch()) return;
+  HCompareIDAndBranch* compare = HCompareIDAndBranch::cast(end);
+  if (!compare->GetInputRepresentation().IsInteger32()) return;
+  if (compare->FirstSuccessor() == compare->SecondSuccessor()) return;
+
+  Token::Value op = compare->token();
+  if (compare->SecondSuccessor() == block) op = Token::NegateCompareOp(op);
+  HValue* index;
+  HValue* length;
+  if (op == Token::LT) {
+    index = compare->left();
+    length = compare->right();
+  } else if (op == Token::GT) {
+    index = compare->right();
+    length = compare->left();
+  } else {
+    return;
+  }
+  if (!IsNonNegative(index)) return;
+
+  HValue* base;
+  int32_t offset;
+  DecomposeIndex(index, &base, &offset);
+  AddFact(base, ActualLength(length), offset, NULL, block);
+}
+
+
+bool HBoundsCheckEliminator::HoistCheck(HBoundsCheck* check,
+                                        HBoundsCheck* position) {
+  // The index has to be available at the new position. It is either the
+  // base, which the fact's own index was computed from, or an int32 add or
+  // sub of the base and a constant, which can move up with the check.
+  HValue* index = check->index();
+  if (!DominatesInstruction(index, position)) {
+    if (!index->IsAdd() && !index->IsSub()) return false;
+    HInstruction* operation = HInstruction::cast(index);
+    for (int i = 0; i < operation->OperandCount(); ++i) {
+      HValue* operand = operation->OperandAt(i);
+      if (DominatesInstruction(operand, position)) continue;
+      if (!operand->IsConstant() || operand->block() != position->block()) {
+        return false;
+      }
+      HConstant::cast(operand)->Unlink();
+      HConstant::cast(operand)->InsertBefore(position);
+    }
+    operation->Unlink();
+    operation->InsertBefore(position);
+  }
+  check->Unlink();
+  check->SetOperandAt(1, position->length());
+  check->InsertBefore(position);
+  return true;
+}
+
+
+void HBoundsCheckEliminator::ProcessCheck(HBoundsCheck* check) {
+  HValue* index = check->index();
+  Range* index_range = index->range();
+  Range* length_range = check->length()->range();
+  if (index_range != NULL && length_range != NULL &&
+      index_range->lower() >= 0 &&
+      index_range->upper() < length_range->lower()) {
+    check->DeleteAndReplaceWith(index);
+    return;
+  }
+
+  HValue* base;
+  int32_t offset;
+  DecomposeIndex(index, &base, &offset);
+  HValue* length = ActualLength(check->length());
+
+  Fact* local_fact = NULL;
+  for (int i = facts_.length() - 1; i >= 0; --i) {
+    Fact* fact = facts_[i];
+    if (fact->base != base || !SameLength(fact->length, length)) continue;
+    if (fact->lower <= offset && offset <= fact->upper) {
+      check->DeleteAndReplaceWith(index);
+      return;
+    }
+    if (fact->block == check->block() && fact->upper_check != NULL) {
+      local_fact = fact;
+    }
+  }
+
+  if (local_fact == NULL) {
+    AddFact(base, length, offset, check, check->block());
+    return;
+  }
+
+  // Hoist the check to the check for the extreme it goes beyond. The old
+  // extreme is then covered unless it is also the other extreme.
+  bool above = offset > local_fact->upper;
+  HBoundsCheck* old_check =
+      above ? local_fact->upper_check : local_fact->lower_check;
+  if (!HoistCheck(check, old_check)) {
+    AddFact(base, length, offset, check, check->block());
+    return;
+  }
+  if (local_fact->lower_check != local_fact->upper_check) {
+    old_check->DeleteAndReplaceWith(old_check->index());
+  }
+  if (above) {
+    local_fact->upper = offset;
+    local_fact->upper_check = check;
+  } else {
+    local_fact->lower = offset;
+    local_fact->lower_check = check;
+  }
+}
+
+
+void HBoundsCheckEliminator::ProcessBlock(HBasicBlock* block) {
+  int facts_on_entry = facts_.length();
+  AddConditionFact(block);
+
+  HInstruction* instr = block->first();
+  while (instr != NULL) {
+    HInstruction* next = instr->next();
+    if (instr->IsBoundsCheck()) ProcessCheck(HBoundsCheck::cast(instr));
+    instr = next;
+  }
+
+  for (int i = 0; i < block->dominated_blocks()->length(); ++i) {
+    ProcessBlock(block->dominated_blocks()->at(i));
+  }
+  facts_.Rewind(facts_on_entry);
+}
+
+
+void HBoundsCheckEliminator::Process() {
+  HPhase phase("Bounds check elimination", graph_);
+  const ZoneList<HBasicBlock*>* blocks = graph_->blocks();
+  for (int i = 0; i < blocks->length(); ++i) {
+    for (HInstruction* instr = blocks->at(i)->first();
+         instr != NULL;
+         instr = instr->next()) {
+      if (instr->CheckFlag(HValue::kChangesArrayLengths)) {
+        changes_array_lengths_.Add(i);
+        break;
+      }
+    }
+  }
+  ProcessBlock(graph_->entry_block());
+}
+
+
 // Simple sparse set with O(1) add, contains, and clear.
 class SparseSet {
  public:
@@ -1345,13 +2437,9 @@ class HGlobalValueNumberer BASE_EMBEDDED {
         block_side_effects_(graph->blocks()->length()),
         loop_side_effects_(graph->blocks()->length()),
         visited_on_paths_(graph->zone(), graph->blocks()->length()) {
-    ASSERT(info->isolate()->heap()->allow_allocation(false));
     block_side_effects_.AddBlock(0, graph_->blocks()->length());
     loop_side_effects_.AddBlock(0, graph_->blocks()->length());
   }
-  ~HGlobalValueNumberer() {
-    ASSERT(!info_->isolate()->heap()->allow_allocation(true));
-  }
 
   void Analyze();
 
@@ -2005,11 +3093,13 @@ void HGraph::ComputeMinusZeroChecks() {
 // a (possibly inlined) function.
 FunctionState::FunctionState(HGraphBuilder* owner,
                              CompilationInfo* info,
-                             TypeFeedbackOracle* oracle)
+                             TypeFeedbackOracle* oracle,
+                             bool is_construct)
     : owner_(owner),
       compilation_info_(info),
       oracle_(oracle),
       call_context_(NULL),
+      is_construct_(is_construct),
       function_return_(NULL),
       test_context_(NULL),
       outer_(owner->function_state()) {
@@ -2360,30 +3450,67 @@ HGraph* HGraphBuilder::CreateGraph() {
   graph()->InitializeInferredTypes();
   graph()->Canonicalize();
 
+  return graph();
+}
+
+
+void HGraph::Optimize(CompilationInfo* info) {
+  // Replace object literals that do not escape by the values of their fields.
+  if (FLAG_use_escape_analysis) {
+    HEscapeAnalysis ea(this);
+    ea.Process();
+    YieldHeapAccess();
+  }
+
   // Perform common subexpression elimination and loop-invariant code motion.
   if (FLAG_use_gvn) {
-    HPhase phase("Global value numbering", graph());
-    HGlobalValueNumberer gvn(graph(), info());
+    HPhase phase("Global value numbering", this);
+    HGlobalValueNumberer gvn(this, info);
     gvn.Analyze();
+    YieldHeapAccess();
+  }
+
+  // Forward and hoist named field loads and remove dead field stores.
+  if (FLAG_use_load_store_elimination) {
+    HLoadStoreEliminator lse(this, info);
+    lse.Process();
+    YieldHeapAccess();
   }
 
   if (FLAG_use_range) {
-    HRangeAnalysis rangeAnalysis(graph());
+    HRangeAnalysis rangeAnalysis(this);
     rangeAnalysis.Analyze();
   }
-  graph()->ComputeMinusZeroChecks();
+  ComputeMinusZeroChecks();
+
+  // Remove and merge redundant array bounds checks.
+  if (FLAG_array_bounds_checks_elimination) {
+    HBoundsCheckEliminator bce(this);
+    bce.Process();
+    YieldHeapAccess();
+  }
 
   // Eliminate redundant stack checks on backwards branches.
-  HStackCheckEliminator sce(graph());
+  HStackCheckEliminator sce(this);
   sce.Process();
 
+  // Drop write barriers for stores into objects that were just allocated.
+  if (FLAG_eliminate_write_barriers) {
+    HWriteBarrierEliminator wbe(this);
+    wbe.Process();
+  }
+
   // Replace the results of check instructions with the original value, if the
   // result is used. This is safe now, since we don't do code motion after this
   // point. It enables better register allocation since the value produced by
   // check instructions is really a copy of the original value.
-  graph()->ReplaceCheckedValues();
+  ReplaceCheckedValues();
+}
 
-  return graph();
+
+void HGraph::YieldHeapAccess() {
+  OptimizingCompilerThread* thread = isolate()->optimizing_compiler_thread();
+  if (thread != NULL) thread->YieldHeapAccess();
 }
 
 
@@ -2642,6 +3769,35 @@ void HGraphBuilder::VisitReturnStatement(ReturnStatement* stmt) {
     HValue* result = environment()->Pop();
     current_block()->FinishExit(new(zone()) HReturn(result));
     set_current_block(NULL);
+  } else if (function_state()->is_construct()) {
+    // Return from an inlined construct call.  In a test context the return
+    // value always evaluates to true, in a value context the return value
+    // is the receiver unless it is a JavaScript object.
+    if (context->IsTest()) {
+      TestContext* test = TestContext::cast(context);
+      CHECK_ALIVE(VisitForEffect(stmt->expression()));
+      current_block()->Goto(test->if_true());
+    } else if (context->IsEffect()) {
+      CHECK_ALIVE(VisitForEffect(stmt->expression()));
+      current_block()->Goto(function_return());
+    } else {
+      ASSERT(context->IsValue());
+      CHECK_ALIVE(VisitForValue(stmt->expression()));
+      HValue* return_value = environment()->Pop();
+      HValue* receiver = environment()->Lookup(0);
+      HHasInstanceTypeAndBranch* typecheck =
+          new(zone()) HHasInstanceTypeAndBranch(return_value,
+                                                FIRST_SPEC_OBJECT_TYPE,
+                                                LAST_SPEC_OBJECT_TYPE);
+      HBasicBlock* if_spec_object = graph()->CreateBasicBlock();
+      HBasicBlock* not_spec_object = graph()->CreateBasicBlock();
+      typecheck->SetSuccessorAt(0, if_spec_object);
+      typecheck->SetSuccessorAt(1, not_spec_object);
+      current_block()->Finish(typecheck);
+      if_spec_object->AddLeaveInlined(return_value, function_return());
+      not_spec_object->AddLeaveInlined(receiver, function_return());
+    }
+    set_current_block(NULL);
   } else {
     // Return from an inlined function, visit the subexpression in the
     // expression context of the call.
@@ -3235,6 +4391,37 @@ void HGraphBuilder::VisitRegExpLiteral(RegExpLiteral* expr) {
 }
 
 
+// Record the layout of the boilerplate of an object literal that has been
+// created before, if the boilerplate has no elements and only in-object
+// properties. The literal is a copy of the boilerplate and shares its map.
+static void RecordBoilerplateLayout(HObjectLiteral* literal,
+                                    Handle<JSFunction> closure,
+                                    Zone* zone) {
+  if (literal->depth() > 1 || literal->has_function()) return;
+  Handle<Object> boilerplate(closure->literals()->get(
+      literal->literal_index()));
+  if (!boilerplate->IsJSObject()) return;
+  Handle<JSObject> object = Handle<JSObject>::cast(boilerplate);
+  Handle<Map> map(object->map());
+  if (map->instance_type() != JS_OBJECT_TYPE ||
+      !object->HasFastProperties() ||
+      object->properties()->length() != 0 ||
+      object->elements()->length() != 0) {
+    return;
+  }
+  int count = map->inobject_properties();
+  if (map->instance_size() != JSObject::kHeaderSize + count * kPointerSize) {
+    return;
+  }
+  ZoneList<Handle<Object> >* values =
+      new(zone) ZoneList<Handle<Object> >(count);
+  for (int i = 0; i < count; ++i) {
+    values->Add(Handle<Object>(object->InObjectPropertyAt(i)));
+  }
+  literal->set_boilerplate_layout(object, values);
+}
+
+
 void HGraphBuilder::VisitObjectLiteral(ObjectLiteral* expr) {
   ASSERT(!HasStackOverflow());
   ASSERT(current_block() != NULL);
@@ -3247,6 +4434,11 @@ void HGraphBuilder::VisitObjectLiteral(ObjectLiteral* expr) {
                                  expr->literal_index(),
                                  expr->depth(),
                                  expr->has_function());
+  // Stores into a literal with a known layout are field stores, which
+  // escape analysis can see through.
+  if (FLAG_use_escape_analysis) {
+    RecordBoilerplateLayout(literal, info()->closure(), zone());
+  }
   // The object is expected in the bailout environment during computation
   // of the property values and is the value of the entire expression.
   PushAndAdd(literal);
@@ -3270,13 +4462,19 @@ void HGraphBuilder::VisitObjectLiteral(ObjectLiteral* expr) {
             CHECK_ALIVE(VisitForValue(value));
             HValue* value = Pop();
             Handle<String> name = Handle<String>::cast(key->handle());
-            HStoreNamedGeneric* store =
-                new(zone()) HStoreNamedGeneric(
-                                context,
-                                literal,
-                                name,
-                                value,
-                                function_strict_mode());
+            HInstruction* store = NULL;
+            if (literal->has_boilerplate_layout()) {
+              Handle<Map> map = literal->boilerplate_map();
+              LookupResult lookup;
+              map->LookupInDescriptors(NULL, *name, &lookup);
+              if (lookup.IsProperty() && lookup.type() == FIELD) {
+                store = BuildStoreNamedField(literal, name, value, map,
+                                             &lookup, false);
+              }
+            }
+            if (store == NULL) {
+              store = BuildStoreNamedGeneric(literal, name, value);
+            }
             AddInstruction(store);
             AddSimulate(key->id());
           } else {
@@ -4441,7 +5639,7 @@ void HGraphBuilder::HandlePolymorphicCallNamed(Call* expr,
         PrintF("Trying to inline the polymorphic call to %s\n",
                *name->ToCString());
       }
-      if (FLAG_polymorphic_inlining && TryInline(expr)) {
+      if (FLAG_polymorphic_inlining && TryInlineCall(expr)) {
         // Trying to inline will signal that we should bailout from the
         // entire compilation by setting stack overflow on the visitor.
         if (HasStackOverflow()) return;
@@ -4511,19 +5709,17 @@ void HGraphBuilder::TraceInline(Handle<JSFunction> target,
 }
 
 
-bool HGraphBuilder::TryInline(Call* expr) {
+bool HGraphBuilder::TryInline(CallKind call_kind,
+                              Handle<JSFunction> target,
+                              ZoneList<Expression*>* arguments,
+                              int ast_id,
+                              int return_id,
+                              bool is_construct) {
   if (!FLAG_use_inlining) return false;
 
-  // The function call we are inlining is a method call if the call
-  // is a property call.
-  CallKind call_kind = (expr->expression()->AsProperty() == NULL)
-      ? CALL_AS_FUNCTION
-      : CALL_AS_METHOD;
-
   // Precondition: call is monomorphic and we have found a target with the
   // appropriate arity.
   Handle<JSFunction> caller = info()->closure();
-  Handle<JSFunction> target = expr->target();
   Handle<SharedFunctionInfo> target_shared(target->shared());
 
   // Do a quick check on source code length to avoid parsing large
@@ -4607,7 +5803,7 @@ bool HGraphBuilder::TryInline(Call* expr) {
 
   // Don't inline functions that uses the arguments object or that
   // have a mismatching number of parameters.
-  int arity = expr->arguments()->length();
+  int arity = arguments->length();
   if (function->scope()->arguments() != NULL ||
       arity != target_shared->formal_parameter_count()) {
     TraceInline(target, caller, "target requires special argument handling");
@@ -4665,14 +5861,23 @@ bool HGraphBuilder::TryInline(Call* expr) {
       Handle<Code>(target_shared->code()),
       Handle<Context>(target->context()->global_context()),
       isolate());
-  FunctionState target_state(this, &target_info, &target_oracle);
+  FunctionState target_state(this, &target_info, &target_oracle, is_construct);
+
+  // Remember the receiver and the arguments, the inlined environment takes
+  // them over from the expression stack.
+  ZoneList<HValue*>* arguments_values =
+      new(zone()) ZoneList<HValue*>(arity + 1);
+  for (int i = arity; i >= 0; --i) {
+    arguments_values->Add(environment()->ExpressionStackAt(i));
+  }
 
   HConstant* undefined = graph()->GetConstantUndefined();
   HEnvironment* inner_env =
       environment()->CopyForInlining(target,
                                      function,
                                      undefined,
-                                     call_kind);
+                                     call_kind,
+                                     is_construct);
 #ifdef V8_TARGET_ARCH_IA32
   // IA32 only, overwrite the caller's context in the deoptimization
   // environment with the correct one.
@@ -4686,11 +5891,13 @@ bool HGraphBuilder::TryInline(Call* expr) {
 #endif
   HBasicBlock* body_entry = CreateBasicBlock(inner_env);
   current_block()->Goto(body_entry);
-  body_entry->SetJoinId(expr->ReturnId());
+  body_entry->SetJoinId(return_id);
   set_current_block(body_entry);
   AddInstruction(new(zone()) HEnterInlined(target,
                                            function,
-                                           call_kind));
+                                           call_kind,
+                                           is_construct,
+                                           arguments_values));
   VisitDeclarations(target_info.scope()->declarations());
   VisitStatements(function->body());
   if (HasStackOverflow()) {
@@ -4707,7 +5914,22 @@ bool HGraphBuilder::TryInline(Call* expr) {
 
   TraceInline(target, caller, NULL);
 
-  if (current_block() != NULL) {
+  if (current_block() != NULL && is_construct) {
+    // Add a return of the receiver if control can fall off the body of an
+    // inlined constructor.  In a test context, the receiver is true.
+    if (inlined_test_context() == NULL) {
+      ASSERT(function_return() != NULL);
+      ASSERT(call_context()->IsEffect() || call_context()->IsValue());
+      if (call_context()->IsEffect()) {
+        current_block()->Goto(function_return());
+      } else {
+        HValue* receiver = environment()->Lookup(0);
+        current_block()->AddLeaveInlined(receiver, function_return());
+      }
+    } else {
+      current_block()->Goto(inlined_test_context()->if_true());
+    }
+  } else if (current_block() != NULL) {
     // Add a return of undefined if control can fall off the body.  In a
     // test context, undefined is false.
     if (inlined_test_context() == NULL) {
@@ -4745,19 +5967,19 @@ bool HGraphBuilder::TryInline(Call* expr) {
 
     // Forward to the real test context.
     if (if_true->HasPredecessor()) {
-      if_true->SetJoinId(expr->id());
+      if_true->SetJoinId(ast_id);
       HBasicBlock* true_target = TestContext::cast(ast_context())->if_true();
       if_true->Goto(true_target);
     }
     if (if_false->HasPredecessor()) {
-      if_false->SetJoinId(expr->id());
+      if_false->SetJoinId(ast_id);
       HBasicBlock* false_target = TestContext::cast(ast_context())->if_false();
       if_false->Goto(false_target);
     }
     set_current_block(NULL);
 
   } else if (function_return()->HasPredecessor()) {
-    function_return()->SetJoinId(expr->id());
+    function_return()->SetJoinId(ast_id);
     set_current_block(function_return());
   } else {
     set_current_block(NULL);
@@ -4767,6 +5989,33 @@ bool HGraphBuilder::TryInline(Call* expr) {
 }
 
 
+bool HGraphBuilder::TryInlineCall(Call* expr) {
+  // The function call we are inlining is a method call if the call
+  // is a property call.
+  CallKind call_kind = (expr->expression()->AsProperty() == NULL)
+      ? CALL_AS_FUNCTION
+      : CALL_AS_METHOD;
+
+  return TryInline(call_kind,
+                   expr->target(),
+                   expr->arguments(),
+                   expr->id(),
+                   expr->ReturnId(),
+                   false);
+}
+
+
+bool HGraphBuilder::TryInlineConstruct(CallNew* expr,
+                                       Handle<JSFunction> target) {
+  return TryInline(CALL_AS_METHOD,
+                   target,
+                   expr->arguments(),
+                   expr->id(),
+                   expr->ReturnId(),
+                   true);
+}
+
+
 bool HGraphBuilder::TryInlineBuiltinFunction(Call* expr,
                                              HValue* receiver,
                                              Handle<Map> receiver_map,
@@ -4987,7 +6236,7 @@ void HGraphBuilder::VisitCall(Call* expr) {
       } else {
         AddCheckConstantFunction(expr, receiver, receiver_map, true);
 
-        if (TryInline(expr)) return;
+        if (TryInlineCall(expr)) return;
         call = PreProcessCall(
             new(zone()) HCallConstantFunction(expr->target(),
                                               argument_count));
@@ -5043,7 +6292,7 @@ void HGraphBuilder::VisitCall(Call* expr) {
                IsGlobalObject());
         environment()->SetExpressionStackAt(receiver_index, global_receiver);
 
-        if (TryInline(expr)) return;
+        if (TryInlineCall(expr)) return;
         call = PreProcessCall(new(zone()) HCallKnownGlobal(expr->target(),
                                                            argument_count));
       } else {
@@ -5069,7 +6318,7 @@ void HGraphBuilder::VisitCall(Call* expr) {
       PushAndAdd(receiver);
       CHECK_ALIVE(VisitExpressions(expr->arguments()));
       AddInstruction(new(zone()) HCheckFunction(function, expr->target()));
-      if (TryInline(expr)) {
+      if (TryInlineCall(expr)) {
         // The function is lingering in the deoptimization environment.
         // Handle it by case analysis on the AST context.
         if (ast_context()->IsEffect()) {
@@ -5126,18 +6375,78 @@ void HGraphBuilder::VisitCallNew(CallNew* expr) {
   // The constructor function is also used as the receiver argument to the
   // JS construct call builtin.
   HValue* constructor = NULL;
-  CHECK_ALIVE(constructor = VisitArgument(expr->expression()));
-  CHECK_ALIVE(VisitArgumentList(expr->arguments()));
-
-  HValue* context = environment()->LookupContext();
+  CHECK_ALIVE(VisitForValue(expr->expression()));
+  constructor = Top();
 
   // The constructor is both an operand to the instruction and an argument
   // to the construct call.
   int arg_count = expr->arguments()->length() + 1;  // Plus constructor.
-  HCallNew* call = new(zone()) HCallNew(context, constructor, arg_count);
-  call->set_position(expr->position());
-  Drop(arg_count);
-  return ast_context()->ReturnInstruction(call, expr->id());
+  HValue* context = environment()->LookupContext();
+
+  Handle<JSFunction> target = LookupConstructTarget(constructor);
+  if (FLAG_inline_construct && !target.is_null()) {
+    // Make the in-object layout of the target's instances final before
+    // deciding whether they can be allocated inline.
+    if (target->shared()->IsInobjectSlackTrackingInProgress()) {
+      target->shared()->CompleteInobjectSlackTracking();
+    }
+  }
+
+  if (FLAG_inline_construct &&
+      !target.is_null() &&
+      HAllocateObject::IsAllocationInlineable(target)) {
+    CHECK_ALIVE(VisitExpressions(expr->arguments()));
+    HInstruction* check = AddInstruction(
+        new(zone()) HCheckFunction(constructor, target));
+
+    // Replace the constructor function with a newly allocated receiver.
+    HInstruction* receiver = new(zone()) HAllocateObject(target);
+    AddInstruction(receiver);
+    int receiver_index = arg_count - 1;
+    ASSERT(environment()->ExpressionStackAt(receiver_index) == constructor);
+    environment()->SetExpressionStackAt(receiver_index, receiver);
+
+    if (TryInlineConstruct(expr, target)) return;
+
+    // Inlining failed, remove the allocation and the check again and fall
+    // back to a generic construct call with the values already on the stack.
+    receiver->DeleteAndReplaceWith(NULL);
+    check->DeleteAndReplaceWith(NULL);
+    environment()->SetExpressionStackAt(receiver_index, constructor);
+    HInstruction* call = PreProcessCall(
+        new(zone()) HCallNew(context, constructor, arg_count));
+    call->set_position(expr->position());
+    return ast_context()->ReturnInstruction(call, expr->id());
+  } else {
+    // The constructor was evaluated as a plain value above, pass it to the
+    // construct call as an argument.
+    Drop(1);
+    Push(AddInstruction(new(zone()) HPushArgument(constructor)));
+    CHECK_ALIVE(VisitArgumentList(expr->arguments()));
+    HCallNew* call = new(zone()) HCallNew(context, constructor, arg_count);
+    call->set_position(expr->position());
+    Drop(arg_count);
+    return ast_context()->ReturnInstruction(call, expr->id());
+  }
+}
+
+
+Handle<JSFunction> HGraphBuilder::LookupConstructTarget(HValue* constructor) {
+  // Constructors called through a global variable or a constant are known
+  // when the code is compiled.  The target is checked at runtime before the
+  // call is specialized for it.
+  Handle<Object> value;
+  if (constructor->IsConstant()) {
+    value = HConstant::cast(constructor)->handle();
+  } else if (constructor->IsLoadGlobalCell()) {
+    Handle<JSGlobalPropertyCell> cell =
+        HLoadGlobalCell::cast(constructor)->cell();
+    value = Handle<Object>(cell->value());
+  }
+  if (value.is_null() || !value->IsJSFunction()) {
+    return Handle<JSFunction>::null();
+  }
+  return Handle<JSFunction>::cast(value);
 }
 
 
@@ -6110,10 +7419,11 @@ void HGraphBuilder::GenerateIsStringWrapperSafeForDefaultValueOf(
 void HGraphBuilder::GenerateIsConstructCall(CallRuntime* call) {
   ASSERT(call->arguments()->length() == 0);
   if (function_state()->outer() != NULL) {
-    // We are generating graph for inlined function. Currently
-    // constructor inlining is not supported and we can just return
-    // false from %_IsConstructCall().
-    return ast_context()->ReturnValue(graph()->GetConstantFalse());
+    // We are generating graph for inlined function.
+    HValue* value = function_state()->is_construct()
+        ? graph()->GetConstantTrue()
+        : graph()->GetConstantFalse();
+    return ast_context()->ReturnValue(value);
   } else {
     return ast_context()->ReturnControl(new(zone()) HIsConstructCallAndBranch,
                                         call->id());
@@ -6427,6 +7737,7 @@ HEnvironment::HEnvironment(HEnvironment* outer,
       specials_count_(1),
       local_count_(0),
       outer_(outer),
+      frame_type_(JS_FUNCTION),
       pop_count_(0),
       push_count_(0),
       ast_id_(AstNode::kNoNumber) {
@@ -6441,6 +7752,7 @@ HEnvironment::HEnvironment(const HEnvironment* other)
       specials_count_(1),
       local_count_(0),
       outer_(NULL),
+      frame_type_(JS_FUNCTION),
       pop_count_(0),
       push_count_(0),
       ast_id_(other->ast_id()) {
@@ -6448,6 +7760,24 @@ HEnvironment::HEnvironment(const HEnvironment* other)
 }
 
 
+HEnvironment::HEnvironment(HEnvironment* outer,
+                           Handle<JSFunction> closure,
+                           FrameType frame_type,
+                           int arguments)
+    : closure_(closure),
+      values_(arguments),
+      assigned_variables_(0),
+      parameter_count_(arguments),
+      specials_count_(0),
+      local_count_(0),
+      outer_(outer),
+      frame_type_(frame_type),
+      pop_count_(0),
+      push_count_(0),
+      ast_id_(AstNode::kNoNumber) {
+}
+
+
 void HEnvironment::Initialize(int parameter_count,
                               int local_count,
                               int stack_height) {
@@ -6466,8 +7796,10 @@ void HEnvironment::Initialize(const HEnvironment* other) {
   values_.AddAll(other->values_);
   assigned_variables_.AddAll(other->assigned_variables_);
   parameter_count_ = other->parameter_count_;
+  specials_count_ = other->specials_count_;
   local_count_ = other->local_count_;
   if (other->outer_ != NULL) outer_ = other->outer_->Copy();  // Deep copy.
+  frame_type_ = other->frame_type_;
   pop_count_ = other->pop_count_;
   push_count_ = other->push_count_;
   ast_id_ = other->ast_id_;
@@ -6547,6 +7879,20 @@ void HEnvironment::Drop(int count) {
 }
 
 
+void HEnvironment::ReplaceCapturedObject(HCapturedObject* object) {
+  for (HEnvironment* env = this; env != NULL; env = env->outer()) {
+    for (int i = 0; i < env->length(); ++i) {
+      HValue* value = env->values_[i];
+      if (value != NULL &&
+          value->IsCapturedObject() &&
+          HCapturedObject::cast(value)->object_id() == object->object_id()) {
+        env->values_[i] = object;
+      }
+    }
+  }
+}
+
+
 HEnvironment* HEnvironment::Copy() const {
   return new(closure()->GetIsolate()->zone()) HEnvironment(this);
 }
@@ -6572,16 +7918,40 @@ HEnvironment* HEnvironment::CopyAsLoopHeader(HBasicBlock* loop_header) const {
 }
 
 
+HEnvironment* HEnvironment::CreateStubEnvironment(HEnvironment* outer,
+                                                  Handle<JSFunction> target,
+                                                  FrameType frame_type,
+                                                  int arguments) const {
+  Zone* zone = closure()->GetIsolate()->zone();
+  HEnvironment* new_env = new(zone) HEnvironment(outer, target, frame_type,
+                                                 arguments + 1);
+  for (int i = 0; i <= arguments; ++i) {  // Include receiver.
+    new_env->Push(ExpressionStackAt(arguments - i));
+  }
+  new_env->ClearHistory();
+  return new_env;
+}
+
+
 HEnvironment* HEnvironment::CopyForInlining(
     Handle<JSFunction> target,
     FunctionLiteral* function,
     HConstant* undefined,
-    CallKind call_kind) const {
+    CallKind call_kind,
+    bool is_construct) const {
   // Outer environment is a copy of this one without the arguments.
   int arity = function->scope()->num_parameters();
   HEnvironment* outer = Copy();
   outer->Drop(arity + 1);  // Including receiver.
   outer->ClearHistory();
+
+  if (is_construct) {
+    // Create artificial constructor stub environment.  The receiver should
+    // actually be the constructor function, but we pass the newly allocated
+    // object instead, DoComputeConstructStubFrame() relies on that.
+    outer = CreateStubEnvironment(outer, target, JS_CONSTRUCT, arity);
+  }
+
   Zone* zone = closure()->GetIsolate()->zone();
   HEnvironment* inner =
       new(zone) HEnvironment(outer, function->scope(), target);
@@ -6597,7 +7967,9 @@ HEnvironment* HEnvironment::CopyForInlining(
       call_kind == CALL_AS_FUNCTION) {
     inner->SetValueAt(0, undefined);
   }
-  inner->SetValueAt(arity + 1, outer->LookupContext());
+  // The construct stub environment has no context slot, so take the
+  // context from the caller's environment.
+  inner->SetValueAt(arity + 1, LookupContext());
   for (int i = arity + 2; i < inner->length(); ++i) {
     inner->SetValueAt(i, undefined);
   }
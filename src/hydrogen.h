@@ -251,7 +251,21 @@ class HGraph: public ZoneObject {
 
   void CollectPhis();
 
-  Handle<Code> Compile(CompilationInfo* info);
+  // Runs the optimizations that neither allocate nor create handles, so
+  // that they may run off the main thread.
+  void Optimize(CompilationInfo* info);
+
+  // Builds the lithium chunk and allocates registers, returning NULL on
+  // bailout. Like Optimize() this does not touch the heap.
+  LChunk* BuildChunk(CompilationInfo* info);
+
+  // Generates the code object for a chunk built from this graph.
+  Handle<Code> GenerateCode(LChunk* chunk, CompilationInfo* info);
+
+  // Called between the phases of Optimize() and BuildChunk(), where no
+  // raw heap pointers are live, to let a pending garbage collection run
+  // when the graph is being optimized on the compiler thread.
+  void YieldHeapAccess();
 
   void set_undefined_constant(HConstant* constant) {
     undefined_constant_.set(constant);
@@ -335,12 +349,21 @@ class HGraph: public ZoneObject {
 Zone* HBasicBlock::zone() { return graph_->zone(); }
 
 
+enum FrameType { JS_FUNCTION, JS_CONSTRUCT };
+
+
 class HEnvironment: public ZoneObject {
  public:
   HEnvironment(HEnvironment* outer,
                Scope* scope,
                Handle<JSFunction> closure);
 
+  HEnvironment* DiscardInlined() {
+    HEnvironment* outer = outer_;
+    while (outer->frame_type() != JS_FUNCTION) outer = outer->outer_;
+    return outer;
+  }
+
   // Simple accessors.
   Handle<JSFunction> closure() const { return closure_; }
   const ZoneList<HValue*>* values() const { return &values_; }
@@ -353,6 +376,7 @@ class HEnvironment: public ZoneObject {
   HEnvironment* outer() const { return outer_; }
   int pop_count() const { return pop_count_; }
   int push_count() const { return push_count_; }
+  FrameType frame_type() const { return frame_type_; }
 
   int ast_id() const { return ast_id_; }
   void set_ast_id(int id) { ast_id_ = id; }
@@ -423,11 +447,13 @@ class HEnvironment: public ZoneObject {
 
   // Create an "inlined version" of this environment, where the original
   // environment is the outer environment but the top expression stack
-  // elements are moved to an inner environment as parameters.
+  // elements are moved to an inner environment as parameters.  A construct
+  // call additionally gets a construct stub environment between the two.
   HEnvironment* CopyForInlining(Handle<JSFunction> target,
                                 FunctionLiteral* function,
                                 HConstant* undefined,
-                                CallKind call_kind) const;
+                                CallKind call_kind,
+                                bool is_construct) const;
 
   void AddIncomingEdge(HBasicBlock* block, HEnvironment* other);
 
@@ -442,12 +468,28 @@ class HEnvironment: public ZoneObject {
     values_[index] = value;
   }
 
+  // Replace earlier snapshots of the same captured object, in this and all
+  // outer environments.
+  void ReplaceCapturedObject(HCapturedObject* object);
+
   void PrintTo(StringStream* stream);
   void PrintToStd();
 
  private:
   explicit HEnvironment(const HEnvironment* other);
 
+  HEnvironment(HEnvironment* outer,
+               Handle<JSFunction> closure,
+               FrameType frame_type,
+               int arguments);
+
+  // Create an artificial stub environment (e.g. for argument adaptor or
+  // constructor stub).
+  HEnvironment* CreateStubEnvironment(HEnvironment* outer,
+                                      Handle<JSFunction> target,
+                                      FrameType frame_type,
+                                      int arguments) const;
+
   // True if index is included in the expression stack part of the environment.
   bool HasExpressionAt(int index) const;
 
@@ -473,6 +515,7 @@ class HEnvironment: public ZoneObject {
   int specials_count_;
   int local_count_;
   HEnvironment* outer_;
+  FrameType frame_type_;
   int pop_count_;
   int push_count_;
   int ast_id_;
@@ -607,12 +650,14 @@ class FunctionState BASE_EMBEDDED {
  public:
   FunctionState(HGraphBuilder* owner,
                 CompilationInfo* info,
-                TypeFeedbackOracle* oracle);
+                TypeFeedbackOracle* oracle,
+                bool is_construct);
   ~FunctionState();
 
   CompilationInfo* compilation_info() { return compilation_info_; }
   TypeFeedbackOracle* oracle() { return oracle_; }
   AstContext* call_context() { return call_context_; }
+  bool is_construct() { return is_construct_; }
   HBasicBlock* function_return() { return function_return_; }
   TestContext* test_context() { return test_context_; }
   void ClearInlinedTestContext() {
@@ -632,6 +677,10 @@ class FunctionState BASE_EMBEDDED {
   // inlined. NULL when not inlining.
   AstContext* call_context_;
 
+  // Indicate if we have to return the receiver when inlining a constructor
+  // call.  False when not inlining.
+  bool is_construct_;
+
   // When inlining in an effect of value context, this is the return block.
   // It is NULL otherwise.  When inlining in a test context, there are a
   // pair of return blocks in the context.  When not inlining, there is no
@@ -883,7 +932,19 @@ class HGraphBuilder: public AstVisitor {
   // Try to optimize fun.apply(receiver, arguments) pattern.
   bool TryCallApply(Call* expr);
 
-  bool TryInline(Call* expr);
+  bool TryInline(CallKind call_kind,
+                 Handle<JSFunction> target,
+                 ZoneList<Expression*>* arguments,
+                 int ast_id,
+                 int return_id,
+                 bool is_construct);
+
+  bool TryInlineCall(Call* expr);
+  bool TryInlineConstruct(CallNew* expr, Handle<JSFunction> target);
+
+  // Returns the function a construct call is known to target, or a null
+  // handle.
+  Handle<JSFunction> LookupConstructTarget(HValue* constructor);
   bool TryInlineBuiltinFunction(Call* expr,
                                 HValue* receiver,
                                 Handle<Map> receiver_map,
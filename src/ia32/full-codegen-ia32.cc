@@ -2325,6 +2325,7 @@ void FullCodeGenerator::VisitCallNew(CallNew* expr) {
   __ call(construct_builtin, RelocInfo::CONSTRUCT_CALL);
 
   decrement_stack_height(arg_count + 1);
+  PrepareForBailoutForId(expr->ReturnId(), TOS_REG);
   context()->Plug(eax);
 }
 
@@ -398,15 +398,42 @@ void LCodeGen::WriteTranslation(LEnvironment* environment,
                                 Translation* translation) {
   if (environment == NULL) return;
 
-  // The translation includes one command per value in the environment.
-  int translation_size = environment->values()->length();
+  // The translation includes one command per value in the frame. Captured
+  // objects are followed by the commands for their boilerplate and fields.
+  int translation_size = environment->translation_size();
   // The output frame height does not include the parameters.
   int height = translation_size - environment->parameter_count();
 
   WriteTranslation(environment->outer(), translation);
   int closure_id = DefineDeoptimizationLiteral(environment->closure());
-  translation->BeginFrame(environment->ast_id(), closure_id, height);
+  switch (environment->frame_type()) {
+    case JS_FUNCTION:
+      translation->BeginFrame(environment->ast_id(), closure_id, height);
+      break;
+    case JS_CONSTRUCT:
+      translation->BeginConstructStubFrame(closure_id, translation_size);
+      break;
+    default:
+      UNREACHABLE();
+  }
+  int field_index = translation_size;
   for (int i = 0; i < translation_size; ++i) {
+    HCapturedObject* object = environment->CapturedObjectAt(i);
+    if (object != NULL) {
+      // Captured objects are never live at an OSR entry, so their fields
+      // are not spilled.
+      int length = object->OperandCount();
+      translation->BeginCapturedObject(object->object_id(), length + 1);
+      translation->StoreLiteral(
+          DefineDeoptimizationLiteral(object->boilerplate()));
+      for (int j = 0; j < length; ++j, ++field_index) {
+        AddToTranslation(translation,
+                         environment->values()->at(field_index),
+                         environment->HasTaggedValueAt(field_index));
+      }
+      continue;
+    }
+
     LOperand* value = environment->values()->at(i);
     // spilled_registers_ and spilled_double_registers_ are either
     // both NULL or both set.
@@ -581,10 +608,14 @@ void LCodeGen::RegisterEnvironmentForDeoptimization(LEnvironment* environment) {
     // |>------------  translation_size ------------<|
 
     int frame_count = 0;
+    int jsframe_count = 0;
     for (LEnvironment* e = environment; e != NULL; e = e->outer()) {
       ++frame_count;
+      if (e->frame_type() == JS_FUNCTION) {
+        ++jsframe_count;
+      }
     }
-    Translation translation(&translations_, frame_count);
+    Translation translation(&translations_, frame_count, jsframe_count);
     WriteTranslation(environment, &translation);
     int deoptimization_index = deoptimizations_.length();
     environment->Register(deoptimization_index, translation.index());
@@ -4093,6 +4124,99 @@ void LCodeGen::DoCheckPrototypeMaps(LCheckPrototypeMaps* instr) {
 }
 
 
+void LCodeGen::DoAllocateObject(LAllocateObject* instr) {
+  class DeferredAllocateObject: public LDeferredCode {
+   public:
+    DeferredAllocateObject(LCodeGen* codegen, LAllocateObject* instr)
+        : LDeferredCode(codegen), instr_(instr) { }
+    virtual void Generate() { codegen()->DoDeferredAllocateObject(instr_); }
+    virtual LInstruction* instr() { return instr_; }
+   private:
+    LAllocateObject* instr_;
+  };
+
+  DeferredAllocateObject* deferred = new DeferredAllocateObject(this, instr);
+
+  Register result = ToRegister(instr->result());
+  Register scratch = ToRegister(instr->TempAt(0));
+  Handle<JSFunction> constructor = instr->hydrogen()->constructor();
+  Handle<Map> initial_map(constructor->initial_map());
+  int instance_size = initial_map->instance_size();
+  ASSERT(initial_map->pre_allocated_property_fields() +
+         initial_map->unused_property_fields() -
+         initial_map->inobject_properties() == 0);
+
+  // Allocate memory for the object.  The initial map might change when the
+  // constructor's prototype changes, but the instance size and the property
+  // counts stay the same once slack tracking has finished.
+  ASSERT(!constructor->shared()->IsInobjectSlackTrackingInProgress());
+  if (FLAG_inline_new) {
+    __ AllocateInNewSpace(instance_size,
+                          result,
+                          no_reg,
+                          scratch,
+                          deferred->entry(),
+                          TAG_OBJECT);
+  } else {
+    __ jmp(deferred->entry());
+  }
+  __ bind(deferred->exit());
+
+  // Load the initial map.
+  Register map = scratch;
+  LoadHeapObject(scratch, constructor);
+  __ mov(map, FieldOperand(scratch, JSFunction::kPrototypeOrInitialMapOffset));
+
+  if (FLAG_debug_code) {
+    __ AbortIfSmi(map);
+    __ cmpb(FieldOperand(map, Map::kInstanceSizeOffset),
+            instance_size >> kPointerSizeLog2);
+    __ Assert(equal, "Unexpected instance size");
+    __ cmpb(FieldOperand(map, Map::kInObjectPropertiesOffset),
+            initial_map->inobject_properties());
+    __ Assert(equal, "Unexpected in-object property count");
+  }
+
+  // Initialize the map and the fields of the new object.
+  __ mov(FieldOperand(result, JSObject::kMapOffset), map);
+  __ mov(scratch, factory()->empty_fixed_array());
+  __ mov(FieldOperand(result, JSObject::kElementsOffset), scratch);
+  __ mov(FieldOperand(result, JSObject::kPropertiesOffset), scratch);
+  if (initial_map->inobject_properties() != 0) {
+    __ mov(scratch, factory()->undefined_value());
+    for (int i = 0; i < initial_map->inobject_properties(); i++) {
+      int property_offset = JSObject::kHeaderSize + i * kPointerSize;
+      __ mov(FieldOperand(result, property_offset), scratch);
+    }
+  }
+}
+
+
+void LCodeGen::DoDeferredAllocateObject(LAllocateObject* instr) {
+  Register result = ToRegister(instr->result());
+  Handle<JSFunction> constructor = instr->hydrogen()->constructor();
+  int instance_size = constructor->initial_map()->instance_size();
+
+  // TODO(3095996): Get rid of this. For now, we need to make the
+  // result register contain a valid pointer because it is already
+  // contained in the register pointer map.
+  __ Set(result, Immediate(0));
+
+  // Stores into the object may omit the write barrier, so the fallback
+  // has to allocate in new space as well.  The fields are initialized
+  // after returning to the inline code.
+  PushSafepointRegistersScope scope(this);
+  __ push(Immediate(Smi::FromInt(instance_size)));
+  // Runtime::kAllocateInNewSpace does not need the context of an inlined
+  // function, so use the one from the frame.
+  __ mov(esi, Operand(ebp, StandardFrameConstants::kContextOffset));
+  __ CallRuntimeSaveDoubles(Runtime::kAllocateInNewSpace);
+  RecordSafepointWithRegisters(
+      instr->pointer_map(), 1, Safepoint::kNoDeoptimizationIndex);
+  __ StoreToSafepointRegisterSlot(result, eax);
+}
+
+
 void LCodeGen::DoArrayLiteral(LArrayLiteral* instr) {
   ASSERT(ToRegister(instr->context()).is(esi));
   // Setup the parameters to the stub/runtime call.
@@ -4119,6 +4243,18 @@ void LCodeGen::DoArrayLiteral(LArrayLiteral* instr) {
     FastCloneShallowArrayStub stub(mode, length);
     CallCode(stub.GetCode(), RelocInfo::CODE_TARGET, instr);
   }
+
+  if (instr->hydrogen()->requires_new_space()) {
+    // Stores into the literal omit the write barrier, so the array and its
+    // elements must not have been allocated in old space.
+    Label deopt, done;
+    __ JumpIfNotInNewSpace(eax, ebx, &deopt, Label::kNear);
+    __ mov(ebx, FieldOperand(eax, JSObject::kElementsOffset));
+    __ JumpIfInNewSpace(ebx, ebx, &done, Label::kNear);
+    __ bind(&deopt);
+    DeoptimizeIf(no_condition, instr->environment());
+    __ bind(&done);
+  }
 }
 
 
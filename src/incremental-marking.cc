@@ -694,9 +694,30 @@ void IncrementalMarking::Step(intptr_t allocated_bytes) {
 
   intptr_t bytes_to_process = allocated_ * allocation_marking_factor_;
 
+  // Stay within the pause goal, even if marking falls behind allocation.
+  intptr_t max_step_size = heap_->MaxIncrementalMarkingStepSize();
+  if (max_step_size > 0 && bytes_to_process > max_step_size) {
+    bytes_to_process = max_step_size;
+  }
+
+  Advance(bytes_to_process);
+}
+
+
+void IncrementalMarking::Advance(intptr_t bytes_to_process) {
+  if (heap_->gc_state() != Heap::NOT_IN_GC ||
+      !FLAG_incremental_marking ||
+      (state_ != SWEEPING && state_ != MARKING)) {
+    return;
+  }
+
+  intptr_t bytes_requested = bytes_to_process;
+  bool marking = (state_ == MARKING);
+
   double start = 0;
 
-  if (FLAG_trace_incremental_marking || FLAG_trace_gc) {
+  if (FLAG_trace_incremental_marking || FLAG_trace_gc ||
+      heap_->HasGCGoals()) {
     start = OS::TimeCurrentMillis();
   }
 
@@ -786,12 +807,17 @@ void IncrementalMarking::Step(intptr_t allocated_bytes) {
     }
   }
 
-  if (FLAG_trace_incremental_marking || FLAG_trace_gc) {
+  if (FLAG_trace_incremental_marking || FLAG_trace_gc ||
+      heap_->HasGCGoals()) {
     double end = OS::TimeCurrentMillis();
     double delta = (end - start);
     longest_step_ = Max(longest_step_, delta);
     steps_took_ += delta;
     steps_took_since_last_gc_ += delta;
+    if (marking && heap_->HasGCGoals()) {
+      heap_->RecordIncrementalMarkingStep(bytes_requested - bytes_to_process,
+                                          delta);
+    }
   }
 }
 
@@ -103,6 +103,10 @@ class IncrementalMarking {
   }
   void Step(intptr_t allocated);
 
+  // Does about bytes_to_process bytes of sweeping or marking work, whatever
+  // the amount allocated since the last step.
+  void Advance(intptr_t bytes_to_process);
+
   inline void RestartIfNotMarking() {
     if (state_ == COMPLETE) {
       state_ = MARKING;
@@ -29,6 +29,7 @@
 
 #include "v8.h"
 
+#include "api.h"
 #include "ast.h"
 #include "bootstrapper.h"
 #include "codegen.h"
@@ -41,6 +42,7 @@
 #include "lithium-allocator.h"
 #include "log.h"
 #include "messages.h"
+#include "optimizing-compiler-thread.h"
 #include "regexp-stack.h"
 #include "runtime-profiler.h"
 #include "scopeinfo.h"
@@ -314,6 +316,7 @@ void Isolate::PreallocatedStorageDelete(void* p) {
 Isolate* Isolate::default_isolate_ = NULL;
 Thread::LocalStorageKey Isolate::isolate_key_;
 Thread::LocalStorageKey Isolate::thread_id_key_;
+Thread::LocalStorageKey Isolate::zone_key_;
 Thread::LocalStorageKey Isolate::per_isolate_thread_data_key_;
 Mutex* Isolate::process_wide_mutex_ = OS::CreateMutex();
 Isolate::ThreadDataTable* Isolate::thread_data_table_ = NULL;
@@ -384,6 +387,7 @@ void Isolate::EnsureDefaultIsolate() {
   if (default_isolate_ == NULL) {
     isolate_key_ = Thread::CreateThreadLocalKey();
     thread_id_key_ = Thread::CreateThreadLocalKey();
+    zone_key_ = Thread::CreateThreadLocalKey();
     per_isolate_thread_data_key_ = Thread::CreateThreadLocalKey();
     thread_data_table_ = new Isolate::ThreadDataTable();
     default_isolate_ = new Isolate();
@@ -489,6 +493,45 @@ void Isolate::Iterate(ObjectVisitor* v) {
 }
 
 
+void Isolate::LinkDeferredHandles(DeferredHandles* deferred) {
+  deferred->next_ = deferred_handles_head_;
+  if (deferred_handles_head_ != NULL) {
+    deferred_handles_head_->previous_ = deferred;
+  }
+  deferred_handles_head_ = deferred;
+}
+
+
+void Isolate::UnlinkDeferredHandles(DeferredHandles* deferred) {
+#ifdef DEBUG
+  // In debug mode assert that the linked list is well-formed.
+  DeferredHandles* deferred_iterator = deferred;
+  while (deferred_iterator->previous_ != NULL) {
+    deferred_iterator = deferred_iterator->previous_;
+  }
+  ASSERT(deferred_handles_head_ == deferred_iterator);
+#endif
+  if (deferred_handles_head_ == deferred) {
+    deferred_handles_head_ = deferred_handles_head_->next_;
+  }
+  if (deferred->next_ != NULL) {
+    deferred->next_->previous_ = deferred->previous_;
+  }
+  if (deferred->previous_ != NULL) {
+    deferred->previous_->next_ = deferred->next_;
+  }
+}
+
+
+void Isolate::IterateDeferredHandles(ObjectVisitor* v) {
+  for (DeferredHandles* deferred = deferred_handles_head_;
+       deferred != NULL;
+       deferred = deferred->next_) {
+    deferred->Iterate(v);
+  }
+}
+
+
 void Isolate::RegisterTryCatchHandler(v8::TryCatch* that) {
   // The ARM simulator has a separate JS stack.  We therefore register
   // the C++ try catch handler with the simulator and get back an
@@ -1389,6 +1432,8 @@ Isolate::Isolate()
       preallocated_message_space_(NULL),
       bootstrapper_(NULL),
       runtime_profiler_(NULL),
+      optimizing_compiler_thread_(NULL),
+      deferred_handles_head_(NULL),
       compilation_cache_(NULL),
       counters_(NULL),
       code_range_(NULL),
@@ -1504,6 +1549,12 @@ void Isolate::Deinit() {
     // We must stop the logger before we tear down other components.
     logger_->EnsureTickerStopped();
 
+    if (optimizing_compiler_thread_ != NULL) {
+      optimizing_compiler_thread_->Stop();
+      delete optimizing_compiler_thread_;
+      optimizing_compiler_thread_ = NULL;
+    }
+
     delete deoptimizer_data_;
     deoptimizer_data_ = NULL;
     if (FLAG_preemption) {
@@ -1792,6 +1843,13 @@ bool Isolate::Init(Deserializer* des) {
   runtime_profiler_ = new RuntimeProfiler(this);
   runtime_profiler_->Setup();
 
+  // Hydrogen tracing and statistics are not thread safe.
+  if (FLAG_concurrent_recompilation && V8::UseCrankshaft() &&
+      !FLAG_trace_hydrogen && !FLAG_hydrogen_stats) {
+    optimizing_compiler_thread_ = new OptimizingCompilerThread(this);
+    optimizing_compiler_thread_->Start();
+  }
+
   // If we are deserializing, log non-function code objects and compiled
   // functions found in the snapshot.
   if (des != NULL && (FLAG_log_code || FLAG_ll_prof)) {
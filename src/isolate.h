@@ -56,6 +56,7 @@ class ContextSwitcher;
 class Counters;
 class CpuFeatures;
 class CpuProfiler;
+class DeferredHandles;
 class DeoptimizerData;
 class Deserializer;
 class EmptyStatement;
@@ -67,6 +68,7 @@ class HeapProfiler;
 class InlineRuntimeFunctionsTable;
 class NoAllocationStringAllocator;
 class InnerPointerToCodeCache;
+class OptimizingCompilerThread;
 class PreallocatedMemoryThread;
 class RegExpStack;
 class SaveContext;
@@ -738,6 +740,12 @@ class Isolate {
   void IterateThread(ThreadVisitor* v);
   void IterateThread(ThreadVisitor* v, char* t);
 
+  // Handles detached from their handle scope by a DeferredHandleScope stay
+  // alive until the DeferredHandles object owning them is deleted.
+  void LinkDeferredHandles(DeferredHandles* deferred_handles);
+  void UnlinkDeferredHandles(DeferredHandles* deferred_handles);
+  void IterateDeferredHandles(ObjectVisitor* v);
+
 
   // Returns the current global context.
   Handle<Context> global_context();
@@ -794,6 +802,10 @@ class Isolate {
   }
   CodeRange* code_range() { return code_range_; }
   RuntimeProfiler* runtime_profiler() { return runtime_profiler_; }
+  // NULL unless --concurrent-recompilation is on.
+  OptimizingCompilerThread* optimizing_compiler_thread() {
+    return optimizing_compiler_thread_;
+  }
   CompilationCache* compilation_cache() { return compilation_cache_; }
   Logger* logger() {
     // Call InitializeLoggingAndCounters() if logging is needed before
@@ -835,7 +847,24 @@ class Isolate {
     ASSERT(handle_scope_implementer_);
     return handle_scope_implementer_;
   }
-  Zone* zone() { return &zone_; }
+  // Returns the zone that allocations on the current thread go to: the
+  // isolate's zone unless a ThreadZoneScope switched it. Zones are only
+  // switched when there is an optimizing compiler thread, so the thread
+  // local lookup is skipped otherwise.
+  Zone* zone() {
+    if (optimizing_compiler_thread_ != NULL) {
+      Zone* zone = ThreadZone();
+      if (zone != NULL) return zone;
+    }
+    return &zone_;
+  }
+
+  static Zone* ThreadZone() {
+    return reinterpret_cast<Zone*>(Thread::GetExistingThreadLocal(zone_key_));
+  }
+  static void SetThreadZone(Zone* zone) {
+    Thread::SetThreadLocal(zone_key_, zone);
+  }
 
   UnicodeCache* unicode_cache() {
     return unicode_cache_;
@@ -1046,6 +1075,7 @@ class Isolate {
   static Thread::LocalStorageKey per_isolate_thread_data_key_;
   static Thread::LocalStorageKey isolate_key_;
   static Thread::LocalStorageKey thread_id_key_;
+  static Thread::LocalStorageKey zone_key_;
   static Isolate* default_isolate_;
   static ThreadDataTable* thread_data_table_;
 
@@ -1110,6 +1140,8 @@ class Isolate {
 
   Bootstrapper* bootstrapper_;
   RuntimeProfiler* runtime_profiler_;
+  OptimizingCompilerThread* optimizing_compiler_thread_;
+  DeferredHandles* deferred_handles_head_;
   CompilationCache* compilation_cache_;
   Counters* counters_;
   CodeRange* code_range_;
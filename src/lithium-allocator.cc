@@ -1069,8 +1069,11 @@ void LAllocator::Allocate(LChunk* chunk) {
   MeetRegisterConstraints();
   ResolvePhis();
   BuildLiveRanges();
+  graph_->YieldHeapAccess();
   AllocateGeneralRegisters();
+  graph_->YieldHeapAccess();
   AllocateDoubleRegisters();
+  graph_->YieldHeapAccess();
   PopulatePointerMaps();
   if (has_osr_entry_) ProcessOsrEntry();
   ConnectRanges();
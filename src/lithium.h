@@ -443,12 +443,14 @@ class LPointerMap: public ZoneObject {
 class LEnvironment: public ZoneObject {
  public:
   LEnvironment(Handle<JSFunction> closure,
+               FrameType frame_type,
                int ast_id,
                int parameter_count,
                int argument_count,
                int value_count,
                LEnvironment* outer)
       : closure_(closure),
+        frame_type_(frame_type),
         arguments_stack_height_(argument_count),
         deoptimization_index_(Safepoint::kNoDeoptimizationIndex),
         translation_index_(-1),
@@ -456,12 +458,16 @@ class LEnvironment: public ZoneObject {
         parameter_count_(parameter_count),
         values_(value_count),
         representations_(value_count),
+        captured_object_indexes_(0),
+        captured_objects_(0),
+        captured_field_count_(0),
         spilled_registers_(NULL),
         spilled_double_registers_(NULL),
         outer_(outer) {
   }
 
   Handle<JSFunction> closure() const { return closure_; }
+  FrameType frame_type() const { return frame_type_; }
   int arguments_stack_height() const { return arguments_stack_height_; }
   int deoptimization_index() const { return deoptimization_index_; }
   int translation_index() const { return translation_index_; }
@@ -483,6 +489,34 @@ class LEnvironment: public ZoneObject {
     return representations_[index].IsTagged();
   }
 
+  // A captured object takes a NULL value in the frame. The values of its
+  // fields are added after all values of the frame.
+  void AddCapturedObject(HCapturedObject* object) {
+    captured_object_indexes_.Add(values_.length());
+    captured_objects_.Add(object);
+    AddValue(NULL, Representation::Tagged());
+  }
+
+  void AddCapturedObjectField(LOperand* operand,
+                              Representation representation) {
+    AddValue(operand, representation);
+    captured_field_count_++;
+  }
+
+  // The number of values in the frame, without the fields of captured
+  // objects.
+  int translation_size() const {
+    return values_.length() - captured_field_count_;
+  }
+
+  // Returns the captured object at the given index in the frame, or NULL.
+  HCapturedObject* CapturedObjectAt(int index) const {
+    for (int i = 0; i < captured_objects_.length(); ++i) {
+      if (captured_object_indexes_[i] == index) return captured_objects_[i];
+    }
+    return NULL;
+  }
+
   void Register(int deoptimization_index, int translation_index) {
     ASSERT(!HasBeenRegistered());
     deoptimization_index_ = deoptimization_index;
@@ -502,6 +536,7 @@ class LEnvironment: public ZoneObject {
 
  private:
   Handle<JSFunction> closure_;
+  FrameType frame_type_;
   int arguments_stack_height_;
   int deoptimization_index_;
   int translation_index_;
@@ -509,6 +544,9 @@ class LEnvironment: public ZoneObject {
   int parameter_count_;
   ZoneList<LOperand*> values_;
   ZoneList<Representation> representations_;
+  ZoneList<int> captured_object_indexes_;
+  ZoneList<HCapturedObject*> captured_objects_;
+  int captured_field_count_;
 
   // Allocation index indexed arrays of spill slot operands for registers
   // that are also in spill slots at an OSR entry.  NULL for environments
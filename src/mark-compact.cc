@@ -63,6 +63,7 @@ MarkCompactCollector::MarkCompactCollector() :  // NOLINT
       compacting_(false),
       was_marked_incrementally_(false),
       collect_maps_(FLAG_collect_maps),
+      attribute_contexts_(false),
       tracer_(NULL),
       migration_slots_buffer_(NULL),
 #ifdef DEBUG
@@ -76,6 +77,10 @@ MarkCompactCollector::MarkCompactCollector() :  // NOLINT
       live_bytes_(0),
 #endif
       heap_(NULL),
+      parallel_marker_(NULL),
+      parallel_evacuator_(NULL),
+      concurrent_sweeper_(NULL),
+      concurrent_sweeping_pending_(false),
       code_flusher_(NULL),
       encountered_weak_maps_(NULL) { }
 
@@ -707,6 +712,24 @@ MarkCompactCollector::~MarkCompactCollector() {
     delete code_flusher_;
     code_flusher_ = NULL;
   }
+  TearDown();
+}
+
+
+void MarkCompactCollector::TearDown() {
+  if (parallel_marker_ != NULL) {
+    delete parallel_marker_;
+    parallel_marker_ = NULL;
+  }
+  if (parallel_evacuator_ != NULL) {
+    delete parallel_evacuator_;
+    parallel_evacuator_ = NULL;
+  }
+  ASSERT(!concurrent_sweeping_pending_);
+  if (concurrent_sweeper_ != NULL) {
+    delete concurrent_sweeper_;
+    concurrent_sweeper_ = NULL;
+  }
 }
 
 
@@ -1834,6 +1857,59 @@ void MarkCompactCollector::MarkRoots(RootMarkingVisitor* visitor) {
 }
 
 
+void MarkCompactCollector::MarkGlobalContextsForAttribution(
+    RootMarkingVisitor* visitor) {
+  // The root list (maps, oddballs, empty arrays, caches) and the builtins
+  // are shared by all contexts and not charged to any of them.
+  heap()->IterateRootList(visitor);
+  heap()->isolate()->builtins()->IterateBuiltins(visitor);
+  while (marking_deque_.overflowed()) {
+    RefillMarkingDeque();
+    EmptyMarkingDeque();
+  }
+
+  intptr_t live_bytes = LiveBytesOfHeap();
+  Object* context = heap()->global_contexts_list();
+  while (!context->IsUndefined()) {
+    Object* next = Context::cast(context)->get(Context::NEXT_CONTEXT_LINK);
+    visitor->VisitPointer(&context);
+    while (marking_deque_.overflowed()) {
+      RefillMarkingDeque();
+      EmptyMarkingDeque();
+    }
+    intptr_t new_live_bytes = LiveBytesOfHeap();
+    attributed_context_sizes_.Add(new_live_bytes - live_bytes);
+    live_bytes = new_live_bytes;
+    context = next;
+  }
+}
+
+
+static intptr_t LiveBytesOfSpace(PagedSpace* space) {
+  intptr_t live_bytes = 0;
+  PageIterator it(space);
+  while (it.has_next()) live_bytes += it.next()->LiveBytes();
+  return live_bytes;
+}
+
+
+intptr_t MarkCompactCollector::LiveBytesOfHeap() {
+  intptr_t live_bytes = LiveBytesOfSpace(heap()->old_pointer_space()) +
+                        LiveBytesOfSpace(heap()->old_data_space()) +
+                        LiveBytesOfSpace(heap()->code_space()) +
+                        LiveBytesOfSpace(heap()->map_space()) +
+                        LiveBytesOfSpace(heap()->cell_space());
+  NewSpace* new_space = heap()->new_space();
+  NewSpacePageIterator it(new_space->ToSpaceStart(), new_space->ToSpaceEnd());
+  while (it.has_next()) live_bytes += it.next()->LiveBytes();
+  LargeObjectIterator lo_it(heap()->lo_space());
+  for (HeapObject* obj = lo_it.Next(); obj != NULL; obj = lo_it.Next()) {
+    live_bytes += MemoryChunk::FromAddress(obj->address())->LiveBytes();
+  }
+  return live_bytes;
+}
+
+
 void MarkCompactCollector::MarkObjectGroups() {
   List<ObjectGroup*>* object_groups =
       heap()->isolate()->global_handles()->object_groups();
@@ -1914,13 +1990,314 @@ void MarkCompactCollector::MarkImplicitRefGroups() {
 }
 
 
+ParallelMarkingDeque::ParallelMarkingDeque()
+    : array_(NewArray<HeapObject*>(kCapacity)),
+      mutex_(OS::CreateMutex()),
+      top_(0),
+      bottom_(0) {
+  STATIC_ASSERT(IS_POWER_OF_TWO(kCapacity));
+}
+
+
+ParallelMarkingDeque::~ParallelMarkingDeque() {
+  DeleteArray(array_);
+  delete mutex_;
+}
+
+
+bool ParallelMarkingDeque::Push(HeapObject* object) {
+  ScopedLock lock(mutex_);
+  if (top_ - bottom_ == kCapacity) return false;
+  array_[top_ & kMask] = object;
+  NoBarrier_Store(&top_, top_ + 1);
+  return true;
+}
+
+
+bool ParallelMarkingDeque::Pop(HeapObject** object) {
+  ScopedLock lock(mutex_);
+  if (top_ == bottom_) {
+    // Keep the indices small, the deque is reused across collections.
+    top_ = bottom_ = 0;
+    return false;
+  }
+  NoBarrier_Store(&top_, top_ - 1);
+  *object = array_[top_ & kMask];
+  return true;
+}
+
+
+bool ParallelMarkingDeque::Steal(HeapObject** object) {
+  ScopedLock lock(mutex_);
+  if (top_ == bottom_) return false;
+  *object = array_[bottom_ & kMask];
+  NoBarrier_Store(&bottom_, bottom_ + 1);
+  return true;
+}
+
+
+class ParallelMarkingThread : public Thread {
+ public:
+  ParallelMarkingThread(ParallelMarker* marker,
+                        int task_id,
+                        Semaphore* done_semaphore)
+      : Thread("v8:ParallelMarker"),
+        marker_(marker),
+        task_id_(task_id),
+        start_semaphore_(OS::CreateSemaphore(0)),
+        done_semaphore_(done_semaphore),
+        stop_(0) { }
+
+  ~ParallelMarkingThread() {
+    delete start_semaphore_;
+  }
+
+  void Run() {
+    while (true) {
+      start_semaphore_->Wait();
+      if (Acquire_Load(&stop_) != 0) return;
+      marker_->Work(task_id_);
+      done_semaphore_->Signal();
+    }
+  }
+
+  void StartTask() {
+    start_semaphore_->Signal();
+  }
+
+  void Stop() {
+    Release_Store(&stop_, 1);
+    start_semaphore_->Signal();
+    Join();
+  }
+
+ private:
+  ParallelMarker* marker_;
+  int task_id_;
+  Semaphore* start_semaphore_;
+  Semaphore* done_semaphore_;
+  Atomic32 stop_;
+};
+
+
+class ParallelMarkingVisitor : public ObjectVisitor {
+ public:
+  ParallelMarkingVisitor(ParallelMarker* marker, ParallelMarkingDeque* deque)
+      : marker_(marker), deque_(deque) { }
+
+  void VisitPointers(Object** start, Object** end) {
+    for (Object** p = start; p < end; p++) {
+      Object* object = *p;
+      if (!object->IsHeapObject()) continue;
+      marker_->RecordSlot(start, p, object);
+      marker_->MarkObject(HeapObject::cast(object), deque_);
+    }
+  }
+
+ private:
+  ParallelMarker* marker_;
+  ParallelMarkingDeque* deque_;
+};
+
+
+ParallelMarker::ParallelMarker(Heap* heap)
+    : heap_(heap),
+      tasks_(FLAG_marking_threads),
+      deques_(new ParallelMarkingDeque[FLAG_marking_threads]),
+      threads_(NewArray<ParallelMarkingThread*>(FLAG_marking_threads - 1)),
+      idle_tasks_(0),
+      overflowed_(0),
+      deferred_(kMinWorkForParallelMarking),
+      deferred_mutex_(OS::CreateMutex()),
+      slots_mutex_(OS::CreateMutex()),
+      done_semaphore_(OS::CreateSemaphore(0)) {
+  ASSERT(tasks_ > 1);
+  // Task 0 is run by the thread that started the collection.
+  for (int i = 1; i < tasks_; i++) {
+    threads_[i - 1] = new ParallelMarkingThread(this, i, done_semaphore_);
+    threads_[i - 1]->Start();
+  }
+}
+
+
+ParallelMarker::~ParallelMarker() {
+  for (int i = 1; i < tasks_; i++) {
+    threads_[i - 1]->Stop();
+    delete threads_[i - 1];
+  }
+  DeleteArray(threads_);
+  delete[] deques_;
+  delete deferred_mutex_;
+  delete slots_mutex_;
+  delete done_semaphore_;
+}
+
+
+bool ParallelMarker::IsSafeForParallelMarking(Map* map) {
+  switch (map->visitor_id()) {
+    case StaticVisitorBase::kVisitGlobalContext:
+    case StaticVisitorBase::kVisitCode:
+    case StaticVisitorBase::kVisitMap:
+    case StaticVisitorBase::kVisitSharedFunctionInfo:
+    case StaticVisitorBase::kVisitJSFunction:
+    case StaticVisitorBase::kVisitJSWeakMap:
+    case StaticVisitorBase::kVisitJSRegExp:
+      return false;
+    default:
+      return true;
+  }
+}
+
+
+void ParallelMarker::RecordSlot(Object** anchor_slot,
+                                Object** slot,
+                                Object* object) {
+  Page* object_page = Page::FromAddress(reinterpret_cast<Address>(object));
+  if (object_page->IsEvacuationCandidate()) {
+    ScopedLock lock(slots_mutex_);
+    heap_->mark_compact_collector()->RecordSlot(anchor_slot, slot, object);
+  }
+}
+
+
+void ParallelMarker::MarkObject(HeapObject* object,
+                                ParallelMarkingDeque* deque) {
+  MarkBit mark_bit = Marking::MarkBitFrom(object);
+  if (!mark_bit.SetAtomic()) return;
+  MemoryChunk::IncrementLiveBytesAtomic(object->address(), object->Size());
+
+  if (!IsSafeForParallelMarking(object->map())) {
+    ScopedLock lock(deferred_mutex_);
+    deferred_.Add(object);
+    return;
+  }
+
+  if (!deque->Push(object)) {
+    // Turn the object grey and let the sequential marker rediscover it
+    // when it refills its marking deque.
+    mark_bit.Next().SetAtomic();
+    MemoryChunk::IncrementLiveBytesAtomic(object->address(), -object->Size());
+    Release_Store(&overflowed_, 1);
+  }
+}
+
+
+void ParallelMarker::VisitObject(HeapObject* object,
+                                 ParallelMarkingDeque* deque) {
+  ASSERT(Marking::IsBlack(Marking::MarkBitFrom(object)));
+  Map* map = object->map();
+  MarkObject(map, deque);
+  ParallelMarkingVisitor visitor(this, deque);
+  object->IterateBody(map->instance_type(), object->SizeFromMap(map), &visitor);
+}
+
+
+bool ParallelMarker::IsWorkAvailable() {
+  for (int i = 0; i < tasks_; i++) {
+    if (!deques_[i].IsEmpty()) return true;
+  }
+  return false;
+}
+
+
+bool ParallelMarker::TrySteal(int task_id, HeapObject** object) {
+  for (int i = 1; i < tasks_; i++) {
+    if (deques_[(task_id + i) % tasks_].Steal(object)) return true;
+  }
+  return false;
+}
+
+
+void ParallelMarker::Work(int task_id) {
+  ParallelMarkingDeque* deque = &deques_[task_id];
+  HeapObject* object;
+  while (true) {
+    while (deque->Pop(&object)) VisitObject(object, deque);
+    if (TrySteal(task_id, &object)) {
+      VisitObject(object, deque);
+      continue;
+    }
+
+    // Out of work.  Terminate when every other task is out of work too,
+    // otherwise go back to stealing as soon as something shows up.  Give
+    // up the CPU while waiting so that the tasks that still have work are
+    // not starved by the idle ones.
+    Barrier_AtomicIncrement(&idle_tasks_, 1);
+    while (!IsWorkAvailable()) {
+      if (Acquire_Load(&idle_tasks_) == tasks_) return;
+      Thread::YieldCPU();
+    }
+    Barrier_AtomicIncrement(&idle_tasks_, -1);
+  }
+}
+
+
+void ParallelMarker::Drain() {
+  MarkCompactCollector* collector = heap_->mark_compact_collector();
+  MarkingDeque* marking_deque = &collector->marking_deque_;
+
+  // Spread the initial work round robin over the tasks' deques.  Objects
+  // that need the sequential marker and whatever does not fit stay on the
+  // marking deque.
+  List<HeapObject*> sequential;
+  int task = 0;
+  while (!marking_deque->IsEmpty()) {
+    HeapObject* object = marking_deque->Pop();
+    if (!IsSafeForParallelMarking(object->map())) {
+      sequential.Add(object);
+    } else if (deques_[task].Push(object)) {
+      task = (task + 1) % tasks_;
+    } else {
+      sequential.Add(object);
+      break;
+    }
+  }
+  for (int i = 0; i < sequential.length(); i++) {
+    marking_deque->PushBlack(sequential[i]);
+  }
+
+  NoBarrier_Store(&idle_tasks_, 0);
+  NoBarrier_Store(&overflowed_, 0);
+  for (int i = 1; i < tasks_; i++) threads_[i - 1]->StartTask();
+  Work(0);
+  for (int i = 1; i < tasks_; i++) done_semaphore_->Wait();
+
+  // Hand the objects the helpers could not process back to the sequential
+  // marker.
+  for (int i = 0; i < deferred_.length(); i++) {
+    collector->ProcessNewlyMarkedObject(deferred_[i]);
+  }
+  deferred_.Rewind(0);
+
+  if (Acquire_Load(&overflowed_) != 0) marking_deque->SetOverflowed();
+}
+
+
 // Mark all objects reachable from the objects on the marking stack.
 // Before: the marking stack contains zero or more heap object pointers.
 // After: the marking stack is empty, and all objects reachable from the
 // marking stack have been marked, or are overflowed in the heap.
 void MarkCompactCollector::EmptyMarkingDeque() {
+  bool use_parallel_marker = FLAG_parallel_marking && FLAG_marking_threads > 1;
+  // Number of objects to process sequentially before the parallel marker
+  // may be started again.  Guarantees progress when the deque is full of
+  // objects only the sequential marker can handle.
+  int sequential_work = 0;
   while (!marking_deque_.IsEmpty()) {
     while (!marking_deque_.IsEmpty()) {
+      if (use_parallel_marker &&
+          sequential_work == 0 &&
+          marking_deque_.Size() >=
+              ParallelMarker::kMinWorkForParallelMarking) {
+        if (parallel_marker_ == NULL) {
+          parallel_marker_ = new ParallelMarker(heap());
+        }
+        parallel_marker_->Drain();
+        sequential_work = marking_deque_.Size();
+        continue;
+      }
+      if (sequential_work > 0) sequential_work--;
+
       HeapObject* object = marking_deque_.Pop();
       ASSERT(object->IsHeapObject());
       ASSERT(heap()->Contains(object));
@@ -2060,6 +2437,13 @@ void MarkCompactCollector::MarkLiveObjects() {
   PrepareForCodeFlushing();
 
   RootMarkingVisitor root_visitor(heap());
+  if (attribute_contexts_) {
+    attributed_context_sizes_.Rewind(0);
+    if (!was_marked_incrementally_) {
+      MarkGlobalContextsForAttribution(&root_visitor);
+    }
+    attribute_contexts_ = false;
+  }
   MarkRoots(&root_visitor);
 
   // The objects reachable from the roots are marked, yet unreachable
@@ -2395,6 +2779,16 @@ void MarkCompactCollector::MigrateObject(Address dst,
                                          Address src,
                                          int size,
                                          AllocationSpace dest) {
+  MigrateObject(dst, src, size, dest, &migration_slots_buffer_, NULL);
+}
+
+
+void MarkCompactCollector::MigrateObject(Address dst,
+                                         Address src,
+                                         int size,
+                                         AllocationSpace dest,
+                                         SlotsBuffer** migration_slots_buffer,
+                                         List<Address>* store_buffer_slots) {
   HEAP_PROFILE(heap(), ObjectMoveEvent(src, dst));
   if (dest == OLD_POINTER_SPACE || dest == LO_SPACE) {
     Address src_slot = src;
@@ -2407,10 +2801,14 @@ void MarkCompactCollector::MigrateObject(Address dst,
       Memory::Object_at(dst_slot) = value;
 
       if (heap_->InNewSpace(value)) {
-        heap_->store_buffer()->Mark(dst_slot);
+        if (store_buffer_slots == NULL) {
+          heap_->store_buffer()->Mark(dst_slot);
+        } else {
+          store_buffer_slots->Add(dst_slot);
+        }
       } else if (value->IsHeapObject() && IsOnEvacuationCandidate(value)) {
         SlotsBuffer::AddTo(&slots_buffer_allocator_,
-                           &migration_slots_buffer_,
+                           migration_slots_buffer,
                            reinterpret_cast<Object**>(dst_slot),
                            SlotsBuffer::IGNORE_OVERFLOW);
       }
@@ -2425,7 +2823,7 @@ void MarkCompactCollector::MigrateObject(Address dst,
 
       if (Page::FromAddress(code_entry)->IsEvacuationCandidate()) {
         SlotsBuffer::AddTo(&slots_buffer_allocator_,
-                           &migration_slots_buffer_,
+                           migration_slots_buffer,
                            SlotsBuffer::CODE_ENTRY_SLOT,
                            code_entry_slot,
                            SlotsBuffer::IGNORE_OVERFLOW);
@@ -2435,7 +2833,7 @@ void MarkCompactCollector::MigrateObject(Address dst,
     PROFILE(heap()->isolate(), CodeMoveEvent(src, dst));
     heap()->MoveBlock(dst, src, size);
     SlotsBuffer::AddTo(&slots_buffer_allocator_,
-                       &migration_slots_buffer_,
+                       migration_slots_buffer,
                        SlotsBuffer::RELOCATED_CODE_OBJECT,
                        dst,
                        SlotsBuffer::IGNORE_OVERFLOW);
@@ -2712,6 +3110,26 @@ void MarkCompactCollector::EvacuateLiveObjectsFromPage(Page* p) {
 
 void MarkCompactCollector::EvacuatePages() {
   int npages = evacuation_candidates_.length();
+  if (CanEvacuateInParallel()) {
+    if (parallel_evacuator_ == NULL) {
+      parallel_evacuator_ = new ParallelEvacuator(heap());
+    }
+    {
+      AlwaysAllocateScope always_allocate;
+      parallel_evacuator_->EvacuatePages(&evacuation_candidates_);
+    }
+    // Pessimistically abandon the pages the evacuator did not get to.
+    for (int i = 0; i < npages; i++) {
+      Page* p = evacuation_candidates_[i];
+      if (p->IsEvacuationCandidate() && !p->WasSwept()) {
+        slots_buffer_allocator_.DeallocateChain(p->slots_buffer_address());
+        p->ClearEvacuationCandidate();
+        p->SetFlag(Page::RESCAN_ON_EVACUATION);
+      }
+    }
+    return;
+  }
+
   for (int i = 0; i < npages; i++) {
     Page* p = evacuation_candidates_[i];
     ASSERT(p->IsEvacuationCandidate() ||
@@ -2737,6 +3155,386 @@ void MarkCompactCollector::EvacuatePages() {
 }
 
 
+bool MarkCompactCollector::CanEvacuateInParallel() {
+  if (!FLAG_parallel_compaction || FLAG_compaction_threads < 2) return false;
+  Isolate* isolate = heap()->isolate();
+  HeapProfiler* heap_profiler = isolate->heap_profiler();
+  return !isolate->logger()->is_logging() &&
+         !CpuProfiler::is_profiling(isolate) &&
+         (heap_profiler == NULL || !heap_profiler->is_profiling());
+}
+
+
+// A task of the parallel evacuator.  Objects are copied into local
+// allocation buffers in the old pointer and old data spaces; code objects
+// and objects too large for a buffer are allocated directly.
+class ParallelEvacuationTask {
+ public:
+  ParallelEvacuationTask(Heap* heap, ParallelEvacuator* evacuator)
+      : heap_(heap),
+        evacuator_(evacuator),
+        migration_slots_buffer_(NULL) {
+    ClearBuffer(&old_pointer_space_buffer_);
+    ClearBuffer(&old_data_space_buffer_);
+  }
+
+  void EvacuatePage(Page* p);
+
+  // Gives the unused parts of the allocation buffers back and enters the
+  // recorded slots into the store buffer.  Called on the main thread after
+  // all tasks are done.
+  void Finish();
+
+  SlotsBuffer** migration_slots_buffer_address() {
+    return &migration_slots_buffer_;
+  }
+
+  // Local allocation buffers are refilled in chunks of this size.  Larger
+  // objects are allocated directly, which bounds the waste at the end of a
+  // buffer to a quarter of it.
+  static const int kBufferSize = 8 * KB;
+  static const int kMaxBufferedObjectSize = kBufferSize / 4;
+
+ private:
+  static void ClearBuffer(AllocationInfo* buffer) {
+    buffer->top = buffer->limit = NULL;
+  }
+
+  HeapObject* Allocate(PagedSpace* space, int size_in_bytes);
+  void ReleaseBuffer(PagedSpace* space, AllocationInfo* buffer);
+
+  Heap* heap_;
+  ParallelEvacuator* evacuator_;
+
+  AllocationInfo old_pointer_space_buffer_;
+  AllocationInfo old_data_space_buffer_;
+
+  SlotsBuffer* migration_slots_buffer_;
+
+  // Slots of migrated objects that point to new space.
+  List<Address> store_buffer_slots_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelEvacuationTask);
+};
+
+
+HeapObject* ParallelEvacuationTask::Allocate(PagedSpace* space,
+                                             int size_in_bytes) {
+  if (space->identity() == CODE_SPACE ||
+      size_in_bytes > kMaxBufferedObjectSize) {
+    return evacuator_->Allocate(space, size_in_bytes);
+  }
+
+  AllocationInfo* buffer = (space->identity() == OLD_POINTER_SPACE)
+      ? &old_pointer_space_buffer_
+      : &old_data_space_buffer_;
+  if (buffer->limit - buffer->top < size_in_bytes) {
+    ReleaseBuffer(space, buffer);
+    HeapObject* chunk = evacuator_->Allocate(space, kBufferSize);
+    if (chunk == NULL) return evacuator_->Allocate(space, size_in_bytes);
+    buffer->top = chunk->address();
+    buffer->limit = chunk->address() + kBufferSize;
+  }
+  HeapObject* result = HeapObject::FromAddress(buffer->top);
+  buffer->top += size_in_bytes;
+  return result;
+}
+
+
+void ParallelEvacuationTask::ReleaseBuffer(PagedSpace* space,
+                                           AllocationInfo* buffer) {
+  if (buffer->top != NULL && buffer->top != buffer->limit) {
+    evacuator_->Free(space,
+                     buffer->top,
+                     static_cast<int>(buffer->limit - buffer->top));
+  }
+  ClearBuffer(buffer);
+}
+
+
+void ParallelEvacuationTask::EvacuatePage(Page* p) {
+  MarkCompactCollector* collector = heap_->mark_compact_collector();
+  PagedSpace* space = static_cast<PagedSpace*>(p->owner());
+  ASSERT(p->IsEvacuationCandidate() && !p->WasSwept());
+  MarkBit::CellType* cells = p->markbits()->cells();
+  p->MarkSweptPrecisely();
+
+  int last_cell_index =
+      Bitmap::IndexToCell(
+          Bitmap::CellAlignIndex(
+              p->AddressToMarkbitIndex(p->ObjectAreaEnd())));
+
+  Address cell_base = p->ObjectAreaStart();
+  int offsets[16];
+
+  for (int cell_index = Page::kFirstUsedCell;
+       cell_index < last_cell_index;
+       cell_index++, cell_base += 32 * kPointerSize) {
+    if (cells[cell_index] == 0) continue;
+
+    int live_objects = MarkWordToObjectStarts(cells[cell_index], offsets);
+    for (int i = 0; i < live_objects; i++) {
+      Address object_addr = cell_base + offsets[i] * kPointerSize;
+      HeapObject* object = HeapObject::FromAddress(object_addr);
+      ASSERT(Marking::IsBlack(Marking::MarkBitFrom(object)));
+
+      int size = object->Size();
+      HeapObject* target = Allocate(space, size);
+      if (target == NULL) {
+        // OS refused to give us memory.
+        V8::FatalProcessOutOfMemory("Evacuation");
+        return;
+      }
+
+      collector->MigrateObject(target->address(),
+                               object_addr,
+                               size,
+                               space->identity(),
+                               &migration_slots_buffer_,
+                               &store_buffer_slots_);
+      ASSERT(object->map_word().IsForwardingAddress());
+    }
+
+    // Clear marking bits for current cell.
+    cells[cell_index] = 0;
+  }
+  p->ResetLiveBytes();
+}
+
+
+void ParallelEvacuationTask::Finish() {
+  ReleaseBuffer(heap_->old_pointer_space(), &old_pointer_space_buffer_);
+  ReleaseBuffer(heap_->old_data_space(), &old_data_space_buffer_);
+
+  for (int i = 0; i < store_buffer_slots_.length(); i++) {
+    heap_->store_buffer()->Mark(store_buffer_slots_[i]);
+  }
+  store_buffer_slots_.Clear();
+}
+
+
+class ParallelEvacuationThread : public Thread {
+ public:
+  ParallelEvacuationThread(ParallelEvacuator* evacuator,
+                           int task_id,
+                           Isolate* isolate,
+                           Semaphore* done_semaphore)
+      : Thread("v8:ParallelEvacuator"),
+        evacuator_(evacuator),
+        task_id_(task_id),
+        isolate_(isolate),
+        start_semaphore_(OS::CreateSemaphore(0)),
+        done_semaphore_(done_semaphore),
+        stop_(0) { }
+
+  ~ParallelEvacuationThread() {
+    delete start_semaphore_;
+  }
+
+  void Run() {
+    // Relocating code objects flushes the instruction cache through the
+    // current isolate.
+    Thread::SetThreadLocal(Isolate::isolate_key(), isolate_);
+    while (true) {
+      start_semaphore_->Wait();
+      if (Acquire_Load(&stop_) != 0) return;
+      evacuator_->Work(task_id_);
+      done_semaphore_->Signal();
+    }
+  }
+
+  void StartTask() {
+    start_semaphore_->Signal();
+  }
+
+  void Stop() {
+    Release_Store(&stop_, 1);
+    start_semaphore_->Signal();
+    Join();
+  }
+
+ private:
+  ParallelEvacuator* evacuator_;
+  int task_id_;
+  Isolate* isolate_;
+  Semaphore* start_semaphore_;
+  Semaphore* done_semaphore_;
+  Atomic32 stop_;
+};
+
+
+ParallelEvacuator::ParallelEvacuator(Heap* heap)
+    : heap_(heap),
+      tasks_(FLAG_compaction_threads),
+      task_state_(NewArray<ParallelEvacuationTask*>(FLAG_compaction_threads)),
+      threads_(NewArray<ParallelEvacuationThread*>(
+          FLAG_compaction_threads - 1)),
+      phase_(EVACUATE_PAGES),
+      pages_(NULL),
+      next_page_(0),
+      aborted_(0),
+      next_slots_buffer_(0),
+      code_slots_filtering_required_(false),
+      allocation_mutex_(OS::CreateMutex()),
+      done_semaphore_(OS::CreateSemaphore(0)) {
+  ASSERT(tasks_ > 1);
+  for (int i = 0; i < tasks_; i++) {
+    task_state_[i] = new ParallelEvacuationTask(heap, this);
+  }
+  // Task 0 is run by the thread that started the collection.
+  for (int i = 1; i < tasks_; i++) {
+    threads_[i - 1] = new ParallelEvacuationThread(this,
+                                                   i,
+                                                   heap->isolate(),
+                                                   done_semaphore_);
+    threads_[i - 1]->Start();
+  }
+}
+
+
+ParallelEvacuator::~ParallelEvacuator() {
+  for (int i = 1; i < tasks_; i++) {
+    threads_[i - 1]->Stop();
+    delete threads_[i - 1];
+  }
+  DeleteArray(threads_);
+  DeallocateMigrationSlots();
+  for (int i = 0; i < tasks_; i++) delete task_state_[i];
+  DeleteArray(task_state_);
+  delete allocation_mutex_;
+  delete done_semaphore_;
+}
+
+
+void ParallelEvacuator::StartHelpers(Phase phase) {
+  phase_ = phase;
+  for (int i = 1; i < tasks_; i++) threads_[i - 1]->StartTask();
+}
+
+
+void ParallelEvacuator::WaitForHelpers() {
+  for (int i = 1; i < tasks_; i++) done_semaphore_->Wait();
+}
+
+
+void ParallelEvacuator::EvacuatePages(List<Page*>* pages) {
+  pages_ = pages;
+  NoBarrier_Store(&next_page_, 0);
+  NoBarrier_Store(&aborted_, 0);
+  StartHelpers(EVACUATE_PAGES);
+  Work(0);
+  WaitForHelpers();
+  pages_ = NULL;
+
+  for (int i = 0; i < tasks_; i++) task_state_[i]->Finish();
+}
+
+
+void ParallelEvacuator::StartUpdatingSlots(SlotsBuffer* migration_slots_buffer,
+                                           List<Page*>* pages,
+                                           bool code_slots_filtering_required) {
+  ASSERT(slots_buffers_.is_empty());
+  for (SlotsBuffer* buffer = migration_slots_buffer;
+       buffer != NULL;
+       buffer = buffer->next()) {
+    slots_buffers_.Add(buffer);
+  }
+  for (int i = 0; i < tasks_; i++) {
+    SlotsBuffer* buffer = *task_state_[i]->migration_slots_buffer_address();
+    for (; buffer != NULL; buffer = buffer->next()) {
+      slots_buffers_.Add(buffer);
+    }
+  }
+  for (int i = 0; i < pages->length(); i++) {
+    Page* p = pages->at(i);
+    if (!p->IsEvacuationCandidate()) continue;
+    for (SlotsBuffer* buffer = p->slots_buffer();
+         buffer != NULL;
+         buffer = buffer->next()) {
+      slots_buffers_.Add(buffer);
+    }
+  }
+
+  code_slots_filtering_required_ = code_slots_filtering_required;
+  NoBarrier_Store(&next_slots_buffer_, 0);
+  StartHelpers(UPDATE_SLOTS);
+}
+
+
+void ParallelEvacuator::FinishUpdatingSlots() {
+  Work(0);
+  WaitForHelpers();
+  slots_buffers_.Rewind(0);
+}
+
+
+void ParallelEvacuator::DeallocateMigrationSlots() {
+  SlotsBufferAllocator* allocator =
+      &heap_->mark_compact_collector()->slots_buffer_allocator_;
+  for (int i = 0; i < tasks_; i++) {
+    allocator->DeallocateChain(
+        task_state_[i]->migration_slots_buffer_address());
+  }
+}
+
+
+void ParallelEvacuator::Work(int task_id) {
+  if (phase_ == EVACUATE_PAGES) {
+    ParallelEvacuationTask* task = task_state_[task_id];
+    while (Acquire_Load(&aborted_) == 0) {
+      int index = Barrier_AtomicIncrement(&next_page_, 1) - 1;
+      if (index >= pages_->length()) break;
+      Page* p = pages_->at(index);
+      if (!p->IsEvacuationCandidate()) continue;
+      // During compaction we might have to request a new page.  Without
+      // room for expansion evacuation is not guaranteed to succeed, so no
+      // more pages are started.
+      if (!CanExpand(static_cast<PagedSpace*>(p->owner()))) {
+        Release_Store(&aborted_, 1);
+        break;
+      }
+      task->EvacuatePage(p);
+    }
+  } else {
+    ASSERT(phase_ == UPDATE_SLOTS);
+    while (true) {
+      int index = Barrier_AtomicIncrement(&next_slots_buffer_, 1) - 1;
+      if (index >= slots_buffers_.length()) break;
+      SlotsBuffer* buffer = slots_buffers_[index];
+      if (code_slots_filtering_required_) {
+        buffer->UpdateSlotsWithFilter(heap_);
+      } else {
+        buffer->UpdateSlots(heap_);
+      }
+    }
+  }
+}
+
+
+HeapObject* ParallelEvacuator::Allocate(PagedSpace* space,
+                                        int size_in_bytes) {
+  ScopedLock lock(allocation_mutex_);
+  MaybeObject* maybe_result = space->AllocateRaw(size_in_bytes);
+  Object* result;
+  if (!maybe_result->ToObject(&result)) return NULL;
+  return HeapObject::cast(result);
+}
+
+
+void ParallelEvacuator::Free(PagedSpace* space,
+                             Address start,
+                             int size_in_bytes) {
+  ScopedLock lock(allocation_mutex_);
+  space->Free(start, size_in_bytes);
+}
+
+
+bool ParallelEvacuator::CanExpand(PagedSpace* space) {
+  ScopedLock lock(allocation_mutex_);
+  return space->CanExpand();
+}
+
+
 class EvacuationWeakObjectRetainer : public WeakObjectRetainer {
  public:
   virtual Object* RetainAs(Object* object) {
@@ -3001,6 +3799,7 @@ void MarkCompactCollector::ProcessInvalidatedCode(ObjectVisitor* visitor) {
 
 void MarkCompactCollector::EvacuateNewSpaceAndCandidates() {
   bool code_slots_filtering_required = MarkInvalidatedCode();
+  bool evacuate_in_parallel = CanEvacuateInParallel();
 
   EvacuateNewSpace();
   EvacuatePages();
@@ -3024,6 +3823,13 @@ void MarkCompactCollector::EvacuateNewSpaceAndCandidates() {
   heap_->IterateRoots(&updating_visitor, VISIT_ALL_IN_SWEEP_NEWSPACE);
   LiveObjectList::IterateElements(&updating_visitor);
 
+  // The helpers update the recorded slots while the store buffer is rebuilt.
+  if (evacuate_in_parallel) {
+    parallel_evacuator_->StartUpdatingSlots(migration_slots_buffer_,
+                                            &evacuation_candidates_,
+                                            code_slots_filtering_required);
+  }
+
   {
     StoreBufferRebuildScope scope(heap_,
                                   heap_->store_buffer(),
@@ -3031,9 +3837,13 @@ void MarkCompactCollector::EvacuateNewSpaceAndCandidates() {
     heap_->store_buffer()->IteratePointersToNewSpace(&UpdatePointer);
   }
 
-  SlotsBuffer::UpdateSlotsRecordedIn(heap_,
-                                     migration_slots_buffer_,
-                                     code_slots_filtering_required);
+  if (evacuate_in_parallel) {
+    parallel_evacuator_->FinishUpdatingSlots();
+  } else {
+    SlotsBuffer::UpdateSlotsRecordedIn(heap_,
+                                       migration_slots_buffer_,
+                                       code_slots_filtering_required);
+  }
   if (FLAG_trace_fragmentation) {
     PrintF("  migration slots buffer: %d\n",
            SlotsBuffer::SizeOfChain(migration_slots_buffer_));
@@ -3062,9 +3872,11 @@ void MarkCompactCollector::EvacuateNewSpaceAndCandidates() {
            p->IsFlagSet(Page::RESCAN_ON_EVACUATION));
 
     if (p->IsEvacuationCandidate()) {
-      SlotsBuffer::UpdateSlotsRecordedIn(heap_,
-                                         p->slots_buffer(),
-                                         code_slots_filtering_required);
+      if (!evacuate_in_parallel) {
+        SlotsBuffer::UpdateSlotsRecordedIn(heap_,
+                                           p->slots_buffer(),
+                                           code_slots_filtering_required);
+      }
       if (FLAG_trace_fragmentation) {
         PrintF("  page %p slots buffer: %d\n",
                reinterpret_cast<void*>(p),
@@ -3144,6 +3956,7 @@ void MarkCompactCollector::EvacuateNewSpaceAndCandidates() {
 
   slots_buffer_allocator_.DeallocateChain(&migration_slots_buffer_);
   ASSERT(migration_slots_buffer_ == NULL);
+  if (evacuate_in_parallel) parallel_evacuator_->DeallocateMigrationSlots();
   for (int i = 0; i < npages; i++) {
     Page* p = evacuation_candidates_[i];
     if (!p->IsEvacuationCandidate()) continue;
@@ -3441,10 +4254,36 @@ static inline Address StartOfLiveObject(Address block_address, uint32_t cell) {
 // because it means that any FreeSpace maps left actually describe a region of
 // memory that can be ignored when scanning.  Dead objects other than free
 // spaces will not contain the free space map.
-intptr_t MarkCompactCollector::SweepConservatively(PagedSpace* space, Page* p) {
+//
+// When sweeping in parallel the freed memory is put on a private free list
+// and the page header is left alone, the main thread marks the page as swept
+// later on.
+enum SweepingParallelism {
+  SWEEP_SEQUENTIALLY,
+  SWEEP_IN_PARALLEL
+};
+
+
+template<SweepingParallelism mode>
+static inline intptr_t FreeConservatively(PagedSpace* space,
+                                          FreeList* free_list,
+                                          Address start,
+                                          int size) {
+  if (mode == SWEEP_SEQUENTIALLY) {
+    return space->Free(start, size);
+  } else {
+    return size - free_list->Free(start, size);
+  }
+}
+
+
+template<SweepingParallelism mode>
+static intptr_t SweepConservativelyImpl(PagedSpace* space,
+                                        FreeList* free_list,
+                                        Page* p) {
   ASSERT(!p->IsEvacuationCandidate() && !p->WasSwept());
   MarkBit::CellType* cells = p->markbits()->cells();
-  p->MarkSweptConservatively();
+  if (mode == SWEEP_SEQUENTIALLY) p->MarkSweptConservatively();
 
   int last_cell_index =
       Bitmap::IndexToCell(
@@ -3465,8 +4304,10 @@ intptr_t MarkCompactCollector::SweepConservatively(PagedSpace* space, Page* p) {
   }
   size_t size = block_address - p->ObjectAreaStart();
   if (cell_index == last_cell_index) {
-    freed_bytes += static_cast<int>(space->Free(p->ObjectAreaStart(),
-                                                static_cast<int>(size)));
+    freed_bytes += FreeConservatively<mode>(space,
+                                            free_list,
+                                            p->ObjectAreaStart(),
+                                            static_cast<int>(size));
     ASSERT_EQ(0, p->LiveBytes());
     return freed_bytes;
   }
@@ -3475,8 +4316,10 @@ intptr_t MarkCompactCollector::SweepConservatively(PagedSpace* space, Page* p) {
   Address free_end = StartOfLiveObject(block_address, cells[cell_index]);
   // Free the first free space.
   size = free_end - p->ObjectAreaStart();
-  freed_bytes += space->Free(p->ObjectAreaStart(),
-                             static_cast<int>(size));
+  freed_bytes += FreeConservatively<mode>(space,
+                                          free_list,
+                                          p->ObjectAreaStart(),
+                                          static_cast<int>(size));
   // The start of the current free area is represented in undigested form by
   // the address of the last 32-word section that contained a live object and
   // the marking bitmap for that cell, which describes where the live object
@@ -3505,8 +4348,11 @@ intptr_t MarkCompactCollector::SweepConservatively(PagedSpace* space, Page* p) {
           // so now we need to find the start of the first live object at the
           // end of the free space.
           free_end = StartOfLiveObject(block_address, cell);
-          freed_bytes += space->Free(free_start,
-                                     static_cast<int>(free_end - free_start));
+          freed_bytes += FreeConservatively<mode>(
+              space,
+              free_list,
+              free_start,
+              static_cast<int>(free_end - free_start));
         }
       }
       // Update our undigested record of where the current free area started.
@@ -3520,19 +4366,182 @@ intptr_t MarkCompactCollector::SweepConservatively(PagedSpace* space, Page* p) {
   // Handle the free space at the end of the page.
   if (block_address - free_start > 32 * kPointerSize) {
     free_start = DigestFreeStart(free_start, free_start_cell);
-    freed_bytes += space->Free(free_start,
-                               static_cast<int>(block_address - free_start));
+    freed_bytes += FreeConservatively<mode>(
+        space,
+        free_list,
+        free_start,
+        static_cast<int>(block_address - free_start));
   }
 
-  p->ResetLiveBytes();
+  if (mode == SWEEP_SEQUENTIALLY) p->ResetLiveBytes();
   return freed_bytes;
 }
 
 
+intptr_t MarkCompactCollector::SweepConservatively(PagedSpace* space, Page* p) {
+  return SweepConservativelyImpl<SWEEP_SEQUENTIALLY>(space, NULL, p);
+}
+
+
+intptr_t MarkCompactCollector::SweepConservativelyInParallel(
+    FreeList* free_list, Page* p) {
+  return SweepConservativelyImpl<SWEEP_IN_PARALLEL>(NULL, free_list, p);
+}
+
+
+class ConcurrentSweeperThread : public Thread {
+ public:
+  ConcurrentSweeperThread(ConcurrentSweeper* sweeper,
+                          Semaphore* done_semaphore)
+      : Thread("v8:ConcurrentSweeper"),
+        sweeper_(sweeper),
+        start_semaphore_(OS::CreateSemaphore(0)),
+        done_semaphore_(done_semaphore),
+        stop_(0) { }
+
+  ~ConcurrentSweeperThread() {
+    delete start_semaphore_;
+  }
+
+  void Run() {
+    while (true) {
+      start_semaphore_->Wait();
+      if (Acquire_Load(&stop_) != 0) return;
+      sweeper_->SweepPages();
+      done_semaphore_->Signal();
+    }
+  }
+
+  void StartTask() {
+    start_semaphore_->Signal();
+  }
+
+  void Stop() {
+    Release_Store(&stop_, 1);
+    start_semaphore_->Signal();
+    Join();
+  }
+
+ private:
+  ConcurrentSweeper* sweeper_;
+  Semaphore* start_semaphore_;
+  Semaphore* done_semaphore_;
+  Atomic32 stop_;
+};
+
+
+ConcurrentSweeper::ConcurrentSweeper(Heap* heap)
+    : heap_(heap),
+      thread_(NULL),
+      pages_swept_(0),
+      old_pointer_space_free_list_(heap->old_pointer_space()),
+      old_data_space_free_list_(heap->old_data_space()),
+      mutex_(OS::CreateMutex()),
+      page_swept_semaphore_(OS::CreateSemaphore(0)),
+      done_semaphore_(OS::CreateSemaphore(0)) { }
+
+
+ConcurrentSweeper::~ConcurrentSweeper() {
+  if (thread_ != NULL) {
+    thread_->Stop();
+    delete thread_;
+  }
+  delete mutex_;
+  delete page_swept_semaphore_;
+  delete done_semaphore_;
+}
+
+
+void ConcurrentSweeper::Start() {
+  ASSERT(pages_swept_ == 0);
+  if (thread_ == NULL) {
+    thread_ = new ConcurrentSweeperThread(this, done_semaphore_);
+    thread_->Start();
+  }
+  thread_->StartTask();
+}
+
+
+void ConcurrentSweeper::SweepPages() {
+  for (int i = 0; i < pages_.length(); i++) {
+    Page* p = pages_[i];
+    PagedSpace* space = static_cast<PagedSpace*>(p->owner());
+    FreeList private_free_list(space);
+    MarkCompactCollector::SweepConservativelyInParallel(&private_free_list, p);
+    {
+      ScopedLock lock(mutex_);
+      PublishedFreeList(space)->Concatenate(&private_free_list);
+    }
+    Barrier_AtomicIncrement(&pages_swept_, 1);
+    page_swept_semaphore_->Signal();
+  }
+}
+
+
+void ConcurrentSweeper::WaitForSweptPage() {
+  // Every page signals the semaphore once after it has been published, so
+  // as long as not all pages are done another signal is still to come.
+  // Signals left over from earlier waits only cause a spurious wake-up.
+  if (IsDone()) return;
+  page_swept_semaphore_->Wait();
+}
+
+
+intptr_t ConcurrentSweeper::TakeSweptMemory(PagedSpace* space,
+                                            FreeList* free_list) {
+  ScopedLock lock(mutex_);
+  return free_list->Concatenate(PublishedFreeList(space));
+}
+
+
+void ConcurrentSweeper::Finish() {
+  done_semaphore_->Wait();
+  ASSERT(IsDone());
+  for (int i = 0; i < pages_.length(); i++) {
+    Page* p = pages_[i];
+    p->MarkSweptConservatively();
+    p->ResetLiveBytes();
+  }
+  pages_.Clear();
+  pages_swept_ = 0;
+}
+
+
+FreeList* ConcurrentSweeper::PublishedFreeList(PagedSpace* space) {
+  if (space->identity() == OLD_POINTER_SPACE) {
+    return &old_pointer_space_free_list_;
+  }
+  ASSERT(space->identity() == OLD_DATA_SPACE);
+  return &old_data_space_free_list_;
+}
+
+
+bool MarkCompactCollector::AdvanceConcurrentSweeping() {
+  if (!concurrent_sweeping_pending_) return true;
+  heap()->old_pointer_space()->RefillFreeList();
+  heap()->old_data_space()->RefillFreeList();
+  if (!concurrent_sweeper_->IsDone()) return false;
+  WaitUntilSweepingCompleted();
+  return true;
+}
+
+
+void MarkCompactCollector::WaitUntilSweepingCompleted() {
+  if (!concurrent_sweeping_pending_) return;
+  concurrent_sweeper_->Finish();
+  heap()->old_pointer_space()->RefillFreeList();
+  heap()->old_data_space()->RefillFreeList();
+  heap()->old_pointer_space()->set_concurrent_sweeping_in_progress(false);
+  heap()->old_data_space()->set_concurrent_sweeping_in_progress(false);
+  concurrent_sweeping_pending_ = false;
+}
+
+
 void MarkCompactCollector::SweepSpace(PagedSpace* space,
                                       SweeperType sweeper) {
   space->set_was_swept_conservatively(sweeper == CONSERVATIVE ||
-                                      sweeper == LAZY_CONSERVATIVE);
+                                      sweeper == LAZY_CONSERVATIVE ||
+                                      sweeper == CONCURRENT_CONSERVATIVE);
 
   space->ClearStats();
 
@@ -3541,6 +4550,7 @@ void MarkCompactCollector::SweepSpace(PagedSpace* space,
   intptr_t freed_bytes = 0;
   intptr_t newspace_size = space->heap()->new_space()->Size();
   bool lazy_sweeping_active = false;
+  bool concurrent_sweeping_active = false;
   bool unused_page_present = false;
 
   while (it.has_next()) {
@@ -3568,6 +4578,15 @@ void MarkCompactCollector::SweepSpace(PagedSpace* space,
       continue;
     }
 
+    if (concurrent_sweeping_active) {
+      if (FLAG_gc_verbose) {
+        PrintF("Sweeping 0x%" V8PRIxPTR " concurrently postponed.\n",
+               reinterpret_cast<intptr_t>(p));
+      }
+      concurrent_sweeper_->AddPage(p);
+      continue;
+    }
+
     // One unused page is kept, all further are released before sweeping them.
     if (p->LiveBytes() == 0) {
       if (unused_page_present) {
@@ -3600,6 +4619,15 @@ void MarkCompactCollector::SweepSpace(PagedSpace* space,
         }
         break;
       }
+      case CONCURRENT_CONSERVATIVE: {
+        // Sweep enough pages to satisfy the allocations right after the
+        // collection and leave the rest to the concurrent sweeper thread.
+        freed_bytes += SweepConservatively(space, p);
+        if (freed_bytes >= newspace_size && p != space->LastPage()) {
+          concurrent_sweeping_active = true;
+        }
+        break;
+      }
       case PRECISE: {
         if (space->identity() == CODE_SPACE) {
           SweepPrecisely<SWEEP_ONLY, REBUILD_SKIP_LIST>(space, p, NULL);
@@ -3626,7 +4654,12 @@ void MarkCompactCollector::SweepSpaces() {
 #endif
   SweeperType how_to_sweep =
       FLAG_lazy_sweeping ? LAZY_CONSERVATIVE : CONSERVATIVE;
+  if (FLAG_concurrent_sweeping) how_to_sweep = CONCURRENT_CONSERVATIVE;
   if (sweep_precisely_) how_to_sweep = PRECISE;
+  if (how_to_sweep == CONCURRENT_CONSERVATIVE &&
+      concurrent_sweeper_ == NULL) {
+    concurrent_sweeper_ = new ConcurrentSweeper(heap());
+  }
   // Noncompacting collections simply sweep the spaces to clear the mark
   // bits and free the nonlive blocks (for old and map spaces).  We sweep
   // the map space last because freeing non-live maps overwrites them and
@@ -3653,6 +4686,24 @@ void MarkCompactCollector::SweepSpaces() {
 
   // Deallocate unmarked objects and clear marked bits for marked objects.
   heap_->lo_space()->FreeUnmarkedObjects();
+
+  if (FLAG_trace_fragmentation) {
+    // Pages that are swept lazily or concurrently are not on the free lists
+    // yet.
+    heap()->old_pointer_space()->PrintFreeListStatistics();
+    heap()->old_data_space()->PrintFreeListStatistics();
+    heap()->code_space()->PrintFreeListStatistics();
+  }
+
+  // Evacuation is done, so nothing iterates the postponed pages anymore
+  // during this collection and they can be handed to the sweeper thread.
+  if (how_to_sweep == CONCURRENT_CONSERVATIVE &&
+      concurrent_sweeper_->HasPages()) {
+    heap()->old_pointer_space()->set_concurrent_sweeping_in_progress(true);
+    heap()->old_data_space()->set_concurrent_sweeping_in_progress(true);
+    concurrent_sweeping_pending_ = true;
+    concurrent_sweeper_->Start();
+  }
 }
 
 
@@ -3767,13 +4818,22 @@ static inline SlotsBuffer::SlotType DecodeSlotType(
 }
 
 
+// Recorded slots that point to new space are updated through the store
+// buffer, possibly at the same time on another thread.  Code objects never
+// point to new space, so typed slots need no such check.
+static inline void UpdateRecordedSlot(Heap* heap, Object** slot) {
+  if (heap->InNewSpace(*slot)) return;
+  PointersUpdatingVisitor::UpdateSlot(heap, slot);
+}
+
+
 void SlotsBuffer::UpdateSlots(Heap* heap) {
   PointersUpdatingVisitor v(heap);
 
   for (int slot_idx = 0; slot_idx < idx_; ++slot_idx) {
     ObjectSlot slot = slots_[slot_idx];
     if (!IsTypedSlot(slot)) {
-      PointersUpdatingVisitor::UpdateSlot(heap, slot);
+      UpdateRecordedSlot(heap, slot);
     } else {
       ++slot_idx;
       ASSERT(slot_idx < idx_);
@@ -3792,7 +4852,7 @@ void SlotsBuffer::UpdateSlotsWithFilter(Heap* heap) {
     ObjectSlot slot = slots_[slot_idx];
     if (!IsTypedSlot(slot)) {
       if (!IsOnInvalidatedCodeObject(reinterpret_cast<Address>(slot))) {
-        PointersUpdatingVisitor::UpdateSlot(heap, slot);
+        UpdateRecordedSlot(heap, slot);
       }
     } else {
       ++slot_idx;
@@ -254,6 +254,8 @@ class MarkingDeque {
     }
   }
 
+  int Size() { return (top_ - bottom_) & mask_; }
+
   HeapObject** array() { return array_; }
   int bottom() { return bottom_; }
   int top() { return top_; }
@@ -274,6 +276,185 @@ class MarkingDeque {
 };
 
 
+// ----------------------------------------------------------------------------
+// Parallel marking.
+//
+// When --parallel-marking is on, large batches of work on the collector's
+// marking deque are handed to a ParallelMarker.  The main thread and
+// --marking-threads - 1 helper threads then trace the object graph together,
+// each from its own work-stealing deque.  Mark bits are set with atomic
+// compare-and-swap so an object is claimed by exactly one thread.
+//
+// Only objects whose marking visitor has no side effects beyond marking
+// (fixed arrays, JS objects, strings, structs, ...) are traced in parallel.
+// Maps and objects needing special treatment (code, functions, shared
+// function infos, global contexts, weak maps, regexps) are marked black by
+// the helpers but handed back to the main thread, which processes them
+// with the ordinary sequential marker.  Helper deque overflow is handled
+// like marking deque overflow: the object is left grey in the heap and the
+// collector's marking deque is flagged as overflowed.
+
+class ParallelMarkingDeque {
+ public:
+  ParallelMarkingDeque();
+  ~ParallelMarkingDeque();
+
+  // Both return false if the operation could not be performed, i.e. the
+  // deque is full or empty respectively.
+  bool Push(HeapObject* object);
+  bool Pop(HeapObject** object);
+
+  // Takes an object from the opposite end of the deque.  Used by threads
+  // that ran out of work.
+  bool Steal(HeapObject** object);
+
+  bool IsEmpty() {
+    return NoBarrier_Load(&top_) == NoBarrier_Load(&bottom_);
+  }
+
+  static const int kCapacity = 32 * KB;
+
+ private:
+  HeapObject** array_;
+  Mutex* mutex_;
+  // Entries live in array_[bottom_ & kMask .. (top_ - 1) & kMask].
+  Atomic32 top_;
+  Atomic32 bottom_;
+
+  static const int kMask = kCapacity - 1;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelMarkingDeque);
+};
+
+
+class ParallelMarkingThread;
+
+class ParallelMarker {
+ public:
+  explicit ParallelMarker(Heap* heap);
+  ~ParallelMarker();
+
+  int tasks() { return tasks_; }
+
+  // Transitively marks everything reachable from the objects currently on
+  // the collector's marking deque.  On return the objects that have to be
+  // processed by the sequential marker have been pushed back onto the
+  // marking deque (which might have overflowed).
+  void Drain();
+
+  // Entry point of the helper threads and of the main thread while a
+  // Drain is in progress.
+  void Work(int task_id);
+
+  // Minimum amount of work on the marking deque worth starting the helper
+  // threads for.
+  static const int kMinWorkForParallelMarking = 512;
+
+ private:
+  void VisitObject(HeapObject* object, ParallelMarkingDeque* deque);
+  void MarkObject(HeapObject* object, ParallelMarkingDeque* deque);
+  void RecordSlot(Object** anchor_slot, Object** slot, Object* object);
+  bool TrySteal(int task_id, HeapObject** object);
+  bool IsWorkAvailable();
+
+  static inline bool IsSafeForParallelMarking(Map* map);
+
+  Heap* heap_;
+  int tasks_;
+  ParallelMarkingDeque* deques_;
+  ParallelMarkingThread** threads_;
+
+  // Number of tasks that found no work to steal.  Marking terminates when
+  // all of them are idle.
+  Atomic32 idle_tasks_;
+  Atomic32 overflowed_;
+
+  // Objects that are marked black but have to be processed by the
+  // sequential marker, protected by deferred_mutex_.
+  List<HeapObject*> deferred_;
+  Mutex* deferred_mutex_;
+
+  // Serializes slot recording for evacuation candidates.
+  Mutex* slots_mutex_;
+
+  Semaphore* done_semaphore_;
+
+  friend class ParallelMarkingVisitor;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelMarker);
+};
+
+
+// Concurrent sweeping.
+//
+// With --concurrent-sweeping the old pointer and old data space pages that
+// would otherwise be left for the lazy sweeper are swept conservatively on a
+// background thread.  The thread sweeps each page into a private free list
+// and then publishes the freed memory; the allocator moves published memory
+// to the space's free list in PagedSpace::SlowAllocateRaw and only blocks
+// when nothing has been published yet.  The sweeper thread never touches
+// page flags or live byte counts, these are updated on the main thread when
+// sweeping is finalized, which happens at the latest before the next
+// garbage collection.
+class ConcurrentSweeperThread;
+
+class ConcurrentSweeper {
+ public:
+  explicit ConcurrentSweeper(Heap* heap);
+  ~ConcurrentSweeper();
+
+  // Queues a page for sweeping.  Pages can only be added while the sweeper
+  // thread is idle.
+  void AddPage(Page* p) { pages_.Add(p); }
+
+  bool HasPages() { return !pages_.is_empty(); }
+
+  // Wakes up the sweeper thread to sweep the queued pages.
+  void Start();
+
+  // Returns true once every queued page has been swept and published.
+  bool IsDone() {
+    return Acquire_Load(&pages_swept_) == pages_.length();
+  }
+
+  // Blocks until another page has been published.  Returns immediately if
+  // all pages have already been swept.
+  void WaitForSweptPage();
+
+  // Moves the memory published so far for the given space onto free_list
+  // and returns the number of bytes moved.
+  intptr_t TakeSweptMemory(PagedSpace* space, FreeList* free_list);
+
+  // Waits for the sweeper thread to finish, then marks all queued pages as
+  // swept and clears the queue.  Memory published by the sweeper thread
+  // that has not been taken yet stays available to TakeSweptMemory.
+  void Finish();
+
+  // Entry point of the sweeper thread.
+  void SweepPages();
+
+ private:
+  FreeList* PublishedFreeList(PagedSpace* space);
+
+  Heap* heap_;
+  ConcurrentSweeperThread* thread_;
+
+  List<Page*> pages_;
+  Atomic32 pages_swept_;
+
+  // Memory freed by the sweeper thread that has not yet been moved to the
+  // spaces' free lists, protected by mutex_.
+  FreeList old_pointer_space_free_list_;
+  FreeList old_data_space_free_list_;
+  Mutex* mutex_;
+
+  Semaphore* page_swept_semaphore_;
+  Semaphore* done_semaphore_;
+
+  DISALLOW_COPY_AND_ASSIGN(ConcurrentSweeper);
+};
+
+
 class SlotsBufferAllocator {
  public:
   SlotsBuffer* AllocateBuffer(SlotsBuffer* next_buffer);
@@ -403,6 +584,89 @@ class SlotsBuffer {
 };
 
 
+// Parallel evacuation.
+//
+// With --parallel-compaction the evacuation candidates are evacuated by the
+// main thread and --compaction-threads - 1 helper threads, which claim whole
+// pages.  Objects are copied into local allocation buffers that a task takes
+// from the target space under a lock; code objects are allocated one at a
+// time so the skip lists of code pages stay precise.  Every task records
+// migration slots and store buffer entries privately.  The store buffer
+// entries are entered by the main thread once all pages are done.
+//
+// Afterwards the slots recorded in slots buffers are updated by all tasks,
+// one buffer at a time, while the main thread first rebuilds the store
+// buffer.  Recorded slots that point into new space are always left to the
+// store buffer, so the two never write the same slot.
+class ParallelEvacuationTask;
+class ParallelEvacuationThread;
+
+class ParallelEvacuator {
+ public:
+  explicit ParallelEvacuator(Heap* heap);
+  ~ParallelEvacuator();
+
+  int tasks() { return tasks_; }
+
+  // Evacuates the live objects of the evacuation candidates among the
+  // given pages.  Candidates that were not evacuated because their space
+  // could not expand are left unswept.
+  void EvacuatePages(List<Page*>* pages);
+
+  // Starts updating the slots recorded in the given migration slots buffer,
+  // in the slots buffers of the evacuation candidates among the given pages
+  // and in the tasks' own migration slots buffers on the helper threads.
+  // FinishUpdatingSlots helps with the remaining buffers and waits for the
+  // helpers; the main thread is free to do other work in between.
+  void StartUpdatingSlots(SlotsBuffer* migration_slots_buffer,
+                          List<Page*>* pages,
+                          bool code_slots_filtering_required);
+  void FinishUpdatingSlots();
+
+  // Frees the migration slots buffers of the tasks.
+  void DeallocateMigrationSlots();
+
+  // Entry point of the helper threads and of the main thread while pages
+  // are evacuated or slots are updated.
+  void Work(int task_id);
+
+ private:
+  enum Phase {
+    EVACUATE_PAGES,
+    UPDATE_SLOTS
+  };
+
+  void StartHelpers(Phase phase);
+  void WaitForHelpers();
+
+  // Allocation in the target spaces, serialized by allocation_mutex_.
+  HeapObject* Allocate(PagedSpace* space, int size_in_bytes);
+  void Free(PagedSpace* space, Address start, int size_in_bytes);
+  bool CanExpand(PagedSpace* space);
+
+  Heap* heap_;
+  int tasks_;
+  ParallelEvacuationTask** task_state_;
+  ParallelEvacuationThread** threads_;
+  Phase phase_;
+
+  List<Page*>* pages_;
+  Atomic32 next_page_;
+  Atomic32 aborted_;
+
+  List<SlotsBuffer*> slots_buffers_;
+  Atomic32 next_slots_buffer_;
+  bool code_slots_filtering_required_;
+
+  Mutex* allocation_mutex_;
+  Semaphore* done_semaphore_;
+
+  friend class ParallelEvacuationTask;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelEvacuator);
+};
+
+
 // -------------------------------------------------------------------------
 // Mark-Compact collector
 class MarkCompactCollector {
@@ -487,9 +751,20 @@ class MarkCompactCollector {
   inline bool is_code_flushing_enabled() const { return code_flusher_ != NULL; }
   void EnableCodeFlushing(bool enable);
 
+  // Makes the next full marking attribute live bytes to the global
+  // contexts, see Heap::MeasureContextMemory.  Has no effect if the
+  // collection finishes an incremental marking cycle.
+  void RequestContextAttribution() { attribute_contexts_ = true; }
+  // Live bytes per global context in the order of the global contexts
+  // list, as found by the last attributing collection.
+  const List<intptr_t>& attributed_context_sizes() {
+    return attributed_context_sizes_;
+  }
+
   enum SweeperType {
     CONSERVATIVE,
     LAZY_CONSERVATIVE,
+    CONCURRENT_CONSERVATIVE,
     PRECISE
   };
 
@@ -503,6 +778,12 @@ class MarkCompactCollector {
   // Return a number of reclaimed bytes.
   static intptr_t SweepConservatively(PagedSpace* space, Page* p);
 
+  // Sweep a single page conservatively on the concurrent sweeper thread.
+  // Freed memory is put on the given free list and neither the page nor the
+  // space it belongs to is modified otherwise.  Return a number of bytes
+  // added to the free list.
+  static intptr_t SweepConservativelyInParallel(FreeList* free_list, Page* p);
+
   INLINE(static bool ShouldSkipEvacuationSlotRecording(Object** anchor)) {
     return Page::FromAddress(reinterpret_cast<Address>(anchor))->
         ShouldSkipEvacuationSlotRecording();
@@ -549,6 +830,16 @@ class MarkCompactCollector {
                      int size,
                      AllocationSpace to_old_space);
 
+  // Like MigrateObject, but records migration slots in the given slots
+  // buffer and slots pointing to new space in the given list instead of the
+  // store buffer.  Used by the parallel evacuator.
+  void MigrateObject(Address dst,
+                     Address src,
+                     int size,
+                     AllocationSpace to_old_space,
+                     SlotsBuffer** migration_slots_buffer,
+                     List<Address>* store_buffer_slots);
+
   bool TryPromoteObject(HeapObject* object, int object_size);
 
   inline Object* encountered_weak_maps() { return encountered_weak_maps_; }
@@ -558,6 +849,23 @@ class MarkCompactCollector {
 
   void InvalidateCode(Code* code);
 
+  // Stops the parallel marking threads, if any.
+  void TearDown();
+
+  bool IsConcurrentSweepingInProgress() { return concurrent_sweeping_pending_; }
+
+  ConcurrentSweeper* concurrent_sweeper() { return concurrent_sweeper_; }
+
+  // Moves the memory freed by the concurrent sweeper so far to the free
+  // lists of the old spaces and finalizes sweeping if the sweeper thread is
+  // done.  Returns true if concurrent sweeping has completed.
+  bool AdvanceConcurrentSweeping();
+
+  // Blocks until the concurrent sweeper thread has swept all pages and
+  // finalizes sweeping.  Has to be called before anything iterates the old
+  // spaces or changes their page lists.
+  void WaitUntilSweepingCompleted();
+
  private:
   MarkCompactCollector();
   ~MarkCompactCollector();
@@ -594,6 +902,9 @@ class MarkCompactCollector {
 
   bool collect_maps_;
 
+  bool attribute_contexts_;
+  List<intptr_t> attributed_context_sizes_;
+
   // A pointer to the current stack-allocated GC tracer object during a full
   // collection (NULL before and after).
   GCTracer* tracer_;
@@ -617,6 +928,9 @@ class MarkCompactCollector {
 
   friend class RootMarkingVisitor;
   friend class MarkingVisitor;
+  friend class ParallelMarker;
+  friend class ParallelEvacuator;
+  friend class ParallelEvacuationTask;
   friend class StaticMarkingVisitor;
   friend class CodeMarkingVisitor;
   friend class SharedFunctionInfoMarkingVisitor;
@@ -648,6 +962,14 @@ class MarkCompactCollector {
   // Mark the heap roots and all objects reachable from them.
   void MarkRoots(RootMarkingVisitor* visitor);
 
+  // Mark the objects shared by all contexts, then the objects reachable
+  // from each global context in turn, recording the live bytes each one
+  // adds.  Every global context is treated as a root.
+  void MarkGlobalContextsForAttribution(RootMarkingVisitor* visitor);
+
+  // Sum of the live bytes of all pages, as counted while marking.
+  intptr_t LiveBytesOfHeap();
+
   // Mark the symbol table specially.  References to symbols from the
   // symbol table are weak.
   void MarkSymbolTable();
@@ -733,6 +1055,11 @@ class MarkCompactCollector {
 
   void EvacuatePages();
 
+  // Returns true if evacuation and pointer updating can be shared with the
+  // parallel evacuator's helper threads.  Object move events for the
+  // profilers and the log have to be sent from the main thread.
+  bool CanEvacuateInParallel();
+
   void EvacuateNewSpaceAndCandidates();
 
   void SweepSpace(PagedSpace* space, SweeperType sweeper);
@@ -777,6 +1104,10 @@ class MarkCompactCollector {
 
   Heap* heap_;
   MarkingDeque marking_deque_;
+  ParallelMarker* parallel_marker_;
+  ParallelEvacuator* parallel_evacuator_;
+  ConcurrentSweeper* concurrent_sweeper_;
+  bool concurrent_sweeping_pending_;
   CodeFlusher* code_flusher_;
   Object* encountered_weak_maps_;
 
@@ -73,6 +73,12 @@ void Deoptimizer::DoComputeOsrOutputFrame() {
 }
 
 
+void Deoptimizer::DoComputeConstructStubFrame(TranslationIterator* iterator,
+                                              int frame_index) {
+  UNIMPLEMENTED();
+}
+
+
 void Deoptimizer::DoComputeFrame(TranslationIterator* iterator,
                                  int frame_index) {
   UNIMPLEMENTED();
@@ -0,0 +1,199 @@
+// Copyright 2011 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "v8.h"
+
+#include "optimizing-compiler-thread.h"
+
+#include "api.h"
+#include "execution.h"
+#include "hydrogen.h"
+#include "isolate.h"
+
+namespace v8 {
+namespace internal {
+
+
+RecompileJob::RecompileJob(Handle<JSFunction> closure)
+    : zone_(closure->GetIsolate()),
+      info_(closure),
+      compiler_(&info_),
+      status_(OptimizingCompiler::FAILED),
+      deferred_handles_(NULL) {
+  info_.SetOptimizing(AstNode::kNoNumber);
+}
+
+
+RecompileJob::~RecompileJob() {
+  zone_.DeleteAll();
+  zone_.DeleteKeptSegment();
+  delete deferred_handles_;
+}
+
+
+OptimizingCompilerThread::OptimizingCompilerThread(Isolate* isolate)
+    : Thread("v8:OptimizingRecompile"),
+      isolate_(isolate),
+      heap_access_mutex_(OS::CreateMutex()),
+      heap_access_requests_(0),
+      thread_id_(ThreadId::Invalid()),
+      queue_mutex_(OS::CreateMutex()),
+      input_semaphore_(OS::CreateSemaphore(0)),
+      output_semaphore_(OS::CreateSemaphore(0)),
+      pending_(0),
+      stop_(false) {
+}
+
+
+OptimizingCompilerThread::~OptimizingCompilerThread() {
+  ASSERT(jobs_.is_empty());
+  delete output_semaphore_;
+  delete input_semaphore_;
+  delete queue_mutex_;
+  delete heap_access_mutex_;
+}
+
+
+void OptimizingCompilerThread::Run() {
+  Thread::SetThreadLocal(Isolate::isolate_key(), isolate_);
+  thread_id_ = ThreadId::Current();
+  while (true) {
+    input_semaphore_->Wait();
+    if (stop_) break;
+
+    RecompileJob* job;
+    {
+      ScopedLock lock(queue_mutex_);
+      job = input_queue_.RemoveLast();
+    }
+    {
+      ScopedLock lock(heap_access_mutex_);
+      ThreadZoneScope zone_scope(job->zone());
+      job->set_status(job->compiler()->OptimizeGraph());
+    }
+    {
+      ScopedLock lock(queue_mutex_);
+      output_queue_.Add(job);
+      pending_--;
+    }
+    isolate_->stack_guard()->RequestInstallCode();
+    output_semaphore_->Signal();
+  }
+}
+
+
+void OptimizingCompilerThread::LockHeapAccess() {
+  Barrier_AtomicIncrement(&heap_access_requests_, 1);
+  heap_access_mutex_->Lock();
+}
+
+
+void OptimizingCompilerThread::UnlockHeapAccess() {
+  heap_access_mutex_->Unlock();
+  Barrier_AtomicIncrement(&heap_access_requests_, -1);
+}
+
+
+void OptimizingCompilerThread::YieldHeapAccess() {
+  if (!IsOptimizerThread()) return;
+  // The graph refers to heap objects through handles only, which the
+  // collection updates, so it may run here.
+  while (Acquire_Load(&heap_access_requests_) > 0) {
+    heap_access_mutex_->Unlock();
+    Thread::YieldCPU();
+    heap_access_mutex_->Lock();
+  }
+}
+
+
+void OptimizingCompilerThread::Stop() {
+  stop_ = true;
+  input_semaphore_->Signal();
+  Join();
+  // Jobs that were not finished or installed are dropped; their functions
+  // keep running unoptimized code.
+  while (!jobs_.is_empty()) delete jobs_.RemoveLast();
+  input_queue_.Clear();
+  output_queue_.Clear();
+}
+
+
+bool OptimizingCompilerThread::IsQueueAvailable() {
+  return jobs_.length() < FLAG_concurrent_recompilation_queue_length;
+}
+
+
+void OptimizingCompilerThread::QueueForOptimization(RecompileJob* job) {
+  ASSERT(IsQueueAvailable());
+  jobs_.Add(job);
+  {
+    ScopedLock lock(queue_mutex_);
+    // Jobs are taken from the end of the list; keep it in FIFO order.
+    input_queue_.InsertAt(0, job);
+    pending_++;
+  }
+  input_semaphore_->Signal();
+}
+
+
+bool OptimizingCompilerThread::IsQueued(JSFunction* function) {
+  for (int i = 0; i < jobs_.length(); i++) {
+    if (*jobs_[i]->info()->closure() == function) return true;
+  }
+  return false;
+}
+
+
+void OptimizingCompilerThread::InstallOptimizedFunctions() {
+  HandleScope scope(isolate_);
+  while (true) {
+    RecompileJob* job;
+    {
+      ScopedLock lock(queue_mutex_);
+      if (output_queue_.is_empty()) return;
+      job = output_queue_.RemoveLast();
+    }
+    Compiler::InstallOptimizedCode(job);
+    jobs_.RemoveElement(job);
+    delete job;
+  }
+}
+
+
+void OptimizingCompilerThread::Flush() {
+  while (true) {
+    {
+      ScopedLock lock(queue_mutex_);
+      if (pending_ == 0) break;
+    }
+    output_semaphore_->Wait();
+  }
+  InstallOptimizedFunctions();
+}
+
+
+} }  // namespace v8::internal
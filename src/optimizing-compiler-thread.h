@@ -0,0 +1,138 @@
+// Copyright 2011 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef V8_OPTIMIZING_COMPILER_THREAD_H_
+#define V8_OPTIMIZING_COMPILER_THREAD_H_
+
+#include "atomicops.h"
+#include "compiler.h"
+#include "list.h"
+#include "platform.h"
+#include "zone.h"
+
+namespace v8 {
+namespace internal {
+
+class DeferredHandles;
+
+// A function queued for optimization on the optimizing compiler thread.
+// The job owns everything the compilation needs: the zone holding the AST,
+// the graph and the lithium chunk, and the handles the graph refers to.
+class RecompileJob : public Malloced {
+ public:
+  explicit RecompileJob(Handle<JSFunction> closure);
+  ~RecompileJob();
+
+  Zone* zone() { return &zone_; }
+  CompilationInfo* info() { return &info_; }
+  OptimizingCompiler* compiler() { return &compiler_; }
+
+  // Result of OptimizingCompiler::OptimizeGraph() on the compiler thread.
+  OptimizingCompiler::Status status() const { return status_; }
+  void set_status(OptimizingCompiler::Status status) { status_ = status; }
+
+  // The unoptimized code the graph was built against.
+  Handle<Code> unoptimized_code() const { return unoptimized_code_; }
+  void set_unoptimized_code(Handle<Code> code) { unoptimized_code_ = code; }
+
+  void set_deferred_handles(DeferredHandles* deferred_handles) {
+    ASSERT(deferred_handles_ == NULL);
+    deferred_handles_ = deferred_handles;
+  }
+
+ private:
+  Zone zone_;
+  CompilationInfo info_;
+  OptimizingCompiler compiler_;
+  OptimizingCompiler::Status status_;
+  Handle<Code> unoptimized_code_;
+  DeferredHandles* deferred_handles_;
+
+  DISALLOW_COPY_AND_ASSIGN(RecompileJob);
+};
+
+
+// Runs the heap-independent phase of the optimizing compiler, graph
+// optimization and register allocation, off the main thread. Jobs are
+// created and finished on the main thread; the compiler thread requests
+// an interrupt when a job is ready to be installed.
+class OptimizingCompilerThread : public Thread {
+ public:
+  explicit OptimizingCompilerThread(Isolate* isolate);
+  ~OptimizingCompilerThread();
+
+  virtual void Run();
+
+  // Main thread interface.
+  void Stop();
+  bool IsQueueAvailable();
+  void QueueForOptimization(RecompileJob* job);
+  bool IsQueued(JSFunction* function);
+  void InstallOptimizedFunctions();
+  // Waits for all queued jobs to finish and installs their code.
+  void Flush();
+
+  // Used by the garbage collector around a collection. Waits until the
+  // compiler thread is between two phases of its job and keeps it there
+  // until UnlockHeapAccess().
+  void LockHeapAccess();
+  void UnlockHeapAccess();
+
+  // Called between the phases of a job. On the compiler thread this lets
+  // a waiting collection run; on other threads it does nothing.
+  void YieldHeapAccess();
+
+  bool IsOptimizerThread() { return ThreadId::Current().Equals(thread_id_); }
+
+ private:
+  Isolate* isolate_;
+  // Held by the compiler thread while it works on a job, except while it
+  // yields to a collection.
+  Mutex* heap_access_mutex_;
+  // Number of collections waiting for heap_access_mutex_.
+  volatile Atomic32 heap_access_requests_;
+  ThreadId thread_id_;
+  Mutex* queue_mutex_;
+  Semaphore* input_semaphore_;
+  Semaphore* output_semaphore_;
+
+  // Protected by queue_mutex_.
+  List<RecompileJob*> input_queue_;
+  List<RecompileJob*> output_queue_;
+  int pending_;
+
+  // All jobs that have not been installed yet; main thread only.
+  List<RecompileJob*> jobs_;
+
+  volatile bool stop_;
+
+  DISALLOW_COPY_AND_ASSIGN(OptimizingCompilerThread);
+};
+
+} }  // namespace v8::internal
+
+#endif  // V8_OPTIMIZING_COMPILER_THREAD_H_
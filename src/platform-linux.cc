@@ -711,6 +711,35 @@ bool VirtualMemory::ReleaseRegion(void* base, size_t size) {
 }
 
 
+bool VirtualMemory::HasHugePageSupport() {
+#ifdef MADV_HUGEPAGE
+  FILE* file = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+  if (file == NULL) return false;
+  char buffer[64];
+  bool supported = fgets(buffer, sizeof(buffer), file) != NULL &&
+                   strstr(buffer, "[never]") == NULL;
+  fclose(file);
+  return supported;
+#else
+  return false;
+#endif
+}
+
+
+bool VirtualMemory::AdviseHugePages(void* base, size_t size) {
+#ifdef MADV_HUGEPAGE
+  return madvise(base, size, MADV_HUGEPAGE) == 0;
+#else
+  return false;
+#endif
+}
+
+
+bool VirtualMemory::DiscardRegion(void* base, size_t size) {
+  return madvise(base, size, MADV_DONTNEED) == 0;
+}
+
+
 class Thread::PlatformData : public Malloced {
  public:
   PlatformData() : thread_(kNoThread) {}
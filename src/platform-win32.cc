@@ -1491,6 +1491,21 @@ bool VirtualMemory::ReleaseRegion(void* base, size_t size) {
 }
 
 
+bool VirtualMemory::HasHugePageSupport() {
+  return false;
+}
+
+
+bool VirtualMemory::AdviseHugePages(void* base, size_t size) {
+  return false;
+}
+
+
+bool VirtualMemory::DiscardRegion(void* base, size_t size) {
+  return VirtualAlloc(base, size, MEM_RESET, PAGE_READWRITE) != NULL;
+}
+
+
 
 // ----------------------------------------------------------------------------
 // Win32 thread support.
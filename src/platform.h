@@ -383,6 +383,18 @@ class VirtualMemory {
   // and the same size it was reserved with.
   static bool ReleaseRegion(void* base, size_t size);
 
+  // Returns whether the OS can back memory with transparent huge pages.
+  static bool HasHugePageSupport();
+
+  // Advises the OS to back the committed region with huge pages.  Returns
+  // whether the advice was accepted.
+  static bool AdviseHugePages(void* base, size_t size);
+
+  // Tells the OS that the contents of the committed region are not needed
+  // anymore, so that it can reclaim the physical pages.  The region stays
+  // committed and reads as zeros or as the old contents afterwards.
+  static bool DiscardRegion(void* base, size_t size);
+
  private:
   void* address_;  // Start address of the virtual memory.
   size_t size_;  // Size of the virtual memory.
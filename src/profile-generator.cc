@@ -29,6 +29,7 @@
 
 #include "profile-generator-inl.h"
 
+#include "frames-inl.h"
 #include "global-handles.h"
 #include "heap-profiler.h"
 #include "scopeinfo.h"
@@ -92,7 +93,14 @@ void TokenEnumerator::TokenRemoved(Object** token_location) {
 
 
 StringsStorage::StringsStorage()
-    : names_(StringsMatch) {
+    : names_(StringsMatch),
+      max_name_length_(String::kMaxLength) {
+}
+
+
+StringsStorage::StringsStorage(int max_name_length)
+    : names_(StringsMatch),
+      max_name_length_(max_name_length) {
 }
 
 
@@ -150,6 +158,15 @@ const char* StringsStorage::GetVFormatted(const char* format, va_list args) {
 
 const char* StringsStorage::GetName(String* name) {
   if (name->IsString()) {
+    if (name->length() > max_name_length_) {
+      int length = 0;
+      char* str = name->ToCString(DISALLOW_NULLS,
+                                  ROBUST_STRING_TRAVERSAL,
+                                  0,
+                                  max_name_length_,
+                                  &length).Detach();
+      return AddOrDisposeString(str, HashSequentialString(str, length));
+    }
     return AddOrDisposeString(
         name->ToCString(DISALLOW_NULLS, ROBUST_STRING_TRAVERSAL).Detach(),
         name->Hash());
@@ -922,6 +939,191 @@ void ProfileGenerator::RecordTickSample(const TickSample& sample) {
 }
 
 
+AllocationSampler::AllocationSampler(Heap* heap, intptr_t sample_interval)
+    : heap_(heap),
+      sample_interval_(sample_interval),
+      samples_count_(0),
+      entries_map_(CodeEntriesMatch),
+      function_entries_(SharedFunctionInfosMatch),
+      pending_object_(NULL) {
+  ASSERT(sample_interval > 0);
+  bytes_until_sample_ = NextSampleInterval();
+  // Ticks are samples here, give them some well-defined duration.
+  tree_.SetTickRatePerMs(1.0);
+}
+
+
+AllocationSampler::~AllocationSampler() {
+  for (int i = 0; i < entries_.length(); ++i) delete entries_[i];
+}
+
+
+intptr_t AllocationSampler::NextSampleInterval() {
+  // Sample points form a Poisson process, so that objects allocated at
+  // regular distances are not always or never sampled.
+  static const double kTwoToThe32 = 4294967296.0;
+  double u = V8::RandomPrivate(heap_->isolate()) / kTwoToThe32;
+  double next = -log(1.0 - u) * sample_interval_;
+  if (next < kPointerSize) return kPointerSize;
+  if (next > 100.0 * sample_interval_) return 100 * sample_interval_;
+  return static_cast<intptr_t>(next);
+}
+
+
+void AllocationSampler::Step(intptr_t bytes_allocated, Address soon_object) {
+  // Objects copied by the garbage collector are not allocations.
+  if (heap_->gc_state() != Heap::NOT_IN_GC) return;
+  bytes_until_sample_ -= bytes_allocated;
+  if (bytes_until_sample_ > 0 || soon_object == NULL) return;
+  FlushPendingSample();
+  RecordStack();
+  pending_object_ = soon_object;
+  samples_count_++;
+  bytes_until_sample_ = NextSampleInterval();
+}
+
+
+void AllocationSampler::GarbageCollectionPrologue() {
+  FlushPendingSample();
+  function_entries_.Clear();
+}
+
+
+ProfileTree* AllocationSampler::tree() {
+  FlushPendingSample();
+  return &tree_;
+}
+
+
+void AllocationSampler::RecordStack() {
+  ASSERT(pending_path_.is_empty());
+  // The innermost function comes first.  Walking the stack does not
+  // allocate on the JavaScript heap.
+  for (JavaScriptFrameIterator it(heap_->isolate());
+       !it.done() && pending_path_.length() < TickSample::kMaxFramesCount;
+       it.Advance()) {
+    Object* function = it.frame()->function();
+    if (!function->IsJSFunction()) continue;
+    pending_path_.Add(EntryForFunction(JSFunction::cast(function)));
+  }
+}
+
+
+void AllocationSampler::FlushPendingSample() {
+  if (pending_object_ == NULL) return;
+  HeapObject* object = HeapObject::FromAddress(pending_object_);
+  pending_object_ = NULL;
+  // Walk from the outermost function to the allocating one and end at
+  // the type of the object.
+  ProfileNode* node = tree_.root();
+  node->IncreaseTotalTicks(1);
+  for (int i = pending_path_.length() - 1; i >= 0; --i) {
+    node = node->FindOrAddChild(pending_path_[i]);
+    node->IncreaseTotalTicks(1);
+  }
+  node = node->FindOrAddChild(EntryForObject(object));
+  node->IncreaseTotalTicks(1);
+  node->IncrementSelfTicks();
+  pending_path_.Rewind(0);
+}
+
+
+static int LineNumberIfKnown(Script* script, int position) {
+  // Computing the line ends of the script would allocate.
+  if (!script->line_ends()->IsFixedArray()) {
+    return v8::CpuProfileNode::kNoLineNumberInfo;
+  }
+  FixedArray* line_ends = FixedArray::cast(script->line_ends());
+  int low = 0;
+  int high = line_ends->length();
+  while (low < high) {
+    int mid = low + (high - low) / 2;
+    if (Smi::cast(line_ends->get(mid))->value() < position) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low + script->line_offset()->value() + 1;
+}
+
+
+CodeEntry* AllocationSampler::EntryForFunction(JSFunction* function) {
+  SharedFunctionInfo* shared = function->shared();
+  HashMap::Entry* map_entry = function_entries_.Lookup(
+      shared, ComputePointerHash(shared), true);
+  if (map_entry->value != NULL) {
+    return reinterpret_cast<CodeEntry*>(map_entry->value);
+  }
+  const char* resource_name = "";
+  int line_number = v8::CpuProfileNode::kNoLineNumberInfo;
+  if (shared->script()->IsScript()) {
+    Script* script = Script::cast(shared->script());
+    if (script->name()->IsString()) {
+      resource_name = names_.GetName(String::cast(script->name()));
+    }
+    line_number = LineNumberIfKnown(script, shared->start_position());
+  }
+  CodeEntry* entry = FindOrAddEntry(
+      names_.GetFunctionName(shared->DebugName()), resource_name, line_number);
+  map_entry->value = entry;
+  return entry;
+}
+
+
+CodeEntry* AllocationSampler::EntryForObject(HeapObject* object) {
+  const char* name;
+  if (object->IsJSFunction()) {
+    name = "(closure)";
+  } else if (object->IsJSObject()) {
+    name = names_.GetFormatted(
+        "(%s)",
+        names_.GetName(V8HeapExplorer::GetConstructorName(
+            JSObject::cast(object))));
+  } else if (object->IsString()) {
+    name = "(string)";
+  } else if (object->IsHeapNumber()) {
+    name = "(number)";
+  } else if (object->IsFixedArray() ||
+             object->IsFixedDoubleArray() ||
+             object->IsByteArray() ||
+             object->IsExternalArray()) {
+    name = "(array)";
+  } else if (object->IsCode()) {
+    name = "(code)";
+  } else {
+    name = "(system)";
+  }
+  return FindOrAddEntry(name, "", v8::CpuProfileNode::kNoLineNumberInfo);
+}
+
+
+CodeEntry* AllocationSampler::FindOrAddEntry(const char* name,
+                                             const char* resource_name,
+                                             int line_number) {
+  CodeEntry key(Logger::FUNCTION_TAG,
+                CodeEntry::kEmptyNamePrefix,
+                name,
+                resource_name,
+                line_number,
+                TokenEnumerator::kNoSecurityToken);
+  HashMap::Entry* map_entry =
+      entries_map_.Lookup(&key, key.GetCallUid(), true);
+  if (map_entry->value == NULL) {
+    CodeEntry* entry = new CodeEntry(Logger::FUNCTION_TAG,
+                                     CodeEntry::kEmptyNamePrefix,
+                                     name,
+                                     resource_name,
+                                     line_number,
+                                     TokenEnumerator::kNoSecurityToken);
+    entries_.Add(entry);
+    map_entry->key = entry;
+    map_entry->value = entry;
+  }
+  return reinterpret_cast<CodeEntry*>(map_entry->value);
+}
+
+
 void HeapGraphEdge::Init(
     int child_index, Type type, const char* name, HeapEntry* to) {
   ASSERT(type == kContextVariable
@@ -1206,7 +1408,8 @@ HeapSnapshot::HeapSnapshot(HeapSnapshotsCollection* collection,
       gc_roots_entry_(NULL),
       natives_root_entry_(NULL),
       raw_entries_(NULL),
-      entries_sorted_(false) {
+      entries_sorted_(false),
+      aggregation_thread_(NULL) {
   STATIC_ASSERT(
       sizeof(HeapGraphEdge) ==
       SnapshotSizeConstants<sizeof(void*)>::kExpectedHeapGraphEdgeSize);  // NOLINT
@@ -1216,6 +1419,7 @@ HeapSnapshot::HeapSnapshot(HeapSnapshotsCollection* collection,
 }
 
 HeapSnapshot::~HeapSnapshot() {
+  WaitForAggregation();
   DeleteArray(raw_entries_);
 }
 
@@ -1236,6 +1440,38 @@ void HeapSnapshot::AllocateEntries(int entries_count,
 }
 
 
+class HeapSnapshotAggregationThread : public Thread {
+ public:
+  explicit HeapSnapshotAggregationThread(HeapSnapshot* snapshot)
+      : Thread("v8:HeapSnapAggr"),
+        snapshot_(snapshot) {
+  }
+
+  virtual void Run() {
+    HeapSnapshotAggregator aggregator(snapshot_, NULL, 0, 0);
+    aggregator.Aggregate();
+  }
+
+ private:
+  HeapSnapshot* snapshot_;
+};
+
+
+void HeapSnapshot::AggregateInBackground() {
+  ASSERT(aggregation_thread_ == NULL);
+  aggregation_thread_ = new HeapSnapshotAggregationThread(this);
+  aggregation_thread_->Start();
+}
+
+
+void HeapSnapshot::WaitForAggregation() {
+  if (aggregation_thread_ == NULL) return;
+  aggregation_thread_->Join();
+  delete aggregation_thread_;
+  aggregation_thread_ = NULL;
+}
+
+
 static void HeapEntryClearPaint(HeapEntry** entry_ptr) {
   (*entry_ptr)->clear_paint();
 }
@@ -1395,6 +1631,16 @@ uint64_t HeapObjectsMap::FindObject(Address addr) {
 }
 
 
+uint64_t HeapObjectsMap::FindOrAddObject(Address addr) {
+  uint64_t existing = FindEntry(addr);
+  if (existing != 0) return existing;
+  uint64_t id = next_id_;
+  next_id_ += 2;
+  AddEntry(addr, id);
+  return id;
+}
+
+
 void HeapObjectsMap::MoveObject(Address from, Address to) {
   if (from == to) return;
   HashMap::Entry* entry = entries_map_.Lookup(from, AddressHash(from), false);
@@ -1686,10 +1932,12 @@ HeapObject *const V8HeapExplorer::kGcRootsObject =
 
 V8HeapExplorer::V8HeapExplorer(
     HeapSnapshot* snapshot,
-    SnapshottingProgressReportingInterface* progress)
+    SnapshottingProgressReportingInterface* progress,
+    StringsStorage* names)
     : heap_(Isolate::Current()->heap()),
       snapshot_(snapshot),
       collection_(snapshot_->collection()),
+      names_(names != NULL ? names : collection_->names()),
       progress_(progress),
       filler_(NULL) {
 }
@@ -1714,91 +1962,65 @@ HeapEntry* V8HeapExplorer::AddEntry(HeapObject* object,
     return snapshot_->AddRootEntry(children_count);
   } else if (object == kGcRootsObject) {
     return snapshot_->AddGcRootsEntry(children_count, retainers_count);
-  } else if (object->IsJSGlobalObject()) {
+  }
+  HeapEntry::Type type;
+  const char* name;
+  DescribeObject(object, &type, &name);
+  return AddEntry(object, type, name, children_count, retainers_count);
+}
+
+
+void V8HeapExplorer::DescribeObject(HeapObject* object,
+                                    HeapEntry::Type* type,
+                                    const char** name) {
+  if (object->IsJSGlobalObject()) {
     const char* tag = objects_tags_.GetTag(object);
-    const char* name = collection_->names()->GetName(
-        GetConstructorName(JSObject::cast(object)));
+    *type = HeapEntry::kObject;
+    *name = names_->GetName(GetConstructorName(JSObject::cast(object)));
     if (tag != NULL) {
-      name = collection_->names()->GetFormatted("%s / %s", name, tag);
+      *name = names_->GetFormatted("%s / %s", *name, tag);
     }
-    return AddEntry(object,
-                    HeapEntry::kObject,
-                    name,
-                    children_count,
-                    retainers_count);
   } else if (object->IsJSFunction()) {
     JSFunction* func = JSFunction::cast(object);
     SharedFunctionInfo* shared = func->shared();
-    return AddEntry(object,
-                    HeapEntry::kClosure,
-                    collection_->names()->GetName(String::cast(shared->name())),
-                    children_count,
-                    retainers_count);
+    *type = HeapEntry::kClosure;
+    *name = names_->GetName(String::cast(shared->name()));
   } else if (object->IsJSRegExp()) {
     JSRegExp* re = JSRegExp::cast(object);
-    return AddEntry(object,
-                    HeapEntry::kRegExp,
-                    collection_->names()->GetName(re->Pattern()),
-                    children_count,
-                    retainers_count);
+    *type = HeapEntry::kRegExp;
+    *name = names_->GetName(re->Pattern());
   } else if (object->IsJSObject()) {
-    return AddEntry(object,
-                    HeapEntry::kObject,
-                    collection_->names()->GetName(
-                        GetConstructorName(JSObject::cast(object))),
-                    children_count,
-                    retainers_count);
+    *type = HeapEntry::kObject;
+    *name = names_->GetName(GetConstructorName(JSObject::cast(object)));
   } else if (object->IsString()) {
-    return AddEntry(object,
-                    HeapEntry::kString,
-                    collection_->names()->GetName(String::cast(object)),
-                    children_count,
-                    retainers_count);
+    *type = HeapEntry::kString;
+    *name = names_->GetName(String::cast(object));
   } else if (object->IsCode()) {
-    return AddEntry(object,
-                    HeapEntry::kCode,
-                    "",
-                    children_count,
-                    retainers_count);
+    *type = HeapEntry::kCode;
+    *name = "";
   } else if (object->IsSharedFunctionInfo()) {
     SharedFunctionInfo* shared = SharedFunctionInfo::cast(object);
-    return AddEntry(object,
-                    HeapEntry::kCode,
-                    collection_->names()->GetName(String::cast(shared->name())),
-                    children_count,
-                    retainers_count);
+    *type = HeapEntry::kCode;
+    *name = names_->GetName(String::cast(shared->name()));
   } else if (object->IsScript()) {
     Script* script = Script::cast(object);
-    return AddEntry(object,
-                    HeapEntry::kCode,
-                    script->name()->IsString() ?
-                        collection_->names()->GetName(
-                            String::cast(script->name()))
-                        : "",
-                    children_count,
-                    retainers_count);
+    *type = HeapEntry::kCode;
+    *name = script->name()->IsString() ?
+        names_->GetName(String::cast(script->name())) : "";
   } else if (object->IsFixedArray() ||
              object->IsFixedDoubleArray() ||
              object->IsByteArray() ||
              object->IsExternalArray()) {
     const char* tag = objects_tags_.GetTag(object);
-    return AddEntry(object,
-                    HeapEntry::kArray,
-                    tag != NULL ? tag : "",
-                    children_count,
-                    retainers_count);
+    *type = HeapEntry::kArray;
+    *name = tag != NULL ? tag : "";
   } else if (object->IsHeapNumber()) {
-    return AddEntry(object,
-                    HeapEntry::kHeapNumber,
-                    "number",
-                    children_count,
-                    retainers_count);
+    *type = HeapEntry::kHeapNumber;
+    *name = "number";
+  } else {
+    *type = HeapEntry::kHidden;
+    *name = GetSystemEntryName(object);
   }
-  return AddEntry(object,
-                  HeapEntry::kHidden,
-                  GetSystemEntryName(object),
-                  children_count,
-                  retainers_count);
 }
 
 
@@ -2219,7 +2441,9 @@ bool V8HeapExplorer::IterateAndExtractReferences(
        obj != NULL;
        obj = iterator.next(), progress_->ProgressStep()) {
     if (!interrupted) {
+      filler_->BeginReferences(obj);
       ExtractReferences(obj);
+      filler_->EndReferences(obj);
       if (!progress_->ProgressReport(false)) interrupted = true;
     }
   }
@@ -2244,7 +2468,7 @@ void V8HeapExplorer::SetClosureReference(HeapObject* parent_obj,
     filler_->SetNamedReference(HeapGraphEdge::kContextVariable,
                                parent_obj,
                                parent_entry,
-                               collection_->names()->GetName(reference_name),
+                               names_->GetName(reference_name),
                                child_obj,
                                child_entry);
   }
@@ -2295,7 +2519,7 @@ void V8HeapExplorer::SetInternalReference(HeapObject* parent_obj,
     filler_->SetNamedReference(HeapGraphEdge::kInternal,
                                parent_obj,
                                parent_entry,
-                               collection_->names()->GetName(index),
+                               names_->GetName(index),
                                child_obj,
                                child_entry);
     IndexedReferencesExtractor::MarkVisitedField(parent_obj, field_offset);
@@ -2331,7 +2555,7 @@ void V8HeapExplorer::SetPropertyReference(HeapObject* parent_obj,
     filler_->SetNamedReference(type,
                                parent_obj,
                                parent_entry,
-                               collection_->names()->GetName(reference_name),
+                               names_->GetName(reference_name),
                                child_obj,
                                child_entry);
     IndexedReferencesExtractor::MarkVisitedField(parent_obj, field_offset);
@@ -2348,7 +2572,7 @@ void V8HeapExplorer::SetPropertyShortcutReference(HeapObject* parent_obj,
     filler_->SetNamedReference(HeapGraphEdge::kShortcut,
                                parent_obj,
                                parent_entry,
-                               collection_->names()->GetName(reference_name),
+                               names_->GetName(reference_name),
                                child_obj,
                                child_entry);
   }
@@ -2440,7 +2664,7 @@ void V8HeapExplorer::TagGlobalObjects() {
       Object* obj_url;
       if (document->GetProperty(*url_string)->ToObject(&obj_url) &&
           obj_url->IsString()) {
-        urls[i] = collection_->names()->GetName(String::cast(obj_url));
+        urls[i] = names_->GetName(String::cast(obj_url));
       }
     }
   }
@@ -2803,7 +3027,9 @@ bool HeapSnapshotGenerator::GenerateSnapshot() {
   debug_heap->Verify();
 #endif
 
-  SetProgressTotal(4);  // 2 passes + dominators + sizes.
+  // 2 passes + dominators + sizes, unless aggregation is left to a
+  // background thread.
+  SetProgressTotal(FLAG_heap_snapshot_background_aggregation ? 2 : 4);
 
 #ifdef DEBUG
   debug_heap->Verify();
@@ -2825,8 +3051,15 @@ bool HeapSnapshotGenerator::GenerateSnapshot() {
   // Pass 2. Fill references.
   if (!FillReferences()) return false;
 
-  if (!SetEntriesDominators()) return false;
-  if (!ApproximateRetainedSizes()) return false;
+  if (FLAG_heap_snapshot_background_aggregation) {
+    // The heap is not needed anymore, so the isolate may go on while
+    // dominators and retained sizes are computed.
+    snapshot_->AggregateInBackground();
+  } else {
+    HeapSnapshotAggregator aggregator(
+        snapshot_, control_, progress_counter_, progress_total_);
+    if (!aggregator.Aggregate()) return false;
+  }
 
   progress_counter_ = progress_total_;
   if (!ProgressReport(true)) return false;
@@ -2879,7 +3112,40 @@ bool HeapSnapshotGenerator::FillReferences() {
 }
 
 
-void HeapSnapshotGenerator::FillReversePostorderIndexes(
+HeapSnapshotAggregator::HeapSnapshotAggregator(HeapSnapshot* snapshot,
+                                               v8::ActivityControl* control,
+                                               int progress_counter,
+                                               int progress_total)
+    : snapshot_(snapshot),
+      control_(control),
+      progress_counter_(progress_counter),
+      progress_total_(progress_total) {
+}
+
+
+bool HeapSnapshotAggregator::Aggregate() {
+  return SetEntriesDominators() && ApproximateRetainedSizes();
+}
+
+
+void HeapSnapshotAggregator::ProgressStep() {
+  ++progress_counter_;
+}
+
+
+bool HeapSnapshotAggregator::ProgressReport(bool force) {
+  const int kProgressReportGranularity = 10000;
+  if (control_ != NULL
+      && (force || progress_counter_ % kProgressReportGranularity == 0)) {
+      return
+          control_->ReportProgressValue(progress_counter_, progress_total_) ==
+          v8::ActivityControl::kContinue;
+  }
+  return true;
+}
+
+
+void HeapSnapshotAggregator::FillReversePostorderIndexes(
     Vector<HeapEntry*>* entries) {
   snapshot_->ClearPaint();
   int current_entry = 0;
@@ -2921,7 +3187,7 @@ static int Intersect(int i1, int i2, const Vector<HeapEntry*>& dominators) {
 // The algorithm is based on the article:
 // K. Cooper, T. Harvey and K. Kennedy "A Simple, Fast Dominance Algorithm"
 // Softw. Pract. Exper. 4 (2001), pp. 1-10.
-bool HeapSnapshotGenerator::BuildDominatorTree(
+bool HeapSnapshotAggregator::BuildDominatorTree(
     const Vector<HeapEntry*>& entries,
     Vector<HeapEntry*>* dominators) {
   if (entries.length() == 0) return true;
@@ -2967,7 +3233,7 @@ bool HeapSnapshotGenerator::BuildDominatorTree(
 }
 
 
-bool HeapSnapshotGenerator::SetEntriesDominators() {
+bool HeapSnapshotAggregator::SetEntriesDominators() {
   // This array is used for maintaining reverse postorder of nodes.
   ScopedVector<HeapEntry*> ordered_entries(snapshot_->entries()->length());
   FillReversePostorderIndexes(&ordered_entries);
@@ -2981,7 +3247,7 @@ bool HeapSnapshotGenerator::SetEntriesDominators() {
 }
 
 
-bool HeapSnapshotGenerator::ApproximateRetainedSizes() {
+bool HeapSnapshotAggregator::ApproximateRetainedSizes() {
   // As for the dominators tree we only know parent nodes, not
   // children, to sum up total sizes we "bubble" node's self size
   // adding it to all of its parents.
@@ -3315,53 +3581,58 @@ static void WriteUChar(OutputStreamWriter* w, unibrow::uchar u) {
   w->AddCharacter(hex_chars[u & 0xf]);
 }
 
-void HeapSnapshotJSONSerializer::SerializeString(const unsigned char* s) {
-  writer_->AddCharacter('\n');
-  writer_->AddCharacter('\"');
+static void WriteJSONString(OutputStreamWriter* w, const unsigned char* s) {
+  w->AddCharacter('\n');
+  w->AddCharacter('\"');
   for ( ; *s != '\0'; ++s) {
     switch (*s) {
       case '\b':
-        writer_->AddString("\\b");
+        w->AddString("\\b");
         continue;
       case '\f':
-        writer_->AddString("\\f");
+        w->AddString("\\f");
         continue;
       case '\n':
-        writer_->AddString("\\n");
+        w->AddString("\\n");
         continue;
       case '\r':
-        writer_->AddString("\\r");
+        w->AddString("\\r");
         continue;
       case '\t':
-        writer_->AddString("\\t");
+        w->AddString("\\t");
         continue;
       case '\"':
       case '\\':
-        writer_->AddCharacter('\\');
-        writer_->AddCharacter(*s);
+        w->AddCharacter('\\');
+        w->AddCharacter(*s);
         continue;
       default:
         if (*s > 31 && *s < 128) {
-          writer_->AddCharacter(*s);
+          w->AddCharacter(*s);
         } else if (*s <= 31) {
           // Special character with no dedicated literal.
-          WriteUChar(writer_, *s);
+          WriteUChar(w, *s);
         } else {
           // Convert UTF-8 into \u UTF-16 literal.
           unsigned length = 1, cursor = 0;
           for ( ; length <= 4 && *(s + length) != '\0'; ++length) { }
           unibrow::uchar c = unibrow::Utf8::CalculateValue(s, length, &cursor);
           if (c != unibrow::Utf8::kBadChar) {
-            WriteUChar(writer_, c);
+            WriteUChar(w, c);
             ASSERT(cursor != 0);
             s += cursor - 1;
           } else {
-            writer_->AddCharacter('?');
+            w->AddCharacter('?');
           }
         }
     }
   }
-  writer_->AddCharacter('\"');
+  w->AddCharacter('\"');
+}
+
+
+void HeapSnapshotJSONSerializer::SerializeString(const unsigned char* s) {
+  WriteJSONString(writer_, s);
 }
 
 
@@ -3399,4 +3670,324 @@ void HeapSnapshotJSONSerializer::SortHashMap(
   sorted_entries->Sort(SortUsingEntryValue);
 }
 
+
+// Passes the references found by V8HeapExplorer on to a
+// HeapSnapshotStreamer instead of storing them in snapshot entries.
+class StreamingSnapshotFiller : public SnapshotFillerInterface {
+ public:
+  explicit StreamingSnapshotFiller(HeapSnapshotStreamer* streamer)
+      : streamer_(streamer) {
+  }
+  HeapEntry* AddEntry(HeapThing ptr, HeapEntriesAllocator* allocator) {
+    return HeapEntriesMap::kHeapEntryPlaceholder;
+  }
+  HeapEntry* FindEntry(HeapThing ptr) {
+    return HeapEntriesMap::kHeapEntryPlaceholder;
+  }
+  HeapEntry* FindOrAddEntry(HeapThing ptr, HeapEntriesAllocator* allocator) {
+    return HeapEntriesMap::kHeapEntryPlaceholder;
+  }
+  void BeginReferences(HeapThing ptr) {
+    streamer_->BeginNode(ptr);
+  }
+  void EndReferences(HeapThing ptr) {
+    streamer_->EndNode(ptr);
+  }
+  void SetIndexedReference(HeapGraphEdge::Type type,
+                           HeapThing parent_ptr,
+                           HeapEntry* parent_entry,
+                           int index,
+                           HeapThing child_ptr,
+                           HeapEntry* child_entry) {
+    streamer_->AddEdge(parent_ptr, type, index, child_ptr);
+  }
+  void SetIndexedAutoIndexReference(HeapGraphEdge::Type type,
+                                    HeapThing parent_ptr,
+                                    HeapEntry* parent_entry,
+                                    HeapThing child_ptr,
+                                    HeapEntry* child_entry) {
+    int index = streamer_->EdgesCount(parent_ptr) + 1;
+    streamer_->AddEdge(parent_ptr, type, index, child_ptr);
+  }
+  void SetNamedReference(HeapGraphEdge::Type type,
+                         HeapThing parent_ptr,
+                         HeapEntry* parent_entry,
+                         const char* reference_name,
+                         HeapThing child_ptr,
+                         HeapEntry* child_entry) {
+    streamer_->AddEdge(
+        parent_ptr, type, streamer_->GetStringId(reference_name), child_ptr);
+  }
+  void SetNamedAutoIndexReference(HeapGraphEdge::Type type,
+                                  HeapThing parent_ptr,
+                                  HeapEntry* parent_entry,
+                                  HeapThing child_ptr,
+                                  HeapEntry* child_entry) {
+    const char* name =
+        streamer_->names()->GetName(streamer_->EdgesCount(parent_ptr) + 1);
+    streamer_->AddEdge(
+        parent_ptr, type, streamer_->GetStringId(name), child_ptr);
+  }
+
+ private:
+  HeapSnapshotStreamer* streamer_;
+};
+
+
+HeapSnapshotStreamer::HeapSnapshotStreamer(HeapSnapshot* snapshot,
+                                           v8::ActivityControl* control)
+    : snapshot_(snapshot),
+      control_(control),
+      names_(kMaxNameLength),
+      v8_heap_explorer_(snapshot_, this, &names_),
+      writer_(NULL),
+      strings_(ObjectsMatch),
+      next_string_id_(1),
+      current_(NULL),
+      progress_counter_(0),
+      progress_total_(0) {
+}
+
+
+bool HeapSnapshotStreamer::Stream(v8::OutputStream* stream) {
+  ASSERT(writer_ == NULL);
+  v8_heap_explorer_.TagGlobalObjects();
+
+  // Only objects reachable from the roots are written, so make sure
+  // weakly reachable objects are gone like GenerateSnapshot does.
+  Isolate::Current()->heap()->CollectAllGarbage(Heap::kMakeHeapIterableMask);
+  Isolate::Current()->heap()->CollectAllGarbage(Heap::kMakeHeapIterableMask);
+
+  // The ids of the objects must not change while they are written.
+  AssertNoAllocation no_alloc;
+
+  SetProgressTotal();
+  writer_ = new OutputStreamWriter(stream);
+  SerializeHeader();
+  StreamingSnapshotFiller filler(this);
+  bool completed = v8_heap_explorer_.IterateAndExtractReferences(&filler);
+  if (completed) {
+    SerializeNode(HeapEntry::kObject,
+                  "",
+                  HeapObjectsMap::kInternalRootObjectId,
+                  0,
+                  &root_edges_);
+    SerializeNode(HeapEntry::kObject,
+                  "(GC roots)",
+                  HeapObjectsMap::kGcRootsObjectId,
+                  0,
+                  &gc_roots_edges_);
+    writer_->AddString("],\n");
+    writer_->AddString("\"strings\":[");
+    SerializeStrings();
+    writer_->AddCharacter(']');
+    writer_->AddCharacter('}');
+    writer_->Finalize();
+    completed = !writer_->aborted();
+  }
+  delete writer_;
+  writer_ = NULL;
+  return completed;
+}
+
+
+void HeapSnapshotStreamer::BeginNode(HeapThing ptr) {
+  ASSERT(current_ == NULL);
+  current_ = ptr;
+}
+
+
+void HeapSnapshotStreamer::EndNode(HeapThing ptr) {
+  ASSERT(current_ == ptr);
+  HeapObject* object = reinterpret_cast<HeapObject*>(ptr);
+  HeapEntry::Type type;
+  const char* name;
+  v8_heap_explorer_.DescribeObject(object, &type, &name);
+  SerializeNode(type, name, GetNodeId(ptr), object->Size(), &current_edges_);
+  current_edges_.Rewind(0);
+  current_ = NULL;
+}
+
+
+void HeapSnapshotStreamer::AddEdge(HeapThing parent_ptr,
+                                   HeapGraphEdge::Type type,
+                                   int name_or_index,
+                                   HeapThing child_ptr) {
+  Edge edge;
+  edge.type = type;
+  edge.name_or_index = name_or_index;
+  edge.to_id = GetNodeId(child_ptr);
+  EdgesOf(parent_ptr)->Add(edge);
+}
+
+
+int HeapSnapshotStreamer::EdgesCount(HeapThing parent_ptr) {
+  return EdgesOf(parent_ptr)->length();
+}
+
+
+List<HeapSnapshotStreamer::Edge>* HeapSnapshotStreamer::EdgesOf(
+    HeapThing parent_ptr) {
+  if (parent_ptr == V8HeapExplorer::kInternalRootObject) {
+    return &root_edges_;
+  } else if (parent_ptr == V8HeapExplorer::kGcRootsObject) {
+    return &gc_roots_edges_;
+  }
+  ASSERT(parent_ptr == current_);
+  return &current_edges_;
+}
+
+
+uint64_t HeapSnapshotStreamer::GetNodeId(HeapThing ptr) {
+  if (ptr == V8HeapExplorer::kInternalRootObject) {
+    return HeapObjectsMap::kInternalRootObjectId;
+  } else if (ptr == V8HeapExplorer::kGcRootsObject) {
+    return HeapObjectsMap::kGcRootsObjectId;
+  }
+  // An object is asked for once as a node and once per edge to it.
+  return collection()->FindOrAddObjectId(
+      reinterpret_cast<HeapObject*>(ptr)->address());
+}
+
+
+int HeapSnapshotStreamer::GetStringId(const char* s) {
+  HashMap::Entry* cache_entry = strings_.Lookup(
+      const_cast<char*>(s), ObjectHash(s), true);
+  if (cache_entry->value == NULL) {
+    cache_entry->value = reinterpret_cast<void*>(next_string_id_++);
+  }
+  return static_cast<int>(reinterpret_cast<intptr_t>(cache_entry->value));
+}
+
+
+void HeapSnapshotStreamer::ProgressStep() {
+  ++progress_counter_;
+}
+
+
+bool HeapSnapshotStreamer::ProgressReport(bool force) {
+  // Stop exploring the heap once the stream has refused more data.
+  if (writer_ != NULL && writer_->aborted()) return false;
+  const int kProgressReportGranularity = 10000;
+  if (control_ != NULL
+      && (force || progress_counter_ % kProgressReportGranularity == 0)) {
+      return
+          control_->ReportProgressValue(progress_counter_, progress_total_) ==
+          v8::ActivityControl::kContinue;
+  }
+  return true;
+}
+
+
+void HeapSnapshotStreamer::SetProgressTotal() {
+  if (control_ == NULL) return;
+  HeapIterator iterator(HeapIterator::kFilterUnreachable);
+  progress_total_ = v8_heap_explorer_.EstimateObjectsCount(&iterator);
+  progress_counter_ = 0;
+}
+
+
+void HeapSnapshotStreamer::SerializeHeader() {
+  writer_->AddCharacter('{');
+  writer_->AddString("\"snapshot\":{");
+  writer_->AddString("\"title\":\"");
+  writer_->AddString(snapshot_->title());
+  writer_->AddString("\"");
+  writer_->AddString(",\"uid\":");
+  writer_->AddNumber(snapshot_->uid());
+  writer_->AddString(",\"streamed\":true");
+  writer_->AddString("},\n");
+  writer_->AddString("\"nodes\":[");
+  // The first (zero) item of nodes array is an object describing node
+  // serialization layout.
+#define JSON_A(s) "["s"]"
+#define JSON_O(s) "{"s"}"
+#define JSON_S(s) "\""s"\""
+  writer_->AddString(JSON_O(
+    JSON_S("fields") ":" JSON_A(
+        JSON_S("type")
+        "," JSON_S("name")
+        "," JSON_S("id")
+        "," JSON_S("self_size")
+        "," JSON_S("children_count")
+        "," JSON_S("children"))
+    "," JSON_S("types") ":" JSON_A(
+        JSON_A(
+            JSON_S("hidden")
+            "," JSON_S("array")
+            "," JSON_S("string")
+            "," JSON_S("object")
+            "," JSON_S("code")
+            "," JSON_S("closure")
+            "," JSON_S("regexp")
+            "," JSON_S("number")
+            "," JSON_S("native"))
+        "," JSON_S("string")
+        "," JSON_S("number")
+        "," JSON_S("number")
+        "," JSON_S("number")
+        "," JSON_O(
+            JSON_S("fields") ":" JSON_A(
+                JSON_S("type")
+                "," JSON_S("name_or_index")
+                "," JSON_S("to_node"))
+            "," JSON_S("types") ":" JSON_A(
+                JSON_A(
+                    JSON_S("context")
+                    "," JSON_S("element")
+                    "," JSON_S("property")
+                    "," JSON_S("internal")
+                    "," JSON_S("hidden")
+                    "," JSON_S("shortcut"))
+                "," JSON_S("string_or_number")
+                "," JSON_S("node_id"))))));
+#undef JSON_S
+#undef JSON_O
+#undef JSON_A
+}
+
+
+void HeapSnapshotStreamer::SerializeNode(HeapEntry::Type type,
+                                         const char* name,
+                                         uint64_t id,
+                                         int self_size,
+                                         List<Edge>* edges) {
+  if (writer_->aborted()) return;
+  writer_->AddCharacter('\n');
+  writer_->AddCharacter(',');
+  writer_->AddNumber(type);
+  writer_->AddCharacter(',');
+  writer_->AddNumber(GetStringId(name));
+  writer_->AddCharacter(',');
+  writer_->AddNumber(id);
+  writer_->AddCharacter(',');
+  writer_->AddNumber(self_size);
+  writer_->AddCharacter(',');
+  writer_->AddNumber(edges->length());
+  for (int i = 0; i < edges->length(); ++i) {
+    const Edge& edge = edges->at(i);
+    writer_->AddCharacter(',');
+    writer_->AddNumber(edge.type);
+    writer_->AddCharacter(',');
+    writer_->AddNumber(edge.name_or_index);
+    writer_->AddCharacter(',');
+    writer_->AddNumber(edge.to_id);
+  }
+}
+
+
+void HeapSnapshotStreamer::SerializeStrings() {
+  List<HashMap::Entry*> sorted_strings;
+  for (HashMap::Entry* p = strings_.Start(); p != NULL; p = strings_.Next(p))
+    sorted_strings.Add(p);
+  sorted_strings.Sort(SortUsingEntryValue);
+  writer_->AddString("\"<dummy>\"");
+  for (int i = 0; i < sorted_strings.length(); ++i) {
+    writer_->AddCharacter(',');
+    WriteJSONString(writer_, reinterpret_cast<const unsigned char*>(
+        sorted_strings[i]->key));
+    if (writer_->aborted()) return;
+  }
+}
+
 } }  // namespace v8::internal
@@ -63,6 +63,8 @@ class TokenEnumerator {
 class StringsStorage {
  public:
   StringsStorage();
+  // Names taken from strings are cut to max_name_length characters.
+  explicit StringsStorage(int max_name_length);
   ~StringsStorage();
 
   const char* GetCopy(const char* src);
@@ -82,6 +84,7 @@ class StringsStorage {
 
   // Mapping of strings by String::Hash to const char* strings.
   HashMap names_;
+  int max_name_length_;
 
   DISALLOW_COPY_AND_ASSIGN(StringsStorage);
 };
@@ -443,6 +446,74 @@ class ProfileGenerator {
 };
 
 
+// Samples heap allocations: about every sample_interval allocated bytes
+// (the actual distance is drawn from an exponential distribution) the
+// JavaScript stack of the allocating code and the type of the allocated
+// object are added to a call tree.  Paths in the tree lead from the
+// outermost function to the allocating one, leafs name the object types,
+// and the self ticks of a leaf count its samples.  A sample stands for
+// sample_interval bytes of allocation on average.
+class AllocationSampler {
+ public:
+  AllocationSampler(Heap* heap, intptr_t sample_interval);
+  ~AllocationSampler();
+
+  // Accounts for bytes_allocated more bytes of allocation, including the
+  // object starting at soon_object.  Takes a sample if the next sample
+  // point has been reached.  The object is not initialized yet, so its
+  // type is looked up later on.  If soon_object is NULL the sample is
+  // taken at the next object.
+  void Step(intptr_t bytes_allocated, Address soon_object);
+
+  // Completes the pending sample before objects move or die.
+  void GarbageCollectionPrologue();
+
+  // Returns the call tree of all samples taken so far.
+  ProfileTree* tree();
+
+  intptr_t sample_interval() const { return sample_interval_; }
+  intptr_t bytes_until_next_sample() const { return bytes_until_sample_; }
+  int samples_count() const { return samples_count_; }
+
+ private:
+  intptr_t NextSampleInterval();
+  void RecordStack();
+  void FlushPendingSample();
+  CodeEntry* EntryForFunction(JSFunction* function);
+  CodeEntry* EntryForObject(HeapObject* object);
+  CodeEntry* FindOrAddEntry(const char* name,
+                            const char* resource_name,
+                            int line_number);
+
+  INLINE(static bool CodeEntriesMatch(void* entry1, void* entry2)) {
+    return reinterpret_cast<CodeEntry*>(entry1)->IsSameAs(
+        reinterpret_cast<CodeEntry*>(entry2));
+  }
+
+  INLINE(static bool SharedFunctionInfosMatch(void* key1, void* key2)) {
+    return key1 == key2;
+  }
+
+  Heap* heap_;
+  intptr_t sample_interval_;
+  intptr_t bytes_until_sample_;
+  int samples_count_;
+  StringsStorage names_;
+  // All code entries, deduplicated with IsSameAs.
+  List<CodeEntry*> entries_;
+  HashMap entries_map_;
+  // Mapping from SharedFunctionInfo* to CodeEntry*.  Cleared at every GC
+  // since the infos may move.
+  HashMap function_entries_;
+  // The last sample, waiting for its object to be initialized.
+  Address pending_object_;
+  List<CodeEntry*> pending_path_;
+  ProfileTree tree_;
+
+  DISALLOW_COPY_AND_ASSIGN(AllocationSampler);
+};
+
+
 class HeapEntry;
 
 class HeapGraphEdge BASE_EMBEDDED {
@@ -639,6 +710,8 @@ class HeapSnapshotsCollection;
 // HeapSnapshots. All HeapSnapshots share strings copied from JS heap
 // to be able to return them even if they were collected.
 // HeapSnapshotGenerator fills in a HeapSnapshot.
+class HeapSnapshotAggregationThread;
+
 class HeapSnapshot {
  public:
   enum Type {
@@ -680,6 +753,11 @@ class HeapSnapshot {
   void IterateEntries(Visitor* visitor) { entries_.Iterate(visitor); }
   void SetDominatorsToSelf();
 
+  // Computes dominators and retained sizes on a background thread.  Until
+  // WaitForAggregation() returns only the graph itself may be accessed.
+  void AggregateInBackground();
+  void WaitForAggregation();
+
   void Print(int max_depth);
   void PrintEntriesSize();
 
@@ -697,6 +775,7 @@ class HeapSnapshot {
   List<HeapEntry*> entries_;
   bool entries_sorted_;
   int raw_entries_size_;
+  HeapSnapshotAggregationThread* aggregation_thread_;
 
   friend class HeapSnapshotTester;
 
@@ -711,6 +790,9 @@ class HeapObjectsMap {
 
   void SnapshotGenerationFinished();
   uint64_t FindObject(Address addr);
+  // Unlike FindObject, can be asked for the same object several times
+  // while the map is being filled initially.
+  uint64_t FindOrAddObject(Address addr);
   void MoveObject(Address from, Address to);
 
   static uint64_t GenerateId(v8::RetainedObjectInfo* info);
@@ -768,6 +850,9 @@ class HeapSnapshotsCollection {
   TokenEnumerator* token_enumerator() { return token_enumerator_; }
 
   uint64_t GetObjectId(Address addr) { return ids_.FindObject(addr); }
+  uint64_t FindOrAddObjectId(Address addr) {
+    return ids_.FindOrAddObject(addr);
+  }
   Handle<HeapObject> FindHeapObjectById(uint64_t id);
   void ObjectMoveEvent(Address from, Address to) { ids_.MoveObject(from, to); }
 
@@ -903,6 +988,9 @@ class SnapshotFillerInterface {
                                           HeapEntry* parent_entry,
                                           HeapThing child_ptr,
                                           HeapEntry* child_entry) = 0;
+  // Bracket the references set while a heap object is being explored.
+  virtual void BeginReferences(HeapThing ptr) { }
+  virtual void EndReferences(HeapThing ptr) { }
 };
 
 
@@ -917,8 +1005,10 @@ class SnapshottingProgressReportingInterface {
 // An implementation of V8 heap graph extractor.
 class V8HeapExplorer : public HeapEntriesAllocator {
  public:
+  // Names go to the collection's storage unless another one is given.
   V8HeapExplorer(HeapSnapshot* snapshot,
-                 SnapshottingProgressReportingInterface* progress);
+                 SnapshottingProgressReportingInterface* progress,
+                 StringsStorage* names = NULL);
   virtual ~V8HeapExplorer();
   virtual HeapEntry* AllocateEntry(
       HeapThing ptr, int children_count, int retainers_count);
@@ -926,10 +1016,14 @@ class V8HeapExplorer : public HeapEntriesAllocator {
   int EstimateObjectsCount(HeapIterator* iterator);
   bool IterateAndExtractReferences(SnapshotFillerInterface* filler);
   void TagGlobalObjects();
+  void DescribeObject(HeapObject* object,
+                      HeapEntry::Type* type,
+                      const char** name);
 
   static String* GetConstructorName(JSObject* object);
 
   static HeapObject* const kInternalRootObject;
+  static HeapObject* const kGcRootsObject;
 
  private:
   HeapEntry* AddEntry(
@@ -986,12 +1080,11 @@ class V8HeapExplorer : public HeapEntriesAllocator {
   Heap* heap_;
   HeapSnapshot* snapshot_;
   HeapSnapshotsCollection* collection_;
+  StringsStorage* names_;
   SnapshottingProgressReportingInterface* progress_;
   SnapshotFillerInterface* filler_;
   HeapObjectsSet objects_tags_;
 
-  static HeapObject* const kGcRootsObject;
-
   friend class IndexedReferencesExtractor;
   friend class RootsReferencesExtractor;
 
@@ -1054,15 +1147,10 @@ class HeapSnapshotGenerator : public SnapshottingProgressReportingInterface {
   bool GenerateSnapshot();
 
  private:
-  bool ApproximateRetainedSizes();
-  bool BuildDominatorTree(const Vector<HeapEntry*>& entries,
-                          Vector<HeapEntry*>* dominators);
   bool CountEntriesAndReferences();
   bool FillReferences();
-  void FillReversePostorderIndexes(Vector<HeapEntry*>* entries);
   void ProgressStep();
   bool ProgressReport(bool force = false);
-  bool SetEntriesDominators();
   void SetProgressTotal(int iterations_count);
 
   HeapSnapshot* snapshot_;
@@ -1078,8 +1166,114 @@ class HeapSnapshotGenerator : public SnapshottingProgressReportingInterface {
   DISALLOW_COPY_AND_ASSIGN(HeapSnapshotGenerator);
 };
 
+// Computes dominators and retained sizes of a snapshot whose entries are
+// filled.  Only the snapshot graph is used, never the V8 heap, so this
+// can run on a background thread (without an activity control).
+class HeapSnapshotAggregator : public SnapshottingProgressReportingInterface {
+ public:
+  HeapSnapshotAggregator(HeapSnapshot* snapshot,
+                         v8::ActivityControl* control,
+                         int progress_counter,
+                         int progress_total);
+  bool Aggregate();
+  int progress_counter() { return progress_counter_; }
+
+ private:
+  bool ApproximateRetainedSizes();
+  bool BuildDominatorTree(const Vector<HeapEntry*>& entries,
+                          Vector<HeapEntry*>* dominators);
+  void FillReversePostorderIndexes(Vector<HeapEntry*>* entries);
+  void ProgressStep();
+  bool ProgressReport(bool force = false);
+  bool SetEntriesDominators();
+
+  HeapSnapshot* snapshot_;
+  v8::ActivityControl* control_;
+  int progress_counter_;
+  int progress_total_;
+
+  DISALLOW_COPY_AND_ASSIGN(HeapSnapshotAggregator);
+};
+
 class OutputStreamWriter;
 
+// Writes a heap snapshot to a stream while the heap is being explored,
+// without building the nodes and edges graph in memory. Besides the ids
+// map of the snapshots collection, it only keeps the names written so
+// far and the references of the object being explored. Dominators and
+// retained sizes need the whole graph, so they are not computed, and
+// native objects are not reported. Edges refer to nodes by their ids,
+// and the root nodes are written last.
+class HeapSnapshotStreamer : public SnapshottingProgressReportingInterface {
+ public:
+  HeapSnapshotStreamer(HeapSnapshot* snapshot,
+                       v8::ActivityControl* control);
+  // Returns false if streaming was aborted by the stream or the control.
+  bool Stream(v8::OutputStream* stream);
+
+  HeapSnapshotsCollection* collection() { return snapshot_->collection(); }
+  StringsStorage* names() { return &names_; }
+  void BeginNode(HeapThing ptr);
+  void EndNode(HeapThing ptr);
+  void AddEdge(HeapThing parent_ptr,
+               HeapGraphEdge::Type type,
+               int name_or_index,
+               HeapThing child_ptr);
+  int EdgesCount(HeapThing parent_ptr);
+  int GetStringId(const char* s);
+
+ private:
+  struct Edge {
+    HeapGraphEdge::Type type;
+    int name_or_index;
+    uint64_t to_id;
+  };
+
+  INLINE(static bool ObjectsMatch(void* key1, void* key2)) {
+    return key1 == key2;
+  }
+
+  INLINE(static uint32_t ObjectHash(const void* key)) {
+    return ComputeIntegerHash(
+        static_cast<uint32_t>(reinterpret_cast<uintptr_t>(key)));
+  }
+
+  List<Edge>* EdgesOf(HeapThing parent_ptr);
+  uint64_t GetNodeId(HeapThing ptr);
+  void ProgressStep();
+  bool ProgressReport(bool force = false);
+  void SerializeHeader();
+  void SerializeNode(HeapEntry::Type type,
+                     const char* name,
+                     uint64_t id,
+                     int self_size,
+                     List<Edge>* edges);
+  void SerializeStrings();
+  void SetProgressTotal();
+
+  // Strings are cut to this length for their node names.
+  static const int kMaxNameLength = 1024;
+
+  HeapSnapshot* snapshot_;
+  v8::ActivityControl* control_;
+  // Names of the streamed nodes and edges.  Streamed names are not kept in
+  // the collection, they go away together with the streamer when
+  // streaming is done.
+  StringsStorage names_;
+  V8HeapExplorer v8_heap_explorer_;
+  OutputStreamWriter* writer_;
+  HashMap strings_;
+  int next_string_id_;
+  HeapThing current_;
+  List<Edge> current_edges_;
+  List<Edge> root_edges_;
+  List<Edge> gc_roots_edges_;
+  int progress_counter_;
+  int progress_total_;
+
+  DISALLOW_COPY_AND_ASSIGN(HeapSnapshotStreamer);
+};
+
 class HeapSnapshotJSONSerializer {
  public:
   explicit HeapSnapshotJSONSerializer(HeapSnapshot* snapshot)
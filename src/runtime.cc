@@ -48,6 +48,7 @@
 #include "liveedit.h"
 #include "liveobjectlist-inl.h"
 #include "misc-intrinsics.h"
+#include "optimizing-compiler-thread.h"
 #include "parser.h"
 #include "platform.h"
 #include "runtime-profiler.h"
@@ -106,14 +107,16 @@ namespace internal {
   type name = NumberTo##Type(obj);
 
 
-MUST_USE_RESULT static MaybeObject* DeepCopyBoilerplate(Isolate* isolate,
-                                                   JSObject* boilerplate) {
+MUST_USE_RESULT static MaybeObject* DeepCopyBoilerplate(
+    Isolate* isolate,
+    JSObject* boilerplate,
+    PretenureFlag pretenure = NOT_TENURED) {
   StackLimitCheck check(isolate);
   if (check.HasOverflowed()) return isolate->StackOverflow();
 
   Heap* heap = isolate->heap();
   Object* result;
-  { MaybeObject* maybe_result = heap->CopyJSObject(boilerplate);
+  { MaybeObject* maybe_result = heap->CopyJSObject(boilerplate, pretenure);
     if (!maybe_result->ToObject(&result)) return maybe_result;
   }
   JSObject* copy = JSObject::cast(result);
@@ -125,7 +128,8 @@ MUST_USE_RESULT static MaybeObject* DeepCopyBoilerplate(Isolate* isolate,
       Object* value = properties->get(i);
       if (value->IsJSObject()) {
         JSObject* js_object = JSObject::cast(value);
-        { MaybeObject* maybe_result = DeepCopyBoilerplate(isolate, js_object);
+        { MaybeObject* maybe_result =
+              DeepCopyBoilerplate(isolate, js_object, pretenure);
           if (!maybe_result->ToObject(&result)) return maybe_result;
         }
         properties->set(i, result);
@@ -136,7 +140,8 @@ MUST_USE_RESULT static MaybeObject* DeepCopyBoilerplate(Isolate* isolate,
       Object* value = copy->InObjectPropertyAt(i);
       if (value->IsJSObject()) {
         JSObject* js_object = JSObject::cast(value);
-        { MaybeObject* maybe_result = DeepCopyBoilerplate(isolate, js_object);
+        { MaybeObject* maybe_result =
+              DeepCopyBoilerplate(isolate, js_object, pretenure);
           if (!maybe_result->ToObject(&result)) return maybe_result;
         }
         copy->InObjectPropertyAtPut(i, result);
@@ -162,7 +167,8 @@ MUST_USE_RESULT static MaybeObject* DeepCopyBoilerplate(Isolate* isolate,
           copy->GetProperty(key_string, &attributes)->ToObjectUnchecked();
       if (value->IsJSObject()) {
         JSObject* js_object = JSObject::cast(value);
-        { MaybeObject* maybe_result = DeepCopyBoilerplate(isolate, js_object);
+        { MaybeObject* maybe_result =
+              DeepCopyBoilerplate(isolate, js_object, pretenure);
           if (!maybe_result->ToObject(&result)) return maybe_result;
         }
         { MaybeObject* maybe_result =
@@ -196,8 +202,8 @@ MUST_USE_RESULT static MaybeObject* DeepCopyBoilerplate(Isolate* isolate,
                  (copy->GetElementsKind() == FAST_ELEMENTS));
           if (value->IsJSObject()) {
             JSObject* js_object = JSObject::cast(value);
-            { MaybeObject* maybe_result = DeepCopyBoilerplate(isolate,
-                                                              js_object);
+            { MaybeObject* maybe_result =
+                  DeepCopyBoilerplate(isolate, js_object, pretenure);
               if (!maybe_result->ToObject(&result)) return maybe_result;
             }
             elements->set(i, result);
@@ -215,8 +221,8 @@ MUST_USE_RESULT static MaybeObject* DeepCopyBoilerplate(Isolate* isolate,
           Object* value = element_dictionary->ValueAt(i);
           if (value->IsJSObject()) {
             JSObject* js_object = JSObject::cast(value);
-            { MaybeObject* maybe_result = DeepCopyBoilerplate(isolate,
-                                                              js_object);
+            { MaybeObject* maybe_result =
+                  DeepCopyBoilerplate(isolate, js_object, pretenure);
               if (!maybe_result->ToObject(&result)) return maybe_result;
             }
             element_dictionary->ValueAtPut(i, result);
@@ -245,6 +251,32 @@ MUST_USE_RESULT static MaybeObject* DeepCopyBoilerplate(Isolate* isolate,
 }
 
 
+// Copies the boilerplate of a literal for a new literal object.  The
+// boilerplate serves as the allocation site of the copies: it decides
+// where they are allocated and a sample of them is tracked by the heap's
+// allocation site feedback.
+MUST_USE_RESULT static MaybeObject* CopyLiteralBoilerplate(
+    Isolate* isolate,
+    JSObject* boilerplate,
+    bool deep) {
+  Heap* heap = isolate->heap();
+  if (!FLAG_allocation_site_pretenuring) {
+    return deep ? DeepCopyBoilerplate(isolate, boilerplate)
+                : heap->CopyJSObject(boilerplate);
+  }
+  AllocationSiteFeedback* feedback = heap->allocation_site_feedback();
+  PretenureFlag pretenure = feedback->GetPretenureFlag(boilerplate);
+  Object* result;
+  { MaybeObject* maybe_result = deep
+        ? DeepCopyBoilerplate(isolate, boilerplate, pretenure)
+        : heap->CopyJSObject(boilerplate, pretenure);
+    if (!maybe_result->ToObject(&result)) return maybe_result;
+  }
+  feedback->RecordAllocation(boilerplate, HeapObject::cast(result));
+  return result;
+}
+
+
 RUNTIME_FUNCTION(MaybeObject*, Runtime_CloneLiteralBoilerplate) {
   CONVERT_CHECKED(JSObject, boilerplate, args[0]);
   return DeepCopyBoilerplate(isolate, boilerplate);
@@ -566,7 +598,7 @@ RUNTIME_FUNCTION(MaybeObject*, Runtime_CreateObjectLiteral) {
     // Update the functions literal and return the boilerplate.
     literals->set(literals_index, *boilerplate);
   }
-  return DeepCopyBoilerplate(isolate, JSObject::cast(*boilerplate));
+  return CopyLiteralBoilerplate(isolate, JSObject::cast(*boilerplate), true);
 }
 
 
@@ -592,7 +624,7 @@ RUNTIME_FUNCTION(MaybeObject*, Runtime_CreateObjectLiteralShallow) {
     // Update the functions literal and return the boilerplate.
     literals->set(literals_index, *boilerplate);
   }
-  return isolate->heap()->CopyJSObject(JSObject::cast(*boilerplate));
+  return CopyLiteralBoilerplate(isolate, JSObject::cast(*boilerplate), false);
 }
 
 
@@ -611,7 +643,7 @@ RUNTIME_FUNCTION(MaybeObject*, Runtime_CreateArrayLiteral) {
     // Update the functions literal and return the boilerplate.
     literals->set(literals_index, *boilerplate);
   }
-  return DeepCopyBoilerplate(isolate, JSObject::cast(*boilerplate));
+  return CopyLiteralBoilerplate(isolate, JSObject::cast(*boilerplate), true);
 }
 
 
@@ -634,7 +666,7 @@ RUNTIME_FUNCTION(MaybeObject*, Runtime_CreateArrayLiteralShallow) {
       isolate->heap()->fixed_cow_array_map()) {
     isolate->counters()->cow_arrays_created_runtime()->Increment();
   }
-  return isolate->heap()->CopyJSObject(JSObject::cast(*boilerplate));
+  return CopyLiteralBoilerplate(isolate, JSObject::cast(*boilerplate), false);
 }
 
 
@@ -8165,6 +8197,20 @@ RUNTIME_FUNCTION(MaybeObject*, Runtime_LazyRecompile) {
     function->ReplaceCode(function->shared()->code());
     return function->code();
   }
+  OptimizingCompilerThread* thread = isolate->optimizing_compiler_thread();
+  if (thread != NULL) {
+    // Hand the function to the optimizing compiler thread and keep running
+    // the unoptimized code; the optimized code is installed when ready.
+    if (!thread->IsQueued(*function) &&
+        Compiler::RecompileConcurrent(function) &&
+        FLAG_trace_opt) {
+      PrintF("[queued ");
+      function->PrintName();
+      PrintF(" for concurrent optimization]\n");
+    }
+    function->ReplaceCode(function->shared()->code());
+    return function->code();
+  }
   if (CompileOptimized(function, AstNode::kNoNumber, CLEAR_EXCEPTION)) {
     return function->code();
   }
@@ -8211,14 +8257,14 @@ RUNTIME_FUNCTION(MaybeObject*, Runtime_NotifyDeoptimized) {
       static_cast<Deoptimizer::BailoutType>(args.smi_at(0));
   Deoptimizer* deoptimizer = Deoptimizer::Grab(isolate);
   ASSERT(isolate->heap()->IsAllocationAllowed());
-  int frames = deoptimizer->output_count();
+  int jsframes = deoptimizer->jsframe_count();
 
-  deoptimizer->MaterializeHeapNumbers();
+  deoptimizer->MaterializeHeapObjects();
   delete deoptimizer;
 
   JavaScriptFrameIterator it(isolate);
   JavaScriptFrame* frame = NULL;
-  for (int i = 0; i < frames - 1; i++) it.Advance();
+  for (int i = 0; i < jsframes - 1; i++) it.Advance();
   frame = it.frame();
 
   RUNTIME_ASSERT(frame->function()->IsJSFunction());
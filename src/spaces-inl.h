@@ -300,22 +300,35 @@ MaybeObject* PagedSpace::AllocateRaw(int size_in_bytes) {
 MaybeObject* NewSpace::AllocateRawInternal(int size_in_bytes) {
   Address old_top = allocation_info_.top;
   if (allocation_info_.limit - old_top < size_in_bytes) {
+    if (HasThreadAllocationBuffer()) {
+      // The thread allocation buffer is used up, continue in the shared area.
+      RetireAllocationBuffer();
+      return AllocateRawInternal(size_in_bytes);
+    }
     Address new_top = old_top + size_in_bytes;
     Address high = to_space_.page_high();
     if (allocation_info_.limit < high) {
-      // Incremental marking has lowered the limit to get a
-      // chance to do a step.
-      allocation_info_.limit = Min(
-          allocation_info_.limit + inline_allocation_limit_step_,
-          high);
+      // Incremental marking or the allocation sampler has lowered the
+      // limit to get a chance to do a step.
       int bytes_allocated = static_cast<int>(new_top - top_on_previous_step_);
       heap()->incremental_marking()->Step(bytes_allocated);
+      if (allocation_sampling_step_ != 0) {
+        // The object goes to old_top unless it needs a fresh page.
+        heap()->AllocationSamplingStep(bytes_allocated,
+                                       new_top <= high ? old_top : NULL);
+      }
+      allocation_info_.limit = Min(
+          allocation_info_.limit + inline_allocation_step(),
+          high);
       top_on_previous_step_ = new_top;
       return AllocateRawInternal(size_in_bytes);
     } else if (AddFreshPage()) {
       // Switched to new page. Try allocating again.
       int bytes_allocated = static_cast<int>(old_top - top_on_previous_step_);
       heap()->incremental_marking()->Step(bytes_allocated);
+      if (allocation_sampling_step_ != 0) {
+        heap()->AllocationSamplingStep(bytes_allocated, NULL);
+      }
       top_on_previous_step_ = to_space_.page_low();
       return AllocateRawInternal(size_in_bytes);
     } else {
@@ -361,7 +374,8 @@ void NewSpace::ShrinkStringAtAllocationBoundary(String* string, int length) {
 
 bool FreeListNode::IsFreeListNode(HeapObject* object) {
   Map* map = object->map();
-  Heap* heap = object->GetHeap();
+  // Not GetHeap(), this is also used on the concurrent sweeper thread.
+  Heap* heap = MemoryChunk::FromAddress(object->address())->heap();
   return map == heap->raw_unchecked_free_space_map()
       || map == heap->raw_unchecked_one_pointer_filler_map()
       || map == heap->raw_unchecked_two_pointer_filler_map();
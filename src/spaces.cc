@@ -27,6 +27,7 @@
 
 #include "v8.h"
 
+#include "compiler-intrinsics.h"
 #include "liveobjectlist-inl.h"
 #include "macro-assembler.h"
 #include "mark-compact.h"
@@ -275,7 +276,10 @@ MemoryAllocator::MemoryAllocator(Isolate* isolate)
       capacity_(0),
       capacity_executable_(0),
       size_(0),
-      size_executable_(0) {
+      size_executable_(0),
+      use_huge_pages_(false),
+      size_huge_pages_(0),
+      cached_large_page_bytes_(0) {
 }
 
 
@@ -287,11 +291,16 @@ bool MemoryAllocator::Setup(intptr_t capacity, intptr_t capacity_executable) {
   size_ = 0;
   size_executable_ = 0;
 
+  use_huge_pages_ =
+      FLAG_transparent_huge_pages && VirtualMemory::HasHugePageSupport();
+  size_huge_pages_ = 0;
+
   return true;
 }
 
 
 void MemoryAllocator::TearDown() {
+  ReleaseCachedLargePages();
   // Check that spaces were torn down before MemoryAllocator.
   ASSERT(size_ == 0);
   // TODO(gc) this will be true again when we fix FreeMemory.
@@ -367,6 +376,9 @@ Address MemoryAllocator::AllocateAlignedMemory(size_t size,
                                                Executability executable,
                                                VirtualMemory* controller) {
   VirtualMemory reservation;
+  if (UseHugePages(size, executable)) {
+    alignment = Max(alignment, kHugePageSize);
+  }
   Address base = ReserveAlignedMemory(size, alignment, &reservation);
   if (base == NULL) return NULL;
   if (!reservation.Commit(base,
@@ -374,6 +386,10 @@ Address MemoryAllocator::AllocateAlignedMemory(size_t size,
                           executable == EXECUTABLE)) {
     return NULL;
   }
+  if (UseHugePages(reservation.size(), executable)) {
+    VirtualMemory::AdviseHugePages(base, size);
+    UpdateSizeAdvisedForHugePages(reservation.size());
+  }
   controller->TakeControl(&reservation);
   return base;
 }
@@ -549,12 +565,127 @@ Page* MemoryAllocator::AllocatePage(PagedSpace* owner,
 LargePage* MemoryAllocator::AllocateLargePage(intptr_t object_size,
                                               Executability executable,
                                               Space* owner) {
+  if (executable == NOT_EXECUTABLE) {
+    LargePage* page = ReuseCachedLargePage(object_size, owner);
+    if (page != NULL) return page;
+  }
   MemoryChunk* chunk = AllocateChunk(object_size, executable, owner);
+  if (chunk == NULL && !cached_large_pages_.is_empty()) {
+    // The cached pages may be what stands in the way of the allocation.
+    ReleaseCachedLargePages();
+    chunk = AllocateChunk(object_size, executable, owner);
+  }
   if (chunk == NULL) return NULL;
   return LargePage::Initialize(isolate_->heap(), chunk);
 }
 
 
+LargePage* MemoryAllocator::ReuseCachedLargePage(intptr_t object_size,
+                                                 Space* owner) {
+  // Compare object sizes; the page header is not part of the request.
+  int best = -1;
+  for (int i = 0; i < cached_large_pages_.length(); i++) {
+    intptr_t body_size = cached_large_pages_[i].chunk->body_size();
+    if (body_size < object_size || body_size - object_size > object_size / 4) {
+      continue;
+    }
+    if (best < 0 ||
+        body_size < cached_large_pages_[best].chunk->body_size()) {
+      best = i;
+    }
+  }
+  if (best < 0) return NULL;
+
+  MemoryChunk* chunk = cached_large_pages_[best].chunk;
+  cached_large_pages_.Remove(best);
+  cached_large_page_bytes_ -= chunk->size();
+
+  Address base = chunk->address();
+  size_t size = chunk->size();
+  VirtualMemory reservation;
+  reservation.TakeControl(chunk->reserved_memory());
+
+  // Pointer-containing pages are split into fake chunks before they are
+  // freed (see Heap::FreeQueuedChunks).  Clear their owners, which are the
+  // only words of the body the heap looks at before the object is
+  // initialized.
+  for (Address inner = base + Page::kPageSize;
+       inner < base + size;
+       inner += Page::kPageSize) {
+    MemoryChunk::FromAddress(inner)->owner_ = NULL;
+  }
+
+#ifdef DEBUG
+  ZapBlock(base, size);
+#endif
+
+  LOG(isolate_, NewEvent("MemoryChunk", base, size));
+  ObjectSpace space = static_cast<ObjectSpace>(1 << owner->identity());
+  PerformAllocationCallback(space, kAllocationActionAllocate, size);
+
+  MemoryChunk* result = MemoryChunk::Initialize(isolate_->heap(),
+                                                base,
+                                                size,
+                                                NOT_EXECUTABLE,
+                                                owner);
+  result->set_reserved_memory(&reservation);
+  return LargePage::Initialize(isolate_->heap(), result);
+}
+
+
+bool MemoryAllocator::CacheLargePage(MemoryChunk* chunk) {
+  if (!FLAG_cache_large_pages) return false;
+  if (chunk->owner() == NULL || chunk->owner()->identity() != LO_SPACE) {
+    return false;
+  }
+  if (chunk->IsFlagSet(MemoryChunk::IS_EXECUTABLE) ||
+      !chunk->reserved_memory()->IsReserved() ||
+      chunk->size() > kMaxCachedLargePageBytes) {
+    return false;
+  }
+  while (cached_large_pages_.length() >= kMaxCachedLargePages ||
+         cached_large_page_bytes_ + chunk->size() > kMaxCachedLargePageBytes) {
+    ReleaseCachedLargePage(0);
+  }
+  CachedLargePage cached = { chunk, 0 };
+  cached_large_pages_.Add(cached);
+  cached_large_page_bytes_ += chunk->size();
+  return true;
+}
+
+
+void MemoryAllocator::ReleaseCachedLargePage(int index) {
+  MemoryChunk* chunk = cached_large_pages_[index].chunk;
+  cached_large_pages_.Remove(index);
+  cached_large_page_bytes_ -= chunk->size();
+  VirtualMemory* reservation = chunk->reserved_memory();
+  if (UseHugePages(reservation->size(), NOT_EXECUTABLE)) {
+    UpdateSizeAdvisedForHugePages(-static_cast<intptr_t>(reservation->size()));
+  }
+  FreeMemory(reservation, NOT_EXECUTABLE);
+}
+
+
+void MemoryAllocator::ReleaseCachedLargePages() {
+  while (!cached_large_pages_.is_empty()) {
+    ReleaseCachedLargePage(cached_large_pages_.length() - 1);
+  }
+  cached_large_pages_.Free();
+}
+
+
+void MemoryAllocator::AgeCachedLargePages() {
+  int i = 0;
+  while (i < cached_large_pages_.length()) {
+    if (++cached_large_pages_[i].age > kMaxCachedLargePageAge) {
+      ReleaseCachedLargePage(i);
+    } else {
+      i++;
+    }
+  }
+}
+
+
 void MemoryAllocator::Free(MemoryChunk* chunk) {
   LOG(isolate_, DeleteEvent("MemoryChunk", chunk));
   if (chunk->owner() != NULL) {
@@ -566,8 +697,14 @@ void MemoryAllocator::Free(MemoryChunk* chunk) {
   delete chunk->slots_buffer();
   delete chunk->skip_list();
 
+  if (CacheLargePage(chunk)) return;
+
   VirtualMemory* reservation = chunk->reserved_memory();
   if (reservation->IsReserved()) {
+    if (UseHugePages(reservation->size(), chunk->executable())) {
+      UpdateSizeAdvisedForHugePages(
+          -static_cast<intptr_t>(reservation->size()));
+    }
     FreeMemory(reservation, chunk->executable());
   } else {
     FreeMemory(chunk->address(),
@@ -581,6 +718,12 @@ bool MemoryAllocator::CommitBlock(Address start,
                                   size_t size,
                                   Executability executable) {
   if (!VirtualMemory::CommitRegion(start, size, executable)) return false;
+  // Blocks are only committed for the semispaces, which are huge page
+  // aligned whenever they are big enough to benefit.
+  if (use_huge_pages_ && executable == NOT_EXECUTABLE) {
+    VirtualMemory::AdviseHugePages(start, size);
+    UpdateSizeAdvisedForHugePages(size);
+  }
 #ifdef DEBUG
   ZapBlock(start, size);
 #endif
@@ -591,11 +734,32 @@ bool MemoryAllocator::CommitBlock(Address start,
 
 bool MemoryAllocator::UncommitBlock(Address start, size_t size) {
   if (!VirtualMemory::UncommitRegion(start, size)) return false;
+  if (use_huge_pages_) {
+    UpdateSizeAdvisedForHugePages(-static_cast<intptr_t>(size));
+  }
   isolate_->counters()->memory_allocated()->Decrement(static_cast<int>(size));
   return true;
 }
 
 
+void MemoryAllocator::PrefaultBlock(Address start, size_t size) {
+  size_t page_size = OS::AllocateAlignment();
+  for (size_t s = 0; s < size; s += page_size) {
+    // Writing back the value read faults in a private page.
+    volatile Address* slot = reinterpret_cast<volatile Address*>(start + s);
+    *slot = *slot;
+  }
+}
+
+
+void MemoryAllocator::UpdateSizeAdvisedForHugePages(intptr_t delta) {
+  size_huge_pages_ += delta;
+  ASSERT(size_huge_pages_ >= 0);
+  isolate_->counters()->memory_huge_pages()->Increment(
+      static_cast<int>(delta));
+}
+
+
 void MemoryAllocator::ZapBlock(Address start, size_t size) {
   for (size_t s = 0; s + kPointerSize <= size; s += kPointerSize) {
     Memory::Address_at(start + s) = kZapValue;
@@ -670,7 +834,8 @@ PagedSpace::PagedSpace(Heap* heap,
       free_list_(this),
       was_swept_conservatively_(false),
       first_unswept_page_(Page::FromAddress(NULL)),
-      last_unswept_page_(Page::FromAddress(NULL)) {
+      last_unswept_page_(Page::FromAddress(NULL)),
+      concurrent_sweeping_in_progress_(false) {
   max_capacity_ = (RoundDown(max_capacity, Page::kPageSize) / Page::kPageSize)
                   * Page::kObjectAreaSize;
   accounting_stats_.Clear();
@@ -920,6 +1085,7 @@ void NewSpace::TearDown() {
   start_ = NULL;
   allocation_info_.top = NULL;
   allocation_info_.limit = NULL;
+  shared_top_ = NULL;
 
   to_space_.TearDown();
   from_space_.TearDown();
@@ -960,6 +1126,8 @@ void NewSpace::Grow() {
 
 
 void NewSpace::Shrink() {
+  // The limit is reset below.
+  RetireAllocationBuffer();
   int new_capacity = Max(InitialCapacity(), 2 * SizeAsInt());
   int rounded_new_capacity = RoundUp(new_capacity, Page::kPageSize);
   if (rounded_new_capacity < Capacity() &&
@@ -982,20 +1150,91 @@ void NewSpace::Shrink() {
 
 
 void NewSpace::UpdateAllocationInfo() {
-  allocation_info_.top = to_space_.page_low();
+  shared_top_ = NULL;
+  allocation_epoch_++;
+  SetAllocationArea(to_space_.page_low());
+}
+
+
+void NewSpace::SetAllocationArea(Address top) {
+  allocation_info_.top = top;
   allocation_info_.limit = to_space_.page_high();
 
-  // Lower limit during incremental marking.
-  if (heap()->incremental_marking()->IsMarking() &&
-      inline_allocation_limit_step() != 0) {
+  // Lower limit during incremental marking and allocation sampling.
+  if ((heap()->incremental_marking()->IsMarking() &&
+       inline_allocation_limit_step() != 0) ||
+      allocation_sampling_step_ != 0) {
     Address new_limit =
-        allocation_info_.top + inline_allocation_limit_step();
+        allocation_info_.top + inline_allocation_step();
     allocation_info_.limit = Min(new_limit, allocation_info_.limit);
   }
   ASSERT_SEMISPACE_ALLOCATION_INFO(allocation_info_, to_space_);
 }
 
 
+// Threads are archived and give up their buffers while holding the lock,
+// but not necessarily inside the isolate: a lazily archived thread is
+// archived by the next thread that takes the lock, and resources are freed
+// when the locker goes away.  So unlike Heap::CreateFillerObjectAt this
+// does not look up the current isolate.
+static void FillAllocationBufferRest(Heap* heap, Address top, Address limit) {
+  if (limit > top) {
+    FreeListNode::FromAddress(top)->set_size(heap,
+                                             static_cast<int>(limit - top));
+  }
+}
+
+
+void NewSpace::ArchiveAllocationBuffer(ThreadAllocationBuffer* buffer) {
+  Address top = allocation_info_.top;
+  Address limit;
+  Address shared_top;
+  if (shared_top_ != NULL) {
+    // The thread keeps the buffer it was restored with.
+    limit = allocation_info_.limit;
+    shared_top = shared_top_;
+  } else {
+    limit = Min(top + kThreadAllocationBufferSize, to_space_.page_high());
+    shared_top = limit;
+  }
+  buffer->info.top = top;
+  buffer->info.limit = limit;
+  buffer->epoch = allocation_epoch_;
+  FillAllocationBufferRest(heap(), top, limit);
+
+  shared_top_ = NULL;
+  SetAllocationArea(shared_top);
+  top_on_previous_step_ = shared_top;
+}
+
+
+void NewSpace::RestoreAllocationBuffer(ThreadAllocationBuffer* buffer) {
+  ASSERT(shared_top_ == NULL);
+  if (buffer->epoch != allocation_epoch_) return;
+  if (buffer->info.top == buffer->info.limit) return;
+  ASSERT(to_space_.current_page()->ContainsLimit(buffer->info.limit));
+  ASSERT(buffer->info.limit <= allocation_info_.top);
+
+  // The filler that covers the buffer is overwritten by new objects.
+  shared_top_ = allocation_info_.top;
+  allocation_info_ = buffer->info;
+  top_on_previous_step_ = allocation_info_.top;
+}
+
+
+void NewSpace::RetireAllocationBuffer() {
+  if (shared_top_ == NULL) return;
+  FillAllocationBufferRest(heap(),
+                           allocation_info_.top,
+                           allocation_info_.limit);
+
+  Address shared_top = shared_top_;
+  shared_top_ = NULL;
+  SetAllocationArea(shared_top);
+  top_on_previous_step_ = shared_top;
+}
+
+
 void NewSpace::ResetAllocationInfo() {
   to_space_.Reset();
   UpdateAllocationInfo();
@@ -1009,6 +1248,7 @@ void NewSpace::ResetAllocationInfo() {
 
 
 bool NewSpace::AddFreshPage() {
+  ASSERT(!HasThreadAllocationBuffer());
   Address top = allocation_info_.top;
   if (NewSpacePage::IsAtStart(top)) {
     // The current page is already empty. Don't try to make another.
@@ -1132,6 +1372,9 @@ bool SemiSpace::Commit() {
                                                           executable())) {
     return false;
   }
+  if (FLAG_prefault_semi_spaces) {
+    heap()->isolate()->memory_allocator()->PrefaultBlock(start, capacity_);
+  }
 
   NewSpacePage* page = anchor();
   for (int i = 1; i <= pages; i++) {
@@ -1177,6 +1420,9 @@ bool SemiSpace::GrowTo(int new_capacity) {
       start, delta, executable())) {
     return false;
   }
+  if (FLAG_prefault_semi_spaces) {
+    heap()->isolate()->memory_allocator()->PrefaultBlock(start, delta);
+  }
   capacity_ = new_capacity;
   NewSpacePage* last_page = anchor()->prev_page();
   ASSERT(last_page != anchor());
@@ -1598,16 +1844,18 @@ void FreeListNode::set_size(Heap* heap, int size_in_bytes) {
   // appropriate array length for the desired size from HeapObject::Size().
   // If the block is too small (eg, one or two words), to hold both a size
   // field and a next pointer, we give it a filler map that gives it the
-  // correct size.
+  // correct size.  The free space and filler maps are roots, so no write
+  // barrier is needed, which also makes this safe to call from the
+  // concurrent sweeper thread.
   if (size_in_bytes > FreeSpace::kHeaderSize) {
-    set_map(heap->raw_unchecked_free_space_map());
+    set_map_unsafe(heap->raw_unchecked_free_space_map());
     // Can't use FreeSpace::cast because it fails during deserialization.
     FreeSpace* this_as_free_space = reinterpret_cast<FreeSpace*>(this);
     this_as_free_space->set_size(size_in_bytes);
   } else if (size_in_bytes == kPointerSize) {
-    set_map(heap->raw_unchecked_one_pointer_filler_map());
+    set_map_unsafe(heap->raw_unchecked_one_pointer_filler_map());
   } else if (size_in_bytes == 2 * kPointerSize) {
-    set_map(heap->raw_unchecked_two_pointer_filler_map());
+    set_map_unsafe(heap->raw_unchecked_two_pointer_filler_map());
   } else {
     UNREACHABLE();
   }
@@ -1616,9 +1864,17 @@ void FreeListNode::set_size(Heap* heap, int size_in_bytes) {
 }
 
 
+// Free list nodes are also linked by the concurrent sweeper thread, which
+// has no current isolate, so the heap is taken from the page header.
+static inline bool IsFreeSpaceNode(FreeListNode* node) {
+  Heap* heap = MemoryChunk::FromAddress(node->address())->heap();
+  return node->map() == heap->raw_unchecked_free_space_map();
+}
+
+
 FreeListNode* FreeListNode::next() {
   ASSERT(IsFreeListNode(this));
-  if (map() == HEAP->raw_unchecked_free_space_map()) {
+  if (IsFreeSpaceNode(this)) {
     ASSERT(map() == NULL || Size() >= kNextOffset + kPointerSize);
     return reinterpret_cast<FreeListNode*>(
         Memory::Address_at(address() + kNextOffset));
@@ -1631,7 +1887,7 @@ FreeListNode* FreeListNode::next() {
 
 FreeListNode** FreeListNode::next_address() {
   ASSERT(IsFreeListNode(this));
-  if (map() == HEAP->raw_unchecked_free_space_map()) {
+  if (IsFreeSpaceNode(this)) {
     ASSERT(Size() >= kNextOffset + kPointerSize);
     return reinterpret_cast<FreeListNode**>(address() + kNextOffset);
   } else {
@@ -1645,7 +1901,7 @@ void FreeListNode::set_next(FreeListNode* next) {
   // While we are booting the VM the free space map will actually be null.  So
   // we have to make sure that we don't try to use it for anything at that
   // stage.
-  if (map() == HEAP->raw_unchecked_free_space_map()) {
+  if (IsFreeSpaceNode(this)) {
     ASSERT(map() == NULL || Size() >= kNextOffset + kPointerSize);
     Memory::Address_at(address() + kNextOffset) =
         reinterpret_cast<Address>(next);
@@ -1664,10 +1920,44 @@ FreeList::FreeList(PagedSpace* owner)
 
 void FreeList::Reset() {
   available_ = 0;
-  small_list_ = NULL;
-  medium_list_ = NULL;
-  large_list_ = NULL;
-  huge_list_ = NULL;
+  for (int i = 0; i < kNumberOfBins; i++) bins_[i] = NULL;
+  for (int i = 0; i < kBitmapWords; i++) non_empty_bins_[i] = 0;
+}
+
+
+int FreeList::BinIndex(int size_in_bytes) {
+  ASSERT(size_in_bytes >= kMinBlockSize);
+  int words = size_in_bytes >> kPointerSizeLog2;
+  if (size_in_bytes <= kExactBinMax) return words;
+  int log2 = 31 - CompilerIntrinsics::CountLeadingZeros(words);
+  int subdivision = (words >> (log2 - kLargeBinSubdivisionLog2)) &
+                    (kLargeBinSubdivision - 1);
+  int index = kNumberOfExactBins +
+              (log2 - kFirstLargeBinLog2) * kLargeBinSubdivision +
+              subdivision;
+  return Min(index, kNumberOfBins - 1);
+}
+
+
+void FreeList::AddToBin(int index, FreeListNode* node) {
+  node->set_next(bins_[index]);
+  bins_[index] = node;
+  non_empty_bins_[index / kBitsPerBitmapWord] |=
+      1u << (index % kBitsPerBitmapWord);
+}
+
+
+int FreeList::NextNonEmptyBin(int index) {
+  int word = index / kBitsPerBitmapWord;
+  if (word >= kBitmapWords) return -1;
+  uint32_t bits =
+      non_empty_bins_[word] & (~0u << (index % kBitsPerBitmapWord));
+  while (bits == 0) {
+    if (++word == kBitmapWords) return -1;
+    bits = non_empty_bins_[word];
+  }
+  return word * kBitsPerBitmapWord +
+      CompilerIntrinsics::CountTrailingZeros(bits);
 }
 
 
@@ -1676,71 +1966,72 @@ int FreeList::Free(Address start, int size_in_bytes) {
   FreeListNode* node = FreeListNode::FromAddress(start);
   node->set_size(heap_, size_in_bytes);
 
-  // Early return to drop too-small blocks on the floor.
-  if (size_in_bytes < kSmallListMin) return size_in_bytes;
-
-  // Insert other blocks at the head of a free list of the appropriate
-  // magnitude.
-  if (size_in_bytes <= kSmallListMax) {
-    node->set_next(small_list_);
-    small_list_ = node;
-  } else if (size_in_bytes <= kMediumListMax) {
-    node->set_next(medium_list_);
-    medium_list_ = node;
-  } else if (size_in_bytes <= kLargeListMax) {
-    node->set_next(large_list_);
-    large_list_ = node;
-  } else {
-    node->set_next(huge_list_);
-    huge_list_ = node;
-  }
+  // Early return to drop blocks that cannot hold a free list node.
+  if (size_in_bytes < kMinBlockSize) return size_in_bytes;
+
+  AddToBin(BinIndex(size_in_bytes), node);
   available_ += size_in_bytes;
   ASSERT(IsVeryLong() || available_ == SumFreeLists());
   return 0;
 }
 
 
-FreeListNode* FreeList::PickNodeFromList(FreeListNode** list, int* node_size) {
-  FreeListNode* node = *list;
+static void ConcatenateLists(FreeListNode** list, FreeListNode** other) {
+  FreeListNode* head = *other;
+  if (head == NULL) return;
+  FreeListNode* tail = head;
+  while (tail->next() != NULL) tail = tail->next();
+  tail->set_next(*list);
+  *list = head;
+  *other = NULL;
+}
+
+
+intptr_t FreeList::Concatenate(FreeList* free_list) {
+  intptr_t bytes = free_list->available_;
+  for (int i = 0; i < kNumberOfBins; i++) {
+    ConcatenateLists(&bins_[i], &free_list->bins_[i]);
+  }
+  for (int i = 0; i < kBitmapWords; i++) {
+    non_empty_bins_[i] |= free_list->non_empty_bins_[i];
+    free_list->non_empty_bins_[i] = 0;
+  }
+  available_ += static_cast<int>(bytes);
+  free_list->available_ = 0;
+  ASSERT(IsVeryLong() || available_ == SumFreeLists());
+  return bytes;
+}
+
 
-  if (node == NULL) return NULL;
+FreeListNode* FreeList::PickNodeFromBin(int index, int* node_size) {
+  FreeListNode* node = bins_[index];
 
   while (node != NULL &&
          Page::FromAddress(node->address())->IsEvacuationCandidate()) {
-    available_ -= node->Size();
+    available_ -= reinterpret_cast<FreeSpace*>(node)->Size();
     node = node->next();
   }
 
   if (node != NULL) {
-    *node_size = node->Size();
-    *list = node->next();
+    *node_size = reinterpret_cast<FreeSpace*>(node)->Size();
+    bins_[index] = node->next();
   } else {
-    *list = NULL;
+    bins_[index] = NULL;
   }
 
+  if (bins_[index] == NULL) {
+    non_empty_bins_[index / kBitsPerBitmapWord] &=
+        ~(1u << (index % kBitsPerBitmapWord));
+  }
   return node;
 }
 
 
-FreeListNode* FreeList::FindNodeFor(int size_in_bytes, int* node_size) {
+FreeListNode* FreeList::PickFittingNodeFromBin(int index,
+                                               int size_in_bytes,
+                                               int* node_size) {
   FreeListNode* node = NULL;
-
-  if (size_in_bytes <= kSmallAllocationMax) {
-    node = PickNodeFromList(&small_list_, node_size);
-    if (node != NULL) return node;
-  }
-
-  if (size_in_bytes <= kMediumAllocationMax) {
-    node = PickNodeFromList(&medium_list_, node_size);
-    if (node != NULL) return node;
-  }
-
-  if (size_in_bytes <= kLargeAllocationMax) {
-    node = PickNodeFromList(&large_list_, node_size);
-    if (node != NULL) return node;
-  }
-
-  for (FreeListNode** cur = &huge_list_;
+  for (FreeListNode** cur = &bins_[index];
        *cur != NULL;
        cur = (*cur)->next_address()) {
     FreeListNode* cur_node = *cur;
@@ -1765,10 +2056,38 @@ FreeListNode* FreeList::FindNodeFor(int size_in_bytes, int* node_size) {
     }
   }
 
+  if (bins_[index] == NULL) {
+    non_empty_bins_[index / kBitsPerBitmapWord] &=
+        ~(1u << (index % kBitsPerBitmapWord));
+  }
   return node;
 }
 
 
+FreeListNode* FreeList::FindNodeFor(int size_in_bytes, int* node_size) {
+  int index = BinIndex(Max(size_in_bytes, kMinBlockSize));
+
+  // Blocks in the bin of a large request are not necessarily large enough.
+  if (size_in_bytes > kExactBinMax) {
+    FreeListNode* node =
+        PickFittingNodeFromBin(index, size_in_bytes, node_size);
+    if (node != NULL) return node;
+    index++;
+  }
+
+  // Any block in this or a higher bin is large enough.  The smallest one is
+  // taken to keep the large blocks for large requests.
+  for (index = NextNonEmptyBin(index);
+       index >= 0;
+       index = NextNonEmptyBin(index + 1)) {
+    FreeListNode* node = PickNodeFromBin(index, node_size);
+    if (node != NULL) return node;
+  }
+
+  return NULL;
+}
+
+
 // Allocation on the old space free list.  If it succeeds then a new linear
 // allocation space has been set up with the top and limit of the space.  If
 // the allocation fails then NULL is returned, and the caller can perform a GC
@@ -1835,31 +2154,88 @@ HeapObject* FreeList::Allocate(int size_in_bytes) {
 }
 
 
-static intptr_t CountFreeListItemsInList(FreeListNode* n, Page* p) {
-  intptr_t sum = 0;
-  while (n != NULL) {
-    if (Page::FromAddress(n->address()) == p) {
-      FreeSpace* free_space = reinterpret_cast<FreeSpace*>(n);
-      sum += free_space->Size();
+void FreeList::CountFreeListItems(Page* p, intptr_t* sizes) {
+  sizes[0] = sizes[1] = sizes[2] = sizes[3] = 0;
+  for (int i = BinIndex(kSmallListMin); i < kNumberOfBins; i++) {
+    for (FreeListNode* n = bins_[i]; n != NULL; n = n->next()) {
+      if (Page::FromAddress(n->address()) != p) continue;
+      int size = reinterpret_cast<FreeSpace*>(n)->Size();
+      if (size <= kSmallListMax) {
+        sizes[0] += size;
+      } else if (size <= kMediumListMax) {
+        sizes[1] += size;
+      } else if (size <= kLargeListMax) {
+        sizes[2] += size;
+      } else {
+        sizes[3] += size;
+      }
     }
-    n = n->next();
   }
-  return sum;
 }
 
 
-void FreeList::CountFreeListItems(Page* p, intptr_t* sizes) {
-  sizes[0] = CountFreeListItemsInList(small_list_, p);
-  sizes[1] = CountFreeListItemsInList(medium_list_, p);
-  sizes[2] = CountFreeListItemsInList(large_list_, p);
-  sizes[3] = CountFreeListItemsInList(huge_list_, p);
+intptr_t FreeList::DiscardFreeMemory() {
+  intptr_t page_size = static_cast<intptr_t>(OS::AllocateAlignment());
+  intptr_t discarded = 0;
+  for (int i = BinIndex(static_cast<int>(page_size)); i < kNumberOfBins; i++) {
+    for (FreeListNode* n = bins_[i]; n != NULL; n = n->next()) {
+      int size = reinterpret_cast<FreeSpace*>(n)->Size();
+      Address header_end = reinterpret_cast<Address>(n->next_address() + 1);
+      Address start = RoundUp(header_end, page_size);
+      Address end = RoundDown(n->address() + size, page_size);
+      if (start >= end) continue;
+      size_t length = static_cast<size_t>(end - start);
+      if (VirtualMemory::DiscardRegion(start, length)) discarded += length;
+    }
+  }
+  return discarded;
 }
 
+
+void FreeList::PrintFragmentationStatistics() {
+  intptr_t blocks = 0;
+  intptr_t exact_bytes = 0;
+  intptr_t large_bytes = 0;
+  int largest = 0;
+  int bins_in_use = 0;
+  for (int i = 0; i < kNumberOfBins; i++) {
+    if (bins_[i] != NULL) bins_in_use++;
+    for (FreeListNode* n = bins_[i]; n != NULL; n = n->next()) {
+      int size = reinterpret_cast<FreeSpace*>(n)->Size();
+      blocks++;
+      if (size <= kExactBinMax) {
+        exact_bytes += size;
+      } else {
+        large_bytes += size;
+      }
+      largest = Max(largest, size);
+    }
+  }
+
+  // The share of the free memory that cannot be used for the largest block,
+  // 0% if all free memory is in one block.
+  double fragmentation = (available_ == 0) ? 0.0 :
+      100.0 * (available_ - largest) / available_;
+  PrintF("Free list of %s: %d bytes in %" V8_PTR_PREFIX "d blocks "
+         "(%d bins), %" V8_PTR_PREFIX "d bytes in exact bins, "
+         "%" V8_PTR_PREFIX "d bytes in large bins, largest block %d bytes, "
+         "fragmentation %.2f%%\n",
+         AllocationSpaceName(owner_->identity()),
+         available_,
+         blocks,
+         bins_in_use,
+         exact_bytes,
+         large_bytes,
+         largest,
+         fragmentation);
+}
+
+
 #ifdef DEBUG
 intptr_t FreeList::SumFreeList(FreeListNode* cur) {
   intptr_t sum = 0;
   while (cur != NULL) {
-    ASSERT(cur->map() == HEAP->raw_unchecked_free_space_map());
+    ASSERT(IsFreeSpaceNode(cur));
     FreeSpace* cur_as_free_space = reinterpret_cast<FreeSpace*>(cur);
     sum += cur_as_free_space->Size();
     cur = cur->next();
@@ -1883,10 +2259,11 @@ int FreeList::FreeListLength(FreeListNode* cur) {
 
 
 bool FreeList::IsVeryLong() {
-  if (FreeListLength(small_list_) == kVeryLongFreeList) return  true;
-  if (FreeListLength(medium_list_) == kVeryLongFreeList) return  true;
-  if (FreeListLength(large_list_) == kVeryLongFreeList) return  true;
-  if (FreeListLength(huge_list_) == kVeryLongFreeList) return  true;
+  int length = 0;
+  for (int i = 0; i < kNumberOfBins; i++) {
+    length += FreeListLength(bins_[i]);
+    if (length >= kVeryLongFreeList) return true;
+  }
   return false;
 }
 
@@ -1895,10 +2272,10 @@ bool FreeList::IsVeryLong() {
 // on the free list, so it should not be called if FreeListLength returns
 // kVeryLongFreeList.
 intptr_t FreeList::SumFreeLists() {
-  intptr_t sum = SumFreeList(small_list_);
-  sum += SumFreeList(medium_list_);
-  sum += SumFreeList(large_list_);
-  sum += SumFreeList(huge_list_);
+  intptr_t sum = 0;
+  for (int i = 0; i < kNumberOfBins; i++) {
+    sum += SumFreeList(bins_[i]);
+  }
   return sum;
 }
 #endif
@@ -1981,7 +2358,23 @@ bool LargeObjectSpace::ReserveSpace(int bytes) {
 }
 
 
+intptr_t PagedSpace::RefillFreeList() {
+  ConcurrentSweeper* sweeper =
+      heap()->mark_compact_collector()->concurrent_sweeper();
+  intptr_t freed_bytes = sweeper->TakeSweptMemory(this, &free_list_);
+  accounting_stats_.DeallocateBytes(freed_bytes);
+  heap()->LowerOldGenLimits(freed_bytes);
+  return freed_bytes;
+}
+
+
 bool PagedSpace::AdvanceSweeper(intptr_t bytes_to_sweep) {
+  if (concurrent_sweeping_in_progress_) {
+    // The pages are swept by the concurrent sweeper thread.  Just pick up
+    // the memory it has freed so far without waiting for it.
+    heap()->mark_compact_collector()->AdvanceConcurrentSweeping();
+  }
+
   if (IsSweepingComplete()) return true;
 
   intptr_t freed_bytes = 0;
@@ -2031,6 +2424,25 @@ void PagedSpace::EvictEvacuationCandidatesFromFreeLists() {
 HeapObject* PagedSpace::SlowAllocateRaw(int size_in_bytes) {
   // Allocation in this space has failed.
 
+  // If the concurrent sweeper owns pages of this space take the memory it
+  // has freed so far and only wait for it if nothing suitable is left.
+  // Allocating from swept memory does not grow the old generation, so this
+  // is done before checking the allocation limit.
+  if (concurrent_sweeping_in_progress_) {
+    MarkCompactCollector* collector = heap()->mark_compact_collector();
+    ConcurrentSweeper* sweeper = collector->concurrent_sweeper();
+    while (true) {
+      RefillFreeList();
+      HeapObject* object = free_list_.Allocate(size_in_bytes);
+      if (object != NULL) return object;
+      if (sweeper->IsDone()) break;
+      sweeper->WaitForSweptPage();
+    }
+    collector->WaitUntilSweepingCompleted();
+    HeapObject* object = free_list_.Allocate(size_in_bytes);
+    if (object != NULL) return object;
+  }
+
   // Free list allocation failed and there is no next page.  Fail if we have
   // hit the old generation size limit that should cause a garbage
   // collection.
@@ -2306,6 +2718,7 @@ void LargeObjectSpace::TearDown() {
         space, kAllocationActionFree, page->size());
     heap()->isolate()->memory_allocator()->Free(page);
   }
+  heap()->isolate()->memory_allocator()->ReleaseCachedLargePages();
   Setup();
 }
 
@@ -2365,6 +2778,7 @@ LargePage* LargeObjectSpace::FindPageContainingPc(Address pc) {
 
 
 void LargeObjectSpace::FreeUnmarkedObjects() {
+  heap()->isolate()->memory_allocator()->AgeCachedLargePages();
   LargePage* previous = NULL;
   LargePage* current = first_page_;
   while (current != NULL) {
@@ -140,6 +140,21 @@ class MarkBit {
   inline bool Get() { return (*cell_ & mask_) != 0; }
   inline void Clear() { *cell_ &= ~mask_; }
 
+  // Sets the bit with an atomic read-modify-write of the whole cell so that
+  // concurrent markers never lose each other's updates.  Returns false if
+  // the bit was already set (possibly by another thread).
+  inline bool SetAtomic() {
+    volatile Atomic32* cell = reinterpret_cast<volatile Atomic32*>(cell_);
+    Atomic32 mask = static_cast<Atomic32>(mask_);
+    Atomic32 old_value;
+    do {
+      old_value = NoBarrier_Load(cell);
+      if ((old_value & mask) != 0) return false;
+    } while (NoBarrier_CompareAndSwap(cell, old_value, old_value | mask) !=
+             old_value);
+    return true;
+  }
+
   inline bool data_only() { return data_only_; }
 
   inline MarkBit Next() {
@@ -476,6 +491,12 @@ class MemoryChunk {
   static void IncrementLiveBytes(Address address, int by) {
     MemoryChunk::FromAddress(address)->IncrementLiveBytes(by);
   }
+  // Same as above, but safe to use from several marking threads at once.
+  static void IncrementLiveBytesAtomic(Address address, int by) {
+    MemoryChunk* chunk = MemoryChunk::FromAddress(address);
+    NoBarrier_AtomicIncrement(
+        reinterpret_cast<volatile Atomic32*>(&chunk->live_byte_count_), by);
+  }
 
   static const intptr_t kAlignment =
       (static_cast<uintptr_t>(1) << kPageSizeBits);
@@ -954,6 +975,20 @@ class MemoryAllocator {
 
   void Free(MemoryChunk* chunk);
 
+  // Unmaps the large pages that are kept for reuse.
+  void ReleaseCachedLargePages();
+
+  // Called on every full collection.  Unmaps the cached large pages that
+  // have not been reused for kMaxCachedLargePageAge collections.
+  void AgeCachedLargePages();
+
+  int CachedLargePageCount() { return cached_large_pages_.length(); }
+
+  // Returns the committed bytes the OS was advised to back with huge pages.
+  intptr_t SizeAdvisedForHugePages() { return size_huge_pages_; }
+
+  static const size_t kHugePageSize = 2 * MB;
+
   // Returns the maximum available bytes of heaps.
   intptr_t Available() { return capacity_ < size_ ? 0 : capacity_ - size_; }
 
@@ -1010,6 +1045,10 @@ class MemoryAllocator {
   // filling it up with a recognizable non-NULL bit pattern.
   void ZapBlock(Address start, size_t size);
 
+  // Touches every OS page of a committed block, so that the page faults
+  // are taken now rather than on first allocation.
+  void PrefaultBlock(Address start, size_t size);
+
   void PerformAllocationCallback(ObjectSpace space,
                                  AllocationAction action,
                                  size_t size);
@@ -1037,6 +1076,21 @@ class MemoryAllocator {
   // Allocated executable space size in bytes.
   size_t size_executable_;
 
+  // With --transparent-huge-pages, non-executable chunks of at least
+  // kHugePageSize and the new space semispaces are advised to use huge
+  // pages.  Chunks of that size are also aligned to kHugePageSize.
+  bool use_huge_pages_;
+  // Committed bytes advised to use huge pages.
+  intptr_t size_huge_pages_;
+
+  bool UseHugePages(size_t reservation_size, Executability executable) {
+    return use_huge_pages_ &&
+           executable == NOT_EXECUTABLE &&
+           reservation_size >= kHugePageSize;
+  }
+
+  void UpdateSizeAdvisedForHugePages(intptr_t delta);
+
   struct MemoryAllocationCallbackRegistration {
     MemoryAllocationCallbackRegistration(MemoryAllocationCallback callback,
                                          ObjectSpace space,
@@ -1052,6 +1106,33 @@ class MemoryAllocator {
   List<MemoryAllocationCallbackRegistration>
       memory_allocation_callbacks_;
 
+  // Recently freed non-executable large pages.  They stay mapped and are
+  // handed out again to large object allocations of a similar size, which
+  // saves the system calls to map and unmap them and the page faults on
+  // first touch.  Their contents are not cleared: every large object is
+  // fully initialized by the code that allocates it.
+  struct CachedLargePage {
+    MemoryChunk* chunk;
+    int age;
+  };
+
+  static const int kMaxCachedLargePages = 8;
+  static const size_t kMaxCachedLargePageBytes = 32 * MB;
+  static const int kMaxCachedLargePageAge = 2;
+
+  List<CachedLargePage> cached_large_pages_;
+  size_t cached_large_page_bytes_;
+
+  // Returns a cached large page that fits an object of the given size
+  // without wasting more than a quarter of it, or NULL.
+  LargePage* ReuseCachedLargePage(intptr_t object_size, Space* owner);
+
+  // Keeps a freed large page for reuse.  Returns false if the page
+  // cannot be cached.
+  bool CacheLargePage(MemoryChunk* chunk);
+
+  void ReleaseCachedLargePage(int index);
+
   // Initializes pages in a chunk. Returns the first page address.
   // This function and GetChunkId() are provided for the mark-compact
   // collector to rebuild page headers in the from space, which is
@@ -1308,29 +1389,23 @@ class FreeListNode: public HeapObject {
 };
 
 
-// The free list for the old space.  The free list is organized in such a way
-// as to encourage objects allocated around the same time to be near each
-// other.  The normal way to allocate is intended to be by bumping a 'top'
-// pointer until it hits a 'limit' pointer.  When the limit is hit we need to
-// find a new space to allocate from.  This is done with the free list, which
-// is divided up into rough categories to cut down on waste.  Having finer
-// categories would scatter allocation more.
-
-// The old space free list is organized in categories.
-// 1-31 words:  Such small free areas are discarded for efficiency reasons.
-//     They can be reclaimed by the compactor.  However the distance between top
-//     and limit may be this small.
-// 32-255 words: There is a list of spaces this large.  It is used for top and
-//     limit when the object we need to allocate is 1-31 words in size.  These
-//     spaces are called small.
-// 256-2047 words: There is a list of spaces this large.  It is used for top and
-//     limit when the object we need to allocate is 32-255 words in size.  These
-//     spaces are called medium.
-// 1048-16383 words: There is a list of spaces this large.  It is used for top
-//     and limit when the object we need to allocate is 256-2047 words in size.
-//     These spaces are call large.
-// At least 16384 words.  This list is for objects of 2048 words or larger.
-//     Empty pages are added to this list.  These spaces are called huge.
+// The free list for the old space.  The normal way to allocate is intended to
+// be by bumping a 'top' pointer until it hits a 'limit' pointer.  When the
+// limit is hit we need to find a new space to allocate from.  This is done
+// with the free list, which is segregated by size so that a block can be found
+// without walking long lists.
+//
+// The old space free list is organized in bins.
+// 1-2 words:  Such small free areas are discarded because they cannot hold a
+//     free list node.  They can be reclaimed by the compactor.
+// 3-255 words: There is one bin per word size.  A request of this size is
+//     served from its exact bin if possible, otherwise from the smallest
+//     non-empty bin above it.  Both are constant time.
+// At least 256 words: Each power of two is split into four bins.  Blocks in a
+//     bin are searched first fit only if the request falls into the same bin,
+//     any block in a higher bin is large enough.  Empty pages end up in the
+//     last bins.
+// A bitmap records which bins are non-empty.
 class FreeList BASE_EMBEDDED {
  public:
   explicit FreeList(PagedSpace* owner);
@@ -1349,6 +1424,10 @@ class FreeList BASE_EMBEDDED {
   // aligned, and the size should be a non-zero multiple of the word size.
   int Free(Address start, int size_in_bytes);
 
+  // Moves all blocks of the given free list to this one and returns the
+  // number of bytes moved.  The other free list is left empty.
+  intptr_t Concatenate(FreeList* free_list);
+
   // Allocate a block of size 'size_in_bytes' from the free list.  The block
   // is unitialized.  A failure is returned if no block is available.  The
   // number of bytes lost to fragmentation is returned in the output parameter
@@ -1365,14 +1444,59 @@ class FreeList BASE_EMBEDDED {
   bool IsVeryLong();
 #endif
 
+  // Sums up the free blocks on the given page by the magnitude categories
+  // used for compaction decisions: 32-255, 256-2047, 2048-16383 and at least
+  // 16384 words.  Smaller blocks are not counted.
   void CountFreeListItems(Page* p, intptr_t* sizes);
 
+  // Prints the number and sizes of the blocks on the free list.  Used for
+  // --trace_fragmentation.
+  void PrintFragmentationStatistics();
+
+  // Discards the OS pages that lie entirely inside free blocks, except for
+  // the node headers.  Returns the number of bytes discarded.
+  intptr_t DiscardFreeMemory();
+
  private:
   // The size range of blocks, in bytes.
   static const int kMinBlockSize = 3 * kPointerSize;
   static const int kMaxBlockSize = Page::kMaxHeapObjectSize;
 
-  FreeListNode* PickNodeFromList(FreeListNode** list, int* node_size);
+  // Blocks up to this size have a bin per word size.
+  static const int kExactBinMax = 0xff * kPointerSize;
+  static const int kNumberOfExactBins = (kExactBinMax >> kPointerSizeLog2) + 1;
+
+  // Larger blocks are binned by their most significant bit and the two bits
+  // below it.
+  static const int kLargeBinSubdivisionLog2 = 2;
+  static const int kLargeBinSubdivision = 1 << kLargeBinSubdivisionLog2;
+  static const int kFirstLargeBinLog2 = 8;
+  static const int kNumberOfLargeBins =
+      (kPageSizeBits - kPointerSizeLog2 - kFirstLargeBinLog2 + 1) *
+      kLargeBinSubdivision;
+
+  static const int kNumberOfBins = kNumberOfExactBins + kNumberOfLargeBins;
+  static const int kBitsPerBitmapWord = 32;
+  static const int kBitmapWords =
+      (kNumberOfBins + kBitsPerBitmapWord - 1) / kBitsPerBitmapWord;
+
+  // Thresholds of the magnitude categories reported by CountFreeListItems.
+  static const int kSmallListMin = 0x20 * kPointerSize;
+  static const int kSmallListMax = 0xff * kPointerSize;
+  static const int kMediumListMax = 0x7ff * kPointerSize;
+  static const int kLargeListMax = 0x3fff * kPointerSize;
+
+  static int BinIndex(int size_in_bytes);
+
+  void AddToBin(int index, FreeListNode* node);
+
+  // Returns the first non-empty bin at or after the given one, or -1.
+  int NextNonEmptyBin(int index);
+
+  FreeListNode* PickNodeFromBin(int index, int* node_size);
+  FreeListNode* PickFittingNodeFromBin(int index,
+                                       int size_in_bytes,
+                                       int* node_size);
 
   FreeListNode* FindNodeFor(int size_in_bytes, int* node_size);
 
@@ -1382,17 +1506,8 @@ class FreeList BASE_EMBEDDED {
   // Total available bytes in all blocks on this free list.
   int available_;
 
-  static const int kSmallListMin = 0x20 * kPointerSize;
-  static const int kSmallListMax = 0xff * kPointerSize;
-  static const int kMediumListMax = 0x7ff * kPointerSize;
-  static const int kLargeListMax = 0x3fff * kPointerSize;
-  static const int kSmallAllocationMax = kSmallListMin - kPointerSize;
-  static const int kMediumAllocationMax = kSmallListMax;
-  static const int kLargeAllocationMax = kMediumListMax;
-  FreeListNode* small_list_;
-  FreeListNode* medium_list_;
-  FreeListNode* large_list_;
-  FreeListNode* huge_list_;
+  FreeListNode* bins_[kNumberOfBins];
+  uint32_t non_empty_bins_[kBitmapWords];
 
   DISALLOW_IMPLICIT_CONSTRUCTORS(FreeList);
 };
@@ -1515,6 +1630,10 @@ class PagedSpace : public Space {
   // Releases all of the unused pages.
   void ReleaseAllUnusedPages();
 
+  // Gives the memory of large free blocks back to the OS.  Returns the
+  // number of bytes discarded.
+  intptr_t DiscardFreeMemory() { return free_list_.DiscardFreeMemory(); }
+
   // The dummy page that anchors the linked list of pages.
   Page* anchor() { return &anchor_; }
 
@@ -1557,9 +1676,18 @@ class PagedSpace : public Space {
   bool AdvanceSweeper(intptr_t bytes_to_sweep);
 
   bool IsSweepingComplete() {
-    return !first_unswept_page_->is_valid();
+    return !first_unswept_page_->is_valid() &&
+           !concurrent_sweeping_in_progress_;
+  }
+
+  void set_concurrent_sweeping_in_progress(bool in_progress) {
+    concurrent_sweeping_in_progress_ = in_progress;
   }
 
+  // Moves the memory freed so far by the concurrent sweeper thread to the
+  // free list of this space.  Returns the number of bytes moved.
+  intptr_t RefillFreeList();
+
   Page* FirstPage() { return anchor_.next_page(); }
   Page* LastPage() { return anchor_.prev_page(); }
 
@@ -1598,6 +1726,8 @@ class PagedSpace : public Space {
 
   void EvictEvacuationCandidatesFromFreeLists();
 
+  void PrintFreeListStatistics() { free_list_.PrintFragmentationStatistics(); }
+
   bool CanExpand();
 
  protected:
@@ -1627,6 +1757,9 @@ class PagedSpace : public Space {
   Page* first_unswept_page_;
   Page* last_unswept_page_;
 
+  // True while pages of this space are owned by the concurrent sweeper.
+  bool concurrent_sweeping_in_progress_;
+
   // Expands the space by allocating a fixed number of pages. Returns false if
   // it cannot allocate requested number of pages from OS.
   bool Expand();
@@ -2035,7 +2168,10 @@ class NewSpace : public Space {
       to_space_(heap, kToSpace),
       from_space_(heap, kFromSpace),
       reservation_(),
-      inline_allocation_limit_step_(0) {}
+      inline_allocation_limit_step_(0),
+      allocation_sampling_step_(0),
+      shared_top_(NULL),
+      allocation_epoch_(0) {}
 
   // Sets up the new space using the given chunk.
   bool Setup(int reserved_semispace_size_, int max_semispace_size);
@@ -2119,9 +2255,12 @@ class NewSpace : public Space {
   }
 
   // Return the address of the allocation pointer in the active semispace.
+  // While a thread allocation buffer is in use this is the top of the shared
+  // allocation area, which is above the buffer.
   Address top() {
-    ASSERT(to_space_.current_page()->ContainsLimit(allocation_info_.top));
-    return allocation_info_.top;
+    Address top = (shared_top_ != NULL) ? shared_top_ : allocation_info_.top;
+    ASSERT(to_space_.current_page()->ContainsLimit(top));
+    return top;
   }
   // Return the address of the first object in the active semispace.
   Address bottom() { return to_space_.space_start(); }
@@ -2159,17 +2298,68 @@ class NewSpace : public Space {
   void ResetAllocationInfo();
 
   void LowerInlineAllocationLimit(intptr_t step) {
+    RetireAllocationBuffer();
     inline_allocation_limit_step_ = step;
-    if (step == 0) {
+    intptr_t effective_step = inline_allocation_step();
+    if (effective_step == 0) {
       allocation_info_.limit = to_space_.page_high();
     } else {
       allocation_info_.limit = Min(
-          allocation_info_.top + inline_allocation_limit_step_,
+          allocation_info_.top + effective_step,
           allocation_info_.limit);
     }
     top_on_previous_step_ = allocation_info_.top;
   }
 
+  // Lowers the inline allocation limit for the allocation sampler, too.
+  // The limit is raised by the smaller of the marking and sampling steps.
+  void StartAllocationSampling(intptr_t step) {
+    allocation_sampling_step_ = step;
+    LowerInlineAllocationLimit(inline_allocation_limit_step_);
+  }
+
+  void StopAllocationSampling() {
+    allocation_sampling_step_ = 0;
+    LowerInlineAllocationLimit(inline_allocation_limit_step_);
+  }
+
+  // Sets the distance to the next allocation sample, taking effect when
+  // the limit is raised next.
+  void set_allocation_sampling_step(intptr_t step) {
+    ASSERT(allocation_sampling_step_ != 0 && step > 0);
+    allocation_sampling_step_ = step;
+  }
+
+  // Thread allocation buffers.  When several threads use the isolate through
+  // v8::Locker the allocation area of a thread that gets archived is cut off
+  // the shared allocation area and kept for the thread, so the inline
+  // allocation code continues in it when the thread is restored and threads
+  // do not interleave their objects.  Buffers are dropped when allocation
+  // moves to a new page or the semispaces are flipped.
+  static const int kThreadAllocationBufferSize = 32 * KB;
+
+  class ThreadAllocationBuffer {
+   public:
+    ThreadAllocationBuffer() : epoch(-1) { }
+
+    AllocationInfo info;
+    int epoch;
+  };
+
+  // Saves the allocation area of the current thread and switches to the
+  // shared allocation area.  The saved area is covered by a filler.
+  void ArchiveAllocationBuffer(ThreadAllocationBuffer* buffer);
+
+  // Makes a buffer saved by ArchiveAllocationBuffer the allocation area again
+  // if it is still valid.
+  void RestoreAllocationBuffer(ThreadAllocationBuffer* buffer);
+
+  // Gives up the current thread allocation buffer, if any, and switches to
+  // the shared allocation area.  Must be called before new space is iterated.
+  void RetireAllocationBuffer();
+
+  bool HasThreadAllocationBuffer() { return shared_top_ != NULL; }
+
   // Get the extent of the inactive semispace (for use as a marking stack,
   // or to zap it). Notice: space-addresses are not necessarily on the
   // same page, so FromSpaceStart() might be above FromSpaceEnd().
@@ -2243,12 +2433,23 @@ class NewSpace : public Space {
     return inline_allocation_limit_step_;
   }
 
+  // The step the inline allocation limit is actually raised by.
+  inline intptr_t inline_allocation_step() {
+    if (allocation_sampling_step_ == 0) return inline_allocation_limit_step_;
+    if (inline_allocation_limit_step_ == 0) return allocation_sampling_step_;
+    return Min(inline_allocation_limit_step_, allocation_sampling_step_);
+  }
+
   SemiSpace* active_space() { return &to_space_; }
 
  private:
   // Update allocation info to match the current to-space page.
   void UpdateAllocationInfo();
 
+  // Makes the area from top to the end of the current to-space page the
+  // allocation area, respecting the limit used during incremental marking.
+  void SetAllocationArea(Address top);
+
   Address chunk_base_;
   uintptr_t chunk_size_;
 
@@ -2274,8 +2475,20 @@ class NewSpace : public Space {
   // when all allocation is performed from inlined generated code.
   intptr_t inline_allocation_limit_step_;
 
+  // Likewise while the allocation sampler is active, so that it sees
+  // allocations from generated code.
+  intptr_t allocation_sampling_step_;
+
   Address top_on_previous_step_;
 
+  // The top of the shared allocation area while allocation_info_ is a thread
+  // allocation buffer, NULL otherwise.
+  Address shared_top_;
+
+  // Incremented whenever the allocation area moves to another page.  Thread
+  // allocation buffers from earlier epochs are not restored.
+  int allocation_epoch_;
+
   HistogramInfo* allocated_histogram_;
   HistogramInfo* promoted_histogram_;
 
@@ -390,6 +390,9 @@ void StoreBuffer::VerifyPointers(LargeObjectSpace* space) {
 
 void StoreBuffer::Verify() {
 #ifdef DEBUG
+  // Unswept pages are iterated below, so the concurrent sweeper must not be
+  // writing to them.
+  heap_->mark_compact_collector()->WaitUntilSweepingCompleted();
   VerifyPointers(heap_->old_pointer_space(),
                  &StoreBuffer::FindPointersToNewSpaceInRegion);
   VerifyPointers(heap_->map_space(),
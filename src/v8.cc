@@ -175,6 +175,16 @@ bool V8::IdleNotification() {
 }
 
 
+bool V8::IdleNotification(int idle_time_in_ms) {
+  // Returning true tells the caller that there is no need to call
+  // IdleNotification again.
+  if (!FLAG_use_idle_notification) return true;
+
+  // Use the idle time for the GC work that fits into it.
+  return HEAP->IdleNotification(idle_time_in_ms);
+}
+
+
 // Use a union type to avoid type-aliasing optimizations in GCC.
 typedef union {
   double double_value;
@@ -107,6 +107,7 @@ class V8 : public AllStatic {
 
   // Idle notification directly from the API.
   static bool IdleNotification();
+  static bool IdleNotification(int idle_time_in_ms);
 
  private:
   static void InitializeOncePerProcess();
@@ -197,6 +197,7 @@ bool ThreadManager::RestoreThread() {
   from = isolate_->stack_guard()->RestoreStackGuard(from);
   from = isolate_->regexp_stack()->RestoreStack(from);
   from = isolate_->bootstrapper()->RestoreState(from);
+  from = isolate_->heap()->RestoreThread(from);
   per_thread->set_thread_state(NULL);
   if (state->terminate_on_restore()) {
     isolate_->stack_guard()->TerminateExecution();
@@ -231,7 +232,8 @@ static int ArchiveSpacePerThread() {
                      StackGuard::ArchiveSpacePerThread() +
                     RegExpStack::ArchiveSpacePerThread() +
                    Bootstrapper::ArchiveSpacePerThread() +
-                    Relocatable::ArchiveSpacePerThread();
+                    Relocatable::ArchiveSpacePerThread() +
+                           Heap::ArchiveSpacePerThread();
 }
 
 
@@ -344,6 +346,7 @@ void ThreadManager::EagerlyArchiveThread() {
   to = isolate_->stack_guard()->ArchiveStackGuard(to);
   to = isolate_->regexp_stack()->ArchiveStack(to);
   to = isolate_->bootstrapper()->ArchiveState(to);
+  to = isolate_->heap()->ArchiveThread(to);
   lazily_archived_thread_ = ThreadId::Invalid();
   lazily_archived_thread_state_ = NULL;
 }
@@ -358,6 +361,7 @@ void ThreadManager::FreeThreadResources() {
   isolate_->stack_guard()->FreeThreadResources();
   isolate_->regexp_stack()->FreeThreadResources();
   isolate_->bootstrapper()->FreeThreadResources();
+  isolate_->heap()->FreeThreadResources();
 }
 
 
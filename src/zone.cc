@@ -75,6 +75,19 @@ Zone::Zone()
       scope_nesting_(0),
       segment_head_(NULL) {
 }
+
+
+Zone::Zone(Isolate* isolate)
+    : zone_excess_limit_(256 * MB),
+      segment_bytes_allocated_(0),
+      position_(0),
+      limit_(0),
+      scope_nesting_(0),
+      segment_head_(NULL),
+      isolate_(isolate) {
+}
+
+
 unsigned Zone::allocation_size_ = 0;
 
 ZoneScope::~ZoneScope() {
@@ -84,6 +97,19 @@ ZoneScope::~ZoneScope() {
 }
 
 
+ThreadZoneScope::ThreadZoneScope(Zone* zone)
+    : zone_(zone), previous_(Isolate::ThreadZone()) {
+  Isolate::SetThreadZone(zone);
+  zone_->scope_nesting_++;
+}
+
+
+ThreadZoneScope::~ThreadZoneScope() {
+  zone_->scope_nesting_--;
+  Isolate::SetThreadZone(previous_);
+}
+
+
 // Creates a new segment, sets it size, and pushes it to the front
 // of the segment chain. Returns the new segment.
 Segment* Zone::NewSegment(int size) {
@@ -58,6 +58,11 @@ class Segment;
 
 class Zone {
  public:
+  // Creates a zone that is separate from the isolate's own zone, e.g. for
+  // a compilation that outlives the zone scope it was started in. Its
+  // memory is released with DeleteAll() and DeleteKeptSegment().
+  explicit Zone(Isolate* isolate);
+
   // Allocate 'size' bytes of memory in the Zone; expands the Zone by
   // allocating new segments of memory on demand using malloc().
   inline void* New(int size);
@@ -85,6 +90,7 @@ class Zone {
  private:
   friend class Isolate;
   friend class ZoneScope;
+  friend class ThreadZoneScope;
 
   // All pointers returned from New() have this alignment.
   static const int kAlignment = kPointerSize;
@@ -229,6 +235,20 @@ class ZoneScope BASE_EMBEDDED {
 };
 
 
+// Redirects all zone allocation on the current thread to the given zone
+// for the lifetime of the scope. The zone is kept alive across the zone
+// scopes opened while the switch is in effect.
+class ThreadZoneScope BASE_EMBEDDED {
+ public:
+  explicit ThreadZoneScope(Zone* zone);
+  ~ThreadZoneScope();
+
+ private:
+  Zone* zone_;
+  Zone* previous_;
+};
+
+
 // A zone splay tree.  The config type parameter encapsulates the
 // different configurations of a concrete splay tree (see splay-tree.h).
 // The tree itself and all its elements are allocated in the Zone.
@@ -35,6 +35,7 @@
 #include "disassembler.h"
 #include "execution.h"
 #include "factory.h"
+#include "optimizing-compiler-thread.h"
 #include "platform.h"
 #include "cctest.h"
 
@@ -329,6 +330,33 @@ TEST(Regression236) {
 }
 
 
+// Functions marked for optimization are compiled on the optimizing
+// compiler thread and installed once the main thread picks them up.
+TEST(ConcurrentRecompilation) {
+  FLAG_allow_natives_syntax = true;
+  FLAG_concurrent_recompilation = true;
+  InitializeVM();
+  OptimizingCompilerThread* thread =
+      Isolate::Current()->optimizing_compiler_thread();
+  if (thread == NULL) return;
+  v8::HandleScope scope;
+
+  CompileRun("function f(x) { return x * 2 + 1; }"
+             "for (var i = 0; i < 10; i++) f(i);"
+             "%OptimizeFunctionOnNextCall(f);"
+             "f(3);");
+  Handle<JSFunction> f = v8::Utils::OpenHandle(
+      *v8::Handle<v8::Function>::Cast(
+          env->Global()->Get(v8_str("f"))));
+  // The code may already have been installed if the compiler thread was
+  // quick enough, so only check the state after waiting for it.
+  thread->Flush();
+  CHECK(f->IsOptimized());
+  CHECK(!thread->IsQueued(*f));
+  CHECK_EQ(15, CompileRun("f(7)")->Int32Value());
+}
+
+
 TEST(GetScriptLineNumber) {
   LocalContext env;
   v8::HandleScope scope;
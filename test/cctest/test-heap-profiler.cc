@@ -411,6 +411,40 @@ TEST(HeapEntryDominator) {
 }
 
 
+TEST(HeapSnapshotBackgroundAggregation) {
+  v8::HandleScope scope;
+  LocalContext env;
+
+  CompileRun(
+      "function X(a, b) { this.a = a; this.b = b; }\n"
+      "node3 = new X(new X(), new X());");
+
+  bool saved_flag = i::FLAG_heap_snapshot_background_aggregation;
+  i::FLAG_heap_snapshot_background_aggregation = true;
+  const v8::HeapSnapshot* snapshot =
+      v8::HeapProfiler::TakeSnapshot(v8_str("background"));
+  i::FLAG_heap_snapshot_background_aggregation = saved_flag;
+  // The isolate keeps running while the snapshot is aggregated.
+  CompileRun("node3.a = null; for (var i = 0; i < 1000; i++) new X(i);");
+
+  const v8::HeapGraphNode* global = GetGlobalObject(snapshot);
+  const v8::HeapGraphNode* node3 =
+      GetProperty(global, v8::HeapGraphEdge::kShortcut, "node3");
+  CHECK_NE(NULL, node3);
+  const v8::HeapGraphNode* node2 =
+      GetProperty(node3, v8::HeapGraphEdge::kProperty, "a");
+  CHECK_NE(NULL, node2);
+  const v8::HeapGraphNode* node1 =
+      GetProperty(node3, v8::HeapGraphEdge::kProperty, "b");
+  CHECK_NE(NULL, node1);
+  CHECK_EQ(node3, node1->GetDominatorNode());
+  CHECK_EQ(node3, node2->GetDominatorNode());
+  CHECK_GE(node3->GetRetainedSize(false),
+           node1->GetRetainedSize(false) + node2->GetRetainedSize(false) +
+           node3->GetSelfSize());
+}
+
+
 namespace {
 
 class TestJSONStream : public v8::OutputStream {
@@ -563,6 +597,118 @@ TEST(HeapSnapshotJSONSerializationAborting) {
 }
 
 
+TEST(HeapSnapshotStreaming) {
+  v8::HandleScope scope;
+  LocalContext env;
+
+  CompileRun(
+      "function A(s) { this.s = s; }\n"
+      "function B(x) { this.x = x; }\n"
+      "var a = new A('streamed string');\n"
+      "var b = new B(a);\n"
+      "var l = new A(new Array(5001).join('l'));");
+  int snapshots_count = v8::HeapProfiler::GetSnapshotsCount();
+  TestJSONStream stream;
+  CHECK(v8::HeapProfiler::StreamSnapshot(v8_str("stream"), &stream));
+  CHECK_GT(stream.size(), 0);
+  CHECK_EQ(1, stream.eos_signaled());
+  // Streamed snapshots are not kept.
+  CHECK_EQ(snapshots_count, v8::HeapProfiler::GetSnapshotsCount());
+  i::ScopedVector<char> json(stream.size());
+  stream.WriteTo(json);
+
+  AsciiResource json_res(json);
+  v8::Local<v8::String> json_string = v8::String::NewExternal(&json_res);
+  env->Global()->Set(v8_str("json_snapshot"), json_string);
+  v8::Local<v8::Value> snapshot_parse_result = CompileRun(
+      "var parsed = JSON.parse(json_snapshot); parsed.snapshot.streamed;");
+  CHECK(snapshot_parse_result->BooleanValue());
+
+  // Edges refer to nodes by id, so index the nodes by id first.  Then
+  // follow <root> -> <global>.b.x.s through the global objects.  Global
+  // properties live in cells, so the global's shortcut edges are followed.
+  v8::Local<v8::Value> string_name = CompileRun(
+      "var nodes = parsed.nodes;\n"
+      "var meta = nodes[0];\n"
+      "var id_offset = meta.fields.indexOf('id');\n"
+      "var name_offset = meta.fields.indexOf('name');\n"
+      "var children_count_offset = meta.fields.indexOf('children_count');\n"
+      "var children_offset = meta.fields.indexOf('children');\n"
+      "var children_meta = meta.types[children_offset];\n"
+      "var child_fields_count = children_meta.fields.length;\n"
+      "var child_type_offset = children_meta.fields.indexOf('type');\n"
+      "var child_name_offset ="
+      "    children_meta.fields.indexOf('name_or_index');\n"
+      "var child_to_node_offset = children_meta.fields.indexOf('to_node');\n"
+      "var property_type ="
+      "    children_meta.types[child_type_offset].indexOf('property');\n"
+      "var shortcut_type ="
+      "    children_meta.types[child_type_offset].indexOf('shortcut');\n"
+      "var pos_by_id = {};\n"
+      "for (var pos = 1; pos < nodes.length;\n"
+      "     pos += children_offset +\n"
+      "         nodes[pos + children_count_offset] * child_fields_count) {\n"
+      "  pos_by_id[nodes[pos + id_offset]] = pos;\n"
+      "}\n"
+      "function GetChildren(pos) {\n"
+      "  var result = [];\n"
+      "  for (var i = 0; i < nodes[pos + children_count_offset]; i++) {\n"
+      "    var child_pos = pos + children_offset + i * child_fields_count;\n"
+      "    result.push({\n"
+      "      type: nodes[child_pos + child_type_offset],\n"
+      "      name: nodes[child_pos + child_name_offset],\n"
+      "      to: pos_by_id[nodes[child_pos + child_to_node_offset]]});\n"
+      "  }\n"
+      "  return result;\n"
+      "}\n"
+      "function GetProperty(pos, name, type) {\n"
+      "  if (pos === undefined) return undefined;\n"
+      "  var children = GetChildren(pos);\n"
+      "  for (var i = 0; i < children.length; i++) {\n"
+      "    if (children[i].type === type &&\n"
+      "        parsed.strings[children[i].name] === name) {\n"
+      "      return children[i].to;\n"
+      "    }\n"
+      "  }\n"
+      "  return undefined;\n"
+      "}\n"
+      "var string_name = null;\n"
+      "var globals = GetChildren(pos_by_id[1]);\n"
+      "for (var i = 0; i < globals.length; i++) {\n"
+      "  var b = GetProperty(globals[i].to, 'b', shortcut_type);\n"
+      "  var s = GetProperty(GetProperty(b, 'x', property_type), 's',\n"
+      "                      property_type);\n"
+      "  if (s !== undefined)\n"
+      "    string_name = parsed.strings[nodes[s + name_offset]];\n"
+      "}\n"
+      "string_name;");
+  CHECK(string_name->IsString());
+  CHECK_EQ("streamed string", *v8::String::AsciiValue(string_name));
+
+  // Long strings are cut in their node names.
+  v8::Local<v8::Value> long_name_length = CompileRun(
+      "var long_name = null;\n"
+      "for (var i = 0; i < globals.length; i++) {\n"
+      "  var l = GetProperty(globals[i].to, 'l', shortcut_type);\n"
+      "  var s = GetProperty(l, 's', property_type);\n"
+      "  if (s !== undefined)\n"
+      "    long_name = parsed.strings[nodes[s + name_offset]];\n"
+      "}\n"
+      "long_name.length;");
+  CHECK_EQ(1024, long_name_length->Int32Value());
+}
+
+
+TEST(HeapSnapshotStreamingAborting) {
+  v8::HandleScope scope;
+  LocalContext env;
+  TestJSONStream stream(5);
+  CHECK(!v8::HeapProfiler::StreamSnapshot(v8_str("abort"), &stream));
+  CHECK_GT(stream.size(), 0);
+  CHECK_EQ(0, stream.eos_signaled());
+}
+
+
 TEST(HeapSnapshotGetNodeById) {
   v8::HandleScope scope;
   LocalContext env;
@@ -1001,3 +1147,58 @@ TEST(GetConstructorName) {
   CHECK_EQ(0, StringCmp(
       "Object", i::V8HeapExplorer::GetConstructorName(*js_obj6)));
 }
+
+
+static const v8::CpuProfileNode* FindSampleNode(
+    const v8::CpuProfileNode* node, const char* name) {
+  v8::String::AsciiValue node_name(node->GetFunctionName());
+  if (strcmp(*node_name, name) == 0) return node;
+  for (int i = 0; i < node->GetChildrenCount(); ++i) {
+    const v8::CpuProfileNode* found = FindSampleNode(node->GetChild(i), name);
+    if (found != NULL) return found;
+  }
+  return NULL;
+}
+
+
+TEST(HeapObjectSampling) {
+  v8::HandleScope scope;
+  LocalContext env;
+
+  CHECK_EQ(NULL, v8::HeapProfiler::GetHeapObjectSamples());
+  v8::HeapProfiler::StartHeapObjectSampling(256);
+  CompileRun(
+      "function Point(x) { this.x = x; this.y = x; }\n"
+      "function makePoints() {\n"
+      "  var points = new Array(20000);\n"
+      "  for (var i = 0; i < points.length; i++) points[i] = new Point(i);\n"
+      "  return points;\n"
+      "}\n"
+      "var points = makePoints();");
+  const v8::CpuProfileNode* root = v8::HeapProfiler::GetHeapObjectSamples();
+  CHECK_NE(NULL, root);
+  CHECK_GT(root->GetTotalSamplesCount(), 0);
+
+  // The objects built in makePoints are attributed to it, by type.
+  const v8::CpuProfileNode* make_points = FindSampleNode(root, "makePoints");
+  CHECK_NE(NULL, make_points);
+  bool found_point = false;
+  for (int i = 0; i < make_points->GetChildrenCount(); ++i) {
+    const v8::CpuProfileNode* child = make_points->GetChild(i);
+    v8::String::AsciiValue child_name(child->GetFunctionName());
+    if (strcmp(*child_name, "(Point)") == 0) {
+      found_point = true;
+      CHECK_GT(child->GetSelfSamplesCount(), 0);
+      CHECK_EQ(0, child->GetChildrenCount());
+    }
+  }
+  CHECK(found_point);
+
+  // Collections do not disturb sampling.
+  HEAP->CollectAllGarbage(i::Heap::kNoGCFlags);
+  CompileRun("makePoints();");
+  CHECK_NE(NULL, v8::HeapProfiler::GetHeapObjectSamples());
+
+  v8::HeapProfiler::StopHeapObjectSampling();
+  CHECK_EQ(NULL, v8::HeapProfiler::GetHeapObjectSamples());
+}
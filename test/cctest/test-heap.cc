@@ -1273,3 +1273,377 @@ TEST(GrowAndShrinkNewSpace) {
   new_capacity = new_space->Capacity();
   CHECK(old_capacity == new_capacity);
 }
+
+
+TEST(ParallelScavenge) {
+  FLAG_parallel_scavenge = true;
+  InitializeVM();
+
+  v8::HandleScope scope;
+  // Build a young object graph that is reachable both from handles and from
+  // an old space array, so that the roots and the store buffer are split
+  // between the scavenging tasks.
+  const int kLength = 4096;
+  Handle<FixedArray> young = FACTORY->NewFixedArray(kLength, NOT_TENURED);
+  Handle<FixedArray> old = FACTORY->NewFixedArray(kLength, TENURED);
+  CHECK(HEAP->InNewSpace(*young));
+  CHECK(!HEAP->InNewSpace(*old));
+  for (int i = 0; i < kLength; i++) {
+    Handle<FixedArray> element = FACTORY->NewFixedArray(2, NOT_TENURED);
+    element->set(0, Smi::FromInt(i));
+    element->set(1, *FACTORY->NewNumber(i + 0.5));
+    young->set(i, *element);
+    old->set(i, *element);
+  }
+
+  HEAP->CollectGarbage(NEW_SPACE);
+  HEAP->CollectGarbage(NEW_SPACE);
+
+  for (int i = 0; i < kLength; i++) {
+    FixedArray* element = FixedArray::cast(young->get(i));
+    CHECK_EQ(element, old->get(i));
+    CHECK_EQ(Smi::FromInt(i), element->get(0));
+    CHECK_EQ(i + 0.5, element->get(1)->Number());
+  }
+
+  HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+  FLAG_parallel_scavenge = false;
+}
+
+
+TEST(GCGoals) {
+  InitializeVM();
+  CHECK(!HEAP->HasGCGoals());
+
+  v8::ResourceConstraints constraints;
+  constraints.set_max_pause_time(5);
+  constraints.set_max_gc_time_percentage(10);
+  CHECK(v8::SetResourceConstraints(&constraints));
+  CHECK(HEAP->HasGCGoals());
+
+  // Survivors of scavenges and full collections give the heap the speeds it
+  // needs to size new space and incremental marking steps.
+  v8::HandleScope scope;
+  Handle<FixedArray> survivors = FACTORY->NewFixedArray(1000);
+  for (int i = 0; i < 10; i++) {
+    for (int j = 0; j < 1000; j++) {
+      FACTORY->NewFixedArray(10);
+      if (j % 10 == 0) survivors->set(j, *FACTORY->NewFixedArray(10));
+    }
+    HEAP->CollectGarbage(NEW_SPACE);
+  }
+  HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+
+  // The scavenge speed has been measured, so copying a lot more than new
+  // space holds cannot fit the pause goal.
+  intptr_t huge_survivors = static_cast<intptr_t>(kMaxInt);
+  CHECK(HEAP->ScavengeExceedsPauseGoal(huge_survivors));
+
+  // Incremental marking steps are sized to the pause goal.
+  HEAP->RecordIncrementalMarkingStep(100 * KB, 1);
+  intptr_t step_size = HEAP->MaxIncrementalMarkingStepSize();
+  CHECK_GT(step_size, 0);
+  constraints.set_max_pause_time(10);
+  CHECK(v8::SetResourceConstraints(&constraints));
+  CHECK_EQ(2 * step_size, HEAP->MaxIncrementalMarkingStepSize());
+
+  // A goal of 0 clears the goals.
+  constraints.set_max_pause_time(0);
+  constraints.set_max_gc_time_percentage(0);
+  CHECK(v8::SetResourceConstraints(&constraints));
+  CHECK(!HEAP->HasGCGoals());
+  CHECK(!HEAP->ScavengeExceedsPauseGoal(huge_survivors));
+  CHECK_EQ(0, static_cast<int>(HEAP->MaxIncrementalMarkingStepSize()));
+  CHECK(!HEAP->IncrementalMarkingNeededForPauseGoal());
+}
+
+
+TEST(IdleNotificationWithDeadline) {
+  if (!FLAG_incremental_marking) return;
+  InitializeVM();
+
+  v8::HandleScope scope;
+  Handle<FixedArray> old = FACTORY->NewFixedArray(1000, TENURED);
+  for (int i = 0; i < 1000; i++) {
+    old->set(i, *FACTORY->NewFixedArray(10, TENURED));
+  }
+
+  // Idle time is used to finish an incremental marking cycle that has
+  // already started, and no more work is left afterwards.
+  IncrementalMarking* marking = HEAP->incremental_marking();
+  if (marking->IsStopped()) marking->Start();
+  int ms_count = HEAP->ms_count();
+  bool done = false;
+  for (int i = 0; i < 1000 && !done; i++) {
+    done = v8::V8::IdleNotification(100);
+  }
+  CHECK(done);
+  CHECK(marking->IsStopped());
+  CHECK_GT(HEAP->ms_count(), ms_count);
+  CHECK(HEAP->old_pointer_space()->IsSweepingComplete());
+  CHECK(HEAP->old_data_space()->IsSweepingComplete());
+}
+
+
+TEST(AllocationSitePretenuring) {
+  if (!FLAG_allocation_site_pretenuring) return;
+  InitializeVM();
+
+  v8::HandleScope scope;
+  Handle<String> name = FACTORY->LookupAsciiSymbol("Point");
+  Handle<JSFunction> function =
+      FACTORY->NewFunction(name, FACTORY->undefined_value());
+  Handle<Map> initial_map =
+      FACTORY->NewMap(JS_OBJECT_TYPE, JSObject::kHeaderSize);
+  function->set_initial_map(*initial_map);
+  CHECK(HEAP->InNewSpace(*FACTORY->NewJSObject(function)));
+
+  // Every object allocated at the site survives, so the site ends up
+  // allocating its objects in old space.
+  const int kLength = 1024;
+  Handle<FixedArray> survivors = FACTORY->NewFixedArray(kLength, TENURED);
+  for (int i = 0; i < kLength; i++) {
+    survivors->set(i, *FACTORY->NewJSObject(function));
+    if (i % 64 == 63) HEAP->CollectGarbage(NEW_SPACE);
+  }
+  CHECK(!HEAP->InNewSpace(*FACTORY->NewJSObject(function)));
+
+  // The site and its decision survive a full collection.
+  HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+  CHECK(!HEAP->InNewSpace(*FACTORY->NewJSObject(function)));
+  CHECK_GT(HEAP->allocation_site_feedback()->number_of_sites(), 0);
+}
+
+
+TEST(LargeObjectPageReuse) {
+  if (!FLAG_cache_large_pages) return;
+  InitializeVM();
+  MemoryAllocator* allocator = Isolate::Current()->memory_allocator();
+
+  // A large array that dies leaves its page mapped for the next large
+  // object of a similar size.  The arrays are tenured: untenured ones this
+  // size go to large object space only after a last resort collection,
+  // which gives the cached pages back.
+  const int kLength = Page::kMaxHeapObjectSize / kPointerSize + 1;
+  Address address;
+  { v8::HandleScope scope;
+    Handle<FixedArray> array = FACTORY->NewFixedArray(kLength, TENURED);
+    CHECK(HEAP->lo_space()->Contains(*array));
+    address = array->address();
+  }
+  HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+  CHECK_GT(allocator->CachedLargePageCount(), 0);
+
+  { v8::HandleScope scope;
+    Handle<FixedArray> array = FACTORY->NewFixedArray(kLength, TENURED);
+    CHECK_EQ(address, array->address());
+    for (int i = 0; i < kLength; i++) {
+      CHECK(array->get(i)->IsUndefined());
+    }
+  }
+
+  // Low memory notifications give the cached pages back to the OS.
+  v8::V8::LowMemoryNotification();
+  CHECK_EQ(0, allocator->CachedLargePageCount());
+}
+
+
+TEST(ReduceMemoryFootprint) {
+  InitializeVM();
+
+  // Leave large free blocks between surviving arrays in old space.
+  v8::HandleScope scope;
+  const int kArrays = 64;
+  const int kArrayLength = 4 * KB;
+  Handle<FixedArray> survivors = FACTORY->NewFixedArray(kArrays, TENURED);
+  for (int i = 0; i < kArrays; i++) {
+    for (int j = 0; j < 3; j++) FACTORY->NewFixedArray(kArrayLength, TENURED);
+    Handle<FixedArray> array = FACTORY->NewFixedArray(kArrayLength, TENURED);
+    array->set(0, Smi::FromInt(i));
+    array->set(kArrayLength - 1, Smi::FromInt(i));
+    survivors->set(i, *array);
+  }
+  HEAP->CollectAllGarbage(Heap::kMakeHeapIterableMask);
+
+  intptr_t discarded = HEAP->ReduceMemoryFootprint();
+#ifdef __linux__
+  CHECK_GT(discarded, 0);
+#else
+  CHECK_GE(discarded, 0);
+#endif
+
+  // The free blocks are still usable, and the survivors are untouched.
+  for (int i = 0; i < kArrays; i++) {
+    FACTORY->NewFixedArray(kArrayLength, TENURED);
+  }
+  HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+  for (int i = 0; i < kArrays; i++) {
+    FixedArray* array = FixedArray::cast(survivors->get(i));
+    CHECK_EQ(Smi::FromInt(i), array->get(0));
+    CHECK_EQ(Smi::FromInt(i), array->get(kArrayLength - 1));
+  }
+}
+
+
+static int NumberOfWeakCallbacks = 0;
+
+static void CountingWeakGlobalHandleCallback(v8::Persistent<v8::Value> handle,
+                                             void* id) {
+  NumberOfWeakCallbacks++;
+  handle.Dispose();
+}
+
+
+TEST(GlobalHandleBlocks) {
+  InitializeVM();
+  GlobalHandles* global_handles = Isolate::Current()->global_handles();
+  HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+  int initial_blocks = global_handles->NumberOfNodeBlocks();
+
+  // Spread enough handles over several blocks and make them all weak.
+  const int kHandles = 2048;
+  {
+    HandleScope scope;
+    for (int i = 0; i < kHandles; i++) {
+      Handle<Object> object = FACTORY->NewFixedArray(1);
+      Handle<Object> global = global_handles->Create(*object);
+      global_handles->MakeWeak(global.location(),
+                               NULL,
+                               &CountingWeakGlobalHandleCallback);
+    }
+  }
+  CHECK_GT(global_handles->NumberOfNodeBlocks(), initial_blocks);
+
+  // The pending handles are dispatched as a single batch, after which the
+  // blocks they occupied are given back.
+  NumberOfWeakCallbacks = 0;
+  HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+  CHECK_EQ(kHandles, NumberOfWeakCallbacks);
+  CHECK_EQ(0, global_handles->NumberOfWeakHandles());
+  CHECK_LE(global_handles->NumberOfNodeBlocks(), initial_blocks + 1);
+
+  // The remaining free list still hands out valid nodes.
+  {
+    HandleScope scope;
+    Handle<Object> object = FACTORY->NewFixedArray(1);
+    Handle<Object> global = global_handles->Create(*object);
+    HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+    CHECK(global->IsFixedArray());
+    global_handles->Destroy(global.location());
+  }
+}
+
+
+static void CollectingWeakGlobalHandleCallback(
+    v8::Persistent<v8::Value> handle,
+    void* id) {
+  NumberOfWeakCallbacks++;
+  handle.Dispose();
+  HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+}
+
+
+TEST(GlobalHandleBlocksGCInCallback) {
+  InitializeVM();
+  GlobalHandles* global_handles = Isolate::Current()->global_handles();
+  HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+  int initial_blocks = global_handles->NumberOfNodeBlocks();
+
+  const int kHandles = 2048;
+  {
+    HandleScope scope;
+    for (int i = 0; i < kHandles; i++) {
+      Handle<Object> object = FACTORY->NewFixedArray(1);
+      Handle<Object> global = global_handles->Create(*object);
+      global_handles->MakeWeak(global.location(),
+                               NULL,
+                               &CollectingWeakGlobalHandleCallback);
+    }
+  }
+
+  // Every callback empties more of the blocks and runs a full GC.  Those
+  // nested GCs must keep the blocks of the batch, which are given back by
+  // the outer GC once the whole batch has been dispatched.
+  NumberOfWeakCallbacks = 0;
+  HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+  CHECK_EQ(kHandles, NumberOfWeakCallbacks);
+  CHECK_EQ(0, global_handles->NumberOfWeakHandles());
+  CHECK_LE(global_handles->NumberOfNodeBlocks(), initial_blocks + 1);
+}
+
+
+TEST(QueuedWeakCallbacks) {
+  InitializeVM();
+  GlobalHandles* global_handles = Isolate::Current()->global_handles();
+  HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+  CHECK_EQ(0, global_handles->NumberOfPendingWeakCallbacks());
+
+  FLAG_queue_weak_callbacks = true;
+  const int kHandles = 10;
+  Handle<Object> globals[kHandles];
+  {
+    HandleScope scope;
+    for (int i = 0; i < kHandles; i++) {
+      Handle<Object> object = FACTORY->NewFixedArray(1);
+      globals[i] = global_handles->Create(*object);
+      global_handles->MakeWeak(globals[i].location(),
+                               NULL,
+                               &CountingWeakGlobalHandleCallback);
+    }
+  }
+
+  // The GC only queues the callbacks; the handles stay near death and keep
+  // their objects alive through further collections until dispatched.
+  NumberOfWeakCallbacks = 0;
+  HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+  CHECK_EQ(0, NumberOfWeakCallbacks);
+  CHECK_EQ(kHandles, global_handles->NumberOfPendingWeakCallbacks());
+  CHECK_EQ(kHandles, v8::V8::NumberOfPendingWeakCallbacks());
+  for (int i = 0; i < kHandles; i++) {
+    CHECK(GlobalHandles::IsNearDeath(globals[i].location()));
+  }
+
+  CHECK(!v8::V8::DispatchPendingWeakCallbacks(4));
+  CHECK_EQ(4, NumberOfWeakCallbacks);
+  CHECK_EQ(kHandles - 4, global_handles->NumberOfPendingWeakCallbacks());
+
+  HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+  CHECK_EQ(4, NumberOfWeakCallbacks);
+  CHECK_EQ(kHandles - 4, global_handles->NumberOfPendingWeakCallbacks());
+
+  // An idle notification drains the rest of the queue.
+  CHECK(!v8::V8::IdleNotification(1000));
+  CHECK_EQ(kHandles, NumberOfWeakCallbacks);
+  CHECK_EQ(0, v8::V8::NumberOfPendingWeakCallbacks());
+  FLAG_queue_weak_callbacks = false;
+}
+
+
+TEST(MeasureContextMemory) {
+  InitializeVM();
+  v8::HandleScope scope;
+  v8::Persistent<v8::Context> small_context = v8::Context::New();
+  v8::Persistent<v8::Context> large_context = v8::Context::New();
+  {
+    v8::Context::Scope context_scope(large_context);
+    CompileRun("var data = [];"
+               "for (var i = 0; i < 100000; i++) data.push({ i: i });");
+  }
+
+  const int kMaxContexts = 16;
+  v8::Local<v8::Context> contexts[kMaxContexts];
+  intptr_t sizes[kMaxContexts];
+  int count = v8::V8::MeasureContextMemory(contexts, sizes, kMaxContexts);
+  CHECK_GE(count, 3);
+  intptr_t small_size = -1;
+  intptr_t large_size = -1;
+  for (int i = 0; i < count; i++) {
+    if (contexts[i] == small_context) small_size = sizes[i];
+    if (contexts[i] == large_context) large_size = sizes[i];
+  }
+  CHECK_GT(small_size, 0);
+  CHECK_GT(large_size, small_size + 100000 * 3 * kPointerSize);
+
+  small_context.Dispose();
+  large_context.Dispose();
+}
@@ -231,6 +231,126 @@ TEST(MarkCompactCollector) {
 }
 
 
+TEST(ParallelMarking) {
+  FLAG_parallel_marking = true;
+  FLAG_marking_threads = 4;
+  // The whole graph has to be marked by the final collection, not by
+  // incremental marking steps before it.
+  FLAG_incremental_marking = false;
+#ifdef DEBUG
+  // Checks that every object referenced by a marked object is marked.
+  FLAG_verify_heap = true;
+#endif
+  InitializeVM();
+
+  v8::HandleScope sc;
+  // Build a wide graph: small arrays push their elements onto the marking
+  // deque instead of marking them recursively, which gives the parallel
+  // marker enough work to start.
+  const int kOuterLength = 4096;
+  const int kInnerLength = 8;
+  Handle<FixedArray> outer = FACTORY->NewFixedArray(kOuterLength, TENURED);
+  for (int i = 0; i < kOuterLength; i++) {
+    Handle<FixedArray> inner = FACTORY->NewFixedArray(kInnerLength);
+    for (int j = 0; j < kInnerLength; j++) {
+      Handle<FixedArray> leaf = FACTORY->NewFixedArray(1);
+      leaf->set(0, Smi::FromInt(i * kInnerLength + j));
+      inner->set(j, *leaf);
+    }
+    outer->set(i, *inner);
+  }
+
+  HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+  HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+
+  for (int i = 0; i < kOuterLength; i++) {
+    FixedArray* inner = FixedArray::cast(outer->get(i));
+    for (int j = 0; j < kInnerLength; j++) {
+      FixedArray* leaf = FixedArray::cast(inner->get(j));
+      CHECK_EQ(Smi::FromInt(i * kInnerLength + j), leaf->get(0));
+    }
+  }
+  FLAG_parallel_marking = false;
+  FLAG_incremental_marking = true;
+#ifdef DEBUG
+  FLAG_verify_heap = false;
+#endif
+}
+
+
+TEST(ConcurrentSweeping) {
+  FLAG_concurrent_sweeping = true;
+  InitializeVM();
+
+  v8::HandleScope sc;
+  // Fill several old space pages with mostly dead arrays so that most of
+  // them are left to the sweeper thread.
+  const int kLength = 1024;
+  const int kArrays = 2048;
+  Handle<FixedArray> survivors = FACTORY->NewFixedArray(kArrays / 16, TENURED);
+  for (int i = 0; i < kArrays; i++) {
+    Handle<FixedArray> array = FACTORY->NewFixedArray(kLength, TENURED);
+    array->set(0, Smi::FromInt(i));
+    if (i % 16 == 0) survivors->set(i / 16, *array);
+  }
+
+  HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+
+  // Allocating in old space picks up the memory freed by the sweeper thread
+  // and waits for it if necessary.
+  for (int i = 0; i < kArrays; i++) {
+    FACTORY->NewFixedArray(kLength, TENURED);
+  }
+  HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+
+  for (int i = 0; i < kArrays / 16; i++) {
+    FixedArray* array = FixedArray::cast(survivors->get(i));
+    CHECK_EQ(Smi::FromInt(i * 16), array->get(0));
+  }
+  HEAP->mark_compact_collector()->WaitUntilSweepingCompleted();
+  CHECK(HEAP->old_pointer_space()->IsSweepingComplete());
+  FLAG_concurrent_sweeping = false;
+}
+
+
+TEST(ParallelCompaction) {
+  FLAG_parallel_compaction = true;
+  FLAG_compaction_threads = 4;
+  FLAG_stress_compaction = true;
+  InitializeVM();
+
+  v8::HandleScope sc;
+  // Spread old space objects that point to heap numbers in old data space
+  // and to new space over many pages, so that the stress mode picks several
+  // evacuation candidates.
+  const int kLength = 8 * 1024;
+  Handle<FixedArray> old = FACTORY->NewFixedArray(kLength, TENURED);
+  Handle<FixedArray> young = FACTORY->NewFixedArray(kLength, NOT_TENURED);
+  for (int i = 0; i < kLength; i++) {
+    Handle<FixedArray> element = FACTORY->NewFixedArray(3, TENURED);
+    element->set(0, Smi::FromInt(i));
+    element->set(1, *FACTORY->NewNumber(i + 0.5, TENURED));
+    young->set(i, *FACTORY->NewFixedArray(1, NOT_TENURED));
+    element->set(2, young->get(i));
+    old->set(i, *element);
+    // Garbage in between, so that the pages are worth compacting.
+    FACTORY->NewFixedArray(3, TENURED);
+  }
+
+  HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+  HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+
+  for (int i = 0; i < kLength; i++) {
+    FixedArray* element = FixedArray::cast(old->get(i));
+    CHECK_EQ(Smi::FromInt(i), element->get(0));
+    CHECK_EQ(i + 0.5, element->get(1)->Number());
+    CHECK_EQ(young->get(i), element->get(2));
+  }
+  FLAG_stress_compaction = false;
+  FLAG_parallel_compaction = false;
+}
+
+
 // TODO(1600): compaction of map space is temporary removed from GC.
 #if 0
 static Handle<Map> CreateMap() {
@@ -174,6 +174,49 @@ TEST(MemoryAllocator) {
 }
 
 
+TEST(HugePageChunks) {
+  FLAG_transparent_huge_pages = true;
+  OS::Setup();
+  Isolate* isolate = Isolate::Current();
+  isolate->InitializeLoggingAndCounters();
+  Heap* heap = isolate->heap();
+  CHECK(heap->ConfigureHeapDefault());
+  MemoryAllocator* memory_allocator = new MemoryAllocator(isolate);
+  CHECK(memory_allocator->Setup(heap->MaxReserved(),
+                                heap->MaxExecutableSize()));
+  TestMemoryAllocatorScope test_scope(isolate, memory_allocator);
+
+  // Chunks of at least a huge page are aligned to a huge page and advised
+  // to use huge pages, if the OS supports them.  Smaller chunks are not.
+  MemoryChunk* small =
+      memory_allocator->AllocateChunk(Page::kObjectAreaSize,
+                                      NOT_EXECUTABLE,
+                                      NULL);
+  CHECK(small != NULL);
+  CHECK_EQ(0, static_cast<int>(memory_allocator->SizeAdvisedForHugePages()));
+
+  MemoryChunk* big = memory_allocator->AllocateChunk(4 * MB,
+                                                     NOT_EXECUTABLE,
+                                                     NULL);
+  CHECK(big != NULL);
+  if (VirtualMemory::HasHugePageSupport()) {
+    CHECK(IsAligned(OffsetFrom(big->address()),
+                    MemoryAllocator::kHugePageSize));
+    CHECK_GE(memory_allocator->SizeAdvisedForHugePages(),
+             static_cast<intptr_t>(4 * MB));
+  } else {
+    CHECK_EQ(0, static_cast<int>(memory_allocator->SizeAdvisedForHugePages()));
+  }
+
+  memory_allocator->Free(big);
+  memory_allocator->Free(small);
+  CHECK_EQ(0, static_cast<int>(memory_allocator->SizeAdvisedForHugePages()));
+  memory_allocator->TearDown();
+  delete memory_allocator;
+  FLAG_transparent_huge_pages = false;
+}
+
+
 TEST(NewSpace) {
   OS::Setup();
   Isolate* isolate = Isolate::Current();
@@ -233,6 +276,52 @@ TEST(OldSpace) {
 }
 
 
+TEST(FreeListSizeClasses) {
+  OS::Setup();
+  Isolate* isolate = Isolate::Current();
+  isolate->InitializeLoggingAndCounters();
+  Heap* heap = isolate->heap();
+  CHECK(heap->ConfigureHeapDefault());
+  MemoryAllocator* memory_allocator = new MemoryAllocator(isolate);
+  CHECK(memory_allocator->Setup(heap->MaxReserved(),
+                                heap->MaxExecutableSize()));
+  TestMemoryAllocatorScope test_scope(isolate, memory_allocator);
+
+  OldSpace* s = new OldSpace(heap,
+                             heap->MaxOldGenerationSize(),
+                             OLD_DATA_SPACE,
+                             NOT_EXECUTABLE);
+  CHECK(s->Setup());
+
+  // Seed a free list with a large and a small block of a page of the
+  // space.  The heap is not set up, so the blocks get no map.
+  Page* page = memory_allocator->AllocatePage(s, NOT_EXECUTABLE);
+  CHECK(page != NULL);
+  FreeList free_list(s);
+  Address large_block = page->ObjectAreaStart();
+  Address small_block = large_block + 56 * kPointerSize;
+  free_list.Free(large_block, 40 * kPointerSize);
+  free_list.Free(small_block, 5 * kPointerSize);
+  CHECK_EQ(45 * kPointerSize, static_cast<int>(free_list.available()));
+
+  // A request that matches the small block exactly does not break up the
+  // large one.
+  HeapObject* object = free_list.Allocate(5 * kPointerSize);
+  CHECK_EQ(small_block, object->address());
+
+  // Smaller requests are served from the smallest block that fits.
+  object = free_list.Allocate(3 * kPointerSize);
+  CHECK_EQ(large_block, object->address());
+  CHECK_EQ(0, static_cast<int>(free_list.available()));
+
+  s->TearDown();
+  delete s;
+  memory_allocator->Free(page);
+  memory_allocator->TearDown();
+  delete memory_allocator;
+}
+
+
 TEST(LargeObjectSpace) {
   v8::V8::Initialize();
 
@@ -206,3 +206,70 @@ TEST(ThreadJoinSelf) {
   thread.Start();
   thread.Join();
 }
+
+
+// Two threads take turns allocating in new space.  Each of them gets its own
+// allocation buffer when it is archived, so their objects must survive the
+// switches and stay iterable.
+class AllocatingThread : public v8::internal::Thread {
+ public:
+  explicit AllocatingThread(int id)
+      : Thread("AllocatingThread"), id_(id) { }
+
+  void Run() {
+    v8::Locker locker;
+    v8::HandleScope scope;
+    v8::Persistent<v8::Context> context = v8::Context::New();
+    {
+      v8::Context::Scope context_scope(context);
+      v8::Handle<v8::Script> script = v8::Script::Compile(v8::String::New(
+          "var objects = [];"
+          "function allocate(id) {"
+          "  for (var i = 0; i < 100; i++) objects.push({ id: id, i: i });"
+          "}"
+          "function check(id) {"
+          "  for (var i = 0; i < objects.length; i++) {"
+          "    if (objects[i].id != id || objects[i].i != i % 100)"
+          "      return false;"
+          "  }"
+          "  return true;"
+          "}"));
+      script->Run();
+      char source[32];
+      v8::internal::OS::SNPrintF(v8::internal::Vector<char>(source, 32),
+                                 "allocate(%d)", id_);
+      v8::Handle<v8::Script> allocate =
+          v8::Script::Compile(v8::String::New(source));
+      for (int i = 0; i < 20; i++) {
+        allocate->Run();
+        v8::Unlocker unlocker;
+        Thread::YieldCPU();
+      }
+      HEAP->EnsureHeapIsIterable();
+      v8::internal::HeapIterator iterator;
+      while (iterator.next() != NULL) { }
+      HEAP->CollectGarbage(v8::internal::NEW_SPACE);
+      v8::internal::OS::SNPrintF(v8::internal::Vector<char>(source, 32),
+                                 "check(%d)", id_);
+      CHECK(v8::Script::Compile(v8::String::New(source))->Run()->IsTrue());
+    }
+    context.Dispose();
+  }
+
+ private:
+  int id_;
+};
+
+
+TEST(ThreadAllocationBuffers) {
+  v8::V8::Initialize();
+
+  AllocatingThread thread1(1);
+  AllocatingThread thread2(2);
+
+  thread1.Start();
+  thread2.Start();
+
+  thread1.Join();
+  thread2.Join();
+}
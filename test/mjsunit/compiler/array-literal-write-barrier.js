@@ -0,0 +1,111 @@
+// Copyright 2011 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Flags: --allow-natives-syntax --expose-gc
+
+// Stores into freshly created array literals are compiled without write
+// barriers. Check that the stored objects survive scavenges and full
+// collections that happen after the literal is filled in.
+
+function make(a, b, c) {
+  return [a, b, c, {}];
+}
+
+function check(array, a, b, c) {
+  assertEquals(4, array.length);
+  assertSame(a, array[0]);
+  assertSame(b, array[1]);
+  assertSame(c, array[2]);
+  assertEquals("object", typeof array[3]);
+}
+
+var x = {x: 1};
+var y = [1, 2, 3];
+var z = "z" + Math.random();
+
+check(make(x, y, z), x, y, z);
+check(make(x, y, z), x, y, z);
+%OptimizeFunctionOnNextCall(make);
+
+var kept = [];
+for (var i = 0; i < 1000; i++) {
+  var o = {i: i};
+  var array = make(o, [i], "s" + i);
+  if (i % 100 == 0) {
+    gc();
+    kept.push(array);
+  }
+  check(array, o, array[1], "s" + i);
+  assertEquals(i, array[1][0]);
+}
+
+// Keep the old arrays alive across a full collection while their elements
+// point to objects that were young when they were stored.
+gc();
+for (var i = 0; i < kept.length; i++) {
+  assertEquals(i * 100, kept[i][0].i);
+  assertEquals(i * 100, kept[i][1][0]);
+  assertEquals("s" + i * 100, kept[i][2]);
+}
+
+// Values computed by calls between the stores keep their barriers.
+function makeWithCalls(f) {
+  return [f(), f(), f()];
+}
+
+function alloc() { return {}; }
+
+makeWithCalls(alloc);
+makeWithCalls(alloc);
+%OptimizeFunctionOnNextCall(makeWithCalls);
+for (var i = 0; i < 100; i++) {
+  var array = makeWithCalls(alloc);
+  gc();
+  assertEquals(3, array.length);
+  assertEquals("object", typeof array[2]);
+}
+
+// Nested literals are created by the runtime, which allocates them in old
+// space once their allocation site has been pretenured. Their stores keep
+// the barrier instead of deoptimizing on old-space literals.
+function makeNested(a) {
+  return [[a], a];
+}
+
+makeNested(1);
+makeNested(1);
+%OptimizeFunctionOnNextCall(makeNested);
+var survivors = [];
+for (var i = 0; i < 1000; i++) {
+  var o = {i: i};
+  var array = makeNested(o);
+  survivors.push(array);
+  if (i % 100 == 0) gc();
+  assertSame(o, array[0][0]);
+  assertSame(o, array[1]);
+}
+assertTrue(%GetOptimizationStatus(makeNested) != 2);
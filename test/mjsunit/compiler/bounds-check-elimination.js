@@ -0,0 +1,114 @@
+// Copyright 2011 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Flags: --allow-natives-syntax
+
+// Bounds checks that are implied by the loop condition or by other checks
+// are removed, and checks on neighbouring elements are merged. Accesses
+// that are out of bounds must still behave as before.
+
+function sum(a) {
+  var result = 0;
+  for (var i = 0; i < a.length; i++) result += a[i];
+  return result;
+}
+
+function shrinking(a) {
+  var result = 0;
+  for (var i = 0; i < a.length; i++) {
+    if (i == a.length - 1) a.length = i;
+    result += a[i] === undefined ? 100 : a[i];
+  }
+  return result;
+}
+
+function window(a, i) {
+  return a[i] + a[i + 1] + a[i + 2];
+}
+
+function backwards(a, i) {
+  return a[i] + a[i - 1] + a[i - 2];
+}
+
+var array = [1, 2, 3, 4, 5];
+
+assertEquals(15, sum(array));
+assertEquals(15, sum(array));
+%OptimizeFunctionOnNextCall(sum);
+assertEquals(15, sum(array));
+assertEquals(3, sum([1, 2]));
+assertEquals(0, sum([]));
+
+assertEquals(106, shrinking([1, 2, 3, 4]));
+assertEquals(106, shrinking([1, 2, 3, 4]));
+%OptimizeFunctionOnNextCall(shrinking);
+assertEquals(106, shrinking([1, 2, 3, 4]));
+
+assertEquals(6, window(array, 0));
+assertEquals(9, window(array, 1));
+%OptimizeFunctionOnNextCall(window);
+assertEquals(12, window(array, 2));
+assertTrue(isNaN(window(array, 3)));
+assertTrue(isNaN(window(array, -1)));
+assertEquals(6, window(array, 0));
+
+assertEquals(6, backwards(array, 2));
+assertEquals(9, backwards(array, 3));
+%OptimizeFunctionOnNextCall(backwards);
+assertEquals(12, backwards(array, 4));
+assertTrue(isNaN(backwards(array, 1)));
+assertTrue(isNaN(backwards(array, 5)));
+assertEquals(6, backwards(array, 2));
+
+// External arrays keep their bounds checks, but the loops over them and
+// out of bounds accesses must behave as before.
+function sumExternal(a) {
+  var result = 0;
+  for (var i = 0; i < a.length; i++) result += a[i];
+  return result;
+}
+
+function windowExternal(a, i) {
+  return a[i] + a[i + 1] + a[i + 2];
+}
+
+var external = new Int32Array(5);
+for (var i = 0; i < external.length; i++) external[i] = i + 1;
+
+assertEquals(15, sumExternal(external));
+assertEquals(15, sumExternal(external));
+%OptimizeFunctionOnNextCall(sumExternal);
+assertEquals(15, sumExternal(external));
+assertEquals(0, sumExternal(new Int32Array(0)));
+
+assertEquals(6, windowExternal(external, 0));
+assertEquals(9, windowExternal(external, 1));
+%OptimizeFunctionOnNextCall(windowExternal);
+assertEquals(12, windowExternal(external, 2));
+assertTrue(isNaN(windowExternal(external, 3)));
+assertTrue(isNaN(windowExternal(external, -1)));
+assertEquals(6, windowExternal(external, 0));
@@ -0,0 +1,126 @@
+// Copyright 2011 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Flags: --allow-natives-syntax
+
+// Object literals that never escape the optimized function are replaced
+// by their field values. Check that loads see the stored values and that
+// the objects are materialized with the right fields and identity when
+// the function deoptimizes while they are live.
+
+function sum(a, b) {
+  var p = { x: a, y: b };
+  return p.x + p.y;
+}
+
+function store(a, b) {
+  var p = { x: a, y: 0 };
+  p.y = b;
+  p.x = p.x + p.y;
+  return p.x * 10 + p.y;
+}
+
+function branch(a, c) {
+  var p = { x: a, y: 0 };
+  if (c) {
+    p.y = 1;
+  } else {
+    p.y = 1;
+  }
+  return p.x + p.y;
+}
+
+function diverge(a, c) {
+  var p = { x: a, y: 0 };
+  if (c) p.y = 1;
+  return p.x + p.y;
+}
+
+function loop(a, n) {
+  var p = { x: a, y: 1 };
+  var total = 0;
+  for (var i = 0; i < n; i++) {
+    total += p.x * p.y;
+  }
+  return total;
+}
+
+function escape(a) {
+  var p = { x: a, y: 0 };
+  p.y = a + 1;
+  return p;
+}
+
+function deopt(a, b, o) {
+  var p = { x: a, y: 0 };
+  p.y = b;
+  var w = o.w;
+  return p.x * 10 + p.y + w;
+}
+
+function identity(a, o) {
+  var p = { x: a, y: 0 };
+  var q = p;
+  q.y = a + 1;
+  var w = o.w;
+  q.x = w;
+  return p.x + p.y;
+}
+
+function test() {
+  assertEquals(3, sum(1, 2));
+  assertEquals(32, store(1, 2));
+  assertEquals(3, branch(2, true));
+  assertEquals(3, branch(2, false));
+  assertEquals(3, diverge(2, true));
+  assertEquals(2, diverge(2, false));
+  assertEquals(15, loop(3, 5));
+  var e = escape(4);
+  assertEquals(4, e.x);
+  assertEquals(5, e.y);
+  assertEquals(112, deopt(1, 2, { w: 100 }));
+  assertEquals(12, identity(1, { w: 10 }));
+}
+
+test();
+test();
+%OptimizeFunctionOnNextCall(sum);
+%OptimizeFunctionOnNextCall(store);
+%OptimizeFunctionOnNextCall(branch);
+%OptimizeFunctionOnNextCall(diverge);
+%OptimizeFunctionOnNextCall(loop);
+%OptimizeFunctionOnNextCall(escape);
+%OptimizeFunctionOnNextCall(deopt);
+%OptimizeFunctionOnNextCall(identity);
+test();
+test();
+
+// A receiver with a different map deoptimizes at the load of o.w while
+// the literals are live in a local variable.
+assertEquals(112, deopt(1, 2, { z: 0, w: 100 }));
+assertEquals(12, identity(1, { z: 0, w: 10 }));
+assertEquals(1.5 * 10 + 2.5 + 1, deopt(1.5, 2.5, { z: 0, w: 1 }));
@@ -0,0 +1,139 @@
+// Copyright 2011 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Flags: --allow-natives-syntax
+
+// Named field loads are forwarded from earlier loads and stores of the
+// same field, stores that are overwritten are removed, and loads of fields
+// a loop does not store to are hoisted out of the loop. Check that
+// aliasing objects and code that can observe the fields see the right
+// values.
+
+function Point(x, y) {
+  this.x = x;
+  this.y = y;
+}
+
+function forward(p, v) {
+  p.x = v;
+  p.y = p.x + 1;
+  return p.x + p.y;
+}
+
+function alias(a, b) {
+  a.x = 1;
+  b.x = 2;
+  return a.x;
+}
+
+var observed;
+var observer = { get y() { observed = this.target.x; return 0; } };
+
+function overwrite(p) {
+  p.x = 1;
+  var t = observer.y;
+  p.x = 2;
+  return t;
+}
+
+function loop(p, n) {
+  var sum = 0;
+  for (var i = 0; i < n; i++) {
+    p.y = i;
+    sum += p.x;
+  }
+  return sum;
+}
+
+function increment(p, n) {
+  for (var i = 0; i < n; i++) {
+    p.x = p.x + 1;
+  }
+  return p.x;
+}
+
+function test() {
+  var p = new Point(1, 2);
+  assertEquals(11, forward(p, 5));
+  assertEquals(5, p.x);
+  assertEquals(6, p.y);
+
+  var q = new Point(1, 2);
+  assertEquals(1, alias(p, q));
+  assertEquals(2, alias(p, p));
+
+  observer.target = p;
+  observed = undefined;
+  assertEquals(0, overwrite(p));
+  assertEquals(1, observed);
+  assertEquals(2, p.x);
+
+  p = new Point(3, 0);
+  assertEquals(30, loop(p, 10));
+  assertEquals(9, p.y);
+
+  p = new Point(0, 0);
+  assertEquals(10, increment(p, 10));
+}
+
+test();
+test();
+%OptimizeFunctionOnNextCall(forward);
+%OptimizeFunctionOnNextCall(alias);
+%OptimizeFunctionOnNextCall(overwrite);
+%OptimizeFunctionOnNextCall(loop);
+%OptimizeFunctionOnNextCall(increment);
+test();
+test();
+
+
+// A load from a field of a loaded object must not be hoisted above the
+// checks on that object when they stay in the loop.
+function Holder(a) {
+  this.n = 0;
+  this.a = a;
+}
+
+Holder.prototype.sum = function(count) {
+  var s = 0;
+  for (var i = 0; i < count; i++) {
+    this.n = i;
+    s += this.a.x;
+  }
+  return s;
+};
+
+var holder = new Holder({ x: 1 });
+assertEquals(10, holder.sum(10));
+assertEquals(10, holder.sum(10));
+%OptimizeFunctionOnNextCall(Holder.prototype.sum);
+assertEquals(10, holder.sum(10));
+holder.a = { y: 0, x: 2 };
+assertEquals(20, holder.sum(10));
+holder.a = 42;
+assertTrue(isNaN(holder.sum(10)));
+assertEquals(0, holder.sum(0));
@@ -381,6 +381,8 @@
             '../../src/objects-visiting.h',
             '../../src/objects.cc',
             '../../src/objects.h',
+            '../../src/optimizing-compiler-thread.cc',
+            '../../src/optimizing-compiler-thread.h',
             '../../src/parser.cc',
             '../../src/parser.h',
             '../../src/platform-tls-mac.h',